@@ -0,0 +1,369 @@
+//#############################################################################
+//  File:      AppDemoMainBatch.cpp
+//  Purpose:   Headless batch renderer of the demo application. It loads a
+//             demo scene or a model file and renders it with the ray tracer
+//             or path tracer without a window or OpenGL context. The images
+//             are saved as PNG and the timing & ray statistics as JSON.
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLApplication.h>
+#include <SLAssimpImporter.h>
+#include <SLCVCalibration.h>
+#include <SLCVCapture.h>
+#include <SLEnums.h>
+#include <SLFileSystem.h>
+#include <SLPathtracer.h>
+#include <SLSampler.h>
+#include <SLScene.h>
+#include <SLSceneView.h>
+#include <SLSkeleton.h>
+
+//-----------------------------------------------------------------------------
+//! Forward declaration of the scene definition function from AppDemoLoad.cpp
+extern void appDemoLoadScene(SLScene* s, SLSceneView* sv, SLSceneID sceneID);
+
+//-----------------------------------------------------------------------------
+//! Scene names that can be passed with -scene instead of the numeric ID
+static const struct
+{
+    const char* name;
+    SLSceneID   id;
+} sceneNames[] = {{"Minimal", SID_Minimal},
+                  {"Figure", SID_Figure},
+                  {"MeshLoad", SID_MeshLoad},
+                  {"LargeModel", SID_LargeModel},
+                  {"Revolver", SID_Revolver},
+                  {"FrustumCull", SID_FrustumCull},
+                  {"MassiveData", SID_MassiveData},
+                  {"AnimationSkeletal", SID_AnimationSkeletal},
+                  {"AnimationNode", SID_AnimationNode},
+                  {"AnimationArmy", SID_AnimationArmy},
+                  {"RTMuttenzerBox", SID_RTMuttenzerBox},
+                  {"RTSpheres", SID_RTSpheres},
+                  {"RTSoftShadows", SID_RTSoftShadows},
+                  {"RTDoF", SID_RTDoF},
+                  {"RTLens", SID_RTLens},
+                  {"RTTest", SID_RTTest},
+                  {"RTInstances", SID_RTInstances}};
+
+//-----------------------------------------------------------------------------
+//! Command line options of the batch renderer
+struct BatchOptions
+{
+    SLSceneID     sceneID   = SID_RTSpheres; //!< Demo scene to load
+    SLstring      sceneName = "RTSpheres";   //!< Name or ID of the scene
+    SLstring      modelFile;                 //!< Model file (replaces the scene)
+    SLbool        doPT      = false;         //!< Path tracing instead of RT
+    SLint         frames    = 1;             //!< NO. of frames to render
+    SLfloat       fps       = 30.0f;         //!< Animation frames per second
+    SLint         width     = 640;           //!< Image width in pixels
+    SLint         height    = 480;           //!< Image height in pixels
+    SLuint        threads   = 0;             //!< NO. of threads (0 = all)
+    SLint         samples   = -1;            //!< AA (RT) or pixel samples (PT)
+    SLint         depth     = 5;             //!< Max. ray depth
+    SLuint        seed      = 0;             //!< Seed of the PT samples
+    SLSamplerType sampler   = ST_sobol;      //!< Sample generator of the PT
+    SLbool        denoise   = false;         //!< Denoising of the PT image
+    SLstring      outPrefix = "batch";       //!< PNG filename prefix ("" = none)
+    SLstring      jsonFile;                  //!< JSON filename ("" = stdout)
+};
+//-----------------------------------------------------------------------------
+static void printUsage(const char* exe)
+{
+    printf("Usage: %s [options]\n", exe);
+    printf("  -scene <name|id>   Demo scene (default RTSpheres)\n");
+    printf("  -model <file>      Model file loaded with assimp instead of a scene\n");
+    printf("  -renderer <rt|pt>  Ray tracer or path tracer (default rt)\n");
+    printf("  -frames <n>        NO. of frames (default 1)\n");
+    printf("  -fps <f>           Animation frames per second (default 30)\n");
+    printf("  -width <w>         Image width (default 640)\n");
+    printf("  -height <h>        Image height (default 480)\n");
+    printf("  -threads <n>       NO. of render threads (default 0 = all)\n");
+    printf("  -samples <n>       RT: uneven AA samples per side, PT: samples per pixel\n");
+    printf("  -depth <n>         Max. ray depth (default 5)\n");
+    printf("  -seed <n>          Seed of the PT samples (default 0)\n");
+    printf("  -sampler <type>    PT samples: random, halton or sobol (default sobol)\n");
+    printf("  -denoise <0|1>     Denoise the PT image (default 0)\n");
+    printf("  -out <prefix>      PNG filename prefix (default batch, \"\" = no PNG)\n");
+    printf("  -json <file>       Write the statistics to file instead of stdout\n");
+    printf("Scenes:");
+    for (auto& sn : sceneNames)
+        printf(" %s", sn.name);
+    printf("\n");
+}
+//-----------------------------------------------------------------------------
+//! Parses the command line and returns false on an invalid argument
+static SLbool parseArgs(int argc, char* argv[], BatchOptions& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        SLstring arg = argv[i];
+        if (arg == "-h" || arg == "-help" || arg == "--help") return false;
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        SLstring val = argv[++i];
+
+        if (arg == "-scene")
+        {
+            opt.sceneName = val;
+            opt.sceneID   = SID_Empty;
+            for (auto& sn : sceneNames)
+                if (val == sn.name) opt.sceneID = sn.id;
+
+            if (opt.sceneID == SID_Empty)
+            {
+                SLint id = atoi(val.c_str());
+                if (id <= SID_All || id >= SID_Maximal)
+                {
+                    fprintf(stderr, "Unknown scene: %s\n", val.c_str());
+                    return false;
+                }
+                opt.sceneID = (SLSceneID)id;
+            }
+        }
+        else if (arg == "-model")
+            opt.modelFile = val;
+        else if (arg == "-renderer")
+        {
+            if (val != "rt" && val != "pt")
+            {
+                fprintf(stderr, "Unknown renderer: %s\n", val.c_str());
+                return false;
+            }
+            opt.doPT = val == "pt";
+        }
+        else if (arg == "-frames")
+            opt.frames = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-fps")
+            opt.fps = SL_max((SLfloat)atof(val.c_str()), 0.001f);
+        else if (arg == "-width")
+            opt.width = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-height")
+            opt.height = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-threads")
+            opt.threads = (SLuint)SL_max(atoi(val.c_str()), 0);
+        else if (arg == "-samples")
+            opt.samples = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-depth")
+            opt.depth = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-seed")
+            opt.seed = (SLuint)atoi(val.c_str());
+        else if (arg == "-sampler")
+        {
+            if (val == "random")
+                opt.sampler = ST_random;
+            else if (val == "halton")
+                opt.sampler = ST_halton;
+            else if (val == "sobol")
+                opt.sampler = ST_sobol;
+            else
+            {
+                fprintf(stderr, "Unknown sampler: %s\n", val.c_str());
+                return false;
+            }
+        }
+        else if (arg == "-denoise")
+            opt.denoise = atoi(val.c_str()) != 0;
+        else if (arg == "-out")
+            opt.outPrefix = val;
+        else if (arg == "-json")
+            opt.jsonFile = val;
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Advances the animations by a fixed time step and updates the skinned meshes,
+the world matrices and the AABBs. This is the part of SLScene::onUpdate that
+is needed for ray tracing. The fixed time step makes the frames reproducible.
+*/
+static void updateScene(SLScene* s, SLfloat elapsedSec)
+{
+    for (auto skeleton : s->animManager().skeletons())
+        skeleton->changed(false);
+
+    if (!s->stopAnimations())
+        s->animManager().update(elapsedSec);
+
+    // The ray tracer always needs the skinned vertices on the CPU
+    for (auto mesh : s->meshes())
+        mesh->updateSkin(true);
+
+    if (s->root3D())
+        s->root3D()->updateAABBRec();
+}
+//-----------------------------------------------------------------------------
+//! Appends the statistics of one frame as JSON object
+static void frameToJSON(stringstream&     json,
+                        SLint             frame,
+                        SLfloat           buildSec,
+                        SLfloat           renderSec,
+                        const SLRayStats& st)
+{
+    SLfloat sec = SL_max(renderSec, 0.000001f);
+
+    json << "    {\"frame\": " << frame
+         << ", \"accelBuildSec\": " << buildSec
+         << ", \"renderSec\": " << renderSec
+         << ", \"primaryRays\": " << st.primaryRays
+         << ", \"reflectedRays\": " << st.reflectedRays
+         << ", \"refractedRays\": " << st.refractedRays
+         << ", \"shadowRays\": " << st.shadowRays
+         << ", \"subsampledRays\": " << st.subsampledRays
+         << ", \"totalRays\": " << st.totalRays()
+         << ", \"mraysPerSec\": " << (SLfloat)st.totalRays() / sec / 1.0e6f
+         << ", \"tests\": " << st.tests
+         << ", \"intersections\": " << st.intersections
+         << ", \"testsPerRay\": " << st.testsPerRay()
+         << ", \"avgDepth\": " << st.avgDepth()
+         << ", \"maxDepth\": " << st.maxDepthReached
+         << "}";
+}
+//-----------------------------------------------------------------------------
+/*!
+The batch renderer does not create a window or OpenGL context. Therefore it
+doesn't call slCreateAppAndScene and slCreateSceneView that load the GUI fonts.
+SLGLState detects the missing context and skips all its OpenGL calls (see
+SLGLState::hasContext). No other GL resource gets created because nothing is
+drawn with OpenGL. The sceneview gets no window update callback so that the
+ray tracer and path tracer never try to draw their image with GL.
+*/
+int main(int argc, char* argv[])
+{
+    BatchOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Default paths for all loaded resources (see slCreateAppAndScene)
+    SLstring projectRoot          = SLstring(SL_PROJECT_ROOT);
+    SLGLProgram::defaultPath      = projectRoot + "/data/shaders/";
+    SLGLTexture::defaultPath      = projectRoot + "/data/images/textures/";
+    SLGLTexture::defaultPathFonts = projectRoot + "/data/images/fonts/";
+    SLAssimpImporter::defaultPath = projectRoot + "/data/models/";
+    SLCVCapture::videoDefaultPath = projectRoot + "/data/videos/";
+    SLCVCalibration::calibIniPath = projectRoot + "/data/calibrations/";
+    SLApplication::configPath     = SLFileSystem::getAppsWritableDir();
+
+    SLApplication::createAppAndScene("AppDemoBatch", (void*)appDemoLoadScene);
+    SLScene* s = SLApplication::scene;
+
+    SLSceneView* sv = new SLSceneView();
+    sv->init("BatchView", opt.width, opt.height, nullptr, nullptr, nullptr);
+    if (!SLApplication::dpi) SLApplication::dpi = 142;
+
+    // Load the demo scene or an empty scene with the model file
+    if (opt.modelFile.empty())
+        s->onLoad(s, sv, opt.sceneID);
+    else
+    {
+        s->onLoad(s, sv, SID_Empty);
+        s->onLoadAsset(opt.modelFile,
+                       SLProcess_Triangulate |
+                         SLProcess_JoinIdenticalVertices |
+                         SLProcess_FindDegenerates |
+                         SLProcess_FindInvalidData);
+    }
+
+    if (!s->root3D() || !sv->camera())
+    {
+        fprintf(stderr, "Scene has no nodes or no camera.\n");
+        SLApplication::deleteAppAndScene();
+        return EXIT_FAILURE;
+    }
+
+    // Setup the ray tracer or path tracer of the sceneview
+    SLRaytracer* rt = opt.doPT ? (SLRaytracer*)sv->pathtracer() : sv->raytracer();
+    rt->numThreads(opt.threads);
+    rt->maxDepth(opt.depth);
+    if (opt.samples > 0)
+        rt->aaSamples(opt.doPT ? opt.samples : opt.samples | 1);
+    else if (opt.doPT)
+        rt->aaSamples(10);
+
+    // The PT samples only depend on the seed, the pixel and the sample index
+    SLSampler::type(opt.sampler);
+    SLSampler::seed(opt.seed);
+    sv->pathtracer()->doDenoise(opt.denoise);
+
+    stringstream frames;
+
+    for (SLint f = 0; f < opt.frames; ++f)
+    {
+        // Animate with a fixed time step (the first frame is the initial state)
+        updateScene(s, f > 0 ? 1.0f / opt.fps : 0.0f);
+
+        // Build or update the acceleration structures like in draw3DRT
+        double tBuild = s->timeSec();
+        for (auto mesh : s->meshes())
+            mesh->updateAccelStruct();
+        s->sceneBVH().update(s->root3D());
+        SLfloat buildSec = (SLfloat)(s->timeSec() - tBuild);
+
+        ////////////////////////////////////
+        if (opt.doPT)
+            sv->pathtracer()->render(sv);
+        else
+            sv->raytracer()->renderDistrib(sv);
+        ////////////////////////////////////
+
+        if (!opt.outPrefix.empty())
+        {
+            SLchar filename[512];
+            snprintf(filename, sizeof(filename), "%s_%04d.png", opt.outPrefix.c_str(), f);
+            rt->images()[0]->savePNG(filename, 6, true, true);
+        }
+
+        if (f > 0) frames << ",\n";
+        frameToJSON(frames, f, buildSec, rt->renderSec(), rt->stats());
+    }
+
+    stringstream json;
+    json << "{\n"
+         << "  \"scene\": \"" << (opt.modelFile.empty() ? opt.sceneName : opt.modelFile) << "\",\n"
+         << "  \"renderer\": \"" << (opt.doPT ? "pt" : "rt") << "\",\n"
+         << "  \"width\": " << opt.width << ",\n"
+         << "  \"height\": " << opt.height << ",\n"
+         << "  \"threads\": " << rt->numThreads() << ",\n"
+         << "  \"samples\": " << rt->aaSamples() << ",\n"
+         << "  \"maxDepth\": " << rt->maxDepth() << ",\n"
+         << "  \"frames\": [\n"
+         << frames.str() << "\n"
+         << "  ]\n"
+         << "}\n";
+
+    if (opt.jsonFile.empty())
+        printf("%s", json.str().c_str());
+    else
+    {
+        ofstream file(opt.jsonFile);
+        file << json.str();
+    }
+
+    SLApplication::deleteAppAndScene();
+    return EXIT_SUCCESS;
+}
+//-----------------------------------------------------------------------------
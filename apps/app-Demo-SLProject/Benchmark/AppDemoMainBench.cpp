@@ -0,0 +1,636 @@
+//#############################################################################
+//  File:      AppDemoMainBench.cpp
+//  Purpose:   Headless ray tracing benchmark of the demo application. It
+//             measures the acceleration structure build time, the memory
+//             and the ray throughput of primary (scalar and packet), shadow
+//             and secondary rays for the ray tracing demo scenes and for
+//             generated triangle soups. The results are written as JSON.
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLApplication.h>
+#include <SLAssimpImporter.h>
+#include <SLCVCalibration.h>
+#include <SLCVCapture.h>
+#include <SLEnums.h>
+#include <SLFileSystem.h>
+#include <SLLightSpot.h>
+#include <SLRay.h>
+#include <SLRayPacket.h>
+#include <SLRenderPool.h>
+#include <SLSampler.h>
+#include <SLScene.h>
+#include <SLSceneView.h>
+
+//-----------------------------------------------------------------------------
+//! Forward declaration of the scene definition function from AppDemoLoad.cpp
+extern void appDemoLoadScene(SLScene* s, SLSceneView* sv, SLSceneID sceneID);
+
+//-----------------------------------------------------------------------------
+//! Demo scenes of the benchmark
+static const struct
+{
+    const char* name;
+    SLSceneID   id;
+} benchScenes[] = {{"RTMuttenzerBox", SID_RTMuttenzerBox},
+                   {"RTSpheres", SID_RTSpheres},
+                   {"RTSoftShadows", SID_RTSoftShadows},
+                   {"RTDoF", SID_RTDoF},
+                   {"RTLens", SID_RTLens},
+                   {"RTTest", SID_RTTest},
+                   {"RTInstances", SID_RTInstances},
+                   {"LargeModel", SID_LargeModel}};
+
+//-----------------------------------------------------------------------------
+//! Command line options of the benchmark
+struct BenchOptions
+{
+    SLint             width     = 512;      //!< Image width in pixels
+    SLint             height    = 384;      //!< Image height in pixels
+    SLuint            threads   = 0;        //!< NO. of threads (0 = all)
+    SLint             repeat    = 3;        //!< NO. of runs per measurement (best counts)
+    SLint             depth     = 5;        //!< Max. ray depth of the full rendering
+    SLuint            seed      = 1234;     //!< Seed for rand and SLSampler
+    SLVuint           soups     = {10000, 100000, 1000000}; //!< Triangle soup sizes
+    SLAccelStructType accel     = AST_auto; //!< Accel. struct type of all meshes
+    SLVstring         filter;               //!< Only scenes with these names ("" = all)
+    SLstring          jsonFile;             //!< JSON filename ("" = stdout)
+    SLstring          baseline;             //!< JSON file of a previous run to compare
+    SLfloat           threshold = 0.1f;     //!< Max. allowed slowdown against the baseline
+};
+//-----------------------------------------------------------------------------
+//! Result of one throughput measurement
+struct BenchRays
+{
+    SLuint64 rays = 0;    //!< NO. of rays traced per run
+    SLfloat  sec  = 0.0f; //!< Best time of all runs
+
+    SLfloat mraysPerSec() const
+    {
+        return sec > 0.0f ? (SLfloat)rays / sec / 1.0e6f : 0.0f;
+    }
+};
+//-----------------------------------------------------------------------------
+//! Results of one benchmark scene
+struct BenchResult
+{
+    SLstring    name;
+    SLNodeStats stats;             //!< Node stats incl. memory
+    SLuint      sceneBVHBytes = 0; //!< Memory of the scene BVH
+    SLfloat     accelBuildSec = 0; //!< Build time of all mesh accel. structs
+    SLfloat     sceneBVHSec   = 0; //!< Build time of the scene BVH
+    SLfloat     renderSec     = 0; //!< Best time of the full rendering
+    SLuint      renderRays    = 0; //!< NO. of rays of the full rendering
+    BenchRays   primary;           //!< Primary ray intersection only
+    BenchRays   primaryPacket;     //!< Primary rays as packets of 2x2 pixels
+    BenchRays   shadow;            //!< Shadow rays to all lights
+    BenchRays   secondary;         //!< Reflected rays of all primary hits
+};
+//-----------------------------------------------------------------------------
+static void printUsage(const char* exe)
+{
+    printf("Usage: %s [options]\n", exe);
+    printf("  -width <w>          Image width (default 512)\n");
+    printf("  -height <h>         Image height (default 384)\n");
+    printf("  -threads <n>        NO. of render threads (default 0 = all)\n");
+    printf("  -repeat <n>         Runs per measurement, the best counts (default 3)\n");
+    printf("  -depth <n>          Max. ray depth of the full rendering (default 5)\n");
+    printf("  -seed <n>           Seed of the random generators (default 1234)\n");
+    printf("  -soups <n,n,..>     Triangle soup sizes (default 10000,100000,1000000)\n");
+    printf("  -scenes <a,b,..>    Only run these scenes (e.g. RTSpheres,Soup10000)\n");
+    printf("  -accel <type>       Accel. struct of all meshes: auto, grid or bvh (default auto)\n");
+    printf("  -json <file>        Write the results to file instead of stdout\n");
+    printf("  -baseline <file>    Compare the Mrays/s against a previous run\n");
+    printf("  -threshold <f>      Max. allowed slowdown vs. baseline (default 0.1)\n");
+}
+//-----------------------------------------------------------------------------
+//! Splits a comma separated list
+static SLVstring splitList(const SLstring& list)
+{
+    SLVstring    items;
+    stringstream ss(list);
+    SLstring     item;
+    while (getline(ss, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+//-----------------------------------------------------------------------------
+//! Parses the command line and returns false on an invalid argument
+static SLbool parseArgs(int argc, char* argv[], BenchOptions& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        SLstring arg = argv[i];
+        if (arg == "-h" || arg == "-help" || arg == "--help") return false;
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        SLstring val = argv[++i];
+
+        if (arg == "-width")
+            opt.width = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-height")
+            opt.height = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-threads")
+            opt.threads = (SLuint)SL_max(atoi(val.c_str()), 0);
+        else if (arg == "-repeat")
+            opt.repeat = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-depth")
+            opt.depth = SL_max(atoi(val.c_str()), 1);
+        else if (arg == "-seed")
+            opt.seed = (SLuint)atoi(val.c_str());
+        else if (arg == "-soups")
+        {
+            opt.soups.clear();
+            for (auto& n : splitList(val))
+                if (atoi(n.c_str()) > 0) opt.soups.push_back((SLuint)atoi(n.c_str()));
+        }
+        else if (arg == "-scenes")
+            opt.filter = splitList(val);
+        else if (arg == "-accel")
+        {
+            if (val == "auto")
+                opt.accel = AST_auto;
+            else if (val == "grid")
+                opt.accel = AST_compactGrid;
+            else if (val == "bvh")
+                opt.accel = AST_BVH;
+            else
+            {
+                fprintf(stderr, "Unknown accel. struct: %s\n", val.c_str());
+                return false;
+            }
+        }
+        else if (arg == "-json")
+            opt.jsonFile = val;
+        else if (arg == "-baseline")
+            opt.baseline = val;
+        else if (arg == "-threshold")
+            opt.threshold = SL_max((SLfloat)atof(val.c_str()), 0.0f);
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Creates a scene with a soup of numTriangles random triangles within the cube
+[-1,1]^3. The triangles are generated with a fixed seed so that every run
+intersects exactly the same geometry.
+*/
+static void loadTriangleSoup(SLScene*     s,
+                             SLSceneView* sv,
+                             SLuint       numTriangles,
+                             SLuint       seed)
+{
+    s->onLoad(s, sv, SID_Empty);
+    s->name("Soup" + std::to_string(numTriangles));
+
+    mt19937                           rng(seed);
+    uniform_real_distribution<SLfloat> pos(-1.0f, 1.0f);
+
+    // The triangle size shrinks with the NO. of triangles like in real models
+    SLfloat size = 2.0f / cbrtf((SLfloat)numTriangles);
+
+    SLMaterial* mat  = new SLMaterial("soup", SLCol4f(0.6f, 0.6f, 0.6f), SLCol4f::WHITE, 100, 0.2f);
+    SLMesh*     mesh = new SLMesh("Soup mesh");
+    mesh->mat(mat);
+    mesh->P.reserve(numTriangles * 3);
+    mesh->I32.reserve(numTriangles * 3);
+
+    for (SLuint t = 0; t < numTriangles; ++t)
+    {
+        SLVec3f center(pos(rng), pos(rng), pos(rng));
+        for (SLint v = 0; v < 3; ++v)
+        {
+            mesh->P.push_back(center + SLVec3f(pos(rng), pos(rng), pos(rng)) * size);
+            mesh->I32.push_back((SLuint)mesh->I32.size());
+        }
+    }
+
+    SLCamera* cam = new SLCamera("Soup camera");
+    cam->translation(0, 0, 4);
+    cam->lookAt(0, 0, 0);
+    cam->focalDist(4);
+    cam->setInitialState();
+
+    SLLightSpot* light = new SLLightSpot(3, 3, 3, 0.2f);
+    light->attenuation(1, 0, 0);
+
+    SLNode* scene = new SLNode("Soup scene");
+    scene->addChild(cam);
+    scene->addChild(light);
+    scene->addChild(new SLNode(mesh, "Soup node"));
+
+    s->root3D(scene);
+    sv->camera(cam);
+    sv->onInitialize();
+}
+//-----------------------------------------------------------------------------
+/*!
+Measures the throughput of a ray pass that is executed over all tiles with
+the render pool. The pass function returns the NO. of rays of a tile. The
+pass is repeated and the best time counts because it is the least disturbed
+by other processes.
+*/
+static BenchRays measurePass(SLRenderPool&                        pool,
+                             const SLVRenderTile&                 tiles,
+                             SLuint                               threads,
+                             SLint                                repeat,
+                             const function<SLuint(SLRenderTile)> pass)
+{
+    BenchRays result;
+    SLScene*  s = SLApplication::scene;
+
+    for (SLint r = 0; r < repeat; ++r)
+    {
+        // every run starts with empty occluder caches like a rendered frame
+        SLLight::newShadowFrame();
+
+        std::atomic<SLuint64> rays(0);
+        double                t1 = s->timeSec();
+
+        pool.run((SLuint)tiles.size(),
+                 [&](SLuint task, SLuint worker) {
+                     rays += pass(tiles[task]);
+                 },
+                 threads);
+
+        SLfloat sec = (SLfloat)(s->timeSec() - t1);
+        if (r == 0 || sec < result.sec) result.sec = sec;
+        result.rays = rays;
+    }
+    return result;
+}
+//-----------------------------------------------------------------------------
+//! Runs all measurements on the loaded scene
+static BenchResult benchScene(SLSceneView* sv, const BenchOptions& opt)
+{
+    SLScene*     s  = SLApplication::scene;
+    SLRaytracer* rt = sv->raytracer();
+    BenchResult  res;
+    res.name = s->name();
+
+    // Rebuild all acceleration structures from scratch
+    for (auto mesh : s->meshes())
+    {
+        if (opt.accel != AST_auto) mesh->accelStructType(opt.accel);
+        mesh->accelStructOutOfDate(true);
+    }
+
+    double t1 = s->timeSec();
+    for (auto mesh : s->meshes())
+        mesh->updateAccelStruct();
+    res.accelBuildSec = (SLfloat)(s->timeSec() - t1);
+
+    t1 = s->timeSec();
+    s->sceneBVH().build(s->root3D());
+    res.sceneBVHSec   = (SLfloat)(s->timeSec() - t1);
+    res.sceneBVHBytes = s->sceneBVH().numBytes();
+
+    res.stats.clear();
+    s->root3D()->statsRec(res.stats);
+
+    // Full rendering without antialiasing for stable ray counts
+    rt->numThreads(opt.threads);
+    rt->maxDepth(opt.depth);
+    rt->aaSamples(1);
+
+    for (SLint r = 0; r < opt.repeat; ++r)
+    {
+        SLSampler::seed(opt.seed);
+        rt->renderDistrib(sv);
+        if (r == 0 || rt->renderSec() < res.renderSec) res.renderSec = rt->renderSec();
+        res.renderRays = rt->stats().totalRays();
+    }
+
+    // The isolated passes use the camera setup of the last rendering
+    SLint         w = opt.width;
+    SLint         h = opt.height;
+    SLVRenderTile tiles;
+    SLRenderPool  pool;
+    SLRenderPool::hilbertTiles(w, h, SL_RENDER_TILE_SIZE, tiles);
+    vector<SLRay> hits((size_t)(w * h), SLRay(sv));
+
+    // Primary rays: intersection only
+    res.primary = measurePass(pool, tiles, opt.threads, opt.repeat, [&](SLRenderTile tile) {
+        for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+            for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+            {
+                SLRay& ray = hits[(size_t)(y * w + x)];
+                ray        = SLRay(sv);
+                rt->setPrimaryRay((SLfloat)x, (SLfloat)y, &ray);
+                s->hit(&ray);
+            }
+        return (SLuint)(tile.w * tile.h);
+    });
+
+    // Primary rays as packets of 2x2 pixels (see SLRaytracer::renderPacket)
+    if (s->sceneBVH().isEnabled())
+    {
+        vector<SLRay> packetHits((size_t)(w * h), SLRay(sv));
+
+        res.primaryPacket = measurePass(pool, tiles, opt.threads, opt.repeat, [&](SLRenderTile tile) {
+            for (SLint y = tile.y; y < tile.y + tile.h; y += 2)
+                for (SLint x = tile.x; x < tile.x + tile.w; x += 2)
+                {
+                    SLRay*      active[4];
+                    SLint       numRays = 0;
+                    SLRayPacket packet;
+
+                    for (SLint py = y; py < y + 2 && py < tile.y + tile.h; ++py)
+                        for (SLint px = x; px < x + 2 && px < tile.x + tile.w; ++px)
+                        {
+                            SLRay& ray = packetHits[(size_t)(py * w + px)];
+                            ray        = SLRay(sv);
+                            rt->setPrimaryRay((SLfloat)px, (SLfloat)py, &ray);
+                            active[numRays++] = &ray;
+                        }
+
+                    packet.set(active, numRays);
+                    s->hitPacket(packet);
+                }
+            return (SLuint)(tile.w * tile.h);
+        });
+    }
+
+    // Calculate the hit points & normals outside of the measurements
+    pool.run((SLuint)tiles.size(),
+             [&](SLuint task, SLuint worker) {
+                 const SLRenderTile& tile = tiles[task];
+                 for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+                     for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+                     {
+                         SLRay& ray = hits[(size_t)(y * w + x)];
+                         if (ray.length < FLT_MAX) ray.hitMesh->preShade(&ray);
+                     }
+             },
+             opt.threads);
+
+    // Shadow rays: one any-hit query per primary hit and light
+    res.shadow = measurePass(pool, tiles, opt.threads, opt.repeat, [&](SLRenderTile tile) {
+        SLuint num = 0;
+        SLLight::newShadowTile();
+        for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+            for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+            {
+                SLRay& ray = hits[(size_t)(y * w + x)];
+                if (ray.length == FLT_MAX) continue;
+
+                for (auto light : s->lights())
+                {
+                    if (!light->isOn()) continue;
+
+                    SLVec4f lightPos = light->positionWS();
+                    SLVec3f L;
+                    SLfloat lightDist;
+                    if (lightPos.w == 0.0f)
+                    {
+                        L         = -light->spotDirWS();
+                        lightDist = FLT_MAX;
+                        L.normalize();
+                    }
+                    else
+                    {
+                        L.sub(lightPos.vec3(), ray.hitPoint);
+                        lightDist = L.length();
+                        L /= lightDist;
+                    }
+
+                    SLRay shadowRay(lightDist, L, &ray);
+                    light->isOccluded(&shadowRay);
+                    num++;
+                }
+            }
+        return num;
+    });
+
+    // Secondary rays: one reflected ray per primary hit
+    res.secondary = measurePass(pool, tiles, opt.threads, opt.repeat, [&](SLRenderTile tile) {
+        SLuint num = 0;
+        for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+            for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+            {
+                SLRay& ray = hits[(size_t)(y * w + x)];
+                if (ray.length == FLT_MAX) continue;
+
+                SLRay reflected(sv);
+                ray.reflect(&reflected);
+                s->hit(&reflected);
+                num++;
+            }
+        return num;
+    });
+
+    return res;
+}
+//-----------------------------------------------------------------------------
+//! Returns the result of one scene as JSON object on one line
+static SLstring resultToJSON(const BenchResult& r)
+{
+    auto rays = [](const BenchRays& b) {
+        stringstream ss;
+        ss << "{\"rays\": " << b.rays
+           << ", \"sec\": " << b.sec
+           << ", \"mraysPerSec\": " << b.mraysPerSec() << "}";
+        return ss.str();
+    };
+
+    stringstream json;
+    json << "{\"name\": \"" << r.name << "\""
+         << ", \"triangles\": " << r.stats.numTriangles
+         << ", \"meshes\": " << r.stats.numMeshes
+         << ", \"instances\": " << r.stats.numInstances
+         << ", \"meshBytes\": " << r.stats.numBytes
+         << ", \"accelBytes\": " << r.stats.numBytesAccel
+         << ", \"sceneBVHBytes\": " << r.sceneBVHBytes
+         << ", \"accelBuildSec\": " << r.accelBuildSec
+         << ", \"sceneBVHSec\": " << r.sceneBVHSec
+         << ", \"renderSec\": " << r.renderSec
+         << ", \"renderMraysPerSec\": " << (r.renderSec > 0.0f ? r.renderRays / r.renderSec / 1.0e6f : 0.0f)
+         << ", \"primary\": " << rays(r.primary)
+         << ", \"primaryPacket\": " << rays(r.primaryPacket)
+         << ", \"shadow\": " << rays(r.shadow)
+         << ", \"secondary\": " << rays(r.secondary)
+         << "}";
+    return json.str();
+}
+//-----------------------------------------------------------------------------
+//! Returns the value of "key": {... "mraysPerSec": value} within a JSON line
+static SLfloat mraysOfKey(const SLstring& line, const SLstring& key)
+{
+    size_t k = line.find("\"" + key + "\"");
+    if (k == SLstring::npos) return 0.0f;
+    size_t m = line.find("\"mraysPerSec\": ", k);
+    if (m == SLstring::npos) return 0.0f;
+    return (SLfloat)atof(line.c_str() + m + 15);
+}
+//-----------------------------------------------------------------------------
+/*!
+Compares the Mrays/s of all results with the baseline file of a previous run.
+The baseline is read line by line because every scene result is written on
+its own line. Returns the NO. of measurements that got slower than allowed or
+-1 if the baseline file can't be read.
+*/
+static SLint compareBaseline(const vector<BenchResult>& results,
+                             const BenchOptions&        opt)
+{
+    ifstream file(opt.baseline);
+    if (!file.is_open())
+    {
+        fprintf(stderr, "Baseline file not found: %s\n", opt.baseline.c_str());
+        return -1;
+    }
+
+    SLint    numSlower = 0;
+    SLstring line;
+    while (getline(file, line))
+    {
+        for (auto& r : results)
+        {
+            if (line.find("{\"name\": \"" + r.name + "\"") == SLstring::npos)
+                continue;
+
+            const char*      keys[]    = {"primary", "primaryPacket", "shadow", "secondary"};
+            const BenchRays* current[] = {&r.primary, &r.primaryPacket, &r.shadow, &r.secondary};
+
+            for (SLint i = 0; i < 4; ++i)
+            {
+                SLfloat base = mraysOfKey(line, keys[i]);
+                SLfloat now  = current[i]->mraysPerSec();
+                if (base > 0.0f && now < base * (1.0f - opt.threshold))
+                {
+                    fprintf(stderr,
+                            "Regression %s %s: %.3f Mrays/s (baseline %.3f)\n",
+                            r.name.c_str(),
+                            keys[i],
+                            now,
+                            base);
+                    numSlower++;
+                }
+            }
+        }
+    }
+    return numSlower;
+}
+//-----------------------------------------------------------------------------
+//! Returns true if the scene is selected with the -scenes option
+static SLbool isSelected(const BenchOptions& opt, const SLstring& name)
+{
+    return opt.filter.empty() ||
+           std::find(opt.filter.begin(), opt.filter.end(), name) != opt.filter.end();
+}
+//-----------------------------------------------------------------------------
+/*!
+The benchmark runs headless like the batch renderer (see AppDemoMainBatch.cpp).
+All random generators are seeded before every scene so that the generated
+scenes and the sampled rays are the same in every run. The process returns 1
+if a measurement got slower than the baseline allows and 2 if the baseline
+file is missing.
+*/
+int main(int argc, char* argv[])
+{
+    BenchOptions opt;
+    if (!parseArgs(argc, argv, opt))
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Default paths for all loaded resources (see slCreateAppAndScene)
+    SLstring projectRoot          = SLstring(SL_PROJECT_ROOT);
+    SLGLProgram::defaultPath      = projectRoot + "/data/shaders/";
+    SLGLTexture::defaultPath      = projectRoot + "/data/images/textures/";
+    SLGLTexture::defaultPathFonts = projectRoot + "/data/images/fonts/";
+    SLAssimpImporter::defaultPath = projectRoot + "/data/models/";
+    SLCVCapture::videoDefaultPath = projectRoot + "/data/videos/";
+    SLCVCalibration::calibIniPath = projectRoot + "/data/calibrations/";
+    SLApplication::configPath     = SLFileSystem::getAppsWritableDir();
+
+    SLApplication::createAppAndScene("AppDemoBench", (void*)appDemoLoadScene);
+    SLScene* s = SLApplication::scene;
+
+    SLSceneView* sv = new SLSceneView();
+    sv->init("BenchView", opt.width, opt.height, nullptr, nullptr, nullptr);
+    if (!SLApplication::dpi) SLApplication::dpi = 142;
+
+    vector<BenchResult> results;
+
+    for (auto& bs : benchScenes)
+    {
+        if (!isSelected(opt, bs.name)) continue;
+
+        srand(opt.seed);
+        SLSampler::seed(opt.seed);
+        s->onLoad(s, sv, bs.id);
+
+        if (!s->root3D() || !sv->camera() || s->meshes().empty())
+        {
+            fprintf(stderr, "Skipped scene %s without geometry.\n", bs.name);
+            continue;
+        }
+
+        results.push_back(benchScene(sv, opt));
+        results.back().name = bs.name;
+    }
+
+    for (auto numTriangles : opt.soups)
+    {
+        SLstring name = "Soup" + std::to_string(numTriangles);
+        if (!isSelected(opt, name)) continue;
+
+        srand(opt.seed);
+        SLSampler::seed(opt.seed);
+        loadTriangleSoup(s, sv, numTriangles, opt.seed);
+
+        results.push_back(benchScene(sv, opt));
+        results.back().name = name;
+    }
+
+    stringstream json;
+    json << "{\n"
+         << "  \"benchmark\": \"raytracing\",\n"
+         << "  \"width\": " << opt.width << ",\n"
+         << "  \"height\": " << opt.height << ",\n"
+         << "  \"threads\": " << sv->raytracer()->numThreads() << ",\n"
+         << "  \"repeat\": " << opt.repeat << ",\n"
+         << "  \"seed\": " << opt.seed << ",\n"
+         << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+        json << "    " << resultToJSON(results[i])
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    json << "  ]\n"
+         << "}\n";
+
+    if (opt.jsonFile.empty())
+        printf("%s", json.str().c_str());
+    else
+    {
+        ofstream file(opt.jsonFile);
+        file << json.str();
+    }
+
+    SLint numSlower = opt.baseline.empty() ? 0 : compareBaseline(results, opt);
+
+    SLApplication::deleteAppAndScene();
+    if (numSlower < 0) return 2;
+    return numSlower ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+//-----------------------------------------------------------------------------
@@ -32,6 +32,7 @@
 #include <SLMaterial.h>
 #include <SLMesh.h>
 #include <SLNode.h>
+#include <SLSampler.h>
 #include <SLScene.h>
 #include <SLSceneView.h>
 #include <SLTransferFunction.h>
@@ -307,29 +308,34 @@ void AppDemoGui::build(SLScene* s, SLSceneView* sv)
         }
         else if (rType == RT_rt)
         {
-            SLRaytracer* rt           = sv->raytracer();
-            SLuint       rayPrimaries = (SLuint)(sv->scrW() * sv->scrH());
-            SLuint       rayTotal     = rayPrimaries + SLRay::reflectedRays + SLRay::subsampledRays + SLRay::refractedRays + SLRay::shadowRays;
-            SLfloat      rpms         = rt->renderSec() > 0.0f ? rayTotal / rt->renderSec() / 1000.0f : 0.0f;
+            SLRaytracer*      rt           = sv->raytracer();
+            const SLRayStats& st           = rt->stats();
+            SLuint            rayPrimaries = SL_max(st.primaryRays, (SLuint)1);
+            SLuint            rayTotal     = SL_max(st.totalRays(), (SLuint)1);
+            SLfloat           rpms         = rt->renderSec() > 0.0f ? rayTotal / rt->renderSec() / 1000.0f : 0.0f;
 
             sprintf(m + strlen(m), "Renderer      : Ray Tracer\n");
             sprintf(m + strlen(m), "Frame size    : %d x %d\n", sv->scrW(), sv->scrH());
             sprintf(m + strlen(m), "Frames per s. : %0.2f\n", 1.0f / rt->renderSec());
             sprintf(m + strlen(m), "Frame Time    : %0.2f sec.\n", rt->renderSec());
             sprintf(m + strlen(m), "Rays per ms   : %0.0f\n", rpms);
-            sprintf(m + strlen(m), "AA Pixels     : %d (%d%%)\n", SLRay::subsampledPixels, (int)((float)SLRay::subsampledPixels / (float)rayPrimaries * 100.0f));
+            sprintf(m + strlen(m), "Tests per ray : %0.1f\n", st.testsPerRay());
+            sprintf(m + strlen(m), "AA Pixels     : %d (%d%%)\n", st.subsampledPixels, (int)((float)st.subsampledPixels / (float)rayPrimaries * 100.0f));
             sprintf(m + strlen(m), "Threads       : %d\n", rt->numThreads());
             sprintf(m + strlen(m), "-------------------------------\n");
-            sprintf(m + strlen(m), "Primary rays  : %8d (%3d%%)\n", rayPrimaries, (int)((float)rayPrimaries / (float)rayTotal * 100.0f));
-            sprintf(m + strlen(m), "Reflected rays: %8d (%3d%%)\n", SLRay::reflectedRays, (int)((float)SLRay::reflectedRays / (float)rayTotal * 100.0f));
-            sprintf(m + strlen(m), "Refracted rays: %8d (%3d%%)\n", SLRay::refractedRays, (int)((float)SLRay::refractedRays / (float)rayTotal * 100.0f));
-            sprintf(m + strlen(m), "TIR rays      : %8d\n", SLRay::tirRays);
-            sprintf(m + strlen(m), "Shadow rays   : %8d (%3d%%)\n", SLRay::shadowRays, (int)((float)SLRay::shadowRays / (float)rayTotal * 100.0f));
-            sprintf(m + strlen(m), "AA rays       : %8d (%3d%%)\n", SLRay::subsampledRays, (int)((float)SLRay::subsampledRays / (float)rayTotal * 100.0f));
-            sprintf(m + strlen(m), "Total rays    : %8d (%3d%%)\n", rayTotal, 100);
+            sprintf(m + strlen(m), "Primary rays  : %8d (%3d%%)\n", st.primaryRays, (int)((float)st.primaryRays / (float)rayTotal * 100.0f));
+            sprintf(m + strlen(m), "Reflected rays: %8d (%3d%%)\n", st.reflectedRays, (int)((float)st.reflectedRays / (float)rayTotal * 100.0f));
+            sprintf(m + strlen(m), "Refracted rays: %8d (%3d%%)\n", st.refractedRays, (int)((float)st.refractedRays / (float)rayTotal * 100.0f));
+            sprintf(m + strlen(m), "TIR rays      : %8d\n", st.tirRays);
+            sprintf(m + strlen(m), "Shadow rays   : %8d (%3d%%)\n", st.shadowRays, (int)((float)st.shadowRays / (float)rayTotal * 100.0f));
+            sprintf(m + strlen(m), "AA rays       : %8d (%3d%%)\n", st.subsampledRays, (int)((float)st.subsampledRays / (float)rayTotal * 100.0f));
+            sprintf(m + strlen(m), "Total rays    : %8d (%3d%%)\n", st.totalRays(), 100);
             sprintf(m + strlen(m), "-------------------------------\n");
-            sprintf(m + strlen(m), "Maximum depth : %u\n", SLRay::maxDepthReached);
-            sprintf(m + strlen(m), "Average depth : %0.3f\n", SLRay::avgDepth / rayPrimaries);
+            sprintf(m + strlen(m), "Maximum depth : %u\n", st.maxDepthReached);
+            sprintf(m + strlen(m), "Average depth : %0.3f\n", st.avgDepth());
+            for (SLint d = 0; d < SL_RAYSTATS_DEPTH_BINS; ++d)
+                if (st.depthHistogram[d])
+                    sprintf(m + strlen(m), "  Depth %2d%s   : %8d (%3d%%)\n", d + 1, d == SL_RAYSTATS_DEPTH_BINS - 1 ? "+" : " ", st.depthHistogram[d], (int)((float)st.depthHistogram[d] / (float)rayPrimaries * 100.0f));
         }
 
         ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[1]);
@@ -389,6 +395,7 @@ void AppDemoGui::build(SLScene* s, SLSceneView* sv)
         sprintf(m + strlen(m), "- Visible Nodes : %5d (%3d%%)\n", numVisibleNodes, numVisiblePC);
         sprintf(m + strlen(m), "- WM Updates    : %5d\n", SLNode::numWMUpdates);
         sprintf(m + strlen(m), "No. of Meshes   : %5u\n", stats3D.numMeshes);
+        sprintf(m + strlen(m), "- Instances     : %5u\n", stats3D.numInstances);
         sprintf(m + strlen(m), "No. of Triangles: %5u\n", stats3D.numTriangles);
         sprintf(m + strlen(m), "CPU MB in Total : %6.2f (100%%)\n", cpuMBTotal);
         sprintf(m + strlen(m), "-   MB in Tex.  : %6.2f (%3d%%)\n", cpuMBTexture, cpuMBTexturePC);
@@ -935,6 +942,8 @@ void AppDemoGui::buildMenuBar(SLScene* s, SLSceneView* sv)
                         s->onLoad(s, sv, SID_RTLens);
                     if (ImGui::MenuItem("RT Test", nullptr, sid == SID_RTTest))
                         s->onLoad(s, sv, SID_RTTest);
+                    if (ImGui::MenuItem("Massive Instances", nullptr, sid == SID_RTInstances))
+                        s->onLoad(s, sv, SID_RTInstances);
 
                     ImGui::EndMenu();
                 }
@@ -977,6 +986,13 @@ void AppDemoGui::buildMenuBar(SLScene* s, SLSceneView* sv)
             if (ImGui::MenuItem("Animation off", "O", s->stopAnimations()))
                 s->stopAnimations(!s->stopAnimations());
 
+            SLTransformStore& ts = s->transformStore();
+            if (ImGui::MenuItem("Do Transform Store", nullptr, ts.isEnabled()))
+                ts.isEnabled(!ts.isEnabled());
+
+            if (ImGui::MenuItem("Do GPU Skinning", nullptr, s->doGPUSkinning()))
+                s->doGPUSkinning(!s->doGPUSkinning());
+
             ImGui::Separator();
 
             if (ImGui::BeginMenu("Rotation Sensor"))
@@ -1124,6 +1140,9 @@ void AppDemoGui::buildMenuBar(SLScene* s, SLSceneView* sv)
             if (ImGui::MenuItem("Path Tracing (PT)", nullptr, rType == RT_pt))
                 sv->startPathtracing(5, 10);
 
+            if (ImGui::MenuItem("Photon Mapping (PM)", nullptr, rType == RT_pm))
+                sv->startPhotonMapping(5);
+
             ImGui::EndMenu();
         }
 
@@ -1191,6 +1210,58 @@ void AppDemoGui::buildMenuBar(SLScene* s, SLSceneView* sv)
                 if (ImGui::MenuItem("Continuously", nullptr, rt->doContinuous()))
                     rt->doContinuous(!rt->doContinuous());
 
+                if (ImGui::MenuItem("Progressive", nullptr, rt->doProgressive(), !rt->doContinuous()))
+                {
+                    rt->doProgressive(!rt->doProgressive());
+                    sv->startRaytracing(rt->maxDepth());
+                }
+
+                SLSceneBVH& bvh = s->sceneBVH();
+                if (ImGui::MenuItem("Scene BVH", nullptr, bvh.isEnabled()))
+                {
+                    bvh.isEnabled(!bvh.isEnabled());
+                    sv->startRaytracing(rt->maxDepth());
+                }
+
+                if (ImGui::MenuItem("Packet Tracing", nullptr, rt->doPackets(), bvh.isEnabled()))
+                {
+                    rt->doPackets(!rt->doPackets());
+                    sv->startRaytracing(rt->maxDepth());
+                }
+
+                if (ImGui::BeginMenu("Mesh Accel. Struct"))
+                {
+                    static SLAccelStructType ast    = AST_auto;
+                    SLAccelStructType        newAST = ast;
+
+                    if (ImGui::MenuItem("Auto", nullptr, ast == AST_auto))
+                        newAST = AST_auto;
+                    if (ImGui::MenuItem("Compact Grid", nullptr, ast == AST_compactGrid))
+                        newAST = AST_compactGrid;
+                    if (ImGui::MenuItem("BVH", nullptr, ast == AST_BVH))
+                        newAST = AST_BVH;
+
+                    if (newAST != ast)
+                    {
+                        ast = newAST;
+                        for (auto mesh : s->meshes())
+                            mesh->accelStructType(ast);
+                        sv->startRaytracing(rt->maxDepth());
+                    }
+
+                    ImGui::Separator();
+
+                    static SLbool keepSize = false;
+                    if (ImGui::MenuItem("Keep Size of Animated Grids", nullptr, keepSize))
+                    {
+                        keepSize = !keepSize;
+                        for (auto mesh : s->meshes())
+                            mesh->accelStructKeepSize(keepSize);
+                    }
+
+                    ImGui::EndMenu();
+                }
+
                 if (ImGui::MenuItem("Fresnel Reflection", nullptr, rt->doFresnel()))
                 {
                     rt->doFresnel(!rt->doFresnel());
@@ -1278,18 +1349,112 @@ void AppDemoGui::buildMenuBar(SLScene* s, SLSceneView* sv)
                     sv->startPathtracing(5, 10);
                 }
 
+                if (ImGui::MenuItem("Russian Roulette", nullptr, pt->doRussianRoulette()))
+                {
+                    pt->doRussianRoulette(!pt->doRussianRoulette());
+                    sv->startPathtracing(5, 10);
+                }
+
+                if (ImGui::BeginMenu("Sampler"))
+                {
+                    SLSamplerType st = SLSampler::type();
+                    if (ImGui::MenuItem("Random (PCG32)", nullptr, st == ST_random))
+                        SLSampler::type(ST_random);
+                    if (ImGui::MenuItem("Halton", nullptr, st == ST_halton))
+                        SLSampler::type(ST_halton);
+                    if (ImGui::MenuItem("Sobol", nullptr, st == ST_sobol))
+                        SLSampler::type(ST_sobol);
+                    if (st != SLSampler::type())
+                        sv->startPathtracing(5, pt->aaSamples());
+
+                    ImGui::EndMenu();
+                }
+
+                if (ImGui::MenuItem("Denoising", nullptr, pt->doDenoise()))
+                {
+                    pt->doDenoise(!pt->doDenoise());
+                    if (pt->doDenoise() && !pt->denoiser().isValid() && pt->state() == rtFinished)
+                        pt->denoise();
+                    else
+                        pt->updateDisplayImage();
+                }
+
+                if (ImGui::MenuItem("Tone Mapping (Reinhard)", nullptr, pt->doToneMapping()))
+                {
+                    pt->doToneMapping(!pt->doToneMapping());
+                    pt->updateDisplayImage();
+                }
+
                 if (ImGui::MenuItem("Save Rendered Image"))
                     pt->saveImage();
 
+                if (ImGui::MenuItem("Save HDR Image (PFM)"))
+                    pt->saveHDRImage();
+
                 ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.65f);
                 SLfloat gamma = pt->gamma();
                 if (ImGui::SliderFloat("Gamma", &gamma, 0.1f, 3.0f, "%.1f"))
                 {
                     pt->gamma(gamma);
-                    sv->startPathtracing(5, 1);
+                    pt->updateDisplayImage();
+                }
+                SLfloat exposure = pt->exposure();
+                if (ImGui::SliderFloat("Exposure", &exposure, 0.1f, 10.0f, "%.1f", 2.0f))
+                {
+                    pt->exposure(exposure);
+                    pt->updateDisplayImage();
+                }
+                ImGui::PopItemWidth();
+
+                ImGui::EndMenu();
+            }
+        }
+        else if (rType == RT_pm)
+        {
+            if (ImGui::BeginMenu("PM-Settings"))
+            {
+                SLPhotonMapper* pm = sv->photonMapper();
+
+                if (ImGui::BeginMenu("NO. of Photons"))
+                {
+                    if (ImGui::MenuItem("10000", nullptr, pm->numPhotons() == 10000))
+                        pm->numPhotons(10000);
+                    if (ImGui::MenuItem("100000", nullptr, pm->numPhotons() == 100000))
+                        pm->numPhotons(100000);
+                    if (ImGui::MenuItem("200000", nullptr, pm->numPhotons() == 200000))
+                        pm->numPhotons(200000);
+                    if (ImGui::MenuItem("1000000", nullptr, pm->numPhotons() == 1000000))
+                        pm->numPhotons(1000000);
+                    if (ImGui::MenuItem("5000000", nullptr, pm->numPhotons() == 5000000))
+                        pm->numPhotons(5000000);
+
+                    ImGui::EndMenu();
                 }
+
+                if (ImGui::MenuItem("Global Illumination", nullptr, pm->doGlobalIllum()))
+                {
+                    pm->doGlobalIllum(!pm->doGlobalIllum());
+                    sv->startPhotonMapping(pm->maxDepth());
+                }
+
+                if (ImGui::MenuItem("Cache Photons", nullptr, pm->doPhotonCaching()))
+                    pm->doPhotonCaching(!pm->doPhotonCaching());
+
+                if (ImGui::MenuItem("Save Rendered Image"))
+                    pm->saveImage();
+
+                ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.65f);
+                SLfloat causticR = pm->causticRadius();
+                if (ImGui::SliderFloat("Caustic Radius", &causticR, 0.001f, 0.1f, "%.3f"))
+                    pm->causticRadius(causticR);
+                SLfloat globalR = pm->globalRadius();
+                if (ImGui::SliderFloat("Global Radius", &globalR, 0.001f, 0.2f, "%.3f"))
+                    pm->globalRadius(globalR);
                 ImGui::PopItemWidth();
 
+                if (ImGui::MenuItem("Render again"))
+                    sv->startPhotonMapping(pm->maxDepth());
+
                 ImGui::EndMenu();
             }
         }
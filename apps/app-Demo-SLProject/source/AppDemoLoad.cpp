@@ -2701,7 +2701,7 @@ void appDemoLoadScene(SLScene* s, SLSceneView* sv, SLSceneID sceneID)
 #endif
 
         stringstream ss;
-        ss << "Ray tracing with depth of field blur. Each pixel is sampled " << numSamples * numSamples << "x from a lens. Be patient on mobile devices.";
+        ss << "Ray tracing with depth of field blur. Each pixel is sampled up to " << numSamples * numSamples << "x from a lens. Be patient on mobile devices.";
         s->info(ss.str());
 
         SLCamera* cam1 = new SLCamera("Camera 1");
@@ -2870,6 +2870,57 @@ void appDemoLoadScene(SLScene* s, SLSceneView* sv, SLSceneID sceneID)
         // Set active camera
         sv->camera(cam1);
     }
+    else if (SLApplication::sceneID == SID_RTInstances) //...............................................
+    {
+        s->name("Ray tracing massive instances");
+        s->info("100'000 instances of one sphere with 100'000 triangles. The mesh and its acceleration structure exist only once. The scene BVH is built over the instances. The scene is too large for OpenGL and gets ray traced continuously.");
+
+        SLCamera* cam1 = new SLCamera("Camera 1");
+        cam1->clipNear(0.1f);
+        cam1->clipFar(200);
+        cam1->translation(30, 25, 50);
+        cam1->lookAt(0, 0, 0);
+        cam1->focalDist(cam1->translationOS().length());
+        cam1->background().colors(SLCol4f(0.1f, 0.1f, 0.1f));
+        cam1->setInitialState();
+
+        SLLightSpot* light1 = new SLLightSpot(0.3f);
+        light1->translation(40, 60, 80);
+        light1->lookAt(0, 0, 0);
+        light1->ambient(SLCol4f(0.2f, 0.2f, 0.2f));
+        light1->diffuse(SLCol4f(0.8f, 0.8f, 0.8f));
+        light1->specular(SLCol4f(1, 1, 1));
+        light1->attenuation(1, 0, 0);
+
+        SLNode* scene = new SLNode("scene node");
+        scene->addChild(cam1);
+        scene->addChild(light1);
+
+        // One sphere mesh with 2 x 224 x 224 triangles is shared by all nodes
+        SLMaterial* mat    = new SLMaterial("matInstance", SLCol4f(0.2f, 0.4f, 0.8f), SLCol4f(0.5f, 0.5f, 0.5f), 100, 0.0f, 0.0f, 1.0f);
+        SLuint      res    = 224;
+        SLSphere*   sphere = new SLSphere(0.4f, res, res, "sphere", mat);
+
+        // create 50 x 40 x 50 instances of the sphere
+        for (SLint iZ = 0; iZ < 50; ++iZ)
+        {
+            for (SLint iY = 0; iY < 40; ++iY)
+            {
+                for (SLint iX = 0; iX < 50; ++iX)
+                {
+                    SLNode* instance = new SLNode(sphere, "instance");
+                    instance->translate((SLfloat)iX - 24.5f,
+                                        (SLfloat)iY - 19.5f,
+                                        (SLfloat)iZ - 24.5f,
+                                        TS_object);
+                    scene->addChild(instance);
+                }
+            }
+        }
+
+        sv->camera(cam1);
+        s->root3D(scene);
+    }
 
     ////////////////////////////////////////////////////////////////////////////
     // call onInitialize on all scene views to init the scenegraph and stats
@@ -2878,6 +2929,13 @@ void appDemoLoadScene(SLScene* s, SLSceneView* sv, SLSceneID sceneID)
         if (sv != nullptr)
         {
             sv->onInitialize();
+
+            // The instances are too many triangles for OpenGL
+            if (SLApplication::sceneID == SID_RTInstances)
+            {
+                sv->startRaytracing(1);
+                sv->raytracer()->doContinuous(true);
+            }
         }
     }
 
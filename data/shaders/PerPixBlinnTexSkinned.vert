@@ -18,7 +18,10 @@ attribute   vec4  a_jointWeights;// Vertex joint weights attributes
 uniform     mat4  u_mvMatrix;    // modelview matrix 
 uniform     mat3  u_nMatrix;     // normal matrix=transpose(inverse(mv))
 uniform     mat4  u_mvpMatrix;   // = projection * modelView
-uniform     mat4  u_jointMatrices[100]; // joint matrices for skinning
+layout (std140) uniform u_jointBlock // joint matrices for skinning
+{
+    mat4 u_jointMatrices[256];     // see SLSkeleton::bindJointBuffer
+};
 
 varying     vec3  v_P_VS;        // Point of illumination in view space (VS)
 varying     vec3  v_N_VS;        // Normal at P_VS in view space
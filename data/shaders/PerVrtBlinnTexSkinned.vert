@@ -9,8 +9,6 @@
 //             Please visit: http://opensource.org/licenses/GPL-3.0
 //#############################################################################
 
-#version 150
-
 //-----------------------------------------------------------------------------
 attribute vec4 a_position;          // Vertex position attribute
 attribute vec3 a_normal;            // Vertex normal attribute
@@ -21,7 +19,10 @@ attribute vec4 a_jointWeights;      // Vertex joint weights attributes
 uniform mat4   u_mvMatrix;          // modelview matrix 
 uniform mat3   u_nMatrix;           // normal matrix=transpose(inverse(mv))
 uniform mat4   u_mvpMatrix;         // = projection * modelView
-uniform mat4   u_jointMatrices[100];// joint matrices for vertex skinning
+layout (std140) uniform u_jointBlock // joint matrices for vertex skinning
+{
+    mat4 u_jointMatrices[256];       // see SLSkeleton::bindJointBuffer
+};
 
 uniform int    u_numLightsUsed;     // NO. of lights used light arrays
 uniform bool   u_lightIsOn[8];      // flag if light is on
@@ -42,7 +43,6 @@ uniform vec4   u_matDiffuse;        // diffuse color reflection coefficient (kd)
 uniform vec4   u_matSpecular;       // specular color reflection coefficient (ks)
 uniform vec4   u_matEmissive;       // emissive color for selfshining materials
 uniform float  u_matShininess;      // shininess exponent
-uniform float  u_oneOverGamma;      // 1.0f / Gamma correction value
 
 varying vec4   v_color;             // Ambient & diffuse color at vertex
 varying vec4   v_specColor;         // Specular color at vertex
@@ -209,9 +209,6 @@ void main()
     // For correct alpha blending overwrite alpha component
     v_color.a = u_matDiffuse.a;
 
-    // Apply gamma correction
-    v_color.rgb = pow(v_color.rgb, vec3(u_oneOverGamma));
-
     // Transform the vertex with the modelview and joint matrix
     gl_Position = u_mvpMatrix * jm * a_position;
 }
@@ -67,6 +67,7 @@ class SLGLProgram : public SLObject
 
     void addUniform1f(SLGLUniform1f* u); //!< add float uniform
     void addUniform1i(SLGLUniform1i* u); //!< add int uniform
+    void addUniformBlock(const SLstring& name, SLuint binding);
 
     //Getters
     SLuint       programObjectGL() { return _objectGL; }
@@ -121,6 +122,9 @@ class SLGLProgram : public SLObject
                            SLsizei        count,
                            const SLfloat* value,
                            GLboolean      transpose = false);
+
+    SLint uniformBlockBinding(const SLchar* name, SLuint binding);
+
     // statics
     static SLstring defaultPath; //!< default path for GLSL programs
 
@@ -131,6 +135,8 @@ class SLGLProgram : public SLObject
     SLVGLShader  _shaders;    //!< Vector of all shader objects
     SLVUniform1f _uniforms1f; //!< Vector of uniform1f variables
     SLVUniform1i _uniforms1i; //!< Vector of uniform1i variables
+
+    std::map<SLstring, SLuint> _uniformBlocks; //!< Uniform blocks with their binding points
 };
 //-----------------------------------------------------------------------------
 //! STL vector of SLGLProgram pointers
@@ -30,6 +30,10 @@ static const SLint SL_MAX_LIGHTS = 8; //!< max. number of used lights
  programs written in OpenGL Shading Language (GLSL).
  The second purpose is to concentrate OpenGL functionality and to reduce
  redundant state changes.
+ Without a current OpenGL context (e.g. in the headless batch renderer) the
+ version strings stay empty and hasContext returns false. The initialization,
+ the viewport and the error check then skip all OpenGL calls so that a scene
+ can be loaded and ray traced without any GPU.
  */
 class SLGLState
 {
@@ -143,6 +147,7 @@ class SLGLState
     SLstring glSLVersionNO() { return _glSLVersionNO; }
     SLbool   glIsES2() { return _glIsES2; }
     SLbool   glIsES3() { return _glIsES3; }
+    SLbool   hasContext() { return _hasContext; }
     SLbool   hasExtension(SLstring e) { return _glExtensions.find(e) != string::npos; }
 
     // stack operations
@@ -180,6 +185,7 @@ class SLGLState
     SLstring _glExtensions;  //!< OpenGL extensions string
     SLbool   _glIsES2;       //!< Flag if OpenGL ES2
     SLbool   _glIsES3;       //!< Flag if OpenGL ES3
+    SLbool   _hasContext;    //!< Flag if an OpenGL context is current
 
     // read/write states
     SLbool  _blend;                //!< blending default false;
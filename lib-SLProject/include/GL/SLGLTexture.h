@@ -14,7 +14,9 @@
 #include <SLCVImage.h>
 #include <SLGLVertexArray.h>
 #include <SLMat4.h>
+#include <SLTexCache.h>
 #include <atomic>
+#include <mutex>
 
 class SLGLState;
 
@@ -56,7 +58,8 @@ A simple 2D texture has just a single texture image (_images[0]). For cube maps
 you will need 6 images (_images[0-5]). For 3D textures you can have as much
 images of the same size than your GPU and/or CPU memory can hold.
 The images are not released after the OpenGL texture creation. They may be needed
-for ray tracing.
+for ray tracing. The ray tracers sample the images with getTexelf through a tiled
+mip pyramid per image (see SLTexCache) that is built on the first lookup.
 */
 class SLGLTexture : public SLObject
 {
@@ -121,7 +124,10 @@ class SLGLTexture : public SLObject
     SLuint        texName() { return _texName; }
     SLTextureType texType() { return _texType; }
     SLfloat       bumpScale() { return _bumpScale; }
-    SLCol4f       getTexelf(SLfloat s, SLfloat t, SLuint imgIndex = 0);
+    SLCol4f       getTexelf(SLfloat s,
+                            SLfloat t,
+                            SLuint  imgIndex  = 0,
+                            SLfloat footprint = 0.0f);
     SLCol4f       getTexelf(SLVec3f cubemapDir);
     SLbool        hasAlpha() { return (_images.size() &&
                                 ((_images[0]->format() == PF_rgba ||
@@ -149,6 +155,7 @@ class SLGLTexture : public SLObject
                                  SLbool        isTopLeft);
     void          calc3DGradients(SLint sampleRadius);
     void          smooth3DGradients(SLint smoothRadius);
+    void          deleteRTCaches();
 
     // Bumpmap methods
     SLVec2f dsdt(SLfloat s, SLfloat t); //! Returns the derivation as [s,t]
@@ -165,6 +172,7 @@ class SLGLTexture : public SLObject
               SLbool   flipVertical           = true,
               SLbool   loadGrayscaleIntoAlpha = false);
     void load(const SLVCol4f& colors);
+    const SLTexCache* rtCache(SLuint imgIndex);
 
     SLGLState*      _stateGL;      //!< Pointer to global SLGLState instance
     SLCVVImage      _images;       //!< vector of SLCVImage pointers
@@ -182,6 +190,10 @@ class SLGLTexture : public SLObject
     SLbool          _resizeToPow2; //!< Flag if image should be resized to n^2
     SLGLVertexArray _vaoSprite;    //!< Vertex array object for sprite rendering
     atomic<bool>    _needsUpdate;  //!< Flag if image needs an update
+
+    vector<SLTexCache*> _rtCaches;              //!< CPU side copies of the images for ray tracing
+    atomic<bool>        _rtCachesBuilt{false};  //!< Flag if the RT caches are built
+    std::mutex          _rtCacheMutex;          //!< Protects the lazy build of the RT caches
 };
 //-----------------------------------------------------------------------------
 //! STL vector of SLGLTexture pointers
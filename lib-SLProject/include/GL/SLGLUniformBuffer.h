@@ -0,0 +1,49 @@
+//#############################################################################
+//  File:      SLGLUniformBuffer.h
+//  Purpose:   Wrapper class around OpenGL Uniform Buffer Objects (UBO)
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLGLUNIFORMBUFFER_H
+#define SLGLUNIFORMBUFFER_H
+
+#include <SL.h>
+
+//-----------------------------------------------------------------------------
+//! SLGLUniformBuffer encapsulates an OpenGL buffer for a GLSL uniform block
+/*! The data of a uniform block is uploaded once with update and can then be
+used by all shader programs that bind the block to the same binding point
+(see SLGLProgram::uniformBlockBinding). Uniform buffers need OpenGL 3.1 or
+OpenGL ES 3.0. It is used e.g. for the joint matrices of a skeleton with GPU
+skinning (see SLSkeleton::bindJointBuffer).
+*/
+class SLGLUniformBuffer
+{
+    public:
+    SLGLUniformBuffer();
+    ~SLGLUniformBuffer() { deleteGL(); }
+
+    //! Deletes the OpenGL buffer object
+    void deleteGL();
+
+    //! Uploads sizeBytes of data into a buffer of bufferSizeBytes
+    void update(const void* data, SLuint sizeBytes, SLuint bufferSizeBytes);
+
+    //! Binds the buffer to a uniform buffer binding point
+    void bindBase(SLuint binding);
+
+    // Getters
+    SLuint id() { return _id; }
+
+    protected:
+    SLuint _id;        //! OpenGL id of the uniform buffer object
+    SLuint _sizeBytes; //! Total size of the buffer in bytes
+};
+//-----------------------------------------------------------------------------
+
+#endif
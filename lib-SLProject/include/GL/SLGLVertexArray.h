@@ -119,6 +119,13 @@ class SLGLVertexArray
     void updateAttrib(SLGLAttributeType type,
                       SLVVec4f*         data) { updateAttrib(type, 4, (void*)&data->operator[](0)); }
 
+    //! Maps the VBO parts of sequential attributes for writing
+    SLbool mapAttribs(const vector<SLGLAttributeType>& types,
+                      vector<SLfloat*>&                data) { return _VBOf.mapAttribs(types, data); }
+
+    //! Unmaps the VBO after mapAttribs
+    void unmapAttribs() { _VBOf.unmapAttribs(); }
+
     //! Generates the VA & VB objects for a NO. of vertices
     void generate(SLuint          numVertices,
                   SLGLBufferUsage usage             = BU_static,
@@ -77,6 +77,13 @@ class SLGLVertexBuffer
     void updateAttrib(SLGLAttributeType type,
                       SLVVec4f&         data) { updateAttrib(type, 4, (void*)&data[0]); }
 
+    //! Maps the VBO parts of sequential attributes for writing
+    SLbool mapAttribs(const vector<SLGLAttributeType>& types,
+                      vector<SLfloat*>&                data);
+
+    //! Unmaps the VBO after mapAttribs
+    void unmapAttribs();
+
     //! Generates the VBO
     void generate(SLuint          numVertices,
                   SLGLBufferUsage usage             = BU_static,
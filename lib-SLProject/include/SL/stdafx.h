@@ -36,6 +36,7 @@
 #include <string>
 #include <thread>
 #include <typeinfo>
+#include <unordered_set>
 #include <vector>
 //-----------------------------------------------------------------------------
 // Include standard C libraries
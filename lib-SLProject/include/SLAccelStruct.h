@@ -12,6 +12,11 @@
 
 #include <SLMesh.h>
 
+class SLRayPacket;
+
+//-----------------------------------------------------------------------------
+//! Max. depth of the BVHs (SLBVH & SLSceneBVH) and size of their traversal stacks
+#define SL_BVH_MAX_DEPTH 64
 //-----------------------------------------------------------------------------
 //! SLAccelStruct is an abstract base class for acceleration structures
 /*! The SLAccelStruct class serves as common class for the SLUniformGrid,
@@ -31,6 +36,12 @@ class SLAccelStruct
     virtual SLbool intersect(SLRay* ray, SLNode* node) = 0;
     virtual void   disposeBuffers()                    = 0;
 
+    //! Returns true if the structure implements intersectPacket
+    virtual SLbool hasPacketSupport() const { return false; }
+
+    //! Intersects a packet of rays in object space (see SLRayPacket)
+    virtual void intersectPacket(SLRayPacket& packet, SLNode* node) { ; }
+
     protected:
     SLMesh* _m;    //!< Pointer to the mesh
     SLVec3f _minV; //!< min. point of AABB
@@ -28,6 +28,12 @@ An animation track is a specialized track that affects a single SLNode or an
 SLJoint of an SLSkeleton by interpolating its transform. It holds therefore a
 list of SLKeyframe. For a smooth motion it can interpolate the transform at a
 given time between two neighboring SLKeyframe.
+\n For the evaluation the times and values of the keyframes are copied into
+flat arrays (see buildKeyframeArrays) that get rebuilt if a keyframe changes.
+The two neighboring keyframes are found with a binary search in the sorted
+times. Because an animation is mostly played forward, the index of the last
+found keyframe is kept as a cursor and checked first together with its
+successor. So the lookup does not scale with the NO. of keyframes.
 */
 class SLAnimTrack
 {
@@ -47,13 +53,21 @@ class SLAnimTrack
     virtual void drawVisuals(SLSceneView* sv)                         = 0;
     SLint        numKeyframes() const { return (SLint)_keyframes.size(); }
     SLKeyframe*  keyframe(SLint index);
+    void         keyframesOutOfDate() { _keyframesOutOfDate = true; }
 
     protected:
     /// Keyframe creator function for derived implementations
     virtual SLKeyframe* createKeyframeImpl(SLfloat time) = 0;
+    virtual void        buildKeyframeArrays() const;
+    SLfloat             getKeyframeIndicesAtTime(SLfloat time,
+                                                 SLuint& k1,
+                                                 SLuint& k2) const;
 
-    SLAnimation* _animation; //!< parent animation that created this track
-    SLVKeyframe  _keyframes; //!< keyframe list for this track
+    SLAnimation*     _animation;          //!< parent animation that created this track
+    SLVKeyframe      _keyframes;          //!< keyframe list for this track
+    mutable SLVfloat _kfTimes;            //!< sorted times of all keyframes
+    mutable SLuint   _kfCursor;           //!< index of the last found keyframe
+    mutable SLbool   _keyframesOutOfDate; //!< dirty flag of the keyframe arrays
 };
 
 //-----------------------------------------------------------------------------
@@ -85,11 +99,15 @@ class SLNodeAnimTrack : public SLAnimTrack
     protected:
     void                buildInterpolationCurve() const;
     virtual SLKeyframe* createKeyframeImpl(SLfloat time);
+    virtual void        buildKeyframeArrays() const;
 
     SLNode*             _animatedNode;              //!< the target node for this track_nodeID
     mutable SLCurve*    _interpolationCurve;        //!< the translation interpolation curve
     SLAnimInterpolation _translationInterpolation;  //!< interpolation mode for translations (Bezier or linear)
     SLbool              _rebuildInterpolationCurve; //!< dirty flag of the Bezier curve
+    mutable SLVVec3f    _kfTranslations;            //!< translations of all keyframes
+    mutable SLVQuat4f   _kfRotations;               //!< rotations of all keyframes
+    mutable SLVVec3f    _kfScales;                  //!< scales of all keyframes
 };
 //-----------------------------------------------------------------------------
 typedef std::map<SLuint, SLNodeAnimTrack*> SLMNodeAnimTrack;
@@ -0,0 +1,75 @@
+//#############################################################################
+//  File:      SLBVH.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLBVH_H
+#define SLBVH_H
+
+#include <vector>
+
+#include <SLAccelStruct.h>
+#include <SLGLVertexArrayExt.h>
+#include <SLVec3.h>
+
+//-----------------------------------------------------------------------------
+//! Node of the flattened bounding volume hierarchy with 32 bytes
+/*! Inner nodes have a count of zero. Their left child follows directly in the
+node array and the index of the right child is stored in leftFirst. For leaf
+nodes leftFirst is the index of the first triangle in the index array.
+*/
+struct SLBVHNode
+{
+    SLVec3f min;       //!< min. point of the AABB in OS
+    SLuint  leftFirst; //!< right child index or first triangle index
+    SLVec3f max;       //!< max. point of the AABB in OS
+    SLuint  count;     //!< NO. of triangles in leaf (0 for inner nodes)
+};
+//-----------------------------------------------------------------------------
+//! Class for a bounding volume hierarchy acceleration structure
+/*! The SLBVH is built top-down with the binned surface area heuristic (SAH)
+as described by Ingo Wald in "On fast Construction of SAH-based Bounding
+Volume Hierarchies". Other than the SLCompactGrid it adapts to meshes with
+very different triangle sizes where most voxels of a uniform grid would be
+empty and a few overfull. The nodes are stored in depth-first order in a
+flat array of SLBVHNode. For the statistics and the debug drawing the leaves
+are treated as voxels.
+*/
+class SLBVH : public SLAccelStruct
+{
+    public:
+    SLBVH(SLMesh* m);
+    ~SLBVH() { ; }
+
+    void   build(SLVec3f minV, SLVec3f maxV);
+    void   updateStats(SLNodeStats& stats);
+    void   draw(SLSceneView* sv);
+    SLbool intersect(SLRay* ray, SLNode* node);
+    SLbool hasPacketSupport() const { return true; }
+    void   intersectPacket(SLRayPacket& packet, SLNode* node);
+
+    void deleteAll();
+    void disposeBuffers()
+    {
+        if (_vao.id()) _vao.clearAttribs();
+    }
+
+    private:
+    SLuint buildRec(SLuint first, SLuint count, SLuint depth);
+    SLbool isHitInOS(const SLBVHNode& n, SLRay* ray, SLfloat& tNear) const;
+
+    SLuint                 _numTriangles;    //!< NO. of triangles in the mesh
+    std::vector<SLBVHNode> _nodes;           //!< Flat node array with root at 0
+    SLVuint                _triangleIndexes; //!< Triangle indexes in leaf order
+    SLVVec3f               _triMin;          //!< Temp. triangle min. during build
+    SLVVec3f               _triMax;          //!< Temp. triangle max. during build
+    SLVVec3f               _triCenter;       //!< Temp. triangle centers during build
+    SLGLVertexArrayExt     _vao;             //!< Vertex array object for rendering
+};
+//-----------------------------------------------------------------------------
+#endif //SLBVH_H
@@ -12,6 +12,7 @@
 
 #include <array>
 #include <atomic>
+#include <memory>
 #include <numeric>
 #include <vector>
 
@@ -26,6 +27,16 @@ typedef std::function<void(const SLuint, const SLuint)> triVoxCallback;
 /*! This class implements the data structure proposed by Lagae & Dutre in their
 paper "Compact, Fast and Robust Grids for Ray Tracing". It reduces the memory
 footprint to 20% of a regular uniform grid implemented in SLUniformGrid.
+The two passes of the build (counting and filling) run in parallel over
+chunks of triangles. The buffers are reused by subsequent builds so that
+animated meshes don't reallocate them every frame. In the keep size mode the
+number of voxels per axis of the last build is kept and only the voxel size is
+adapted to the new bounds of the moved vertices. The triangles still get
+binned again with both passes, so this is not a refit of the old grid and it
+is not cheaper than a full rebuild. It only keeps the voxel resolution and the
+buffer sizes stable from frame to frame.
+Packets of coherent primary rays traverse the grid slice by slice along the
+dominant axis of their directions (see intersectPacket).
 */
 class SLCompactGrid : public SLAccelStruct
 {
@@ -39,6 +50,8 @@ class SLCompactGrid : public SLAccelStruct
     void   updateStats(SLNodeStats& stats);
     void   draw(SLSceneView* sv);
     SLbool intersect(SLRay* ray, SLNode* node);
+    SLbool hasPacketSupport() const { return true; }
+    void   intersectPacket(SLRayPacket& packet, SLNode* node);
 
     void deleteAll();
     void disposeBuffers()
@@ -56,7 +69,15 @@ class SLCompactGrid : public SLAccelStruct
     void    getMinMaxVoxel(const Triangle& triangle,
                            SLVec3i&        minCell,
                            SLVec3i&        maxCell);
-    void    ifTriangleInVoxelDo(triVoxCallback cb);
+    void    ifTriangleInVoxelDo(triVoxCallback cb,
+                                SLuint         iBegin = 0,
+                                SLuint         iEnd   = UINT_MAX);
+
+    // Setters
+    void keepSize(SLbool keep) { _keepSize = keep; }
+
+    // Getters
+    SLbool keepSize() const { return _keepSize; }
 
     private:
     SLVec3ui           _size;              //!< num. of voxel in grid dir.
@@ -67,6 +88,10 @@ class SLCompactGrid : public SLAccelStruct
     SLVushort          _triangleIndexes16; //!< 16 bit triangle index array (L in the paper)
     SLVuint            _triangleIndexes32; //!< 32 bit triangle index array (L in the paper)
     SLGLVertexArrayExt _vao;               //!< Vertex array object for rendering
+
+    std::unique_ptr<std::atomic<SLuint>[]> _voxelCounters;     //!< Per voxel counters of the parallel build
+    SLuint                                 _voxelCountersSize; //!< NO. of allocated voxel counters
+    SLbool                                 _keepSize;          //!< Flag for keeping the grid size
 };
 //-----------------------------------------------------------------------------
 #endif //SL_COMPACTGRID
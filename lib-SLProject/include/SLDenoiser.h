@@ -0,0 +1,111 @@
+//#############################################################################
+//  File:      SLDenoiser.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLDENOISER_H
+#define SLDENOISER_H
+
+#include <SLRenderPool.h>
+#include <SLVec3.h>
+#include <SLVec4.h>
+
+//-----------------------------------------------------------------------------
+//! Default NO. of filter iterations (kernel steps 1, 2, 4, 8 & 16 pixels)
+#define SL_DENOISE_ITERATIONS 5
+//! Min. NO. of samples for a per pixel variance (less use the neighbours)
+#define SL_DENOISE_MIN_SAMPLES 4
+//-----------------------------------------------------------------------------
+//! Edge avoiding A-trous wavelet filter for noisy path traced images
+/*!
+SLDenoiser filters the mean of the HDR accumulation buffer of SLPathtracer
+like the spatial part of SVGF (Schied et al. 2017). During the rendering the
+path tracer passes the albedo, the normal and the distance of the first hit
+of every sample with addSample. The per pixel means of these features guide
+the filter:
+\n The mean color is divided by the albedo so that the filter only blurs the
+lighting and not the textures. The albedo gets multiplied again at the end.
+\n With the first and second moment of the luminance the variance of the
+mean is known per pixel. Pixels with less than SL_DENOISE_MIN_SAMPLES samples
+take the variance of their neighbours.
+\n Each iteration of the A-trous filter applies a 5x5 B3-spline kernel with
+holes of 2^i pixels. The weights of the neighbours are reduced by the normal
+difference, the relative depth difference and by the luminance difference in
+units of the standard deviation. The variance is filtered along, so the
+filter gets less blurry in the later iterations where the noise is gone.
+All passes run over the image tiles with the threads of the render pool.
+Sample points of the background have the depth 0.
+*/
+class SLDenoiser
+{
+    public:
+    SLDenoiser();
+
+    void resize(SLint width, SLint height);
+    void addSample(SLuint         i,
+                   const SLCol4f& color,
+                   const SLCol4f& albedo,
+                   const SLVec3f& normal,
+                   SLfloat        depth);
+    void denoise(const SLVCol4f&      sum,
+                 const SLVuint&       num,
+                 SLRenderPool&        pool,
+                 const SLVRenderTile& tiles,
+                 SLuint               maxWorkers);
+
+    // Setters
+    void iterations(SLint i) { _iterations = i; }
+    void sigmaColor(SLfloat s) { _sigmaColor = s; }
+    void sigmaNormal(SLfloat s) { _sigmaNormal = s; }
+    void sigmaDepth(SLfloat s) { _sigmaDepth = s; }
+
+    // Getters
+    SLint           iterations() const { return _iterations; }
+    SLfloat         sigmaColor() const { return _sigmaColor; }
+    SLfloat         sigmaNormal() const { return _sigmaNormal; }
+    SLfloat         sigmaDepth() const { return _sigmaDepth; }
+    SLbool          isValid() const { return _isValid; }
+    SLfloat         denoiseSec() const { return _denoiseSec; }
+    const SLCol4f&  result(SLuint i) const { return _result[i]; }
+    const SLVCol4f& result() const { return _result; }
+
+    private:
+    void    prepareTile(const SLRenderTile& tile,
+                        const SLVCol4f&     sum,
+                        const SLVuint&      num);
+    void    estimateVarianceTile(const SLRenderTile& tile);
+    void    filterTile(const SLRenderTile& tile,
+                       SLint               step,
+                       const SLVCol4f&     src,
+                       SLVCol4f&           dst);
+    void    remodulateTile(const SLRenderTile& tile, const SLVCol4f& src);
+    SLfloat geometryWeight(SLuint p, SLuint q, SLint step) const;
+
+    SLint    _width;       //!< image width in pixels
+    SLint    _height;      //!< image height in pixels
+    SLVCol4f _albedoSum;   //!< sum of the first hit albedos per pixel
+    SLVVec3f _normalSum;   //!< sum of the first hit normals per pixel
+    SLVfloat _depthSum;    //!< sum of the first hit distances per pixel
+    SLVfloat _lumSum;      //!< sum of the lighting luminance per pixel
+    SLVfloat _lumSqSum;    //!< sum of the squared lighting luminance per pixel
+    SLVCol4f _albedo;      //!< mean albedo per pixel
+    SLVVec3f _normal;      //!< mean normal per pixel
+    SLVfloat _depth;       //!< mean distance per pixel
+    SLVuint  _numSamples;  //!< NO. of samples per pixel of the last denoise
+    SLVCol4f _ping;        //!< lighting (rgb) & variance (a) of odd passes
+    SLVCol4f _pong;        //!< lighting (rgb) & variance (a) of even passes
+    SLVCol4f _result;      //!< denoised HDR mean color per pixel
+    SLint    _iterations;  //!< NO. of A-trous iterations
+    SLfloat  _sigmaColor;  //!< luminance tolerance in standard deviations
+    SLfloat  _sigmaNormal; //!< exponent of the normal weight
+    SLfloat  _sigmaDepth;  //!< relative depth tolerance per pixel distance
+    SLbool   _isValid;     //!< flag if result holds the current image
+    SLfloat  _denoiseSec;  //!< time of the last denoise in seconds
+};
+//-----------------------------------------------------------------------------
+#endif //SLDENOISER_H
@@ -70,7 +70,32 @@ enum SLRenderType
 {
     RT_gl = 0, //!< OpenGL
     RT_rt = 1, //!< Ray Tracing
-    RT_pt = 2  //!< Path Tracing
+    RT_pt = 2, //!< Path Tracing
+    RT_pm = 3  //!< Photon Mapping
+};
+//-----------------------------------------------------------------------------
+//! Acceleration structure type for the ray-mesh intersection
+enum SLAccelStructType
+{
+    AST_auto        = 0, //!< Choose by the variance of the triangle sizes
+    AST_compactGrid = 1, //!< Compact uniform grid (SLCompactGrid)
+    AST_BVH         = 2  //!< Bounding volume hierarchy (SLBVH)
+};
+//-----------------------------------------------------------------------------
+//! Sample generator type of the Monte Carlo renderers (see SLSampler)
+enum SLSamplerType
+{
+    ST_random = 0, //!< PCG32 random numbers
+    ST_halton = 1, //!< Randomly rotated Halton sequence
+    ST_sobol  = 2  //!< Scrambled 2D Sobol sequence per dimension pair
+};
+//-----------------------------------------------------------------------------
+//! Texture coordinate wrap mode of the ray tracing texture lookups (see SLTexCache)
+enum SLTexWrap
+{
+    TW_repeat         = 0, //!< GL_REPEAT
+    TW_mirroredRepeat = 1, //!< GL_MIRRORED_REPEAT
+    TW_clampToEdge    = 2  //!< GL_CLAMP_TO_EDGE and all other clamp modes
 };
 //-----------------------------------------------------------------------------
 //! Coordinate axis enumeration
@@ -170,6 +195,7 @@ enum SLSceneID
     SID_RTDoF,
     SID_RTLens,
     SID_RTTest,
+    SID_RTInstances,
     SID_Maximal
 };
 //-----------------------------------------------------------------------------
@@ -322,7 +348,11 @@ enum SLShaderProg
     SP_bumpNormalParallax,
     SP_fontTex,
     SP_stereoOculus,
-    SP_stereoOculusDistortion
+    SP_stereoOculusDistortion,
+    SP_perVrtBlinnSkinned,
+    SP_perVrtBlinnTexSkinned,
+    SP_perPixBlinnSkinned,
+    SP_perPixBlinnTexSkinned
 };
 //-----------------------------------------------------------------------------
 //! Type definition for GLSL uniform1f variables that change per frame.
@@ -22,19 +22,21 @@ class SLAnimTrack;
 class SLKeyframe
 {
     public:
-    SLKeyframe(const SLAnimTrack* parent,
-               SLfloat            time);
+    SLKeyframe(SLAnimTrack* parent,
+               SLfloat      time);
 
     bool operator<(const SLKeyframe& other) const;
 
-    void    time(SLfloat t) { _time = t; }
+    void    time(SLfloat t);
     SLfloat time() const { return _time; }
     SLbool  isValid() const { return _isValid; }
 
     protected:
-    const SLAnimTrack* _parentTrack; //!< owning animation track for this keyframe
-    SLfloat            _time;        //!< temporal position in local time relative to the keyframes parent clip in seconds
-    SLbool             _isValid;     //!< is this keyframe in use inside its parent track
+    void changed();
+
+    SLAnimTrack* _parentTrack; //!< owning animation track for this keyframe
+    SLfloat      _time;        //!< temporal position in local time relative to the keyframes parent clip in seconds
+    SLbool       _isValid;     //!< is this keyframe in use inside its parent track
 };
 
 //-----------------------------------------------------------------------------
@@ -45,13 +47,13 @@ Keeps track of translation, rotation and scale.
 class SLTransformKeyframe : public SLKeyframe
 {
     public:
-    SLTransformKeyframe(const SLAnimTrack* parent,
-                        SLfloat            time);
+    SLTransformKeyframe(SLAnimTrack* parent,
+                        SLfloat      time);
 
     // Setters
-    void translation(const SLVec3f& t) { _translation = t; }
-    void rotation(const SLQuat4f& r) { _rotation = r; }
-    void scale(const SLVec3f& s) { _scale = s; }
+    void translation(const SLVec3f& t);
+    void rotation(const SLQuat4f& r);
+    void scale(const SLVec3f& s);
 
     // Getters
     const SLVec3f&  translation() const { return _translation; }
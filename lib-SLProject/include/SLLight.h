@@ -22,6 +22,10 @@ class SLRay;
 /*! The abstract SLLight class encapsulates an invisible light source according
 to the OpenGL specification. The derivatives SLLightSpot and SLLightRect will
 also derive from SLNode and can therefore be freely placed in space.
+The shadow rays of all lights are shot with isOccluded. Every render thread
+remembers the last opaque occluder of each light and tests it first, because
+neighbouring shadow rays to the same light are mostly blocked by the same
+triangle. Only if it doesn't block the ray the full any-hit query is done.
 */
 class SLLight
 {
@@ -79,6 +83,13 @@ class SLLight
                                  const SLVec3f& L,
                                  const SLfloat  lightDist) = 0;
 
+    // Occlusion query for the shadow rays of all lights
+    SLbool        isOccluded(SLRay* shadowRay);
+    static void   newShadowFrame();
+    static SLuint shadowFrame();
+    static void   newShadowTile();
+    static SLuint shadowTile();
+
     protected:
     SLint   _id;               //!< OpenGL light number (0-7)
     SLbool  _isOn;             //!< Flag if light is on or off
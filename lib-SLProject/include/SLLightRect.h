@@ -77,12 +77,11 @@ class SLLightRect : public SLNode
     SLfloat width() { return _width; }
     SLfloat height() { return _height; }
     SLVec4f positionWS() { return updateAndGetWM().translation(); }
-    SLVec3f spotDirWS() { return SLVec3f(_wm.m(8),
-                                         _wm.m(9),
-                                         _wm.m(10)) *
-                                 -1.0; }
+    SLVec3f spotDirWS() { return forwardWS(); }
 
     private:
+    SLbool isLighting(SLRay* ray, SLfloat x, SLfloat y);
+
     SLfloat _width;      //!< Width of square light in x direction
     SLfloat _height;     //!< Lenght of square light in y direction
     SLfloat _halfWidth;  //!< Half width of square light in x dir
@@ -22,9 +22,28 @@ class SLAccelStruct;
 struct SLNodeStats;
 class SLMaterial;
 class SLRay;
+class SLRayPacket;
 class SLSkeleton;
 class SLGLState;
+class SLGLProgram;
 
+//-----------------------------------------------------------------------------
+//! Precomputed triangle for the ray intersection test (see SLMesh::hitTriangleOS)
+/*! The corner A and the two edges e1 = B - A and e2 = C - A are stored as
+16 byte aligned float quadruples. So one triangle fills 48 bytes that are
+fetched with one or two cache line loads and can be loaded directly into SIMD
+registers. The 4th components are unused.
+*/
+struct alignas(16) SLHitTriangle
+{
+    SLfloat v0[4]; //!< corner A of the triangle
+    SLfloat e1[4]; //!< edge from A to B
+    SLfloat e2[4]; //!< edge from A to C
+};
+typedef vector<SLHitTriangle> SLVHitTriangle;
+//-----------------------------------------------------------------------------
+//! NO. of vertices that are skinned by one task (see SLMesh::transformSkin)
+#define SL_SKIN_BATCH 1024
 //-----------------------------------------------------------------------------
 //!An SLMesh object is a triangulated mesh that is drawn with one draw call.
 /*!
@@ -38,6 +57,7 @@ The vertex attributes are stored in vectors with equal number of elements:
 \n T (vertex tangents) optional
 \n Ji (vertex joint index) optional 2D vector
 \n Jw (vertex joint weights) optional 2D vector
+\n Ji4 & Jw4 (packed 4 joint ids & weights) are generated from Ji & Jw
 \n I16 holds the unsigned short vertex indices.
 \n I32 holds the unsigned int vertex indices.
 \n
@@ -113,6 +133,15 @@ transformed every frame by the joint weights. Every vertex of a mesh has
 weights for 1-n joints by which it can be influenced. This transform is
 called skinning and is done in CPU in the method transformSkin. The final
 transformed vertices and normals are stored in _finalP and _finalN.
+\n If the GPU skinning is possible (see skinnedProgram) the skinning is done
+in the vertex shader with the joint matrices of the skeleton in a uniform
+buffer. The CPU skinning is then only done for ray tracing (see updateSkin).
+\n For the skinning the joint influences are packed once into a fixed format
+of four joints per vertex: The joint ids in Ji4 as 8 bit each in one unsigned
+int and the weights in Jw4 as one SLVec4f. So every vertex has the same amount
+of work without any per vertex heap allocation.
+\n A mesh knows the nodes that hold it (see nodes), so that a skinned mesh
+can invalidate the AABBs of its nodes without searching the scene graph.
 */
 
 class SLMesh : public SLObject
@@ -121,13 +150,16 @@ class SLMesh : public SLObject
     SLMesh(SLstring name = "Mesh");
     ~SLMesh();
 
-    virtual void init(SLNode* node);
-    virtual void draw(SLSceneView* sv, SLNode* node);
-    void         addStats(SLNodeStats& stats);
-    virtual void buildAABB(SLAABBox& aabb, SLMat4f wmNode);
-    void         updateAccelStruct();
-    SLbool       hit(SLRay* ray, SLNode* node);
-    virtual void preShade(SLRay* ray);
+    virtual void      init(SLNode* node);
+    virtual void      draw(SLSceneView* sv, SLNode* node);
+    void              addStats(SLNodeStats& stats);
+    virtual void      buildAABB(SLAABBox& aabb, SLMat4f wmNode);
+    void              updateAccelStruct();
+    void              updateTriangleCache();
+    SLAccelStructType autoAccelStructType();
+    SLbool            hit(SLRay* ray, SLNode* node);
+    void              hitPacket(SLRayPacket& packet, SLNode* node);
+    virtual void      preShade(SLRay* ray);
 
     void         deleteData();
     void         deleteSelected(SLNode* node);
@@ -138,21 +170,37 @@ class SLMesh : public SLObject
     virtual void calcMinMax();
     void         calcCenterRad(SLVec3f& center, SLfloat& radius);
     SLbool       hitTriangleOS(SLRay* ray, SLNode* node, SLuint iT);
+    void         hitTrianglePacketOS(SLRayPacket& packet, SLNode* node, SLuint iT);
 
-    void transformSkin();
+    void         addNode(SLNode* node);
+    void         removeNode(SLNode* node);
+    void         removeAllNodes() { _nodes.clear(); }
+    void         transformSkin();
+    SLbool       updateSkin(SLbool needsCPUSkin);
+    SLGLProgram* skinnedProgram();
+    void         packJointInfluences();
 
     // Getters
-    SLMaterial*       mat() const { return _mat; }
-    SLMaterial*       matOut() const { return _matOut; }
-    SLGLPrimitiveType primitive() const { return _primitive; }
-    const SLSkeleton* skeleton() const { return _skeleton; }
-    SLuint            numI() { return (SLuint)(I16.size() ? I16.size() : I32.size()); }
+    SLMaterial*            mat() const { return _mat; }
+    SLMaterial*            matOut() const { return _matOut; }
+    SLGLPrimitiveType      primitive() const { return _primitive; }
+    const SLSkeleton*      skeleton() const { return _skeleton; }
+    SLuint                 numI() { return (SLuint)(I16.size() ? I16.size() : I32.size()); }
+    SLAccelStructType      accelStructType() const { return _accelStructType; }
+    SLAccelStruct*         accelStruct() { return _accelStruct; }
+    SLbool                 accelStructKeepSize() const { return _accelStructKeepSize; }
+    SLbool                 doTriangleCache() const { return _doTriangleCache; }
+    const unordered_set<SLNode*>& nodes() const { return _nodes; }
 
     // Setters
     void mat(SLMaterial* m) { _mat = m; }
     void matOut(SLMaterial* m) { _matOut = m; }
     void primitive(SLGLPrimitiveType pt) { _primitive = pt; }
     void skeleton(SLSkeleton* skel) { _skeleton = skel; }
+    void accelStructType(SLAccelStructType type);
+    void accelStructOutOfDate(SLbool outOfDate) { _accelStructOutOfDate = outOfDate; }
+    void accelStructKeepSize(SLbool keep) { _accelStructKeepSize = keep; }
+    void doTriangleCache(SLbool doCache);
 
     // getter for position and normal data for rendering
     SLVec3f finalP(SLuint i) { return _finalP->operator[](i); }
@@ -169,6 +217,8 @@ class SLMesh : public SLObject
     SLVVec4f  T;    //!< Vector of vertex tangents (opt.)
     SLVVuchar Ji;   //!< 2D Vector of per vertex joint ids (opt.)
     SLVVfloat Jw;   //!< 2D Vector of per vertex joint weights (opt.)
+    SLVuint   Ji4;  //!< Vector of 4 packed 8 bit joint ids per vertex (opt.)
+    SLVVec4f  Jw4;  //!< Vector of 4 joint weights per vertex (opt.)
     SLVushort I16;  //!< Vector of vertex indices 16 bit
     SLVuint   I32;  //!< Vector of vertex indices 32 bit
     SLVuint   IS32; //!< Vector of rectangle selected vertex indices 32 bit
@@ -188,18 +238,64 @@ class SLMesh : public SLObject
     SLGLVertexArrayExt _vaoT; //!< OpenGL VAO for optional tangent drawing
     SLGLVertexArrayExt _vaoS; //!< OpenGL VAO for optional selection drawing
 
-    SLbool         _isVolume;             //!< Flag for RT if mesh is a closed volume
-    SLAccelStruct* _accelStruct;          //!< KD-tree or uniform grid
-    SLbool         _accelStructOutOfDate; //!< flag id accel.struct needs update
+    SLbool            _isVolume;             //!< Flag for RT if mesh is a closed volume
+    SLAccelStruct*    _accelStruct;          //!< Compact grid or BVH
+    SLbool            _accelStructOutOfDate; //!< flag id accel.struct needs update
+    SLAccelStructType _accelStructType;      //!< Requested type of accel. struct
+    SLbool            _accelStructKeepSize;  //!< Flag for keeping the voxel resolution of a compact grid
+    SLbool            _doTriangleCache;      //!< Flag for using the triangle cache
+    SLVHitTriangle    _hitTriangles;         //!< Triangle cache for the ray intersection
 
-    SLSkeleton* _skeleton;      //!< the skeleton this mesh is bound to
-    SLVMat4f    _jointMatrices; //!< joint matrix vector for this mesh
-    SLVVec3f*   _finalP;        //!< Pointer to final vertex position vector
-    SLVVec3f*   _finalN;        //!< pointer to final vertex normal vector
+    SLSkeleton* _skeleton;          //!< the skeleton this mesh is bound to
+    SLVMat4f    _jointMatrices;     //!< joint matrix vector for this mesh
+    SLVVec3f*   _finalP;            //!< Pointer to final vertex position vector
+    SLVVec3f*   _finalN;            //!< pointer to final vertex normal vector
+    SLbool      _cpuSkinIsOutdated; //!< Flag if skinnedP & skinnedN are outdated
+    SLbool      _vaoIsGPUSkinned;   //!< Flag if the VAO is built for GPU skinning
+    SLVVec4f    _jointIdsGL;        //!< Joint ids of Ji4 as floats for the VBO
+
+    unordered_set<SLNode*> _nodes; //!< Nodes that hold this mesh (see SLNode::addMesh)
 
     void notifyParentNodesAABBUpdate() const;
+    void skinRange(SLuint first, SLuint last, SLfloat* vboP, SLfloat* vboN);
+    void getTriangleOS(SLuint iT, SLVec3f& A, SLVec3f& e1, SLVec3f& e2);
 };
 //-----------------------------------------------------------------------------
+/*! Returns the corner A and the edges e1 = B - A & e2 = C - A of the triangle
+with the first index iT. They are taken from the triangle cache if it is
+valid, otherwise they are calculated from the final vertex positions.
+*/
+inline void SLMesh::getTriangleOS(SLuint   iT,
+                                  SLVec3f& A,
+                                  SLVec3f& e1,
+                                  SLVec3f& e2)
+{
+    if (!_accelStructOutOfDate && _hitTriangles.size() * 3 == numI())
+    {
+        const SLHitTriangle& tri = _hitTriangles[iT / 3];
+        A.set(tri.v0[0], tri.v0[1], tri.v0[2]);
+        e1.set(tri.e1[0], tri.e1[1], tri.e1[2]);
+        e2.set(tri.e2[0], tri.e2[1], tri.e2[2]);
+        return;
+    }
+
+    SLVec3f B, C;
+    if (I16.size())
+    {
+        A = finalP(I16[iT]);
+        B = finalP(I16[iT + 1]);
+        C = finalP(I16[iT + 2]);
+    }
+    else
+    {
+        A = finalP(I32[iT]);
+        B = finalP(I32[iT + 1]);
+        C = finalP(I32[iT + 2]);
+    }
+    e1.sub(B, A);
+    e2.sub(C, A);
+}
+//-----------------------------------------------------------------------------
 typedef std::vector<SLMesh*> SLVMesh;
 //-----------------------------------------------------------------------------
 #endif //SLMESH_H
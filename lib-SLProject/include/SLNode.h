@@ -23,6 +23,7 @@ class SLAABBox;
 class SLNode;
 class SLAnimation;
 class SLCVTracked;
+class SLTransformStore;
 
 //-----------------------------------------------------------------------------
 //! SLVNode typdef for a vector of SLNodes
@@ -30,7 +31,8 @@ typedef std::vector<SLNode*> SLVNode;
 //-----------------------------------------------------------------------------
 //! Struct for scene graph statistics
 /*! The SLNodeStats struct holds some statistics that are set in the recursive
-SLNode::statsRec method.
+SLNode::statsRec method. A mesh that is referenced by several nodes is an
+instance and its data and acceleration structure are counted only once.
 */
 struct SLNodeStats
 {
@@ -39,15 +41,18 @@ struct SLNodeStats
     SLuint  numBytesAccel; //!< NO. of bytes in accel. structs
     SLuint  numGroupNodes; //!< NO. of group nodes
     SLuint  numLeafNodes;  //!< NO. of leaf nodes
-    SLuint  numMeshes;     //!< NO. of visible shapes in node
+    SLuint  numMeshes;     //!< NO. of unique visible shapes in node
+    SLuint  numInstances;  //!< NO. of mesh references of all nodes
     SLuint  numLights;     //!< NO. of lights in mesh
-    SLuint  numTriangles;  //!< NO. of triangles in mesh
+    SLuint  numTriangles;  //!< NO. of triangles in unique meshes
     SLuint  numLines;      //!< NO. of lines in mesh
     SLuint  numVoxels;     //!< NO. of voxels
     SLfloat numVoxEmpty;   //!< NO. of empty voxels
     SLuint  numVoxMaxTria; //!< Max. no. of triangles per voxel
     SLuint  numAnimations; //!< NO. of animations
 
+    unordered_set<const SLMesh*> countedMeshes; //!< meshes already counted
+
     //! Resets all counters to zero
     void clear()
     {
@@ -57,6 +62,7 @@ struct SLNodeStats
         numGroupNodes = 0;
         numLeafNodes  = 0;
         numMeshes     = 0;
+        numInstances  = 0;
         numLights     = 0;
         numTriangles  = 0;
         numLines      = 0;
@@ -64,6 +70,7 @@ struct SLNodeStats
         numVoxEmpty   = 0.0f;
         numVoxMaxTria = 0;
         numAnimations = 0;
+        countedMeshes.clear();
     }
 
     //! Prints all statistic informations on the std out stream.
@@ -84,6 +91,7 @@ struct SLNodeStats
         SL_LOG("Group Nodes    : %d\n", numGroupNodes);
         SL_LOG("Leaf Nodes     : %d\n", numLeafNodes);
         SL_LOG("Meshes         : %d\n", numMeshes);
+        SL_LOG("Mesh Instances : %d\n", numInstances);
         SL_LOG("Triangles      : %d\n", numTriangles);
         SL_LOG("Lights         : %d\n", numLights);
         SL_LOG("\n");
@@ -109,7 +117,9 @@ by SLNode::drawRec.
 A node can be transformed and has therefore a object matrix (_om) for its local
 transform. All other matrices such as the world matrix (_wm), the inverse
 world matrix (_wmI) and the normal world matrix (_wmN) are derived from the
-object matrix and automatically generated and updated.
+object matrix and automatically generated and updated. If the node is in the
+SLTransformStore of the scene its derived matrices are kept in the flat arrays
+of the store instead of the members.
 
 A node can be transformed by one of the various transform functions such
 as translate(). Many of these functions take an additional parameter 
@@ -135,6 +145,7 @@ class SLNode
   , public SLEventHandler
 {
     friend class SLSceneView;
+    friend class SLTransformStore;
 
     public:
     SLNode(SLstring name = "Node");
@@ -146,6 +157,7 @@ class SLNode
     virtual void      cull2DRec(SLSceneView* sv);
     virtual void      drawRec(SLSceneView* sv);
     virtual bool      hitRec(SLRay* ray);
+    bool              hitMeshes(SLRay* ray);
     virtual void      statsRec(SLNodeStats& stats);
     virtual SLNode*   copyRec();
     virtual SLAABBox& updateAABBRec();
@@ -157,7 +169,7 @@ class SLNode
     SLint        numMeshes() { return (SLint)_meshes.size(); }
     void         addMesh(SLMesh* mesh);
     bool         insertMesh(SLMesh* insertM, SLMesh* afterM);
-    void         removeMeshes() { _meshes.clear(); }
+    void         removeMeshes();
     bool         removeMesh();
     bool         removeMesh(SLMesh* mesh);
     bool         removeMesh(SLstring name);
@@ -280,6 +292,8 @@ class SLNode
     const SLMat4f&    updateAndGetWM() const;
     const SLMat4f&    updateAndGetWMI() const;
     const SLMat3f&    updateAndGetWMN() const;
+    const SLMat4f&    nodeWM() const;
+    const SLMat3f&    nodeWMN() const;
     SLDrawBits*       drawBits() { return &_drawBits; }
     SLbool            drawBit(SLuint bit) { return _drawBits.get(bit); }
     SLAABBox*         aabb() { return &_aabb; }
@@ -293,6 +307,7 @@ class SLNode
 
     private:
     void updateWM() const;
+    void needBVHRebuild();
     template<typename T>
     void findChildrenHelper(const SLstring& name,
                             vector<T*>&     list,
@@ -322,6 +337,9 @@ class SLNode
     SLAABBox        _aabb;           //!< axis aligned bounding box
     SLAnimation*    _animation;      //!< animation of the node
     SLCVTracked*    _tracker;        //!< OpenCV Augmented Reality Tracker
+
+    SLTransformStore* _store;      //!< transform store with the matrices or nullptr
+    SLint             _storeIndex; //!< index of the node in the transform store
 };
 
 ////////////////////////
@@ -464,8 +482,7 @@ SLNode::position returns current local position
 inline SLVec3f
 SLNode::translationWS() const
 {
-    updateAndGetWM();
-    return _wm.translation();
+    return updateAndGetWM().translation();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -474,8 +491,8 @@ SLNode::forward returns worlds forward vector
 inline SLVec3f
 SLNode::forwardWS() const
 {
-    updateAndGetWM();
-    return SLVec3f(-_wm.m(8), -_wm.m(9), -_wm.m(10));
+    const SLMat4f& wm = updateAndGetWM();
+    return SLVec3f(-wm.m(8), -wm.m(9), -wm.m(10));
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -484,8 +501,8 @@ SLNode::right returns worlds right vector
 inline SLVec3f
 SLNode::rightWS() const
 {
-    updateAndGetWM();
-    return SLVec3f(_wm.m(0), _wm.m(1), _wm.m(2));
+    const SLMat4f& wm = updateAndGetWM();
+    return SLVec3f(wm.m(0), wm.m(1), wm.m(2));
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -494,8 +511,8 @@ SLNode::up returns worlds up vector
 inline SLVec3f
 SLNode::upWS() const
 {
-    updateAndGetWM();
-    return SLVec3f(_wm.m(4), _wm.m(5), _wm.m(6));
+    const SLMat4f& wm = updateAndGetWM();
+    return SLVec3f(wm.m(4), wm.m(5), wm.m(6));
 }
 //-----------------------------------------------------------------------------
 inline void
@@ -10,10 +10,35 @@
 #ifndef SLPATHTRACER_H
 #define SLPATHTRACER_H
 
+#include <SLDenoiser.h>
 #include <SLRaytracer.h>
 
+class SLLight;
+class SLLightRect;
+
+//-----------------------------------------------------------------------------
+//! Upper limit of the path depth if the paths end by Russian roulette
+#define SL_PT_MAX_DEPTH 64
+
 //-----------------------------------------------------------------------------
 //! Classic Monte Carlo Pathtracing algorithm for real global illumination
+/*! The samples of all passes are summed up per pixel in a float accumulation
+buffer with a sample count per pixel. So the running mean is not quantized to
+8 bits and keeps converging for thousands of samples. The exposure, the
+optional Reinhard tone mapping and the gamma correction are only applied when
+the 8 bit display image is written. They can therefore be changed after the
+rendering with updateDisplayImage. With saveHDRImage the unclamped mean is
+written as PFM (portable float map) image.
+With doDenoise the mean gets filtered by SLDenoiser after the last sample. The
+albedo, the normal and the distance of the first hit of every sample guide
+the filter. The noisy mean stays in the accumulation buffer, so the denoising
+can be switched on and off without rendering again.
+The direct light is calculated with next event estimation (NEE) at every
+diffuse hit: one point per light is sampled and connected with a shadow ray.
+Lights that can also be hit by the diffuse bounces are combined with the
+bounce sampling by multiple importance sampling (MIS) with the power
+heuristic. After maxDepth bounces the paths are ended by Russian roulette.
+*/
 class SLPathtracer : public SLRaytracer
 {
     public:
@@ -22,22 +47,62 @@ class SLPathtracer : public SLRaytracer
 
     // classic ray tracer functions
     SLbool  render(SLSceneView* sv);
-    void    renderSlices(const bool isMainThread, SLint currentSample);
-    SLCol4f trace(SLRay* ray, SLbool em);
+    void    renderTile(const SLRenderTile& tile,
+                       SLuint              worker,
+                       SLint               currentSample);
+    SLCol4f trace(SLRay* ray, SLfloat bsdfPdf);
     SLCol4f shade(SLRay* ray, SLCol4f* mat);
+    SLCol4f emission(SLRay* ray, SLfloat bsdfPdf);
     void    saveImage();
+    void    saveHDRImage();
+    void    updateDisplayImage();
+    void    denoise();
+    SLCol4f toneMap(const SLCol4f& hdr);
 
     // Setters
     void calcDirect(SLbool di) { _calcDirect = di; }
     void calcIndirect(SLbool ii) { _calcIndirect = ii; }
+    void exposure(SLfloat e) { _exposure = e; }
+    void doToneMapping(SLbool tm) { _doToneMapping = tm; }
+    void doRussianRoulette(SLbool rr) { _doRussianRoulette = rr; }
+    void doDenoise(SLbool dn) { _doDenoise = dn; }
 
     // Getters
-    SLbool calcDirect() { return _calcDirect; }
-    SLbool calcIndirect() { return _calcIndirect; }
+    SLbool      calcDirect() { return _calcDirect; }
+    SLbool      calcIndirect() { return _calcIndirect; }
+    SLfloat     exposure() { return _exposure; }
+    SLbool      doToneMapping() { return _doToneMapping; }
+    SLbool      doRussianRoulette() { return _doRussianRoulette; }
+    SLbool      doDenoise() { return _doDenoise; }
+    SLDenoiser& denoiser() { return _denoiser; }
 
     private:
-    SLbool _calcDirect;   //!< flag to calculate direct illum.
-    SLbool _calcIndirect; //!< flag to calculate indirect illum.
+    SLbool  sampleLight(SLLight* light,
+                        SLRay*   ray,
+                        SLVec3f& L,
+                        SLfloat& lightDist,
+                        SLfloat& lightPdf);
+    SLfloat lightPdfOfHit(SLLight* light, SLRay* ray);
+    SLbool  lightIsHitByBounces(SLLight* light);
+    SLfloat rectLightGeometry(SLLightRect* rect,
+                              SLVec3f&     ex,
+                              SLVec3f&     ey,
+                              SLVec3f&     nL);
+    SLCol4f lightIntensity(SLLight*       light,
+                           const SLVec3f& L,
+                           SLfloat        lightDist);
+    SLfloat powerHeuristic(SLfloat pdfA, SLfloat pdfB);
+    SLCol4f hitAlbedo(SLRay* ray);
+
+    SLbool     _calcDirect;        //!< flag to calculate direct illum.
+    SLbool     _calcIndirect;      //!< flag to calculate indirect illum.
+    SLfloat    _exposure;          //!< linear exposure factor applied before tone mapping
+    SLbool     _doToneMapping;     //!< flag for Reinhard tone mapping instead of clamping
+    SLbool     _doRussianRoulette; //!< flag for ending the paths by Russian roulette
+    SLbool     _doDenoise;         //!< flag for denoising the mean after the last sample
+    SLVCol4f   _accumSum;          //!< sum of all samples per pixel (HDR)
+    SLVuint    _accumNum;          //!< NO. of samples per pixel
+    SLDenoiser _denoiser;          //!< edge avoiding filter for the mean
 };
 //-----------------------------------------------------------------------------
 #endif
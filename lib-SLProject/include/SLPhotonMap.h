@@ -1,6 +1,6 @@
 //#############################################################################
-//  File:      SLRay.h
-//  Author:    Michael Strub, Stefan Traud
+//  File:      SLPhotonMap.h
+//  Author:    Michael Strub, Stefan Traud, Marcus Hudritsch
 //  Date:      September 2011 (HS11)
 //  Copyright: Michael Strub, Stefan Traud, Fachhochschule Nordwestschweiz
 //             This software is provide under the GNU General Public License
@@ -10,110 +10,128 @@
 #ifndef SLPHOTONMAP_H
 #define SLPHOTONMAP_H
 
-#include <stdafx.h>
-#include <renderbitch/rgbe.h>
+#include <SL.h>
+#include <SLVec3.h>
+#include <SLVec4.h>
 
 //-----------------------------------------------------------------------------
-// photon struct
-typedef struct 
-{  SLVec3f  pos;     // position of the photon
-   SLVec3f  dir;     // origin direction
-   SLbyte   plane;   // splitting plane
-   RGBE     power;   // power compressed as Ward's Shared Exponent RGB-format
-} SLPhoton;
-typedef std::vector<SLPhoton>  SLPhotonList;
-typedef std::vector<SLPhoton*> SLPhotonPointerList;
-
+//! Photon power compressed in Ward's shared exponent RGBE format (4 bytes)
+struct SLRGBE
+{
+    SLRGBE() { r = g = b = e = 0; }
+    SLRGBE(const SLVec3f& rgb)
+    {
+        SLfloat maxC = SL_max(rgb.x, rgb.y, rgb.z);
+        if (maxC < 1e-32f)
+            r = g = b = e = 0;
+        else
+        {
+            SLint   exp;
+            SLfloat scale = (SLfloat)frexp(maxC, &exp) * 256.0f / maxC;
+            r             = (SLuchar)(SL_max(rgb.x, 0.0f) * scale);
+            g             = (SLuchar)(SL_max(rgb.y, 0.0f) * scale);
+            b             = (SLuchar)(SL_max(rgb.z, 0.0f) * scale);
+            e             = (SLuchar)(exp + 128);
+        }
+    }
+    SLVec3f rgb() const
+    {
+        if (e == 0) return SLVec3f::ZERO;
+        SLfloat f = (SLfloat)ldexp(1.0, (SLint)e - (128 + 8));
+        return SLVec3f(((SLfloat)r + 0.5f) * f,
+                       ((SLfloat)g + 0.5f) * f,
+                       ((SLfloat)b + 0.5f) * f);
+    }
+    SLuchar r, g, b, e;
+};
 //-----------------------------------------------------------------------------
-// nearest photons struct
-typedef struct 
-{  SLlong   max;        // max amount of photons to locate
-   SLlong   found;      // amount of found photons
-   SLbool   got_heap;   // bool indicating if nearest photon are arranged as heap
-   SLVec3f  pos;        // position of the point P in the scene
-   SLfloat* dist2;      // array holding the distance of the photons to point P
-   SLPhotonPointerList* index; //! array of pointers to the photons in the photonmap
-} SLNearestPhotons;
-
+//! Photon stored on a diffuse surface
+struct SLPhoton
+{
+    SLVec3f pos;   //!< position of the photon
+    SLVec3f dir;   //!< incoming direction
+    SLRGBE  power; //!< power compressed in Ward's RGBE format
+    SLuchar plane; //!< splitting plane of the kd-tree node
+};
+typedef vector<SLPhoton> SLVPhoton;
 //-----------------------------------------------------------------------------
-typedef enum 
-{  NONE=0, 
-   CONE=1, 
-   GAUSS=2
-} SLFilterType;
-
+//! Filter type for the radiance estimate
+typedef enum
+{
+    PF_none  = 0, //!< Plain average over the found photons
+    PF_cone  = 1, //!< Cone filter (sharper caustics)
+    PF_gauss = 2  //!< Gaussian filter
+} SLPhotonFilter;
+//-----------------------------------------------------------------------------
+//! k-nearest photons search state (max. heap of found photons)
+struct SLNearestPhotons
+{
+    SLint            max;     //!< max. amount of photons to locate
+    SLint            found;   //!< amount of found photons
+    SLbool           gotHeap; //!< flag if the photons are arranged as max. heap
+    SLVec3f          pos;     //!< position of the point P in the scene
+    SLfloat*         dist2;   //!< squared distances [0] = squared search radius
+    const SLPhoton** index;   //!< pointers to the found photons
+};
 //-----------------------------------------------------------------------------
-//! Photonmap class with datastructure, scattering and gattering methods
+//! Photon map with a left-balanced kd-tree and the radiance estimate
 /*!
-Holds a datastructure for storing photons and diffrent methods for the photon
-scattering and the radiance estimate. The datastructure is a heaplike left-
-balanced kd-tree. It is implented following the source code from H. W. Jensen
-described in his book "Realistic Image Synthesis Using Photon Mappin.
+Holds the photons of one map in a heap-like left-balanced kd-tree. It is
+implemented following the source code from H. W. Jensen described in his book
+"Realistic Image Synthesis Using Photon Mapping".
+The photon mapper collects the photons in per-thread buffers and adds them
+with add before the tree gets built with balance. After balance the map is
+read only. irradianceEstimate and locatePhotons are const and use per-thread
+scratch buffers, so they can be called from all render threads at once.
 */
 class SLPhotonMap
 {
-   public:
-      SLPhotonMap();
-      ~SLPhotonMap();
+    public:
+    SLPhotonMap();
+
+    void clear();
+    void add(const SLVPhoton& photons);
+    void balance();
 
-      //Scattering methods
-      void     store                (SLVec3f pos, SLVec3f dir, SLVec3f power);
-      void     scalePhotonPower     (SLfloat scale);
+    // Gathering methods
+    SLVec3f irradianceEstimate(const SLVec3f& pos,
+                               const SLVec3f& normal,
+                               SLPhotonFilter filter = PF_none) const;
+    void    locatePhotons(SLNearestPhotons* np, SLint index) const;
 
-      //Gattering methods
-      SLCol4f  irradianceEstimate   (SLVec3f pos, SLVec3f normal, SLFilterType filterType=NONE);
-      void     locatePhotons        (SLNearestPhotons* const np, const SLlong index) const;
+    // Setters
+    void estimateParams(SLint maxPhotons, SLfloat maxRadius)
+    {
+        _maxEstimatePhotons = maxPhotons;
+        _maxEstimateRadius  = maxRadius;
+    }
 
-      //Balancing methods
-      void     balance              ();
-      void     balanceSegment       (SLPhotonPointerList* pbal,
-                                     SLPhotonPointerList* porg,
-                                     const SLlong index,
-                                     const SLlong start,
-                                     const SLlong end
-                                    );
-      void     medianSplit          (SLPhotonPointerList* p,
-                                     const SLlong start,
-                                     const SLlong end,
-                                     const SLlong median,
-                                     const SLint  axis
-                                    );
+    // Getters
+    SLint   numPhotons() const { return _numPhotons; }
+    SLbool  isBalanced() const { return _isBalanced; }
+    SLint   maxEstimatePhotons() const { return _maxEstimatePhotons; }
+    SLfloat maxEstimateRadius() const { return _maxEstimateRadius; }
+    SLuint  numBytes() const { return (SLuint)(_photons.capacity() * sizeof(SLPhoton)); }
 
-      //additional methods
-      void     setPhotonMapParams   (SLlong maxStoredPhotons,
-                                     SLuint maxEstimationPhotons,
-                                     SLfloat maxEstimationRadius
-                                    );
-      void     setTestParams        (SLuint maxEstimationPhotons,
-                                     SLfloat maxEstimationRadius);
-      SLbool   isDone               ()             {return _storedPhotons>0;};
-      SLbool   isFull               ()             {return _storedPhotons>=_maxStoredPhotons;}
-      SLlong   storedPhotons        ()             {return _storedPhotons;}
-      SLVec3f  photonPosition       (SLlong index) {SLVec3f pos((*_photonList)[index+1].pos);
-                                                    return SLVec3f((SLfloat)pos.x,(SLfloat) pos.y,(SLfloat)pos.z); }
-      SLVec3f  photonPower          (SLlong index) {return (*_photonList)[index+1].power.getRGBE();}
-      SLVec3f  maxPower             ()             {return _maxPower;};
-      SLVec3f  avgPower             ()             {return _sumPower/(SLfloat)_storedPhotons;};
-      SLfloat  maxRadius            ()             {return sqrt(_maxRadius);};
-      SLlong   maxPhotonsFound      ()             {return _maxPhotonsFound;};
-      SLlong   maxStoredPhotons     ()             {return _maxStoredPhotons;};
-      void     clearMax             ()             {_maxRadius=0;_maxPhotonsFound=0;};
+    private:
+    void balanceSegment(SLVuint& pbal,
+                        SLVuint& porg,
+                        SLint    index,
+                        SLint    start,
+                        SLint    end);
+    void medianSplit(SLVuint& p,
+                     SLint    start,
+                     SLint    end,
+                     SLint    median,
+                     SLint    axis);
 
-   private:
-      SLPhotonList* _photonList;       //!< the photonmap structure
-      SLlong   _storedPhotons;         //!< amount of stored photons
-      SLlong   _lastScaledPhoton;      //!< stores the index of the last scaled photon
-      SLlong   _maxStoredPhotons;      //!< max amount of photons to store in the photonmap
-      SLuint   _maxEstimationPhotons;  //!< max amount of nearest photons to locate
-      SLfloat  _maxEstimationRadius;   //!< max search radius to locate the nearest photons
-      SLVec3f  _bboxMax;               //!< max values for x,y,z coordinates
-      SLVec3f  _bboxMin;               //!< min values for x,y,z coordinates
-      SLVec3f  _maxPower;              //!< max stored power (used for drawing the photonmap in OGL)
-      SLVec3f  _sumPower;              //!< (used for drawing the photonmap in OGL)
-      SLfloat  _maxRadius;             //!< (used for statistic output concerning the estimation)
-      SLlong   _maxPhotonsFound;       //!< (used for statistic output concerning the estimation)
-      SLlong   _balanced;              //!< (used for indicating progress of balancing)
-      SLlong   _char;                  //!< (used for indicating progress of balancing)
+    SLVPhoton _photons;            //!< photons with index 1..numPhotons (0 unused)
+    SLint     _numPhotons;         //!< NO. of stored photons
+    SLbool    _isBalanced;         //!< flag if the kd-tree is built
+    SLint     _maxEstimatePhotons; //!< max. NO. of nearest photons to locate
+    SLfloat   _maxEstimateRadius;  //!< max. search radius for the nearest photons
+    SLVec3f   _bboxMin;            //!< min. corner of all photon positions
+    SLVec3f   _bboxMax;            //!< max. corner of all photon positions
 };
 //-----------------------------------------------------------------------------
-#endif
\ No newline at end of file
+#endif
@@ -1,6 +1,6 @@
 //#############################################################################
 //  File:      SLPhotonMapper.h
-//  Author:    Marcus Hudritsch
+//  Author:    Michael Strub, Stefan Traud, Marcus Hudritsch
 //  Date:      September 2011 (HS11)
 //  Copyright: M. Hudritsch, Fachhochschule Nordwestschweiz
 //             This software is provide under the GNU General Public License
@@ -10,68 +10,101 @@
 #ifndef SLPHOTONMAPPER_H
 #define SLPHOTONMAPPER_H
 
-#include <stdafx.h>
-#include <randomc.h>       // high qualtiy random generators
-#include <SLRaytracer.h>
 #include <SLPhotonMap.h>
+#include <SLRaytracer.h>
 
 class SLLight;
+class SLNode;
 
 //-----------------------------------------------------------------------------
-typedef enum 
-{  LIGHT=0, 
-   GLOBAL=1, 
-   CAUSTIC=2
-} SLPhotonType;
+//! NO. of photons that are emitted by one task of the render pool
+#define SL_PHOTON_CHUNK 2048
+//! Max. NO. of bounces of a photon path
+#define SL_PHOTON_MAX_DEPTH 32
 //-----------------------------------------------------------------------------
-//! 
-/*!      
-
+//! Photon mapper with a caustic and a global photon map
+/*!
+The photon mapper extends the Whitted style ray tracing of SLRaytracer with
+the two photon maps of H. W. Jensen:
+\n The caustic map holds the photons of the paths light - specular - diffuse.
+\n The global map holds the photons that hit a diffuse surface after at least
+one diffuse bounce.
+The direct light and the specular reflections and refractions are calculated
+by SLRaytracer. The overridden shade adds the radiance estimates of both maps
+on diffuse surfaces. So no light path is counted twice. Like in
+SLRaytracer::shade the 1/PI of the Lambertian BRDF is omitted.
+The photons are emitted from point, spot and rectangular lights in chunks by
+the threads of the render pool. Every thread collects its photons in its own
+buffers that are merged before the kd-trees get built by SLPhotonMap::balance.
+The photons get scattered by Russian roulette with the probabilities kr and kt
+of the material and its diffuse color for the rest. All sample values of a
+photon come from SLSampler::local after startPixel with the light and the
+photon index, so the maps are the same for the same seed.
+The image is rendered with SLRaytracer::renderDistrib and the radiance
+estimates are done by all render threads in parallel.
+With doPhotonCaching the maps are only emitted again if anything else than the
+camera changed in the scene (see sceneSignature).
 */
-class SLPhotonMapper: public SLRaytracer
-{  public:           
-                           SLPhotonMapper ();
-                          ~SLPhotonMapper ();
-            
-            // classic ray tracer functions
-            SLbool         render         ();
-            SLCol4f        trace          (SLRay* ray);
-            SLCol4f        shade          (SLRay* ray);
+class SLPhotonMapper : public SLRaytracer
+{
+    public:
+    SLPhotonMapper();
+    ~SLPhotonMapper() { SL_LOG("Destructor      : ~SLPhotonMapper\n"); }
+
+    SLbool  render(SLSceneView* sv);
+    SLCol4f shade(SLRay* ray) override;
+    void    emitPhotons();
+    void    emitChunk(SLuint light, SLuint first, SLuint count, SLuint worker);
+    void    scatterPhoton(SLRay* photon, SLVec3f power, SLuint worker);
+
+    // Setters
+    void numPhotons(SLuint n)
+    {
+        _numPhotons   = n;
+        _mapsAreValid = false;
+    }
+    void doGlobalIllum(SLbool gi) { _doGlobalIllum = gi; }
+    void doPhotonCaching(SLbool cache) { _doPhotonCaching = cache; }
+    void causticRadius(SLfloat r) { _causticRadius = r; }
+    void globalRadius(SLfloat r) { _globalRadius = r; }
+
+    // Getters
+    SLuint             numPhotons() const { return _numPhotons; }
+    SLbool             doGlobalIllum() const { return _doGlobalIllum; }
+    SLbool             doPhotonCaching() const { return _doPhotonCaching; }
+    SLfloat            causticRadius() const { return _causticRadius; }
+    SLfloat            globalRadius() const { return _globalRadius; }
+    SLfloat            emitSec() const { return _emitSec; }
+    const SLPhotonMap& mapCaustic() const { return _mapCaustic; }
+    const SLPhotonMap& mapGlobal() const { return _mapGlobal; }
 
-            void           setPhotonmaps  (SLlong  photonsToEmit,
-                                           SLlong  maxCausticStoredPhotons, 
-                                           SLuint  maxCausticEstimationPhotons, 
-                                           SLfloat maxCausticEstimationRadius,
-                                           SLlong  maxGlobalStoredPhotons, 
-                                           SLuint  maxGlobalEstimationPhotons, 
-                                           SLfloat maxGlobalEstimationRadius);
-            void           photonScatter  (SLRay* photon, 
-                                           SLVec3f power, 
-                                           SLPhotonType photonType);
-            void           photonEmission (SLLight* light);
+    private:
+    SLuint64 sceneSignature();
+    void     hashNodeRec(SLNode* node, SLuint64& hash);
 
-            // Getters
-            SLPhotonMap*   mapCaustic        (){return _mapCaustic;}
-            SLPhotonMap*   mapGlobal         (){return _mapGlobal;}
-            SLlong         photonsToEmit     (){return _photonsToEmit;}
-            SLfloat        random            (){return (SLfloat)_random->Random();}
-            SLbool         mapCausticGotFull (){return _mapCausticGotFull;}
-            SLbool         mapGlobalGotFull  (){return _mapGlobalGotFull;}
-            void           mapCausticGotFull (SLbool mapCausticGotFull){_mapCausticGotFull=mapCausticGotFull;}
-            void           mapGlobalGotFull  (SLbool mapGlobalGotFull){_mapGlobalGotFull=mapGlobalGotFull;}
-                        
-   protected:
-            // random variables
-            TRanrotBGenerator* _random;
-            TRanrotBGenerator* _russianRandom;
+    //! Task of the photon emission: a chunk of photons of one light
+    struct EmitTask
+    {
+        SLuint light; //!< index of the light in _emitLights
+        SLuint first; //!< index of the first photon of the light
+        SLuint count; //!< NO. of photons of the chunk
+    };
 
-            // variables for photonmapping
-            SLPhotonMap*   _mapCaustic;         //!< pointer to caustics photonmap
-            SLPhotonMap*   _mapGlobal;          //!< pointer to global photonmap
-            SLbool         _mapCausticGotFull;  //!< holds if changed from not full to full
-            SLbool         _mapGlobalGotFull;   //!< holds if changed from not full to full
-            SLlong         _photonsToEmit;      //!< total number of photons to be emitted
-            SLfloat        _gamma;              //!< gamma correction
+    SLPhotonMap       _mapCaustic;      //!< caustic photon map
+    SLPhotonMap       _mapGlobal;       //!< global photon map
+    vector<SLVPhoton> _causticBuffers;  //!< caustic photons per worker
+    vector<SLVPhoton> _globalBuffers;   //!< global photons per worker
+    vector<SLLight*>  _emitLights;      //!< lights that emit photons
+    vector<SLVec3f>   _emitPower;       //!< power of one photon per light
+    vector<EmitTask>  _emitTasks;       //!< chunks of the photon emission
+    SLuint            _numPhotons;      //!< NO. of photons to emit from all lights
+    SLbool            _doGlobalIllum;   //!< flag for the global map estimate
+    SLbool            _doPhotonCaching; //!< flag for reusing the maps if only the camera moved
+    SLbool            _mapsAreValid;    //!< flag if the maps are emitted
+    SLuint64          _mapsSignature;   //!< scene signature of the emitted maps
+    SLfloat           _causticRadius;   //!< caustic search radius in scene radii
+    SLfloat           _globalRadius;    //!< global search radius in scene radii
+    SLfloat           _emitSec;         //!< time of the last emission in seconds
 };
 //-----------------------------------------------------------------------------
 #endif
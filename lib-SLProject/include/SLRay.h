@@ -92,6 +92,8 @@ class SLRay
     SLint        srcTriangle;     //!< Points to the triangle at ray origin
     SLCol4f      backgroundColor; //!< Background color at pixel x,y
     SLSceneView* sv;              //!< Pointer to the sceneview
+    SLfloat      coneWidth;       //!< Width of the ray cone at the origin (texture LOD)
+    SLfloat      coneAngle;       //!< Spread angle of the ray cone in radians
 
     // Members set after at intersection
     SLfloat hitU, hitV;  //!< barycentric coords in hit triangle
@@ -112,21 +114,9 @@ class SLRay
     SLfloat tmin;      //!< min. dist. of last AABB intersection
     SLfloat tmax;      //!< max. dist. of last AABB intersection
 
-    // static variables for statistics
-    static SLint   maxDepth;         //!< Max. recursion depth
-    static SLfloat minContrib;       //!< Min. contibution to color (1/256)
-    static SLuint  reflectedRays;    //!< NO. of reflected rays
-    static SLuint  refractedRays;    //!< NO. of refracted rays
-    static SLuint  ignoredRays;      //!< NO. of ignore refraction rays
-    static SLuint  shadowRays;       //!< NO. of shadow rays
-    static SLuint  tirRays;          //!< NO. of TIR refraction rays
-    static SLuint  tests;            //!< NO. of intersection tests
-    static SLuint  intersections;    //!< NO. of intersection
-    static SLint   depthReached;     //!< depth reached for a primary ray
-    static SLint   maxDepthReached;  //!< max. depth reached for all rays
-    static SLfloat avgDepth;         //!< average depth reached
-    static SLuint  subsampledRays;   //!< NO. of of subsampled rays
-    static SLuint  subsampledPixels; //!< NO. of of subsampled pixels
+    // static variables for the ray tracing limits (statistics see SLRayStats)
+    static SLint   maxDepth;   //!< Max. recursion depth
+    static SLfloat minContrib; //!< Min. contibution to color (1/256)
 };
 
 //-----------------------------------------------------------------------------
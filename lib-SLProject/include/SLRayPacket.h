@@ -0,0 +1,79 @@
+//#############################################################################
+//  File:      SLRayPacket.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLRAYPACKET_H
+#define SLRAYPACKET_H
+
+#include <SLMat4.h>
+#include <SLVec3.h>
+
+class SLRay;
+
+//-----------------------------------------------------------------------------
+//! NO. of rays in a packet (4 for SSE/NEON, 8 for AVX)
+#ifndef SL_PACKET_SIZE
+#    define SL_PACKET_SIZE 4
+#endif
+//-----------------------------------------------------------------------------
+//! Packet of coherent rays in structure of arrays (SoA) form
+/*! A ray packet holds SL_PACKET_SIZE rays with their origins, directions and
+inverse directions in separate float arrays in world and object space. All
+per ray calculations (AABB slab tests, ray-triangle tests, transforms) are
+done in fixed length loops over these arrays that the compiler vectorizes
+for SSE/AVX on x86 and NEON on ARM without platform specific intrinsics.
+The packet only references the SLRay objects. The hit information is written
+back into them (see SLMesh::hitTrianglePacketOS) so that the shading works
+with the usual scalar SLRay. Packets are only used for primary rays that
+share the same ray type and inside/outside state.
+*/
+class SLRayPacket
+{
+    public:
+    SLRayPacket();
+
+    void   set(SLRay** rays, SLint numRays);
+    void   toOS(const SLMat4f& wmI);
+    void   toRayOS(SLint i);
+    SLint  numActive() const;
+    SLbool hitAABBInWS(const SLVec3f& min,
+                       const SLVec3f& max,
+                       SLfloat&       tNear) const;
+    SLbool hitAABBInOS(const SLVec3f& min,
+                       const SLVec3f& max,
+                       SLfloat&       tNear) const;
+
+    // Rays in world space
+    alignas(32) SLfloat ox[SL_PACKET_SIZE];  //!< origin x in WS
+    alignas(32) SLfloat oy[SL_PACKET_SIZE];  //!< origin y in WS
+    alignas(32) SLfloat oz[SL_PACKET_SIZE];  //!< origin z in WS
+    alignas(32) SLfloat ix[SL_PACKET_SIZE];  //!< inverse direction x in WS
+    alignas(32) SLfloat iy[SL_PACKET_SIZE];  //!< inverse direction y in WS
+    alignas(32) SLfloat iz[SL_PACKET_SIZE];  //!< inverse direction z in WS
+    alignas(32) SLfloat dx[SL_PACKET_SIZE];  //!< direction x in WS
+    alignas(32) SLfloat dy[SL_PACKET_SIZE];  //!< direction y in WS
+    alignas(32) SLfloat dz[SL_PACKET_SIZE];  //!< direction z in WS
+
+    // Rays in object space of the current node
+    alignas(32) SLfloat oxOS[SL_PACKET_SIZE]; //!< origin x in OS
+    alignas(32) SLfloat oyOS[SL_PACKET_SIZE]; //!< origin y in OS
+    alignas(32) SLfloat ozOS[SL_PACKET_SIZE]; //!< origin z in OS
+    alignas(32) SLfloat dxOS[SL_PACKET_SIZE]; //!< direction x in OS
+    alignas(32) SLfloat dyOS[SL_PACKET_SIZE]; //!< direction y in OS
+    alignas(32) SLfloat dzOS[SL_PACKET_SIZE]; //!< direction z in OS
+    alignas(32) SLfloat ixOS[SL_PACKET_SIZE]; //!< inverse direction x in OS
+    alignas(32) SLfloat iyOS[SL_PACKET_SIZE]; //!< inverse direction y in OS
+    alignas(32) SLfloat izOS[SL_PACKET_SIZE]; //!< inverse direction z in OS
+
+    //! Closest hit distance per ray (-FLT_MAX for inactive rays)
+    alignas(32) SLfloat length[SL_PACKET_SIZE];
+
+    SLRay* rays[SL_PACKET_SIZE]; //!< Pointers to the rays (nullptr if inactive)
+};
+//-----------------------------------------------------------------------------
+#endif //SLRAYPACKET_H
@@ -0,0 +1,65 @@
+//#############################################################################
+//  File:      SLRayStats.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLRAYSTATS_H
+#define SLRAYSTATS_H
+
+#include <SL.h>
+
+//-----------------------------------------------------------------------------
+//! NO. of bins of the depth histogram (the last bin counts all deeper rays)
+#define SL_RAYSTATS_DEPTH_BINS 16
+//-----------------------------------------------------------------------------
+//! Ray tracing statistics of one render thread
+/*! Every thread that traces rays owns its own SLRayStats block that it gets
+with SLRayStats::local(). The counters are plain integers that are only
+written by their owner thread. So there are no atomic operations or locks in
+the innermost intersection loops. The thread local blocks are aligned to a
+cache line so that the counters of different threads never share one.
+After all render threads have finished a frame the blocks are summed up with
+SLRayStats::merged(). Blocks of threads that have already terminated are
+kept in an accumulated block until the next SLRayStats::resetAll().
+*/
+class SLRayStats
+{
+    public:
+    SLRayStats() { reset(); }
+
+    void    reset();
+    void    add(const SLRayStats& other);
+    void    primaryDone();
+    SLuint  totalRays() const;
+    SLfloat testsPerRay() const;
+    SLfloat avgDepth() const;
+
+    static SLRayStats& local();
+    static SLRayStats  merged();
+    static void        resetAll();
+
+    SLuint   primaryRays;      //!< NO. of primary rays (pixels)
+    SLuint   reflectedRays;    //!< NO. of reflected rays
+    SLuint   refractedRays;    //!< NO. of refracted rays
+    SLuint   ignoredRays;      //!< NO. of ignore refraction rays
+    SLuint   shadowRays;       //!< NO. of shadow rays
+    SLuint   occluderHits;     //!< NO. of shadow rays blocked by the cached occluder
+    SLuint   tirRays;          //!< NO. of TIR refraction rays
+    SLuint   subsampledRays;   //!< NO. of of subsampled rays
+    SLuint   subsampledPixels; //!< NO. of of subsampled pixels
+    SLuint64 tests;            //!< NO. of intersection tests
+    SLuint64 intersections;    //!< NO. of intersection
+    SLint    depthReached;     //!< depth reached for the current primary ray
+    SLint    maxDepthReached;  //!< max. depth reached for all rays
+    SLuint64 depthSum;         //!< sum of depth reached of all primary rays
+
+    //! NO. of primary rays per reached depth (index 0 = depth 1)
+    SLuint depthHistogram[SL_RAYSTATS_DEPTH_BINS];
+};
+//-----------------------------------------------------------------------------
+#endif //SLRAYSTATS_H
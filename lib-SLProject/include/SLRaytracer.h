@@ -12,6 +12,8 @@
 
 #include <SLEventHandler.h>
 #include <SLGLTexture.h>
+#include <SLRayStats.h>
+#include <SLRenderPool.h>
 
 class SLScene;
 class SLSceneView;
@@ -19,6 +21,9 @@ class SLRay;
 class SLMaterial;
 class SLCamera;
 
+//-----------------------------------------------------------------------------
+//! Min. NO. of samples of a pixel before renderTileMS may stop adaptively
+#define SL_RT_MIN_MS_SAMPLES 8
 //-----------------------------------------------------------------------------
 //! Ray tracing state
 typedef enum
@@ -59,15 +64,24 @@ class SLRaytracer : public SLGLTexture
     // ray tracer functions
     SLbool  renderClassic(SLSceneView* sv);
     SLbool  renderDistrib(SLSceneView* sv);
-    void    renderSlices(const bool isMainThread);
-    void    renderSlicesMS(const bool isMainThread);
+    SLbool  renderProgressive(SLSceneView* sv);
+    void    renderTile(const SLRenderTile& tile, SLuint worker);
+    void    renderTileMS(const SLRenderTile& tile, SLuint worker);
+    void    renderTileProgressive(const SLRenderTile& tile, SLint pass);
     SLCol4f trace(SLRay* ray);
-    SLCol4f shade(SLRay* ray);
-    void    sampleAAPixels(const bool isMainThread);
+    SLCol4f traceHit(SLRay* ray);
+    virtual SLCol4f shade(SLRay* ray);
+    void    sampleAAPixels(SLuint first, SLuint last);
     void    finishBeforeUpdate();
 
     // additional ray tracer functions
     void    setPrimaryRay(SLfloat x, SLfloat y, SLRay* primaryRay);
+    void    setLensRay(SLfloat x, SLfloat y, const SLVec2f& disc, SLRay* primaryRay);
+    void    renderPacket(SLint x, SLint y, const SLRenderTile& tile);
+    SLCol4f traceSample(SLint x, SLint y, SLint sample);
+    void    addSample(SLint x, SLint y, const SLCol4f& color);
+    SLuint  markRefinePixels(SLint pass);
+    void    updateWindow(SLuint worker, SLint pcStart, SLint pcRange);
     void    getAAPixels();
     SLCol4f fogBlend(SLfloat z, SLCol4f color);
     void    printStats(SLfloat sec);
@@ -76,7 +90,8 @@ class SLRaytracer : public SLGLTexture
     // Setters
     void state(SLRTState state)
     {
-        if (_state != rtBusy) _state = state;
+        // A progressive RT is only busy within its steps and can be stopped
+        if (_state != rtBusy || _progPass >= 0) _state = state;
     }
     void maxDepth(SLint depth)
     {
@@ -94,6 +109,19 @@ class SLRaytracer : public SLGLTexture
         _doFresnel = fresnel;
         state(rtReady);
     }
+    void doPackets(SLbool packets)
+    {
+        _doPackets = packets;
+        state(rtReady);
+    }
+    void doProgressive(SLbool progressive)
+    {
+        _doProgressive = progressive;
+        state(rtReady);
+    }
+    void frameBudgetMS(SLfloat ms) { _frameBudgetMS = ms; }
+    void numThreads(SLuint threads) { _numThreads = threads; }
+    void varThreshold(SLfloat threshold) { _varThreshold = threshold; }
     void aaSamples(SLint samples)
     {
         _aaSamples = samples;
@@ -111,14 +139,25 @@ class SLRaytracer : public SLGLTexture
     SLbool    doDistributed() const { return _doDistributed; }
     SLbool    doContinuous() const { return _doContinuous; }
     SLbool    doFresnel() const { return _doFresnel; }
+    SLbool    doPackets() const { return _doPackets; }
+    SLbool    doProgressive() const { return _doProgressive; }
+    SLbool    isProgressing() const { return _state == rtBusy && _progPass >= 0; }
+    SLfloat   frameBudgetMS() const { return _frameBudgetMS; }
+    SLfloat   varThreshold() const { return _varThreshold; }
     SLint     aaSamples() const { return _aaSamples; }
-    SLuint    numThreads() const { return SL::maxThreads(); }
+    SLuint    numThreads() const
+    {
+        return _numThreads ? SL_min(_numThreads, SL::maxThreads()) : SL::maxThreads();
+    }
     SLint     pcRendered() const { return _pcRendered; }
     SLfloat   aaThreshold() const { return _aaThreshold; }
     SLfloat   renderSec() const { return _renderSec; }
     SLfloat   gamma() { return _gamma; }
     SLfloat   oneOverGamma() { return _oneOverGamma; }
 
+    //! Ray statistics of the last finished frame
+    const SLRayStats& stats() const { return _stats; }
+
     // Render target image
     void prepareImage();
     void renderImage();
@@ -132,21 +171,40 @@ class SLRaytracer : public SLGLTexture
     SLbool       _doContinuous;  //!< if true state goes into ready again
     SLbool       _doDistributed; //!< Flag for parallel distributed RT
     SLbool       _doFresnel;     //!< Flag for Fresnel reflection
+    SLbool       _doPackets;     //!< Flag for packet tracing of primary rays
+    SLbool       _doProgressive; //!< Flag for progressive RT over many frames
     SLint        _pcRendered;    //!< % rendered
     SLfloat      _renderSec;     //!< Rendering time in seconds
+    SLRayStats   _stats;         //!< Merged ray statistics of the last frame
 
-    SLfloat     _pxSize;       //!< Pixel size
-    SLVec3f     _EYE;          //!< Camera position
-    SLVec3f     _LA, _LU, _LR; //!< Camera lookat, lookup, lookright
-    SLVec3f     _BL;           //!< Bottom left vector
-    atomic<int> _next;         //!< next index to render RT
-    SLVPixel    _aaPixels;     //!< Vector for antialiasing pixels
-    SLfloat     _gamma;        //!< gamma correction value
-    SLfloat     _oneOverGamma; //!< one over gamma correction value
+    SLfloat       _pxSize;       //!< Pixel size
+    SLVec3f       _EYE;          //!< Camera position
+    SLVec3f       _LA, _LU, _LR; //!< Camera lookat, lookup, lookright
+    SLVec3f       _BL;           //!< Bottom left vector
+    double        _tUpdate;      //!< Time of the last window update
+    SLVPixel      _aaPixels;     //!< Vector for antialiasing pixels
+    SLRenderPool& _pool;         //!< Shared render threads (see SLRenderPool::render)
+    SLuint        _numThreads;   //!< Max. NO. of render threads (0 = all)
+    SLVRenderTile _tiles;        //!< Image tiles in Hilbert curve order
+    SLfloat       _gamma;        //!< gamma correction value
+    SLfloat       _oneOverGamma; //!< one over gamma correction value
 
     // variables for distributed ray tracing
     SLfloat _aaThreshold; //!< threshold for anti aliasing
     SLint   _aaSamples;   //!< SQRT of uneven num. of AA samples
+
+    // variables for progressive ray tracing
+    SLint     _progPass;       //!< Current progressive pass (-1 = not running)
+    SLuint    _progTile;       //!< Next tile of the current progressive pass
+    SLint     _progMaxSamples; //!< Max. NO. of samples per pixel
+    SLfloat   _progMSPerTile;  //!< Measured ms per tile & worker of the pass
+    double    _progStart;      //!< Start time of the progressive RT
+    SLfloat   _frameBudgetMS;  //!< Max. time of one progressive step in ms
+    SLfloat   _varThreshold;   //!< Std. error of luminance for refinement
+    SLVCol3f  _progSum;        //!< Sum of the linear sample colors per pixel
+    SLVfloat  _progSumSq;      //!< Sum of the squared sample luminance per pixel
+    SLVushort _progNum;        //!< NO. of samples per pixel
+    SLVuchar  _progRefine;     //!< Flags of the pixels to refine in a pass
 };
 //-----------------------------------------------------------------------------
 #endif
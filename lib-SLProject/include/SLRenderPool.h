@@ -0,0 +1,114 @@
+//#############################################################################
+//  File:      SLRenderPool.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLRENDERPOOL_H
+#define SLRENDERPOOL_H
+
+#include <SL.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//-----------------------------------------------------------------------------
+//! Default width and height of a render tile in pixels
+#define SL_RENDER_TILE_SIZE 16
+//-----------------------------------------------------------------------------
+//! Rectangular tile of an image that is rendered as one task
+struct SLRenderTile
+{
+    SLint x, y; //!< lower left pixel of the tile
+    SLint w, h; //!< width and height of the tile (smaller at the image border)
+};
+typedef vector<SLRenderTile> SLVRenderTile;
+//-----------------------------------------------------------------------------
+//! Function that is called for every task with the task and worker index
+typedef std::function<void(SLuint task, SLuint worker)> SLRenderTaskFunc;
+//-----------------------------------------------------------------------------
+//! Persistent pool of render threads with per worker task deques
+/*! The SLRenderPool replaces the racy _next += 4 slice counters and the
+std::threads that were created for every frame by the SLRaytracer and the
+SLPathtracer. Its threads are created on the first call of run and sleep on a
+condition variable between the passes. They are reused for all passes of all
+frames.
+A call of run distributes the task indexes [0, numTasks) in contiguous blocks
+onto the deques of all workers. Each worker pops tasks from the front of its
+own deque. If it gets empty it steals tasks from the back of the deque of
+another worker. So expensive image regions (e.g. glass spheres) don't leave
+the other threads idle. A deque is a begin/end pair packed into one 64 bit
+atomic that is updated lock free with compare & swap.
+The calling (main) thread works as worker 0. So the task function can decide
+with the worker index whether it is allowed to update the window.
+With hilbertTiles an image gets divided into tiles that are ordered along a
+Hilbert curve. Consecutive tasks are therefore close to each other on the
+image, which keeps the scene data that is hit by neighbouring rays in the
+cache of a worker.
+The library uses only two pools: render() for the passes of all renderers
+and update() for the parallel parts of the scene update (transform store,
+skinning, grid builds). The scene update can start while a render pass is
+running, because worker 0 repaints the window in between (see
+SLRaytracer::updateWindow). A run that is started while its pool is still
+running executes all its tasks in the calling thread.
+*/
+class SLRenderPool
+{
+    public:
+    SLRenderPool();
+    ~SLRenderPool();
+
+    void run(SLuint                  numTasks,
+             const SLRenderTaskFunc& func,
+             SLuint                  maxWorkers = 0);
+
+    static void hilbertTiles(SLint          width,
+                             SLint          height,
+                             SLint          tileSize,
+                             SLVRenderTile& tiles);
+
+    static SLRenderPool& render();
+    static SLRenderPool& update();
+
+    // Getters
+    SLuint numWorkers() const { return (SLuint)_workers.size() + 1; }
+    SLuint numTasks() const { return _numTasks; }
+    SLuint numTasksDone() const { return _numTasksDone; }
+
+    private:
+    //! Task deque of a worker packed as begin (low) & end (high) index
+    struct Deque
+    {
+        std::atomic<SLuint64> range; //!< packed [begin, end) of the tasks
+    };
+
+    void   startWorkers(SLuint numThreads);
+    void   workerLoop(SLuint worker, SLuint64 seenGeneration);
+    void   work(SLuint worker);
+    SLbool popTask(SLuint worker, SLuint& task);
+    SLbool stealTask(SLuint worker, SLuint& task);
+
+    vector<std::thread>      _workers;      //!< Threads of the workers 1..n
+    std::unique_ptr<Deque[]> _deques;       //!< Task deques of all workers
+    SLuint                   _numDeques;    //!< NO. of deques
+    SLuint                   _numActive;    //!< NO. of workers in the current run
+    const SLRenderTaskFunc*  _func;         //!< Task function of the current run
+    SLuint                   _numTasks;     //!< NO. of tasks of the current run
+    std::atomic<SLuint>      _numTasksDone; //!< NO. of finished tasks
+    std::atomic<SLuint>      _numBusy;      //!< NO. of workers still working
+    std::atomic<SLbool>      _isRunning;    //!< Flag if a run is in progress
+    SLuint64                 _generation;   //!< Incremented for every run
+    SLbool                   _quit;         //!< Flag to terminate the threads
+    std::mutex               _mutex;        //!< Mutex for the condition variables
+    std::condition_variable  _wakeUp;       //!< Signals a new run to the workers
+    std::condition_variable  _finished;     //!< Signals the end of a run
+};
+//-----------------------------------------------------------------------------
+#endif //SLRENDERPOOL_H
@@ -0,0 +1,77 @@
+//#############################################################################
+//  File:      SLSampler.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLSAMPLER_H
+#define SLSAMPLER_H
+
+#include <SL.h>
+#include <SLEnums.h>
+#include <SLVec2.h>
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+//! Random and low discrepancy sample generator of one render thread
+/*! Every render thread gets its own sampler with SLSampler::local(). So the
+Monte Carlo methods (SLPathtracer, SLRay::reflectMC/refractMC/diffuseMC,
+SLLight::shadowTestMC) never share a generator or its cache line.
+A renderer calls startPixel(x, y, sample) before it traces a path. All numbers
+of the path are then a function of (seed, pixel, sample, dimension) only,
+where the dimension is incremented by every call of get1D. So the rendered
+images are bit-reproducible for the same seed, no matter which thread renders
+which pixel. The sample values depend on the global sampler type:
+\n ST_random: PCG32 stream hashed from (seed, pixel, sample).
+\n ST_halton: Halton sequence over the samples of a pixel with a random
+rotation per pixel and dimension (Cranley-Patterson).
+\n ST_sobol: 2D Sobol (0,2)-sequence for pairs of dimensions with a random
+digit scrambling and index shuffling per pixel and dimension pair.
+\n Without startPixel (e.g. the photon mapper) the sampler runs as plain PCG32
+stream that gets seeded once per thread.
+\n hashed2D returns a point that only depends on (seed, position, index)
+without touching the state of any sampler.
+The global seed and type must only be changed while no rendering is running.
+*/
+class SLSampler
+{
+    public:
+    SLSampler();
+
+    void    startPixel(SLint x, SLint y, SLuint sample);
+    SLfloat get1D();
+    SLVec2f get2D();
+
+    static SLSampler& local();
+    static SLVec2f    hashed2D(SLfloat x, SLfloat y, SLuint index);
+
+    // Setters
+    static void seed(SLuint seed);
+    static void type(SLSamplerType type) { _type = type; }
+
+    // Getters
+    static SLuint        seed() { return _seed; }
+    static SLSamplerType type() { return _type; }
+
+    private:
+    SLuint nextPCG();
+    void   seedPCG(SLuint64 state, SLuint64 stream);
+
+    SLuint64 _pcgState;   //!< State of the PCG32 generator
+    SLuint64 _pcgInc;     //!< Stream increment of the PCG32 generator (odd)
+    SLuint   _pixelHash;  //!< Hash of the seed and the current pixel
+    SLuint   _sample;     //!< Index of the current sample of the pixel
+    SLuint   _dimension;  //!< Index of the next dimension of the sample
+    SLbool   _hasPixel;   //!< Flag if startPixel was called
+    SLuint   _generation; //!< Seed generation the sampler was seeded with
+
+    static SLuint              _seed;           //!< Global seed of all samplers
+    static SLSamplerType       _type;           //!< Global sampler type
+    static std::atomic<SLuint> _seedGeneration; //!< Incremented with every seed
+};
+//-----------------------------------------------------------------------------
+#endif //SLSAMPLER_H
@@ -31,6 +31,7 @@ class SLSamples2D
     SLuint  samplesY() { return _samplesY; }
     SLuint  samples() { return _samples; }
     SLVec2f point(SLuint x, SLuint y) { return _points[x * _samplesY + y]; }
+    SLVec2f stratumPoint(SLuint iR, SLuint iPhi, SLfloat jR, SLfloat jPhi);
     SLuint  sizeInBytes() { return (SLuint)(_points.size() * sizeof(SLVec2f)); }
 
     private:
@@ -40,6 +41,7 @@ class SLSamples2D
     SLuint   _samplesX; //!< No. of samples in x direction
     SLuint   _samplesY; //!< No. of samples in y direction
     SLuint   _samples;  //!< No. of samples = samplesX x samplesY
+    SLbool   _evenly;   //!< Flag if the samples are evenly distributed on the disc
     SLVVec2f _points;   //!< samplepoints for distributed tracing
 };
 //-----------------------------------------------------------------------------
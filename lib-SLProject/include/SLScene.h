@@ -20,6 +20,8 @@
 #include <SLMaterial.h>
 #include <SLMesh.h>
 #include <SLRect.h>
+#include <SLSceneBVH.h>
+#include <SLTransformStore.h>
 #include <SLTimer.h>
 #include <SLVec3.h>
 #include <SLVec4.h>
@@ -64,6 +66,7 @@ class SLScene : public SLObject
     void root2D(SLNode* root2D) { _root2D = root2D; }
     void globalAmbiLight(SLCol4f gloAmbi) { _globalAmbiLight = gloAmbi; }
     void stopAnimations(SLbool stop) { _stopAnimations = stop; }
+    void doGPUSkinning(SLbool doGPU) { _doGPUSkinning = doGPU; }
     void videoType(SLVideoType vt);
     void showDetection(SLbool st) { _showDetection = st; }
     void info(SLstring i) { _info = i; }
@@ -107,10 +110,14 @@ class SLScene : public SLObject
     SLMesh*       selectedMesh() { return _selectedMesh; }
     SLRectf&      selectedRect() { return _selectedRect; }
     SLbool        stopAnimations() const { return _stopAnimations; }
+    SLbool        doGPUSkinning() const { return _doGPUSkinning; }
     SLGLOculus*   oculus() { return &_oculus; }
+    SLSceneBVH&   sceneBVH() { return _sceneBVH; }
     SLint         numSceneCameras();
     SLCamera*     nextCameraInScene(SLSceneView* activeSV);
 
+    SLTransformStore& transformStore() { return _transformStore; }
+
     // Video stuff
     SLVideoType   videoType() { return _videoType; }
     SLGLTexture*  videoTexture() { return &_videoTexture; }
@@ -130,6 +137,10 @@ class SLScene : public SLObject
     void         unInit();
     void         selectNode(SLNode* nodeToSelect);
     void         selectNodeMesh(SLNode* nodeToSelect, SLMesh* meshToSelect);
+    void         updateMeshesForRays();
+    void         updateTransforms();
+    SLbool       hit(SLRay* ray);
+    void         hitPacket(SLRayPacket& packet);
 
     protected:
     SLVSceneView    _sceneViews;    //!< Vector of all sceneview pointers
@@ -171,8 +182,12 @@ class SLScene : public SLObject
     SLAvgFloat _captureTimesMS;   //!< Averaged time for video capturing in ms
 
     SLbool _stopAnimations; //!< Global flag for stopping all animations
+    SLbool _doGPUSkinning;  //!< Global flag for skinning in the vertex shader
+
+    SLGLOculus _oculus;   //!< Oculus Rift interface
+    SLSceneBVH _sceneBVH; //!< Top level BVH over the 3D scene nodes for ray tracing
 
-    SLGLOculus _oculus; //!< Oculus Rift interface
+    SLTransformStore _transformStore; //!< Flat world matrices of the 3D scene nodes
 
     // Video stuff
     SLVideoType  _videoType;       //!< Flag for using the live video image
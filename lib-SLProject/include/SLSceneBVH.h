@@ -0,0 +1,100 @@
+//#############################################################################
+//  File:      SLSceneBVH.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLSCENEBVH_H
+#define SLSCENEBVH_H
+
+#include <SLVec3.h>
+
+class SLNode;
+class SLRay;
+class SLRayPacket;
+
+//-----------------------------------------------------------------------------
+//! Top level bounding volume hierarchy over the nodes of the 3D scene graph
+/*! The SLSceneBVH is the top level of a two-level acceleration structure for
+ray tracing. Its leaves are the nodes of the scene graph with meshes. The
+bottom level is the per mesh acceleration structure (SLAccelStruct) that is
+intersected in the object space of the node by SLNode::hitMeshes.
+A mesh that is referenced by several nodes is instanced: Its acceleration
+structure exists only once and every leaf transforms the ray into its own
+object space. So the memory grows only with the number of nodes.
+Instead of descending the scene graph hierarchy with SLNode::hitRec, a ray
+traverses the flat list of BVH nodes that is built with a binned surface area
+heuristic (SAH) over the world space AABBs of the leaf nodes.
+Nodes that override SLNode::hitRec (e.g. the lights) are inserted as a leaf
+with their entire subtree so that their special ray handling is kept.
+If only transforms or meshes change (see SLNode::needAABBUpdate) the
+hierarchy gets only refitted. The hidden flags of the leaves are collected at
+every update, so that the rays don't have to check the parents of a leaf. If the scene graph structure changes (e.g.
+SLNode::addChild) it gets rebuilt at the next call of update.
+*/
+class SLSceneBVH
+{
+    public:
+    SLSceneBVH();
+    ~SLSceneBVH() { ; }
+
+    void   update(SLNode* root);
+    void   build(SLNode* root);
+    void   refit();
+    void   clear();
+    SLbool intersect(SLRay* ray);
+    void   intersectPacket(SLRayPacket& packet);
+
+    // Setters
+    void needRebuild() { _needsRebuild = true; }
+    void needRefit() { _needsRefit = true; }
+    void isEnabled(SLbool enabled) { _isEnabled = enabled; }
+
+    // Getters
+    SLbool isEnabled() const { return _isEnabled; }
+    SLuint numNodes() const { return (SLuint)_nodes.size(); }
+    SLuint numLeaves() const { return (SLuint)_leaves.size(); }
+    SLuint numBytes() const;
+
+    private:
+    //! A leaf entry that references a scene graph node
+    struct Leaf
+    {
+        SLNode* node;          //!< Pointer to the scene graph node
+        SLbool  isSubtree;     //!< Flag if the entire subtree is intersected by hitRec
+        SLbool  isHidden;      //!< Flag if the node or one of its parents is hidden
+        SLbool  hasMeshParent; //!< Flag if a parent has meshes (source of shadow rays)
+        SLVec3f min;           //!< Minimum of the world space AABB
+        SLVec3f max;           //!< Maximum of the world space AABB
+        SLVec3f center;        //!< Center of the world space AABB
+    };
+
+    //! A node of the flattened hierarchy
+    struct Node
+    {
+        SLVec3f min;   //!< Minimum of the world space AABB
+        SLVec3f max;   //!< Maximum of the world space AABB
+        SLuint  first; //!< Index of the first leaf or of the left child
+        SLuint  count; //!< NO. of leaves (0 for an inner node)
+    };
+
+    void   collectLeavesRec(SLNode* node);
+    void   updateLeafAABB(Leaf& leaf);
+    void   updateLeafFlags(Leaf& leaf);
+    SLuint buildRec(SLuint first, SLuint count, SLint depth);
+    SLbool isHitAABB(const Node& n, SLRay* ray, SLfloat& tNear) const;
+    SLbool isExcluded(const Leaf& leaf, SLRay* ray) const;
+
+    std::vector<Leaf> _leaves;       //!< Leaves in the order of the hierarchy
+    std::vector<Node> _nodes;        //!< Flattened hierarchy with the root at index 0
+    SLNode*           _root;         //!< Root node the hierarchy was built for
+    SLbool            _needsRebuild; //!< Flag if the scene graph structure changed
+    SLbool            _needsRefit;   //!< Flag if an AABB in the scene graph changed
+    SLbool            _isEnabled;    //!< Flag if the BVH is used for ray intersection
+};
+//-----------------------------------------------------------------------------
+#endif //SLSCENEBVH_H
@@ -19,6 +19,7 @@
 #include <SLGLVertexArrayExt.h>
 #include <SLNode.h>
 #include <SLPathtracer.h>
+#include <SLPhotonMapper.h>
 #include <SLRaytracer.h>
 #include <SLScene.h>
 #include <SLSkybox.h>
@@ -116,6 +117,7 @@ class SLSceneView : public SLObject
     void   draw2DGLNodes();
     SLbool draw3DRT();
     SLbool draw3DPT();
+    SLbool draw3DPM();
 
     // SceneView camera
     void   initSceneViewCamera(const SLVec3f& dir  = -SLVec3f::AXISZ,
@@ -128,6 +130,7 @@ class SLSceneView : public SLObject
     SLstring windowTitle();
     void     startRaytracing(SLint maxDepth);
     void     startPathtracing(SLint maxDepth, SLint samples);
+    void     startPhotonMapping(SLint maxDepth);
     void     printStats() { _stats3D.print(); }
     SLbool   testRunIsFinished();
 
@@ -148,36 +151,37 @@ class SLSceneView : public SLObject
     void renderType(SLRenderType rt) { _renderType = rt; }
 
     // Getters
-    SLuint        index() const { return _index; }
-    SLCamera*     camera() { return _camera; }
-    SLCamera*     sceneViewCamera() { return &_sceneViewCamera; }
-    SLSkybox*     skybox() { return _skybox; }
-    SLint         scrW() const { return _scrW; }
-    SLint         scrH() const { return _scrH; }
-    SLint         scrWdiv2() const { return _scrWdiv2; }
-    SLint         scrHdiv2() const { return _scrHdiv2; }
-    SLfloat       scrWdivH() const { return _scrWdivH; }
-    SLGLImGui&    gui() { return _gui; }
-    SLbool        gotPainted() const { return _gotPainted; }
-    SLbool        hasMultiSampling() const { return _stateGL->hasMultiSampling(); }
-    SLbool        doFrustumCulling() const { return _doFrustumCulling; }
-    SLbool        doMultiSampling() const { return _doMultiSampling; }
-    SLbool        doDepthTest() const { return _doDepthTest; }
-    SLbool        doWaitOnIdle() const { return _doWaitOnIdle; }
-    SLVNode*      visibleNodes() { return &_visibleNodes; }
-    SLVNode*      visibleNodes2D() { return &_visibleNodes2D; }
-    SLVNode*      blendNodes() { return &_blendNodes; }
-    SLRaytracer*  raytracer() { return &_raytracer; }
-    SLPathtracer* pathtracer() { return &_pathtracer; }
-    SLRenderType  renderType() const { return _renderType; }
-    SLGLOculusFB* oculusFB() { return &_oculusFB; }
-    SLDrawBits*   drawBits() { return &_drawBits; }
-    SLbool        drawBit(SLuint bit) { return _drawBits.get(bit); }
-    SLfloat       cullTimeMS() const { return _cullTimeMS; }
-    SLfloat       draw3DTimeMS() const { return _draw3DTimeMS; }
-    SLfloat       draw2DTimeMS() const { return _draw2DTimeMS; }
-    SLNodeStats&  stats2D() { return _stats2D; }
-    SLNodeStats&  stats3D() { return _stats3D; }
+    SLuint          index() const { return _index; }
+    SLCamera*       camera() { return _camera; }
+    SLCamera*       sceneViewCamera() { return &_sceneViewCamera; }
+    SLSkybox*       skybox() { return _skybox; }
+    SLint           scrW() const { return _scrW; }
+    SLint           scrH() const { return _scrH; }
+    SLint           scrWdiv2() const { return _scrWdiv2; }
+    SLint           scrHdiv2() const { return _scrHdiv2; }
+    SLfloat         scrWdivH() const { return _scrWdivH; }
+    SLGLImGui&      gui() { return _gui; }
+    SLbool          gotPainted() const { return _gotPainted; }
+    SLbool          hasMultiSampling() const { return _stateGL->hasMultiSampling(); }
+    SLbool          doFrustumCulling() const { return _doFrustumCulling; }
+    SLbool          doMultiSampling() const { return _doMultiSampling; }
+    SLbool          doDepthTest() const { return _doDepthTest; }
+    SLbool          doWaitOnIdle() const { return _doWaitOnIdle; }
+    SLVNode*        visibleNodes() { return &_visibleNodes; }
+    SLVNode*        visibleNodes2D() { return &_visibleNodes2D; }
+    SLVNode*        blendNodes() { return &_blendNodes; }
+    SLRaytracer*    raytracer() { return &_raytracer; }
+    SLPathtracer*   pathtracer() { return &_pathtracer; }
+    SLPhotonMapper* photonMapper() { return &_photonMapper; }
+    SLRenderType    renderType() const { return _renderType; }
+    SLGLOculusFB*   oculusFB() { return &_oculusFB; }
+    SLDrawBits*     drawBits() { return &_drawBits; }
+    SLbool          drawBit(SLuint bit) { return _drawBits.get(bit); }
+    SLfloat         cullTimeMS() const { return _cullTimeMS; }
+    SLfloat         draw3DTimeMS() const { return _draw3DTimeMS; }
+    SLfloat         draw2DTimeMS() const { return _draw2DTimeMS; }
+    SLNodeStats&    stats2D() { return _stats2D; }
+    SLNodeStats&    stats3D() { return _stats3D; }
 
     static const SLint LONGTOUCH_MS; //!< Milliseconds duration of a long touch event
 
@@ -193,7 +197,7 @@ class SLSceneView : public SLObject
     SLNodeStats _stats3D;    //!< Statistic numbers for 3D nodes
     SLbool      _gotPainted; //!< flag if this sceneview got painted
 
-    SLRenderType _renderType; //!< rendering type (GL,RT,PT)
+    SLRenderType _renderType; //!< rendering type (GL,RT,PT,PM)
 
     SLbool     _doDepthTest;      //!< Flag if depth test is turned on
     SLbool     _doMultiSampling;  //!< Flag if multisampling is on
@@ -232,6 +236,9 @@ class SLSceneView : public SLObject
 
     SLPathtracer _pathtracer; //!< Pathtracer
     SLbool       _stopPT;     //!< Flag to stop the PT
+
+    SLPhotonMapper _photonMapper; //!< Photon mapper
+    SLbool         _stopPM;       //!< Flag to stop the PM
 };
 //-----------------------------------------------------------------------------
 #endif
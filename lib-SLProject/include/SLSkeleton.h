@@ -13,11 +13,17 @@
 
 #include <SLAnimPlayback.h>
 #include <SLAnimation.h>
+#include <SLGLUniformBuffer.h>
 #include <SLJoint.h>
 
 class SLAnimManager;
 class SLSceneView;
 
+//-----------------------------------------------------------------------------
+//! Max. NO. of joints in the uniform block of the skinned shader programs
+#define SL_MAX_JOINTS 256
+//! Uniform buffer binding point of the joint matrices for GPU skinning
+#define SL_JOINT_BLOCK_BINDING 0
 //-----------------------------------------------------------------------------
 //! SLSkeleton keeps track of a skeletons joints and animations
 /*!
@@ -30,6 +36,10 @@ A mesh that is associated with a skeleton transforms all its vertices every
 frame by the joint weights. Every vertex of a mesh has weights for four joints
 by which it can be influenced.
 
+For the GPU skinning (see SLMesh::skinnedProgram) the joint matrices are
+uploaded into a uniform buffer once per frame in which the skeleton changed,
+no matter how many meshes are bound to it (see bindJointBuffer).
+
 SLAnimations for this skeleton are also kept in this class. The SLAnimations
 have tracks corresponding to the individual SLJoints in the skeleton.
 
@@ -66,6 +76,7 @@ class SLSkeleton
     void loadAnimation(const SLstring& file);
     void addAnimation(SLAnimation* anim);
     void getJointMatrices(SLVMat4f& jointWM);
+    void bindJointBuffer(SLuint binding);
     void reset();
 
     // Getters
@@ -87,6 +98,7 @@ class SLSkeleton
     {
         _changed         = changed;
         _minMaxOutOfDate = true;
+        if (changed) _jointBufferOutOfDate = true;
     }
 
     SLbool updateAnimations(SLfloat elapsedTimeSec);
@@ -102,6 +114,10 @@ class SLSkeleton
     SLVec3f         _minOS;           //!< min point in os for this skeleton (attribute for skeleton instance)
     SLVec3f         _maxOS;           //!< max point in os for this skeleton (attribute for skeleton instance)
     SLbool          _minMaxOutOfDate; //!< dirty flag aabb rebuild
+
+    SLVMat4f          _jointMatrices;        //!< joint matrices for the GPU skinning
+    SLGLUniformBuffer _jointBuffer;          //!< uniform buffer of the joint matrices
+    SLbool            _jointBufferOutOfDate; //!< dirty flag for the joint buffer upload
 };
 //-----------------------------------------------------------------------------
 typedef std::vector<SLSkeleton*> SLVSkeleton;
@@ -0,0 +1,90 @@
+//#############################################################################
+//  File:      SLTexCache.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLTEXCACHE_H
+#define SLTEXCACHE_H
+
+#include <SL.h>
+#include <SLVec4.h>
+
+class SLCVImage;
+
+//-----------------------------------------------------------------------------
+//! Edge length of the square texel tiles (4x4 RGBA8 texels = 64 bytes)
+#define SL_TEXCACHE_TILE 4
+//-----------------------------------------------------------------------------
+//! CPU side copy of a texture image for the texture lookups of ray tracing
+/*!
+SLTexCache holds a texture image as RGBA8 mip pyramid for the ray tracers. It
+is built once per image by SLGLTexture::getTexelf and is read only afterwards,
+so all render threads can sample it at once.
+The texels of every mip level are stored in tiles of 4x4 texels that fill one
+cache line. Within a tile the texels are in Morton order. So the four texels of
+a bilinear lookup and the lookups of neighbouring rays mostly hit the same
+cache line, even for large textures.
+sample does a trilinear lookup between the two mip levels around the level of
+detail. The level of detail is calculated by SLGLTexture::getTexelf out of the
+footprint of the ray cone (see SLRay::coneWidth). The four texels of a
+bilinear lookup are weighted with SSE2 or NEON if available.
+*/
+class SLTexCache
+{
+    public:
+    SLTexCache(SLCVImage* image, SLbool buildMipmaps);
+
+    SLCol4f sample(SLfloat   s,
+                   SLfloat   t,
+                   SLfloat   lod,
+                   SLTexWrap wrapS,
+                   SLTexWrap wrapT) const;
+    SLCol4f sampleNearest(SLfloat   s,
+                          SLfloat   t,
+                          SLTexWrap wrapS,
+                          SLTexWrap wrapT) const;
+
+    // Getters
+    SLint  width() const { return _levels[0].width; }
+    SLint  height() const { return _levels[0].height; }
+    SLint  numLevels() const { return (SLint)_levels.size(); }
+    SLuint numBytes() const;
+
+    private:
+    //! One mip level with its texels in tiles of 4x4 texels
+    struct SLTexLevel
+    {
+        SLint   width;  //!< width in texels
+        SLint   height; //!< height in texels
+        SLint   tilesX; //!< NO. of tiles in x direction
+        SLVuint texels; //!< packed RGBA8 texels tile by tile
+    };
+
+    inline SLuint  texelIndex(const SLTexLevel& level, SLint x, SLint y) const;
+    SLCol4f        bilinear(const SLTexLevel& level,
+                            SLfloat           s,
+                            SLfloat           t,
+                            SLTexWrap         wrapS,
+                            SLTexWrap         wrapT) const;
+    void           initLevel(SLTexLevel& level, SLint width, SLint height);
+    void           loadLevel0(SLCVImage* image);
+    void           buildLevel(const SLTexLevel& src, SLTexLevel& dst);
+
+    vector<SLTexLevel> _levels; //!< mip levels from the full resolution on
+};
+//-----------------------------------------------------------------------------
+//! Returns the index of the texel x, y in the tiled texel vector of a level
+inline SLuint SLTexCache::texelIndex(const SLTexLevel& level, SLint x, SLint y) const
+{
+    // index of the tile and Morton order of the 2 bit coords within the tile
+    SLuint tile   = (SLuint)((y >> 2) * level.tilesX + (x >> 2));
+    SLuint morton = (SLuint)((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2));
+    return (tile << 4) | morton;
+}
+//-----------------------------------------------------------------------------
+#endif //SLTEXCACHE_H
@@ -0,0 +1,83 @@
+//#############################################################################
+//  File:      SLTransformStore.h
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLTRANSFORMSTORE_H
+#define SLTRANSFORMSTORE_H
+
+#include <SLMat3.h>
+#include <SLMat4.h>
+
+class SLNode;
+
+//-----------------------------------------------------------------------------
+//! NO. of nodes of a tree level that are updated by one task
+#define SL_TRANSFORM_BATCH 256
+//-----------------------------------------------------------------------------
+//! Flat store of the world matrices of all nodes of the 3D scene graph
+/*!
+The SLTransformStore holds the world matrix, its inverse and the normal
+matrix of all nodes under the root node in contiguous arrays. The nodes are
+sorted by their depth in the tree (breadth first), so every node is stored
+after its parent and all nodes of one tree level lie in one index range.
+\n update recalculates the world matrices of all nodes that are flagged by
+SLNode::needUpdate level by level. The nodes of a large level are split into
+batches of SL_TRANSFORM_BATCH nodes that run on the threads of the update
+pool (see SLRenderPool::update).
+A node reads only the world matrix of its parent from the level above, so the
+batches need no locks. The matrix product is done with SSE2 or NEON if
+available and the inverse is the cheaper affine inverse.
+\n The SLNode::updateAndGetWM, updateAndGetWMI and updateAndGetWMN accessors
+of a stored node read the matrices from the store. If a transform changes
+between two updates the accessors update the single node lazily with the
+parent pointer like without the store.
+\n If the structure of the scene graph changes (see SLNode::addChild) the
+arrays get rebuilt at the next update. Deleted nodes remove themselves.
+*/
+class SLTransformStore
+{
+    public:
+    SLTransformStore();
+    ~SLTransformStore() { clear(); }
+
+    void update(SLNode* root);
+    void build(SLNode* root);
+    void clear();
+    void updateNode(SLint index);
+    void removeNode(SLint index);
+
+    // Setters
+    void needRebuild() { _needsRebuild = true; }
+    void markDirty(SLint index) { _dirty[(SLuint)index] = 1; }
+    void isEnabled(SLbool enabled);
+
+    // Getters
+    SLbool         isEnabled() const { return _isEnabled; }
+    SLuint         numNodes() const { return (SLuint)_nodes.size(); }
+    SLuint         numLevels() const { return _levels.empty() ? 0 : (SLuint)_levels.size() - 1; }
+    const SLMat4f& wm(SLint index) const { return _wm[(SLuint)index]; }
+    const SLMat4f& wmI(SLint index) const { return _wmI[(SLuint)index]; }
+    const SLMat3f& wmN(SLint index) const { return _wmN[(SLuint)index]; }
+
+    private:
+    SLuint updateRange(SLuint first, SLuint last);
+    void   finishNode(SLuint index);
+
+    vector<SLNode*> _nodes;        //!< nodes sorted by depth (breadth first)
+    vector<SLint>   _parents;      //!< index of the parent node (-1 for the root)
+    SLVuint         _levels;       //!< start index of every level & end index
+    SLVuchar        _dirty;        //!< flag per node if its matrices are outdated
+    vector<SLMat4f> _wm;           //!< world matrices
+    vector<SLMat4f> _wmI;          //!< inverse world matrices
+    vector<SLMat3f> _wmN;          //!< normal world matrices
+    SLbool          _isEnabled;    //!< flag if the store is used
+    SLbool          _needsRebuild; //!< flag if the scene graph structure changed
+};
+//-----------------------------------------------------------------------------
+#endif //SLTRANSFORMSTORE_H
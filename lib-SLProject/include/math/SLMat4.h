@@ -216,6 +216,7 @@ class SLMat4
          SLMat4<T>   transposed  ();
          void        invert      ();
          SLMat4<T>   inverted    () const;
+         SLMat4<T>   invertedAffine() const;
          SLMat3<T>   inverseTransposed();
          T           trace       () const;
 
@@ -1337,6 +1338,49 @@ SLMat4<T> SLMat4<T>::inverted() const
     return i;
 }
 //-----------------------------------------------------------------------------
+/*! Computes the inverse of an affine matrix with the bottom row (0,0,0,1).
+Only the upper left 3x3 matrix gets inverted by its adjugate and the
+translation is rotated back. This is about three times cheaper than inverted.
+Non affine matrices (e.g. projections) are inverted with inverted.
+*/
+template<class T>
+SLMat4<T> SLMat4<T>::invertedAffine() const
+{
+    if (_m[3] != 0 || _m[7] != 0 || _m[11] != 0 || _m[15] != 1)
+        return inverted();
+
+    // Cofactors of the first column of the 3x3 matrix
+    T c0 = _m[5]*_m[10] - _m[9]*_m[6];
+    T c1 = _m[9]*_m[ 2] - _m[1]*_m[10];
+    T c2 = _m[1]*_m[ 6] - _m[5]*_m[ 2];
+    T det = _m[0]*c0 + _m[4]*c1 + _m[8]*c2;
+
+    if (fabs(det) < FLT_EPSILON)
+        return inverted();
+
+    T invDet = 1 / det;
+    SLMat4<T> i;
+    i._m[ 0] = c0 * invDet;
+    i._m[ 1] = c1 * invDet;
+    i._m[ 2] = c2 * invDet;
+    i._m[ 3] = 0;
+    i._m[ 4] = (_m[8]*_m[ 6] - _m[4]*_m[10]) * invDet;
+    i._m[ 5] = (_m[0]*_m[10] - _m[8]*_m[ 2]) * invDet;
+    i._m[ 6] = (_m[4]*_m[ 2] - _m[0]*_m[ 6]) * invDet;
+    i._m[ 7] = 0;
+    i._m[ 8] = (_m[4]*_m[ 9] - _m[8]*_m[ 5]) * invDet;
+    i._m[ 9] = (_m[8]*_m[ 1] - _m[0]*_m[ 9]) * invDet;
+    i._m[10] = (_m[0]*_m[ 5] - _m[4]*_m[ 1]) * invDet;
+    i._m[11] = 0;
+
+    // The translation is -M^-1 * t
+    i._m[12] = -(i._m[0]*_m[12] + i._m[4]*_m[13] + i._m[ 8]*_m[14]);
+    i._m[13] = -(i._m[1]*_m[12] + i._m[5]*_m[13] + i._m[ 9]*_m[14]);
+    i._m[14] = -(i._m[2]*_m[12] + i._m[6]*_m[13] + i._m[10]*_m[14]);
+    i._m[15] = 1;
+    return i;
+}
+//-----------------------------------------------------------------------------
 /*! Computes the inverse transposed matrix of the upper left 3x3 matrix for
 the transformation of vertex normals.
 */
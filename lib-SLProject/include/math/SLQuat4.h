@@ -826,6 +826,7 @@ inline void SLQuat4<T>::slerp(const SLQuat4<T>& q1,
 }
 
 //-----------------------------------------------------------------------------
-typedef SLQuat4<SLfloat> SLQuat4f;
+typedef SLQuat4<SLfloat>      SLQuat4f;
+typedef std::vector<SLQuat4f> SLVQuat4f;
 //-----------------------------------------------------------------------------
 #endif
@@ -169,6 +169,11 @@ void SLGLProgram::init()
         _isLinked = true;
         for (auto shader : _shaders)
             _name += "+" + shader->name();
+
+        // bind the uniform blocks once after linking
+        if (_stateGL->glIsES3() || _stateGL->glVersionNOf() >= 3.1f)
+            for (auto& block : _uniformBlocks)
+                uniformBlockBinding(block.first.c_str(), block.second);
         //SL_LOG("Linked: %s", _name.c_str());
     }
     else
@@ -293,6 +298,15 @@ void SLGLProgram::addUniform1i(SLGLUniform1i* u)
     _uniforms1i.push_back(u);
 }
 //-----------------------------------------------------------------------------
+/*! SLGLProgram::addUniformBlock adds a uniform block that gets bound to the
+uniform buffer binding point when the program is linked (see init). So the
+block index has not to be looked up at every draw call.
+*/
+void SLGLProgram::addUniformBlock(const SLstring& name, SLuint binding)
+{
+    _uniformBlocks[name] = binding;
+}
+//-----------------------------------------------------------------------------
 SLint SLGLProgram::getUniformLocation(const SLchar* name)
 {
     SLint loc = glGetUniformLocation(_objectGL, name);
@@ -533,3 +547,16 @@ void SLGLProgram::uniformMatrix4fv(const SLint    loc,
     glUniformMatrix4fv(loc, count, transpose, value);
 }
 //-----------------------------------------------------------------------------
+//! Binds the uniform block "name" to a uniform buffer binding point
+/*! Returns the index of the uniform block or -1 if the program has no such
+block. The buffer is bound with SLGLUniformBuffer::bindBase. Uniform blocks need
+OpenGL 3.1 or OpenGL ES 3.0.
+*/
+SLint SLGLProgram::uniformBlockBinding(const SLchar* name, SLuint binding)
+{
+    SLuint index = glGetUniformBlockIndex(_objectGL, name);
+    if (index == GL_INVALID_INDEX) return -1;
+    glUniformBlockBinding(_objectGL, index, binding);
+    return (SLint)index;
+}
+//-----------------------------------------------------------------------------
@@ -97,30 +97,49 @@ void SLGLState::initAll()
 
     globalAmbientLight.set(0.2f, 0.2f, 0.2f, 0.0f);
 
-    _glVersion     = SLstring((const char*)glGetString(GL_VERSION));
-    _glVersionNO   = getGLVersionNO();
-    _glVersionNOf  = (SLfloat)atof(_glVersionNO.c_str());
-    _glVendor      = SLstring((const char*)glGetString(GL_VENDOR));
-    _glRenderer    = SLstring((const char*)glGetString(GL_RENDERER));
-    _glSLVersion   = SLstring((const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
-    _glSLVersionNO = getSLVersionNO();
-    _glIsES2       = (_glVersion.find("OpenGL ES 2") != string::npos);
-    _glIsES3       = (_glVersion.find("OpenGL ES 3") != string::npos);
+    // Without a current context glGetString returns null (headless apps)
+    const GLubyte* version = glGetString(GL_VERSION);
+    _hasContext            = version != nullptr;
+
+    _glVersion.clear();
+    _glVersionNO.clear();
+    _glVersionNOf = 0.0f;
+    _glVendor.clear();
+    _glRenderer.clear();
+    _glSLVersion.clear();
+    _glSLVersionNO.clear();
+    _glExtensions.clear();
+    _glIsES2            = false;
+    _glIsES3            = false;
+    _multiSampleSamples = 0;
+
+    if (_hasContext)
+    {
+        _glVersion     = SLstring((const char*)version);
+        _glVersionNO   = getGLVersionNO();
+        _glVersionNOf  = (SLfloat)atof(_glVersionNO.c_str());
+        _glVendor      = SLstring((const char*)glGetString(GL_VENDOR));
+        _glRenderer    = SLstring((const char*)glGetString(GL_RENDERER));
+        _glSLVersion   = SLstring((const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+        _glSLVersionNO = getSLVersionNO();
+        _glIsES2       = (_glVersion.find("OpenGL ES 2") != string::npos);
+        _glIsES3       = (_glVersion.find("OpenGL ES 3") != string::npos);
 
 // Get extensions
 #ifndef SL_GLES2
-    if (_glVersionNOf > 3.0f)
-    {
-        GLint n;
-        glGetIntegerv(GL_NUM_EXTENSIONS, &n);
-        for (SLuint i = 0; i < (SLuint)n; i++)
-            _glExtensions += SLstring((const char*)glGetStringi(GL_EXTENSIONS, i)) + ", ";
-    }
-    else
+        if (_glVersionNOf > 3.0f)
+        {
+            GLint n;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+            for (SLuint i = 0; i < (SLuint)n; i++)
+                _glExtensions += SLstring((const char*)glGetStringi(GL_EXTENSIONS, i)) + ", ";
+        }
+        else
 #endif
-    {
-        const GLubyte* ext = glGetString(GL_EXTENSIONS);
-        if (ext) _glExtensions = SLstring((const char*)ext);
+        {
+            const GLubyte* ext = glGetString(GL_EXTENSIONS);
+            if (ext) _glExtensions = SLstring((const char*)ext);
+        }
     }
 
     //initialize states a unset
@@ -148,6 +167,8 @@ void SLGLState::initAll()
 
     _isInitialized = true;
 
+    if (!_hasContext) return;
+
     glGetIntegerv(GL_SAMPLES, &_multiSampleSamples);
 
     /* After over 10 years of OpenGL experience I used once a texture that is
@@ -181,6 +202,8 @@ void SLGLState::onInitialize(SLCol4f clearColor)
     // Reset all internal states
     if (!_isInitialized) initAll();
 
+    if (!_hasContext) return;
+
     // enable depth_test
     glDepthFunc(GL_LESS);
     glEnable(GL_DEPTH_TEST);
@@ -444,6 +467,7 @@ void SLGLState::polygonOffset(SLbool stateNew, SLfloat factor, SLfloat units)
  */
 void SLGLState::viewport(SLint x, SLint y, SLsizei width, SLsizei height)
 {
+    if (!_hasContext) return;
 
     if (_viewport.x != x || _viewport.y != y || _viewport.z != width || _viewport.w != height)
     {
@@ -551,6 +575,8 @@ void SLGLState::getGLError(const char* file,
                            bool        quit)
 {
 #if defined(DEBUG) || defined(_DEBUG)
+    if (!instance || !instance->_hasContext) return;
+
     GLenum err;
     if ((err = glGetError()) != GL_NO_ERROR)
     {
@@ -198,7 +198,10 @@ SLGLTexture::~SLGLTexture()
 //-----------------------------------------------------------------------------
 void SLGLTexture::clearData()
 {
-    glDeleteTextures(1, &_texName);
+    if (_texName)
+        glDeleteTextures(1, &_texName);
+
+    deleteRTCaches();
 
     numBytesInTextures -= _bytesOnGPU;
 
@@ -288,6 +291,9 @@ SLbool SLGLTexture::copyVideoImage(SLint         camWidth,
                                        isContinuous,
                                        isTopLeft);
 
+    // The ray tracing copies are built again on the next lookup
+    deleteRTCaches();
+
     // OpenGL ES 2 only can resize non-power-of-two texture with clamp to edge
     _wrap_s = GL_CLAMP_TO_EDGE;
     _wrap_t = GL_CLAMP_TO_EDGE;
@@ -664,8 +670,11 @@ void SLGLTexture::drawSprite(SLbool doUpdate)
 //! SLGLTexture::getTexelf returns a pixel color from s & t texture coordinates.
 /*! If the OpenGL filtering is set to GL_LINEAR a bilinear interpolated color out
 of four neighboring pixels is return. Otherwise the nearest pixel is returned.
+The lookup is done in the RT cache of the image (see SLTexCache). If the
+texture has mipmaps the footprint (width of the ray cone at the hit point in
+texture coordinates) selects the mip level for a trilinear lookup.
 */
-SLCol4f SLGLTexture::getTexelf(SLfloat s, SLfloat t, SLuint imgIndex)
+SLCol4f SLGLTexture::getTexelf(SLfloat s, SLfloat t, SLuint imgIndex, SLfloat footprint)
 {
     assert(imgIndex < _images.size() && "Image index to big!");
 
@@ -673,12 +682,28 @@ SLCol4f SLGLTexture::getTexelf(SLfloat s, SLfloat t, SLuint imgIndex)
     s = s * _tm.m(0) + _tm.m(12);
     t = t * _tm.m(5) + _tm.m(13);
 
-    // Bilinear interpolation
+    const SLTexCache* cache = rtCache(imgIndex);
+    SLTexWrap         wrapS = _wrap_s == GL_REPEAT            ? TW_repeat
+                              : _wrap_s == GL_MIRRORED_REPEAT ? TW_mirroredRepeat
+                                                              : TW_clampToEdge;
+    SLTexWrap         wrapT = _wrap_t == GL_REPEAT            ? TW_repeat
+                              : _wrap_t == GL_MIRRORED_REPEAT ? TW_mirroredRepeat
+                                                              : TW_clampToEdge;
+
+    // Bilinear or trilinear interpolation
     if (_min_filter == GL_LINEAR || _mag_filter == GL_LINEAR)
-        return _images[imgIndex]->getPixelf(s, t);
+    {
+        SLfloat lod = 0.0f;
+        if (footprint > 0.0f && cache->numLevels() > 1)
+        {
+            SLfloat scale = SL_max(SL_abs(_tm.m(0)), SL_abs(_tm.m(5)));
+            SLfloat size  = (SLfloat)SL_max(cache->width(), cache->height());
+            lod           = log2(footprint * scale * size);
+        }
+        return cache->sample(s, t, lod, wrapS, wrapT);
+    }
     else
-        return _images[imgIndex]->getPixeli((SLint)(s * _images[imgIndex]->width()),
-                                            (SLint)(t * _images[imgIndex]->height()));
+        return cache->sampleNearest(s, t, wrapS, wrapT);
 }
 //-----------------------------------------------------------------------------
 //! SLGLTexture::getTexelf returns a pixel color at the specified cubemap direction
@@ -696,6 +721,43 @@ SLCol4f SLGLTexture::getTexelf(SLVec3f cubemapDir)
     return getTexelf(u, v, (SLuint)index);
 }
 //-----------------------------------------------------------------------------
+/*!
+Returns the RT cache of the image with the index imgIndex. The caches of all
+images are built on the first call. Several render threads may call it at the
+same time, so the build is protected by a mutex.
+*/
+const SLTexCache* SLGLTexture::rtCache(SLuint imgIndex)
+{
+    if (!_rtCachesBuilt.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(_rtCacheMutex);
+        if (!_rtCachesBuilt.load(std::memory_order_relaxed))
+        {
+            SLbool buildMipmaps = _min_filter != GL_NEAREST &&
+                                  _min_filter != GL_LINEAR;
+
+            for (auto img : _images)
+                _rtCaches.push_back(new SLTexCache(img, buildMipmaps));
+
+            _rtCachesBuilt.store(true, std::memory_order_release);
+        }
+    }
+    return _rtCaches[imgIndex];
+}
+//-----------------------------------------------------------------------------
+/*!
+Deletes the RT caches of the images. It must be called if the images change
+and no ray tracing is running.
+*/
+void SLGLTexture::deleteRTCaches()
+{
+    std::lock_guard<std::mutex> lock(_rtCacheMutex);
+    for (auto cache : _rtCaches)
+        delete cache;
+    _rtCaches.clear();
+    _rtCachesBuilt = false;
+}
+//-----------------------------------------------------------------------------
 /*! 
 dsdt calculates the partial derivation (gray value slope) at s,t for bump
 mapping either from a height map or a normal map
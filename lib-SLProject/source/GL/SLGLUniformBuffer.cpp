@@ -0,0 +1,83 @@
+//#############################################################################
+//  File:      SLGLUniformBuffer.cpp
+//  Purpose:   Wrapper around an OpenGL Uniform Buffer Object
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLGLUniformBuffer.h>
+#include <SLGLVertexBuffer.h>
+
+//-----------------------------------------------------------------------------
+SLGLUniformBuffer::SLGLUniformBuffer()
+{
+    _id        = 0;
+    _sizeBytes = 0;
+}
+//-----------------------------------------------------------------------------
+void SLGLUniformBuffer::deleteGL()
+{
+    if (_id)
+    {
+        glDeleteBuffers(1, &_id);
+        _id = 0;
+        SLGLVertexBuffer::totalBufferCount--;
+        SLGLVertexBuffer::totalBufferSize -= _sizeBytes;
+        _sizeBytes = 0;
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Uploads the data to the buffer. The buffer is created at the first call
+with bufferSizeBytes that can be larger than the data. A uniform block must be
+backed by at least its full size even if only a part of it is used (e.g. the
+joint matrices of a skeleton with less than SL_MAX_JOINTS joints).
+*/
+void SLGLUniformBuffer::update(const void* data,
+                               SLuint      sizeBytes,
+                               SLuint      bufferSizeBytes)
+{
+    assert(data && "No data pointer passed");
+    assert(sizeBytes <= bufferSizeBytes && "Data exceeds the buffer size");
+
+    if (_id && _sizeBytes != bufferSizeBytes)
+        deleteGL();
+
+    if (!_id)
+    {
+        glGenBuffers(1, &_id);
+        glBindBuffer(GL_UNIFORM_BUFFER, _id);
+        glBufferData(GL_UNIFORM_BUFFER, bufferSizeBytes, nullptr, GL_DYNAMIC_DRAW);
+        _sizeBytes = bufferSizeBytes;
+        SLGLVertexBuffer::totalBufferCount++;
+        SLGLVertexBuffer::totalBufferSize += _sizeBytes;
+    }
+    else
+        glBindBuffer(GL_UNIFORM_BUFFER, _id);
+
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeBytes, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+#ifdef _GLDEBUG
+    GET_GL_ERROR;
+#endif
+}
+//-----------------------------------------------------------------------------
+void SLGLUniformBuffer::bindBase(SLuint binding)
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, _id);
+
+#ifdef _GLDEBUG
+    GET_GL_ERROR;
+#endif
+}
+//-----------------------------------------------------------------------------
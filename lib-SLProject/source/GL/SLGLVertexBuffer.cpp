@@ -98,6 +98,78 @@ void SLGLVertexBuffer::updateAttrib(SLGLAttributeType type,
                     _attribs[(SLuint)index].bufferSizeBytes,
                     _attribs[(SLuint)index].dataPointer);
 
+#ifdef _GLDEBUG
+    GET_GL_ERROR;
+#endif
+}
+//-----------------------------------------------------------------------------
+/*! Maps the part of the VBO that holds the passed sequential float attributes
+for writing and returns a pointer to the first element of each attribute in
+data. So the data can be written directly into the buffer without an extra
+copy of glBufferSubData. The old content gets invalidated if the attributes
+lie next to each other. Returns false if the VBO can't be mapped. The pointers
+are only valid until unmapAttribs is called.
+*/
+SLbool SLGLVertexBuffer::mapAttribs(const vector<SLGLAttributeType>& types,
+                                    vector<SLfloat*>&                data)
+{
+    data.clear();
+
+    if (!_id || _outputInterleaved || _dataType != BT_float || types.empty())
+        return false;
+
+#ifndef SL_GLES
+    if (!glMapBufferRange) // OpenGL < 3.0
+        return false;
+#endif
+
+    // Get the byte range that covers all attributes
+    SLuint begin = UINT_MAX;
+    SLuint end   = 0;
+    SLuint size  = 0;
+    for (auto type : types)
+    {
+        SLint index = attribIndex(type);
+        if (index == -1)
+            SL_EXIT_MSG("Attribute type does not exist in VBO.");
+
+        SLGLAttribute& a = _attribs[(SLuint)index];
+        begin            = SL_min(begin, a.offsetBytes);
+        end              = SL_max(end, a.offsetBytes + a.bufferSizeBytes);
+        size += a.bufferSizeBytes;
+    }
+
+    // Other attributes in between must keep their data
+    GLbitfield access = GL_MAP_WRITE_BIT;
+    if (size == end - begin)
+        access |= GL_MAP_INVALIDATE_RANGE_BIT;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _id);
+    SLuchar* range = (SLuchar*)glMapBufferRange(GL_ARRAY_BUFFER,
+                                                 begin,
+                                                 end - begin,
+                                                 access);
+    if (!range)
+        return false;
+
+    for (auto type : types)
+    {
+        SLGLAttribute& a = _attribs[(SLuint)attribIndex(type)];
+        data.push_back((SLfloat*)(range + a.offsetBytes - begin));
+    }
+
+#ifdef _GLDEBUG
+    GET_GL_ERROR;
+#endif
+
+    return true;
+}
+//-----------------------------------------------------------------------------
+void SLGLVertexBuffer::unmapAttribs()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _id);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+
 #ifdef _GLDEBUG
     GET_GL_ERROR;
 #endif
@@ -22,7 +22,9 @@
 /*! Constructor
 */
 SLAnimTrack::SLAnimTrack(SLAnimation* animation)
-  : _animation(animation)
+  : _animation(animation),
+    _kfCursor(0),
+    _keyframesOutOfDate(true)
 {
 }
 
@@ -45,6 +47,7 @@ SLKeyframe* SLAnimTrack::createKeyframe(SLfloat time)
 {
     SLKeyframe* kf = createKeyframeImpl(time);
     _keyframes.push_back(kf);
+    _keyframesOutOfDate = true;
     return kf;
 }
 
@@ -59,6 +62,24 @@ SLKeyframe* SLAnimTrack::keyframe(SLint index)
     return _keyframes[(SLuint)index];
 }
 
+//-----------------------------------------------------------------------------
+/*! Copies the times of the keyframes into the flat array for the search.
+    Derived tracks copy their values too.
+*/
+void SLAnimTrack::buildKeyframeArrays() const
+{
+    _kfTimes.resize(_keyframes.size());
+    for (SLuint i = 0; i < _keyframes.size(); ++i)
+    {
+        _kfTimes[i] = _keyframes[i]->time();
+        assert((i == 0 || _kfTimes[i - 1] <= _kfTimes[i]) &&
+               "Keyframes must be sorted by time.");
+    }
+
+    _kfCursor           = 0;
+    _keyframesOutOfDate = false;
+}
+
 //-----------------------------------------------------------------------------
 /*! Get the two keyframes to the left or the right of the passed in timestamp.
     If keyframes will wrap around, if there is no keyframe after the passed in time
@@ -69,21 +90,43 @@ SLfloat SLAnimTrack::getKeyframesAtTime(SLfloat      time,
                                         SLKeyframe** k1,
                                         SLKeyframe** k2) const
 {
-    SLfloat t1, t2;
-    SLuint  numKf           = (SLuint)_keyframes.size();
-    float   animationLength = _animation->lengthSec();
-
-    assert(animationLength > 0.0f && "Animation length is invalid.");
-
     *k1 = *k2 = nullptr;
 
-    // no keyframes or only one keyframe in animation, early out
-    if (numKf == 0)
+    if (_keyframes.empty())
         return 0.0f;
 
+    SLuint  i1, i2;
+    SLfloat t = getKeyframeIndicesAtTime(time, i1, i2);
+    *k1       = _keyframes[i1];
+    *k2       = _keyframes[i2];
+    return t;
+}
+
+//-----------------------------------------------------------------------------
+/*! Get the indices of the two keyframes to the left or the right of the passed
+    in timestamp and returns the interpolation factor between them. It wraps
+    around like getKeyframesAtTime. The track must have at least one keyframe.
+    k1 is the last keyframe with a time less or equal the passed in time. The
+    cursor and its successor are checked first, so that a forward playing
+    animation needs no search. Otherwise k1 is found with a binary search.
+*/
+SLfloat SLAnimTrack::getKeyframeIndicesAtTime(SLfloat time,
+                                              SLuint& k1,
+                                              SLuint& k2) const
+{
+    if (_keyframesOutOfDate)
+        buildKeyframeArrays();
+
+    SLuint numKf           = (SLuint)_kfTimes.size();
+    float  animationLength = _animation->lengthSec();
+
+    assert(numKf > 0 && "Track has no keyframes.");
+    assert(animationLength > 0.0f && "Animation length is invalid.");
+
+    // only one keyframe in animation, early out
     if (numKf < 2)
     {
-        *k1 = *k2 = _keyframes[0];
+        k1 = k2 = 0;
         return 0.0f;
     }
 
@@ -95,48 +138,34 @@ SLfloat SLAnimTrack::getKeyframesAtTime(SLfloat      time,
     while (time < 0.0f)
         time += animationLength;
 
-    // search lower bound kf for given time
-    // kf list must be sorted by time at this point
-    // @todo we could use std::lower_bounds here
-    // @todo this could be implemented much nicer
-    //      use the following algorithm:
-    //      1. find the keyframe that comes after the 'time' parameter
-    //      2. if there is no keyframe after 'time' then set keframe 2 to the first keyframe in the list
-    //          set t2 to animationLength + the time of the keyframe
-    //      3. if there is a keyframe after 'time' then set keyframe 2 to that keyframe
-    //          set t2 to the time of the keyframe
-    //      4. now find the keyframe before keyframe 2 (if we use iterators here this is trivial!)
-    //         set keyframe 1 to the keyframe found before keyframe 2
-    SLuint kfIndex = 0;
-    for (SLuint i = 0; i < numKf; ++i)
-    {
-        SLKeyframe* cur = _keyframes[i];
-
-        if (cur->time() <= time)
-        {
-            *k1     = cur;
-            kfIndex = i;
-        }
-    }
-
-    // time is than first kf
-    if (*k1 == nullptr)
+    // search lower bound kf for given time in the sorted times
+    SLuint c = _kfCursor;
+    if (time < _kfTimes[0])
+        k1 = numKf - 1; // time is before the first kf: wrap to the last one
+    else if (_kfTimes[c] <= time && (c + 1 == numKf || time < _kfTimes[c + 1]))
+        k1 = c;
+    else if (c + 1 < numKf && _kfTimes[c + 1] <= time &&
+             (c + 2 == numKf || time < _kfTimes[c + 2]))
+        k1 = c + 1;
+    else
     {
-        *k1 = _keyframes.back();
-        // as long as k1 is in the back
+        auto next = std::upper_bound(_kfTimes.begin(), _kfTimes.end(), time);
+        k1        = (SLuint)(next - _kfTimes.begin()) - 1;
     }
+    _kfCursor = k1;
 
-    t1 = (*k1)->time();
+    SLfloat t1 = _kfTimes[k1];
+    SLfloat t2;
 
-    if (*k1 == _keyframes.back())
+    if (k1 == numKf - 1)
     {
-        *k2 = _keyframes.front();
-        t2  = animationLength + (*k2)->time();
+        k2 = 0;
+        t2 = animationLength + _kfTimes[0];
     }
     else
     {
-        *k2 = _keyframes[kfIndex + 1];
-        t2  = (*k2)->time();
+        k2 = k1 + 1;
+        t2 = _kfTimes[k2];
     }
 
     if (SL_abs(t1 - t2) < 0.0001f)
@@ -204,22 +233,18 @@ SLTransformKeyframe* SLNodeAnimTrack::createNodeKeyframe(SLfloat time)
 void SLNodeAnimTrack::calcInterpolatedKeyframe(SLfloat     time,
                                                SLKeyframe* keyframe) const
 {
-    SLKeyframe* k1;
-    SLKeyframe* k2;
-
-    SLfloat t = getKeyframesAtTime(time, &k1, &k2);
-
-    if (k1 == nullptr)
+    if (_keyframes.empty())
         return;
 
+    SLuint  k1, k2;
+    SLfloat t = getKeyframeIndicesAtTime(time, k1, k2);
+
     SLTransformKeyframe* kfOut = static_cast<SLTransformKeyframe*>(keyframe);
-    SLTransformKeyframe* kf1   = static_cast<SLTransformKeyframe*>(k1);
-    SLTransformKeyframe* kf2   = static_cast<SLTransformKeyframe*>(k2);
 
-    SLVec3f base = kf1->translation();
+    SLVec3f base = _kfTranslations[k1];
     SLVec3f translation;
     if (_translationInterpolation == AI_linear)
-        translation = base + (kf2->translation() - base) * t;
+        translation = base + (_kfTranslations[k2] - base) * t;
     else
     {
         if (_rebuildInterpolationCurve)
@@ -230,12 +255,12 @@ void SLNodeAnimTrack::calcInterpolatedKeyframe(SLfloat     time,
     kfOut->translation(translation);
 
     SLQuat4f rotation;
-    rotation = kf1->rotation().slerp(kf2->rotation(), t); // @todo provide a 2 parameter implementation for lerp, slerp etc.
+    rotation = _kfRotations[k1].slerp(_kfRotations[k2], t); // @todo provide a 2 parameter implementation for lerp, slerp etc.
     kfOut->rotation(rotation);
 
-    base = kf1->scale();
+    base = _kfScales[k1];
     SLVec3f scale;
-    scale = base + (kf2->scale() - base) * t;
+    scale = base + (_kfScales[k2] - base) * t;
     kfOut->scale(scale);
 }
 
@@ -321,6 +346,28 @@ SLKeyframe* SLNodeAnimTrack::createKeyframeImpl(SLfloat time)
     return new SLTransformKeyframe(this, time);
 }
 
+//-----------------------------------------------------------------------------
+/*! Copies the times, translations, rotations and scales of the keyframes into
+    the flat arrays for the evaluation.
+*/
+void SLNodeAnimTrack::buildKeyframeArrays() const
+{
+    SLAnimTrack::buildKeyframeArrays();
+
+    SLuint numKf = (SLuint)_keyframes.size();
+    _kfTranslations.resize(numKf);
+    _kfRotations.resize(numKf);
+    _kfScales.resize(numKf);
+
+    for (SLuint i = 0; i < numKf; ++i)
+    {
+        SLTransformKeyframe* kf = static_cast<SLTransformKeyframe*>(_keyframes[i]);
+        _kfTranslations[i]      = kf->translation();
+        _kfRotations[i]         = kf->rotation();
+        _kfScales[i]            = kf->scale();
+    }
+}
+
 //-----------------------------------------------------------------------------
 /*! setter for the interpolation curve
 */
@@ -0,0 +1,477 @@
+//#############################################################################
+//  File:      SLBVH.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLBVH.h>
+#include <SLNode.h>
+#include <SLRay.h>
+#include <SLRayPacket.h>
+
+//-----------------------------------------------------------------------------
+static_assert(sizeof(SLBVHNode) == 32, "SLBVHNode must have 32 bytes");
+//-----------------------------------------------------------------------------
+//! NO. of bins for the binned SAH split search
+static const SLint SL_BVH_BINS = 16;
+//! Max. NO. of triangles in a leaf
+static const SLuint SL_BVH_LEAF_MAX = 4;
+//! Cost of a node traversal relative to a triangle intersection
+static const SLfloat SL_BVH_COST_TRAVERSAL = 1.0f;
+//-----------------------------------------------------------------------------
+//! Returns the half surface area of the box defined by min & max
+static inline SLfloat halfArea(const SLVec3f& min, const SLVec3f& max)
+{
+    SLVec3f d = max - min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+//-----------------------------------------------------------------------------
+SLBVH::SLBVH(SLMesh* m) : SLAccelStruct(m)
+{
+    _numTriangles  = 0;
+    _voxelCnt      = 0;
+    _voxelCntEmpty = 0;
+    _voxelMaxTria  = 0;
+    _voxelAvgTria  = 0;
+}
+//-----------------------------------------------------------------------------
+//! Deletes the entire hierarchy
+void SLBVH::deleteAll()
+{
+    _voxelCnt      = 0;
+    _voxelCntEmpty = 0;
+    _voxelMaxTria  = 0;
+    _voxelAvgTria  = 0;
+
+    _nodes.clear();
+    _triangleIndexes.clear();
+
+    disposeBuffers();
+}
+//-----------------------------------------------------------------------------
+/*!
+SLBVH::build calculates the bounds of all triangles and builds the hierarchy
+recursively with the binned SAH. The temporary triangle bounds are released
+at the end.
+*/
+void SLBVH::build(SLVec3f minV, SLVec3f maxV)
+{
+    assert(_m->I16.size() || _m->I32.size());
+
+    deleteAll();
+
+    _minV         = minV;
+    _maxV         = maxV;
+    _numTriangles = _m->numI() / 3;
+
+    if (_numTriangles == 0)
+        return;
+
+    // Calculate the bounds and centers of all triangles
+    _triMin.resize(_numTriangles);
+    _triMax.resize(_numTriangles);
+    _triCenter.resize(_numTriangles);
+    _triangleIndexes.resize(_numTriangles);
+
+    for (SLuint t = 0; t < _numTriangles; ++t)
+    {
+        SLuint  i  = t * 3;
+        SLVec3f v0 = _m->finalP(_m->I16.size() ? _m->I16[i] : _m->I32[i]);
+        SLVec3f v1 = _m->finalP(_m->I16.size() ? _m->I16[i + 1] : _m->I32[i + 1]);
+        SLVec3f v2 = _m->finalP(_m->I16.size() ? _m->I16[i + 2] : _m->I32[i + 2]);
+
+        _triMin[t] = v0;
+        _triMin[t].setMin(v1);
+        _triMin[t].setMin(v2);
+        _triMax[t] = v0;
+        _triMax[t].setMax(v1);
+        _triMax[t].setMax(v2);
+        _triCenter[t]       = (_triMin[t] + _triMax[t]) * 0.5f;
+        _triangleIndexes[t] = t;
+    }
+
+    _nodes.reserve(2 * _numTriangles / SL_BVH_LEAF_MAX + 1);
+    buildRec(0, _numTriangles, 0);
+
+    _nodes.shrink_to_fit();
+    _voxelAvgTria = _voxelCnt ? (SLfloat)_numTriangles / (SLfloat)_voxelCnt : 0;
+
+    // Free the temporary build data
+    SLVVec3f().swap(_triMin);
+    SLVVec3f().swap(_triMax);
+    SLVVec3f().swap(_triCenter);
+}
+//-----------------------------------------------------------------------------
+/*!
+Builds the node for the triangles [first, first+count) and returns its index.
+A node becomes a leaf if it has few triangles, if no split is cheaper than
+intersecting all its triangles or if the max. depth is reached.
+*/
+SLuint SLBVH::buildRec(SLuint first, SLuint count, SLuint depth)
+{
+    SLuint index = (SLuint)_nodes.size();
+    _nodes.push_back(SLBVHNode());
+
+    // Calculate the bounds of the triangles and of their centers
+    SLVec3f min(FLT_MAX, FLT_MAX, FLT_MAX);
+    SLVec3f max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    SLVec3f cMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    SLVec3f cMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (SLuint i = first; i < first + count; ++i)
+    {
+        SLuint t = _triangleIndexes[i];
+        min.setMin(_triMin[t]);
+        max.setMax(_triMax[t]);
+        cMin.setMin(_triCenter[t]);
+        cMax.setMax(_triCenter[t]);
+    }
+    _nodes[index].min = min;
+    _nodes[index].max = max;
+
+    // Find the cheapest split plane over all axes with binned SAH
+    SLint   bestAxis = -1;
+    SLint   bestBin  = 0;
+    SLfloat leafCost = (SLfloat)count;
+    SLfloat bestCost = leafCost;
+    SLfloat areaInv  = 1.0f / SL_max(halfArea(min, max), FLT_EPSILON);
+    SLVec3f extent   = cMax - cMin;
+
+    if (count > SL_BVH_LEAF_MAX && depth < SL_BVH_MAX_DEPTH - 1)
+    {
+        for (SLint axis = 0; axis < 3; ++axis)
+        {
+            if (extent.comp[axis] <= FLT_EPSILON) continue;
+
+            SLVec3f binMin[SL_BVH_BINS];
+            SLVec3f binMax[SL_BVH_BINS];
+            SLuint  binCnt[SL_BVH_BINS] = {0};
+            for (SLint b = 0; b < SL_BVH_BINS; ++b)
+            {
+                binMin[b].set(FLT_MAX, FLT_MAX, FLT_MAX);
+                binMax[b].set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            }
+
+            SLfloat scale = (SLfloat)SL_BVH_BINS / extent.comp[axis];
+            for (SLuint i = first; i < first + count; ++i)
+            {
+                SLuint t = _triangleIndexes[i];
+                SLint  b = (SLint)((_triCenter[t].comp[axis] - cMin.comp[axis]) * scale);
+                b        = SL_min(b, SL_BVH_BINS - 1);
+                binCnt[b]++;
+                binMin[b].setMin(_triMin[t]);
+                binMax[b].setMax(_triMax[t]);
+            }
+
+            // Sweep from the right to accumulate the right partitions
+            SLfloat rightCost[SL_BVH_BINS];
+            SLVec3f rMin(FLT_MAX, FLT_MAX, FLT_MAX);
+            SLVec3f rMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            SLuint  rCnt = 0;
+            for (SLint b = SL_BVH_BINS - 1; b > 0; --b)
+            {
+                rMin.setMin(binMin[b]);
+                rMax.setMax(binMax[b]);
+                rCnt += binCnt[b];
+                rightCost[b] = rCnt ? halfArea(rMin, rMax) * (SLfloat)rCnt : 0.0f;
+            }
+
+            // Sweep from the left and evaluate the SAH for each plane
+            SLVec3f lMin(FLT_MAX, FLT_MAX, FLT_MAX);
+            SLVec3f lMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            SLuint  lCnt = 0;
+            for (SLint b = 0; b < SL_BVH_BINS - 1; ++b)
+            {
+                lMin.setMin(binMin[b]);
+                lMax.setMax(binMax[b]);
+                lCnt += binCnt[b];
+                if (lCnt == 0 || lCnt == count) continue;
+
+                SLfloat cost = SL_BVH_COST_TRAVERSAL +
+                               (halfArea(lMin, lMax) * (SLfloat)lCnt +
+                                rightCost[b + 1]) *
+                                 areaInv;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin  = b;
+                }
+            }
+        }
+    }
+
+    // Create a leaf if splitting does not pay off
+    if (bestAxis < 0)
+    {
+        _nodes[index].leftFirst = first;
+        _nodes[index].count     = count;
+        _voxelCnt++;
+        _voxelMaxTria = SL_max(_voxelMaxTria, count);
+        return index;
+    }
+
+    // Partition the triangle indexes by the best split plane
+    SLfloat scale  = (SLfloat)SL_BVH_BINS / extent.comp[bestAxis];
+    auto    isLeft = [&](SLuint t) {
+        SLint b = (SLint)((_triCenter[t].comp[bestAxis] - cMin.comp[bestAxis]) * scale);
+        return SL_min(b, SL_BVH_BINS - 1) <= bestBin;
+    };
+    auto   it  = std::partition(_triangleIndexes.begin() + first,
+                             _triangleIndexes.begin() + first + count,
+                             isLeft);
+    SLuint mid = (SLuint)(it - _triangleIndexes.begin());
+
+    // The left child follows directly, the index of the right one is stored
+    buildRec(first, mid - first, depth + 1);
+    SLuint right = buildRec(mid, first + count - mid, depth + 1);
+
+    _nodes[index].leftFirst = right;
+    _nodes[index].count     = 0;
+    return index;
+}
+//-----------------------------------------------------------------------------
+//! Updates the statistics in the parent node
+void SLBVH::updateStats(SLNodeStats& stats)
+{
+    stats.numVoxels += _voxelCnt;
+    stats.numVoxEmpty += _voxelCntEmpty;
+
+    stats.numBytesAccel += sizeof(SLBVH);
+    stats.numBytesAccel += SL_sizeOfVector(_nodes);
+    stats.numBytesAccel += SL_sizeOfVector(_triangleIndexes);
+
+    stats.numVoxMaxTria = SL_max(_voxelMaxTria, stats.numVoxMaxTria);
+}
+//-----------------------------------------------------------------------------
+//! SLBVH::draw draws the AABBs of the leaf nodes
+void SLBVH::draw(SLSceneView* sv)
+{
+    if (_voxelCnt > 0)
+    {
+        if (!_vao.id())
+        {
+            SLVVec3f P;
+            P.reserve(_voxelCnt * 24);
+
+            for (auto& n : _nodes)
+            {
+                if (n.count == 0) continue;
+
+                const SLVec3f& a = n.min;
+                const SLVec3f& b = n.max;
+
+                // 4 edges in x-direction
+                P.push_back(SLVec3f(a.x, a.y, a.z));
+                P.push_back(SLVec3f(b.x, a.y, a.z));
+                P.push_back(SLVec3f(a.x, b.y, a.z));
+                P.push_back(SLVec3f(b.x, b.y, a.z));
+                P.push_back(SLVec3f(a.x, a.y, b.z));
+                P.push_back(SLVec3f(b.x, a.y, b.z));
+                P.push_back(SLVec3f(a.x, b.y, b.z));
+                P.push_back(SLVec3f(b.x, b.y, b.z));
+
+                // 4 edges in y-direction
+                P.push_back(SLVec3f(a.x, a.y, a.z));
+                P.push_back(SLVec3f(a.x, b.y, a.z));
+                P.push_back(SLVec3f(b.x, a.y, a.z));
+                P.push_back(SLVec3f(b.x, b.y, a.z));
+                P.push_back(SLVec3f(a.x, a.y, b.z));
+                P.push_back(SLVec3f(a.x, b.y, b.z));
+                P.push_back(SLVec3f(b.x, a.y, b.z));
+                P.push_back(SLVec3f(b.x, b.y, b.z));
+
+                // 4 edges in z-direction
+                P.push_back(SLVec3f(a.x, a.y, a.z));
+                P.push_back(SLVec3f(a.x, a.y, b.z));
+                P.push_back(SLVec3f(b.x, a.y, a.z));
+                P.push_back(SLVec3f(b.x, a.y, b.z));
+                P.push_back(SLVec3f(a.x, b.y, a.z));
+                P.push_back(SLVec3f(a.x, b.y, b.z));
+                P.push_back(SLVec3f(b.x, b.y, a.z));
+                P.push_back(SLVec3f(b.x, b.y, b.z));
+            }
+
+            _vao.generateVertexPos(&P);
+        }
+
+        _vao.drawArrayAsColored(PT_lines, SLCol4f::CYAN);
+    }
+}
+//-----------------------------------------------------------------------------
+//! Ray - AABB slab test of a node in object space
+SLbool SLBVH::isHitInOS(const SLBVHNode& n, SLRay* ray, SLfloat& tNear) const
+{
+    SLVec3f params[2] = {n.min, n.max};
+    SLfloat tmin, tmax, tymin, tymax, tzmin, tzmax;
+
+    tmin  = (params[ray->signOS[0]].x - ray->originOS.x) * ray->invDirOS.x;
+    tmax  = (params[1 - ray->signOS[0]].x - ray->originOS.x) * ray->invDirOS.x;
+    tymin = (params[ray->signOS[1]].y - ray->originOS.y) * ray->invDirOS.y;
+    tymax = (params[1 - ray->signOS[1]].y - ray->originOS.y) * ray->invDirOS.y;
+
+    if ((tmin > tymax) || (tymin > tmax)) return false;
+    if (tymin > tmin) tmin = tymin;
+    if (tymax < tmax) tmax = tymax;
+
+    tzmin = (params[ray->signOS[2]].z - ray->originOS.z) * ray->invDirOS.z;
+    tzmax = (params[1 - ray->signOS[2]].z - ray->originOS.z) * ray->invDirOS.z;
+
+    if ((tmin > tzmax) || (tzmin > tmax)) return false;
+    if (tzmin > tmin) tmin = tzmin;
+    if (tzmax < tmax) tmax = tzmax;
+
+    tNear = tmin;
+    return ((tmin < ray->length) && (tmax > 0));
+}
+//-----------------------------------------------------------------------------
+/*!
+Ray Mesh intersection method using a stack based front-to-back traversal of
+the hierarchy. Nodes that are further away than the closest hit so far are
+skipped. Shadow rays stop at the first occluding triangle.
+*/
+SLbool SLBVH::intersect(SLRay* ray, SLNode* node)
+{
+    SLbool wasHit = false;
+
+    if (_nodes.empty())
+    { // not enough triangles for a hierarchy > check them all
+        for (SLuint t = 0; t < _m->numI(); t += 3)
+        {
+            if (_m->hitTriangleOS(ray, node, t) && !wasHit) wasHit = true;
+            if (ray->isShaded()) return true;
+        }
+        return wasHit;
+    }
+
+    SLfloat tNear;
+    if (!isHitInOS(_nodes[0], ray, tNear))
+        return false;
+
+    SLuint  stackNode[SL_BVH_MAX_DEPTH];
+    SLfloat stackNear[SL_BVH_MAX_DEPTH];
+    SLint   top    = 0;
+    stackNode[top] = 0;
+    stackNear[top] = tNear;
+    top++;
+
+    while (top > 0)
+    {
+        --top;
+
+        // Skip the node if a closer hit was found after it got pushed
+        if (stackNear[top] >= ray->length)
+            continue;
+
+        SLuint           i = stackNode[top];
+        const SLBVHNode& n = _nodes[i];
+
+        if (n.count)
+        {
+            for (SLuint l = n.leftFirst; l < n.leftFirst + n.count; ++l)
+            {
+                if (_m->hitTriangleOS(ray, node, _triangleIndexes[l] * 3))
+                    wasHit = true;
+                if (ray->isShaded())
+                    return true;
+            }
+            continue;
+        }
+
+        SLuint  l = i + 1;
+        SLuint  r = n.leftFirst;
+        SLfloat tL, tR;
+        SLbool  hitL = isHitInOS(_nodes[l], ray, tL);
+        SLbool  hitR = isHitInOS(_nodes[r], ray, tR);
+
+        // Push the farther child first so that the nearer gets popped first
+        if (hitL && hitR)
+        {
+            if (tL < tR)
+            {
+                std::swap(l, r);
+                std::swap(tL, tR);
+            }
+            stackNode[top]   = l;
+            stackNear[top++] = tL;
+            stackNode[top]   = r;
+            stackNear[top++] = tR;
+        }
+        else if (hitL)
+        {
+            stackNode[top]   = l;
+            stackNear[top++] = tL;
+        }
+        else if (hitR)
+        {
+            stackNode[top]   = r;
+            stackNear[top++] = tR;
+        }
+    }
+
+    return wasHit;
+}
+//-----------------------------------------------------------------------------
+/*!
+Packet version of intersect. The whole packet descends into a node if at least
+one of its rays hits the nodes AABB. The triangles of the leaves are tested
+against all rays at once with SLMesh::hitTrianglePacketOS.
+*/
+void SLBVH::intersectPacket(SLRayPacket& packet, SLNode* node)
+{
+    if (_nodes.empty())
+    { // not enough triangles for a hierarchy > check them all
+        for (SLuint t = 0; t < _m->numI(); t += 3)
+            _m->hitTrianglePacketOS(packet, node, t);
+        return;
+    }
+
+    SLfloat tNear;
+    if (!packet.hitAABBInOS(_nodes[0].min, _nodes[0].max, tNear))
+        return;
+
+    SLuint stackNode[SL_BVH_MAX_DEPTH];
+    SLint  top       = 0;
+    stackNode[top++] = 0;
+
+    while (top > 0)
+    {
+        SLuint           i = stackNode[--top];
+        const SLBVHNode& n = _nodes[i];
+
+        if (n.count)
+        {
+            for (SLuint l = n.leftFirst; l < n.leftFirst + n.count; ++l)
+                _m->hitTrianglePacketOS(packet, node, _triangleIndexes[l] * 3);
+            continue;
+        }
+
+        SLuint  l = i + 1;
+        SLuint  r = n.leftFirst;
+        SLfloat tL, tR;
+        SLbool  hitL = packet.hitAABBInOS(_nodes[l].min, _nodes[l].max, tL);
+        SLbool  hitR = packet.hitAABBInOS(_nodes[r].min, _nodes[r].max, tR);
+
+        // Push the farther child first so that the nearer gets popped first
+        if (hitL && hitR)
+        {
+            if (tL < tR) std::swap(l, r);
+            stackNode[top++] = l;
+            stackNode[top++] = r;
+        }
+        else if (hitL)
+            stackNode[top++] = l;
+        else if (hitR)
+            stackNode[top++] = r;
+    }
+}
+//-----------------------------------------------------------------------------
@@ -1340,7 +1340,7 @@ SLbool SLCamera::isInFrustum(SLAABBox* aabb)
     aabb->isVisible(true);
 
     // Calculate squared dist. from AABB's center to viewer for blend sorting.
-    SLVec3f viewToCenter(_wm.translation() - aabb->centerWS());
+    SLVec3f viewToCenter(updateAndGetWM().translation() - aabb->centerWS());
     aabb->sqrViewDist(viewToCenter.lengthSqr());
     return true;
 }
@@ -12,14 +12,22 @@
 #include <SLCompactGrid.h>
 #include <SLNode.h>
 #include <SLRay.h>
+#include <SLRayPacket.h>
+#include <SLRenderPool.h>
 #include <TriangleBoxIntersect.h>
 
+//-----------------------------------------------------------------------------
+//! NO. of triangles that are processed as one task of the parallel build
+static const SLuint SL_GRID_BUILD_CHUNK = 4096;
 //-----------------------------------------------------------------------------
 SLCompactGrid::SLCompactGrid(SLMesh* m) : SLAccelStruct(m)
 {
-    _voxelCnt      = 0;
-    _voxelCntEmpty = 0;
-    _voxelMaxTria  = 0;
+    _voxelCnt          = 0;
+    _voxelCntEmpty     = 0;
+    _voxelMaxTria      = 0;
+    _numTriangles      = 0;
+    _voxelCountersSize = 0;
+    _keepSize          = false;
 }
 //-----------------------------------------------------------------------------
 //! Returns the indices of the voxel around a given point
@@ -64,7 +72,7 @@ void SLCompactGrid::getMinMaxVoxel(const Triangle& triangle,
     }
 }
 //-----------------------------------------------------------------------------
-//! Deletes the entire uniform grid data
+//! Deletes the entire uniform grid data but keeps the capacity of the vectors
 void SLCompactGrid::deleteAll()
 {
     _voxelCnt      = 0;
@@ -79,12 +87,20 @@ void SLCompactGrid::deleteAll()
     disposeBuffers();
 }
 //-----------------------------------------------------------------------------
-//!Loops over triangles gets their voxels and calls the callback function
-void SLCompactGrid::ifTriangleInVoxelDo(triVoxCallback callback)
+/*!
+Loops over the triangles [iBegin, iEnd) gets their voxels and calls the
+callback function. The range allows the parallel build to process chunks of
+triangles in different threads.
+*/
+void SLCompactGrid::ifTriangleInVoxelDo(triVoxCallback callback,
+                                        SLuint         iBegin,
+                                        SLuint         iEnd)
 {
     assert(callback && "No callback function passed");
 
-    for (SLuint i = 0; i < _numTriangles; ++i)
+    iEnd = SL_min(iEnd, _numTriangles);
+
+    for (SLuint i = iBegin; i < iEnd; ++i)
     {
         auto     index    = [&](SLuint j) { return _m->I16.size()
                                               ? _m->I16[i * 3 + j]
@@ -117,17 +133,32 @@ void SLCompactGrid::ifTriangleInVoxelDo(triVoxCallback callback)
 //-----------------------------------------------------------------------------
 /*!
 SLCompactGrid::build implements the data structure proposed by Lagae & Dutre in
-their paper "Compact, Fast and Robust Grids for Ray Tracing".
+their paper "Compact, Fast and Robust Grids for Ray Tracing". Both passes run
+in parallel over chunks of SL_GRID_BUILD_CHUNK triangles:
+1) Every triangle voxel overlap increments an atomic counter of the voxel.
+2) After the prefix sum over the counters the counters serve as atomic write
+cursors into the triangle index array.
+Because the threads fill a voxel in arbitrary order, the triangle indexes of
+each voxel are sorted at the end. So the result is the same as the one of the
+serial build. All buffers keep their capacity for the next build. If the
+keep size mode is on and the number of triangles didn't change, the voxel
+resolution of the last build is kept and only the voxel size changes. Both
+passes still run over all triangles in this mode, so it costs the same as a
+full build.
 */
 void SLCompactGrid::build(SLVec3f minV, SLVec3f maxV)
 {
     assert(_m->I16.size() || _m->I32.size());
 
+    SLuint   numTriangles = _m->numI() / 3;
+    SLbool   keepSize     = _keepSize && _voxelCnt > 0 && numTriangles == _numTriangles;
+    SLVec3ui oldSize      = _size;
+
     deleteAll();
 
     _minV         = minV;
     _maxV         = maxV;
-    _numTriangles = _m->numI() / 3;
+    _numTriangles = numTriangles;
 
     // Calculate grid size
     const SLfloat DENSITY = 8;
@@ -139,51 +170,110 @@ void SLCompactGrid::build(SLVec3f minV, SLVec3f maxV)
         return;
     }
 
-    float f        = cbrtf(DENSITY * _numTriangles / volume);
-    _voxelSize.x   = size.x / ceil(size.x * f);
-    _voxelSize.y   = size.y / ceil(size.y * f);
-    _voxelSize.z   = size.z / ceil(size.z * f);
+    if (keepSize)
+    {
+        _size      = oldSize;
+        _voxelSize = SLVec3f(size.x / _size.x,
+                             size.y / _size.y,
+                             size.z / _size.z);
+    }
+    else
+    {
+        float f      = cbrtf(DENSITY * _numTriangles / volume);
+        _voxelSize.x = size.x / ceil(size.x * f);
+        _voxelSize.y = size.y / ceil(size.y * f);
+        _voxelSize.z = size.z / ceil(size.z * f);
+        _size.x      = (SLuint)ceil(size.x / _voxelSize.x);
+        _size.y      = (SLuint)ceil(size.y / _voxelSize.y);
+        _size.z      = (SLuint)ceil(size.z / _voxelSize.z);
+    }
     _voxelSizeHalf = _voxelSize * 0.5f;
-    _size.x        = (SLuint)ceil(size.x / _voxelSize.x);
-    _size.y        = (SLuint)ceil(size.y / _voxelSize.y);
-    _size.z        = (SLuint)ceil(size.z / _voxelSize.z);
     _voxelCnt      = _size.x * _size.y * _size.z;
-    _voxelOffsets.assign(_voxelCnt + 1, 0);
 
-    ifTriangleInVoxelDo([&](const SLuint& i, const SLuint& voxIndex) {
-        ++_voxelOffsets[voxIndex];
+    // Reallocate the counters only if the grid got bigger
+    if (_voxelCountersSize < _voxelCnt)
+    {
+        _voxelCountersSize = _voxelCnt;
+        _voxelCounters.reset(new std::atomic<SLuint>[_voxelCountersSize]);
+    }
+    for (SLuint v = 0; v < _voxelCnt; ++v)
+        _voxelCounters[v].store(0, std::memory_order_relaxed);
+
+    SLRenderPool& pool      = SLRenderPool::update();
+    SLuint        numChunks = (_numTriangles + SL_GRID_BUILD_CHUNK - 1) / SL_GRID_BUILD_CHUNK;
+
+    // 1st pass: count the triangles per voxel
+    pool.run(numChunks, [&](SLuint chunk, SLuint worker) {
+        ifTriangleInVoxelDo(
+          [&](const SLuint& i, const SLuint& voxIndex) {
+              _voxelCounters[voxIndex].fetch_add(1, std::memory_order_relaxed);
+          },
+          chunk * SL_GRID_BUILD_CHUNK,
+          (chunk + 1) * SL_GRID_BUILD_CHUNK);
     });
 
-    //The last counter doesn't count and is always empty.
-    _voxelMaxTria  = _voxelOffsets[0];
-    _voxelCntEmpty = (_voxelOffsets[0] == 0) - 1;
-    for (SLuint i = 1; i < _voxelOffsets.size(); ++i)
+    // Exclusive prefix sum: _voxelOffsets[v] is the first index of voxel v
+    _voxelOffsets.resize(_voxelCnt + 1);
+    _voxelMaxTria  = 0;
+    _voxelCntEmpty = 0;
+    SLuint offset  = 0;
+    for (SLuint v = 0; v < _voxelCnt; ++v)
     {
-        _voxelMaxTria = SL_max(_voxelMaxTria, (SLuint)_voxelOffsets[i]);
-        _voxelCntEmpty += _voxelOffsets[i] == 0;
-        _voxelOffsets[i] += _voxelOffsets[i - 1];
+        SLuint count     = _voxelCounters[v].load(std::memory_order_relaxed);
+        _voxelMaxTria    = SL_max(_voxelMaxTria, count);
+        _voxelCntEmpty  += count == 0;
+        _voxelOffsets[v] = offset;
+        _voxelCounters[v].store(offset, std::memory_order_relaxed);
+        offset += count;
     }
+    _voxelOffsets[_voxelCnt] = offset;
+
+    // 2nd pass: fill in the triangle indexes at the cursor of the voxels
+    // and sort the indexes of each voxel for a deterministic result
+    SLuint numSortTasks = SL_min(numChunks * 4, _voxelCnt);
 
     if (_m->I16.size())
     {
-        _triangleIndexes16.resize(_voxelOffsets.back());
-        ifTriangleInVoxelDo([&](const SLushort& i, const SLuint& voxIndex) {
-            SLuint location              = --_voxelOffsets[voxIndex];
-            _triangleIndexes16[location] = i;
+        _triangleIndexes16.resize(offset);
+        pool.run(numChunks, [&](SLuint chunk, SLuint worker) {
+            ifTriangleInVoxelDo(
+              [&](const SLuint& i, const SLuint& voxIndex) {
+                  SLuint location = _voxelCounters[voxIndex].fetch_add(1, std::memory_order_relaxed);
+                  _triangleIndexes16[location] = (SLushort)i;
+              },
+              chunk * SL_GRID_BUILD_CHUNK,
+              (chunk + 1) * SL_GRID_BUILD_CHUNK);
+        });
+        pool.run(numSortTasks, [&](SLuint task, SLuint worker) {
+            SLuint vBegin = (SLuint)((SLuint64)_voxelCnt * task / numSortTasks);
+            SLuint vEnd   = (SLuint)((SLuint64)_voxelCnt * (task + 1) / numSortTasks);
+            for (SLuint v = vBegin; v < vEnd; ++v)
+                if (_voxelOffsets[v + 1] - _voxelOffsets[v] > 1)
+                    std::sort(_triangleIndexes16.begin() + _voxelOffsets[v],
+                              _triangleIndexes16.begin() + _voxelOffsets[v + 1]);
         });
-        _triangleIndexes16.shrink_to_fit();
     }
     else
     {
-        _triangleIndexes32.resize(_voxelOffsets.back());
-        ifTriangleInVoxelDo([&](const SLuint& i, const SLuint& voxIndex) {
-            SLuint location              = --_voxelOffsets[voxIndex];
-            _triangleIndexes32[location] = i;
+        _triangleIndexes32.resize(offset);
+        pool.run(numChunks, [&](SLuint chunk, SLuint worker) {
+            ifTriangleInVoxelDo(
+              [&](const SLuint& i, const SLuint& voxIndex) {
+                  SLuint location = _voxelCounters[voxIndex].fetch_add(1, std::memory_order_relaxed);
+                  _triangleIndexes32[location] = i;
+              },
+              chunk * SL_GRID_BUILD_CHUNK,
+              (chunk + 1) * SL_GRID_BUILD_CHUNK);
+        });
+        pool.run(numSortTasks, [&](SLuint task, SLuint worker) {
+            SLuint vBegin = (SLuint)((SLuint64)_voxelCnt * task / numSortTasks);
+            SLuint vEnd   = (SLuint)((SLuint64)_voxelCnt * (task + 1) / numSortTasks);
+            for (SLuint v = vBegin; v < vEnd; ++v)
+                if (_voxelOffsets[v + 1] - _voxelOffsets[v] > 1)
+                    std::sort(_triangleIndexes32.begin() + _voxelOffsets[v],
+                              _triangleIndexes32.begin() + _voxelOffsets[v + 1]);
         });
-        _triangleIndexes32.shrink_to_fit();
     }
-
-    _voxelOffsets.shrink_to_fit();
 }
 //-----------------------------------------------------------------------------
 //! Updates the statistics in the parent node
@@ -194,6 +284,7 @@ void SLCompactGrid::updateStats(SLNodeStats& stats)
 
     stats.numBytesAccel += sizeof(SLCompactGrid);
     stats.numBytesAccel += SL_sizeOfVector(_voxelOffsets);
+    stats.numBytesAccel += _voxelCountersSize * sizeof(std::atomic<SLuint>);
     stats.numBytesAccel += _m->I16.size()
                              ? SL_sizeOfVector(_triangleIndexes16)
                              : SL_sizeOfVector(_triangleIndexes32);
@@ -270,6 +361,8 @@ void SLCompactGrid::draw(SLSceneView* sv)
 Ray Mesh intersection method using the regular grid space subdivision structure
 and a voxel traversal algorithm described in "A Fast Voxel Traversal Algorithm
 for Ray Tracing" by John Amanatides and Andrew Woo.
+Shadow rays are any-hit queries: they return at the first triangle that lies
+between the hit point and the light (see SLRay::isShaded).
 */
 SLbool SLCompactGrid::intersect(SLRay* ray, SLNode* node)
 {
@@ -340,6 +433,8 @@ SLbool SLCompactGrid::intersect(SLRay* ray, SLNode* node)
                     {
                         if (_m->hitTriangleOS(ray, node, _triangleIndexes16[i] * 3))
                         {
+                            // a shadow ray is done with the first occluder
+                            if (ray->isShaded()) return true;
                             if (ray->length <= tMax && !wasHit)
                                 wasHit = true;
                         }
@@ -351,6 +446,8 @@ SLbool SLCompactGrid::intersect(SLRay* ray, SLNode* node)
                     {
                         if (_m->hitTriangleOS(ray, node, _triangleIndexes32[i] * 3))
                         {
+                            // a shadow ray is done with the first occluder
+                            if (ray->isShaded()) return true;
                             if (ray->length <= tMax && !wasHit)
                                 wasHit = true;
                         }
@@ -404,6 +501,7 @@ SLbool SLCompactGrid::intersect(SLRay* ray, SLNode* node)
             for (SLuint t = 0; t < _m->numI(); t += 3)
             {
                 if (_m->hitTriangleOS(ray, node, t) && !wasHit) wasHit = true;
+                if (ray->isShaded()) return true;
             }
             return wasHit;
         }
@@ -412,3 +510,154 @@ SLbool SLCompactGrid::intersect(SLRay* ray, SLNode* node)
         return false; // did not hit aabb
 }
 //-----------------------------------------------------------------------------
+/*!
+SLCompactGrid::intersectPacket intersects a packet of rays in object space.
+The grid is traversed slice by slice along the dominant axis k of the first
+active ray (coherent grid traversal by Wald et al.). In every slice the
+rectangle of the voxels that any ray passes between its entry and its exit of
+the slice is tested with the packet. The part of a ray behind its closest hit
+is cut off, so the traversal stops as soon as all rays are done. Packets whose
+rays don't all step in the same direction along k are traced ray by ray.
+*/
+void SLCompactGrid::intersectPacket(SLRayPacket& packet, SLNode* node)
+{
+    if (_voxelCnt == 0)
+    { // not enough triangles for regular grid > check them all
+        for (SLuint t = 0; t < _m->numI(); t += 3)
+            _m->hitTrianglePacketOS(packet, node, t);
+        return;
+    }
+
+    const SLfloat* O[3]    = {packet.oxOS, packet.oyOS, packet.ozOS};
+    const SLfloat* D[3]    = {packet.dxOS, packet.dyOS, packet.dzOS};
+    const SLfloat* invD[3] = {packet.ixOS, packet.iyOS, packet.izOS};
+
+    SLint first = 0;
+    while (first < SL_PACKET_SIZE && !packet.rays[first]) first++;
+    if (first == SL_PACKET_SIZE) return;
+
+    // Slice axis k is the dominant axis of the first ray, u & v are the others
+    SLint k = 0;
+    if (SL_abs(D[1][first]) > SL_abs(D[k][first])) k = 1;
+    if (SL_abs(D[2][first]) > SL_abs(D[k][first])) k = 2;
+    SLint  u        = (k + 1) % 3;
+    SLint  v        = (k + 2) % 3;
+    SLbool positive = D[k][first] > 0.0f;
+
+    // Entry & exit distance of each ray into the grid box
+    SLfloat tEnter[SL_PACKET_SIZE];
+    SLfloat tExit[SL_PACKET_SIZE];
+    SLbool  isCoherent = true;
+    SLint   sMin = (SLint)_size.comp[k], sMax = -1;
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        tEnter[i] = FLT_MAX;
+        tExit[i]  = -FLT_MAX;
+        if (!packet.rays[i]) continue;
+
+        if (D[k][i] == 0.0f || (D[k][i] > 0.0f) != positive)
+            isCoherent = false;
+
+        SLfloat tmin = -FLT_MAX, tmax = FLT_MAX;
+        for (SLint a = 0; a < 3; ++a)
+        {
+            SLfloat t1 = (_minV.comp[a] - O[a][i]) * invD[a][i];
+            SLfloat t2 = (_maxV.comp[a] - O[a][i]) * invD[a][i];
+            tmin       = SL_max(tmin, SL_min(t1, t2));
+            tmax       = SL_min(tmax, SL_max(t1, t2));
+        }
+        tmin = SL_max(tmin, 0.0f);
+        tmax = SL_min(tmax, packet.length[i]);
+        if (tmin > tmax) continue;
+        tEnter[i] = tmin;
+        tExit[i]  = tmax;
+
+        // Range of the slices the ray passes
+        for (SLfloat t : {tmin, tmax})
+        {
+            SLint s = (SLint)((O[k][i] + t * D[k][i] - _minV.comp[k]) / _voxelSize.comp[k]);
+            s       = SL_max(0, SL_min(s, (SLint)_size.comp[k] - 1));
+            sMin    = SL_min(sMin, s);
+            sMax    = SL_max(sMax, s);
+        }
+    }
+
+    if (!isCoherent)
+    { // trace ray by ray
+        for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+        {
+            SLRay* ray = packet.rays[i];
+            if (!ray) continue;
+            packet.toRayOS(i);
+            intersect(ray, node);
+            packet.length[i] = ray->length;
+        }
+        return;
+    }
+
+    if (sMax < 0) return; // no ray hits the grid
+
+    SLint  step     = positive ? 1 : -1;
+    SLint  sBegin   = positive ? sMin : sMax;
+    SLint  sEnd     = positive ? sMax + 1 : sMin - 1;
+    SLuint incID[3] = {1, _size.x, _size.x * _size.y};
+
+    for (SLint s = sBegin; s != sEnd; s += step)
+    {
+        SLfloat lo      = _minV.comp[k] + (SLfloat)s * _voxelSize.comp[k];
+        SLfloat hi      = lo + _voxelSize.comp[k];
+        SLint   uMin    = (SLint)_size.comp[u], uMax = -1;
+        SLint   vMin    = (SLint)_size.comp[v], vMax = -1;
+        SLbool  allDone = true; // all rays are behind their exit or hit
+
+        // Rectangle of the voxels of all rays in the slice
+        for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+        {
+            if (!packet.rays[i]) continue;
+
+            SLfloat t0 = (lo - O[k][i]) * invD[k][i];
+            SLfloat t1 = (hi - O[k][i]) * invD[k][i];
+            if (!positive) std::swap(t0, t1);
+            SLfloat tLimit = SL_min(tExit[i], packet.length[i]);
+            t0             = SL_max(t0, tEnter[i]);
+            t1             = SL_min(t1, tLimit);
+            if (t0 <= tLimit) allDone = false;
+            if (t0 > t1) continue;
+
+            for (SLfloat t : {t0, t1})
+            {
+                SLint cu = (SLint)((O[u][i] + t * D[u][i] - _minV.comp[u]) / _voxelSize.comp[u]);
+                SLint cv = (SLint)((O[v][i] + t * D[v][i] - _minV.comp[v]) / _voxelSize.comp[v]);
+                uMin     = SL_min(uMin, cu);
+                uMax     = SL_max(uMax, cu);
+                vMin     = SL_min(vMin, cv);
+                vMax     = SL_max(vMax, cv);
+            }
+        }
+
+        if (allDone) return;
+
+        uMin = SL_max(uMin, 0);
+        vMin = SL_max(vMin, 0);
+        uMax = SL_min(uMax, (SLint)_size.comp[u] - 1);
+        vMax = SL_min(vMax, (SLint)_size.comp[v] - 1);
+
+        for (SLint cv = vMin; cv <= vMax; ++cv)
+        {
+            for (SLint cu = uMin; cu <= uMax; ++cu)
+            {
+                SLuint voxID = (SLuint)s * incID[k] +
+                               (SLuint)cu * incID[u] +
+                               (SLuint)cv * incID[v];
+
+                for (SLuint i = _voxelOffsets[voxID]; i < _voxelOffsets[voxID + 1]; ++i)
+                {
+                    SLuint t = _m->I16.size() ? _triangleIndexes16[i]
+                                              : _triangleIndexes32[i];
+                    _m->hitTrianglePacketOS(packet, node, t * 3);
+                }
+            }
+        }
+    }
+}
+//-----------------------------------------------------------------------------
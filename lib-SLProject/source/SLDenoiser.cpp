@@ -0,0 +1,354 @@
+//#############################################################################
+//  File:      SLDenoiser.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLApplication.h>
+#include <SLDenoiser.h>
+#include <SLScene.h>
+
+//-----------------------------------------------------------------------------
+//! Albedo channels below this value are not divided out of the color
+static const SLfloat albedoMin = 0.01f;
+//! B3-spline kernel weights of the A-trous filter for the offsets 0, 1 & 2
+static const SLfloat kernelB3[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+//-----------------------------------------------------------------------------
+//! Divides the albedo out of a color channel
+static inline SLfloat demodulate(SLfloat color, SLfloat albedo)
+{
+    return albedo > albedoMin ? color / albedo : color;
+}
+//-----------------------------------------------------------------------------
+//! Multiplies a color channel with the albedo again
+static inline SLfloat remodulate(SLfloat light, SLfloat albedo)
+{
+    return albedo > albedoMin ? light * albedo : light;
+}
+//-----------------------------------------------------------------------------
+//! Returns the luminance of a linear RGB color
+static inline SLfloat luminance(const SLCol4f& c)
+{
+    return 0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b;
+}
+//-----------------------------------------------------------------------------
+SLDenoiser::SLDenoiser()
+{
+    _width       = 0;
+    _height      = 0;
+    _iterations  = SL_DENOISE_ITERATIONS;
+    _sigmaColor  = 4.0f;
+    _sigmaNormal = 128.0f;
+    _sigmaDepth  = 0.02f;
+    _isValid     = false;
+    _denoiseSec  = 0.0f;
+}
+//-----------------------------------------------------------------------------
+/*!
+Sets the image size and resets the feature sums. It is called at the start of
+every path tracing because the accumulation of the samples starts again.
+*/
+void SLDenoiser::resize(SLint width, SLint height)
+{
+    _width  = width;
+    _height = height;
+
+    SLuint numPixels = (SLuint)(width * height);
+    _albedoSum.assign(numPixels, SLCol4f(0, 0, 0, 0));
+    _normalSum.assign(numPixels, SLVec3f::ZERO);
+    _depthSum.assign(numPixels, 0.0f);
+    _lumSum.assign(numPixels, 0.0f);
+    _lumSqSum.assign(numPixels, 0.0f);
+    _isValid = false;
+}
+//-----------------------------------------------------------------------------
+/*!
+Adds the features of the first hit of one sample to the pixel i. The depth is
+the distance of the first hit or 0 if the background was hit. The luminance
+moments are summed up for the lighting, that is the color without albedo.
+A pixel is only written by one render thread at a time.
+*/
+void SLDenoiser::addSample(SLuint         i,
+                           const SLCol4f& color,
+                           const SLCol4f& albedo,
+                           const SLVec3f& normal,
+                           SLfloat        depth)
+{
+    _albedoSum[i] += albedo;
+    _normalSum[i] += normal;
+    _depthSum[i] += depth;
+
+    SLCol4f light(demodulate(color.r, albedo.r),
+                  demodulate(color.g, albedo.g),
+                  demodulate(color.b, albedo.b));
+    SLfloat lum = luminance(light);
+    _lumSum[i] += lum;
+    _lumSqSum[i] += lum * lum;
+}
+//-----------------------------------------------------------------------------
+/*!
+Denoises the mean of the HDR accumulation buffer with the sums sum and the
+sample counts num. The tiles must cover the image. Every pass runs over all
+tiles with the threads of the render pool and writes into its own buffer, so
+the passes need no locks. The denoised mean is available with result.
+*/
+void SLDenoiser::denoise(const SLVCol4f&      sum,
+                         const SLVuint&       num,
+                         SLRenderPool&        pool,
+                         const SLVRenderTile& tiles,
+                         SLuint               maxWorkers)
+{
+    SLuint numPixels = (SLuint)(_width * _height);
+    if (!numPixels || sum.size() != numPixels || num.size() != numPixels)
+        return;
+
+    double t1 = SLApplication::scene->timeSec();
+
+    _albedo.resize(numPixels);
+    _normal.resize(numPixels);
+    _depth.resize(numPixels);
+    _numSamples.resize(numPixels);
+    _ping.resize(numPixels);
+    _pong.resize(numPixels);
+    _result.resize(numPixels);
+
+    auto runTiles = [&](const std::function<void(const SLRenderTile&)>& func) {
+        pool.run((SLuint)tiles.size(),
+                 [&](SLuint task, SLuint worker) { func(tiles[task]); },
+                 maxWorkers);
+    };
+
+    runTiles([&](const SLRenderTile& t) { prepareTile(t, sum, num); });
+    runTiles([&](const SLRenderTile& t) { estimateVarianceTile(t); });
+
+    // The A-trous iterations with growing holes swap the buffers
+    SLVCol4f* src = &_pong;
+    SLVCol4f* dst = &_ping;
+    for (SLint i = 0; i < _iterations; ++i)
+    {
+        SLint step = 1 << i;
+        runTiles([&](const SLRenderTile& t) { filterTile(t, step, *src, *dst); });
+        std::swap(src, dst);
+    }
+
+    runTiles([&](const SLRenderTile& t) { remodulateTile(t, *src); });
+
+    _isValid    = true;
+    _denoiseSec = (SLfloat)(SLApplication::scene->timeSec() - t1);
+}
+//-----------------------------------------------------------------------------
+/*!
+Calculates the mean features of the pixels of a tile and writes the lighting
+and the variance of its mean luminance into _ping.
+*/
+void SLDenoiser::prepareTile(const SLRenderTile& tile,
+                             const SLVCol4f&     sum,
+                             const SLVuint&      num)
+{
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            SLuint i = (SLuint)(y * _width + x);
+            SLuint n = num[i];
+            _numSamples[i] = n;
+
+            if (!n)
+            {
+                _albedo[i].set(1, 1, 1, 1);
+                _normal[i] = SLVec3f::ZERO;
+                _depth[i]  = 0.0f;
+                _ping[i].set(0, 0, 0, 0);
+                continue;
+            }
+
+            SLfloat invN = 1.0f / (SLfloat)n;
+            SLCol4f a(_albedoSum[i].r * invN,
+                      _albedoSum[i].g * invN,
+                      _albedoSum[i].b * invN);
+            _albedo[i] = a;
+
+            SLVec3f N   = _normalSum[i];
+            SLfloat len = N.length();
+            _normal[i]  = len > 0.0f ? N / len : SLVec3f::ZERO;
+            _depth[i]   = _depthSum[i] * invN;
+
+            // variance of the mean is the variance of the samples / n
+            SLfloat lumMean = _lumSum[i] * invN;
+            SLfloat var     = SL_max(_lumSqSum[i] * invN - lumMean * lumMean, 0.0f) * invN;
+
+            _ping[i].set(demodulate(sum[i].r * invN, a.r),
+                         demodulate(sum[i].g * invN, a.g),
+                         demodulate(sum[i].b * invN, a.b),
+                         var);
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Copies the lighting of _ping into _pong. Pixels with too few samples for a
+reliable variance get the luminance variance of the surrounding 7x7 pixels
+on the same surface instead.
+*/
+void SLDenoiser::estimateVarianceTile(const SLRenderTile& tile)
+{
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            SLuint p = (SLuint)(y * _width + x);
+            _pong[p] = _ping[p];
+
+            if (!_numSamples[p] || _numSamples[p] >= SL_DENOISE_MIN_SAMPLES)
+                continue;
+
+            SLfloat sumW = 0.0f, sumL = 0.0f, sumL2 = 0.0f;
+            for (SLint qy = SL_max(y - 3, 0); qy <= SL_min(y + 3, _height - 1); ++qy)
+            {
+                for (SLint qx = SL_max(x - 3, 0); qx <= SL_min(x + 3, _width - 1); ++qx)
+                {
+                    SLuint q = (SLuint)(qy * _width + qx);
+                    if (!_numSamples[q]) continue;
+
+                    SLfloat w = geometryWeight(p, q, 1);
+                    SLfloat l = luminance(_ping[q]);
+                    sumW += w;
+                    sumL += w * l;
+                    sumL2 += w * l * l;
+                }
+            }
+
+            if (sumW > 0.0f)
+            {
+                SLfloat mean = sumL / sumW;
+                _pong[p].a   = SL_max(sumL2 / sumW - mean * mean, 0.0f);
+            }
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the edge stopping weight of the pixel q for the center pixel p out of
+their normals and depths. The allowed depth difference grows with the pixel
+distance step. Background pixels (depth 0) are only mixed with background.
+*/
+SLfloat SLDenoiser::geometryWeight(SLuint p, SLuint q, SLint step) const
+{
+    SLfloat zP = _depth[p];
+    SLfloat zQ = _depth[q];
+    if (zP <= 0.0f || zQ <= 0.0f)
+        return zP <= 0.0f && zQ <= 0.0f ? 1.0f : 0.0f;
+
+    SLfloat NdN = SL_max(_normal[p].dot(_normal[q]), 0.0f);
+    SLfloat wN  = pow(NdN, _sigmaNormal);
+    SLfloat wZ  = exp(-SL_abs(zP - zQ) / (_sigmaDepth * zP * (SLfloat)step));
+    return wN * wZ;
+}
+//-----------------------------------------------------------------------------
+/*!
+One A-trous iteration over a tile: The 5x5 B3-spline kernel is applied with
+the pixel distance step between its taps. The luminance weight uses the
+standard deviation of the center pixel out of its 3x3 blurred variance. The
+variance in the alpha channel is filtered with the squared weights.
+*/
+void SLDenoiser::filterTile(const SLRenderTile& tile,
+                            SLint               step,
+                            const SLVCol4f&     src,
+                            SLVCol4f&           dst)
+{
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            SLuint         p  = (SLuint)(y * _width + x);
+            const SLCol4f& cP = src[p];
+
+            if (!_numSamples[p])
+            {
+                dst[p] = cP;
+                continue;
+            }
+
+            // Blur the variance of the center with a 3x3 Gaussian
+            SLfloat varSum = 0.0f, varW = 0.0f;
+            for (SLint qy = SL_max(y - 1, 0); qy <= SL_min(y + 1, _height - 1); ++qy)
+            {
+                for (SLint qx = SL_max(x - 1, 0); qx <= SL_min(x + 1, _width - 1); ++qx)
+                {
+                    SLfloat w = (qx == x ? 0.5f : 0.25f) * (qy == y ? 0.5f : 0.25f);
+                    varSum += w * src[(SLuint)(qy * _width + qx)].a;
+                    varW += w;
+                }
+            }
+            SLfloat lumP     = luminance(cP);
+            SLfloat lumScale = _sigmaColor * sqrt(varSum / varW) + 1.0e-4f;
+
+            SLfloat wP   = kernelB3[0] * kernelB3[0];
+            SLfloat sumW = wP;
+            SLfloat sumV = wP * wP * cP.a;
+            SLCol4f sumC(cP.r * wP, cP.g * wP, cP.b * wP);
+
+            for (SLint dy = -2; dy <= 2; ++dy)
+            {
+                SLint qy = y + dy * step;
+                if (qy < 0 || qy >= _height) continue;
+
+                for (SLint dx = -2; dx <= 2; ++dx)
+                {
+                    SLint qx = x + dx * step;
+                    if ((!dx && !dy) || qx < 0 || qx >= _width) continue;
+
+                    SLuint q = (SLuint)(qy * _width + qx);
+                    if (!_numSamples[q]) continue;
+
+                    const SLCol4f& cQ = src[q];
+                    SLfloat        wL = exp(-SL_abs(lumP - luminance(cQ)) / lumScale);
+                    SLfloat        w  = kernelB3[SL_abs(dx)] *
+                                kernelB3[SL_abs(dy)] *
+                                geometryWeight(p, q, step) * wL;
+                    if (w <= 0.0f) continue;
+
+                    sumC.r += w * cQ.r;
+                    sumC.g += w * cQ.g;
+                    sumC.b += w * cQ.b;
+                    sumV += w * w * cQ.a;
+                    sumW += w;
+                }
+            }
+
+            dst[p].set(sumC.r / sumW,
+                       sumC.g / sumW,
+                       sumC.b / sumW,
+                       sumV / (sumW * sumW));
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Multiplies the filtered lighting with the albedo into the result
+void SLDenoiser::remodulateTile(const SLRenderTile& tile, const SLVCol4f& src)
+{
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            SLuint         i = (SLuint)(y * _width + x);
+            const SLCol4f& l = src[i];
+            const SLCol4f& a = _albedo[i];
+            _result[i].set(remodulate(l.r, a.r),
+                           remodulate(l.g, a.g),
+                           remodulate(l.b, a.b),
+                           1.0f);
+        }
+    }
+}
+//-----------------------------------------------------------------------------
@@ -13,16 +13,33 @@
 #ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
 #    include <debug_new.h> // memory leak detector
 #endif
+#include <SLAnimTrack.h>
 #include <SLKeyframe.h>
 
 //-----------------------------------------------------------------------------
 /*! Constructor for default keyframes.
 */
-SLKeyframe::SLKeyframe(const SLAnimTrack* parent, SLfloat time)
+SLKeyframe::SLKeyframe(SLAnimTrack* parent, SLfloat time)
   : _parentTrack(parent), _time(time)
 {
 }
 //-----------------------------------------------------------------------------
+/*! Setter for the time. The keyframes of a track must stay sorted by time.
+*/
+void SLKeyframe::time(SLfloat t)
+{
+    _time = t;
+    changed();
+}
+//-----------------------------------------------------------------------------
+/*! Flags the keyframe arrays of the parent track for a rebuild.
+*/
+void SLKeyframe::changed()
+{
+    if (_parentTrack)
+        _parentTrack->keyframesOutOfDate();
+}
+//-----------------------------------------------------------------------------
 /*! Comperator operator.
 */
 bool SLKeyframe::operator<(const SLKeyframe& other) const
@@ -32,8 +49,8 @@ bool SLKeyframe::operator<(const SLKeyframe& other) const
 //-----------------------------------------------------------------------------
 /*! Constructor for specialized transform keyframes.
 */
-SLTransformKeyframe::SLTransformKeyframe(const SLAnimTrack* parent,
-                                         SLfloat            time)
+SLTransformKeyframe::SLTransformKeyframe(SLAnimTrack* parent,
+                                         SLfloat      time)
   : SLKeyframe(parent, time),
     _translation(0, 0, 0),
     _rotation(0, 0, 0, 1),
@@ -41,3 +58,21 @@ SLTransformKeyframe::SLTransformKeyframe(const SLAnimTrack* parent,
 {
 }
 //-----------------------------------------------------------------------------
+void SLTransformKeyframe::translation(const SLVec3f& t)
+{
+    _translation = t;
+    changed();
+}
+//-----------------------------------------------------------------------------
+void SLTransformKeyframe::rotation(const SLQuat4f& r)
+{
+    _rotation = r;
+    changed();
+}
+//-----------------------------------------------------------------------------
+void SLTransformKeyframe::scale(const SLVec3f& s)
+{
+    _scale = s;
+    changed();
+}
+//-----------------------------------------------------------------------------
@@ -14,7 +14,63 @@
 #    include <debug_new.h> // memory leak detector
 #endif
 
-#include "SLLight.h"
+#include <SLApplication.h>
+#include <SLLight.h>
+#include <SLMesh.h>
+#include <SLNode.h>
+#include <SLRay.h>
+#include <SLRayStats.h>
+#include <SLScene.h>
+
+//-----------------------------------------------------------------------------
+//! Last opaque occluder of the shadow rays to one light (see SLLight::isOccluded)
+struct SLOccluder
+{
+    const SLLight* light;    //!< light the shadow rays were shot to
+    SLNode*        node;     //!< node of the occluding mesh
+    SLMesh*        mesh;     //!< occluding mesh
+    SLuint         triangle; //!< index of the first vertex index of the triangle
+};
+//-----------------------------------------------------------------------------
+//! Frame counter that invalidates the shadow caches of all threads
+static std::atomic<SLuint> shadowFrameCounter(0);
+//! Tile counter of the calling thread that scopes the per-tile shadow data
+static thread_local SLuint shadowTileCounter = 0;
+//-----------------------------------------------------------------------------
+/*!
+Returns the occluder cache entry of the light for the calling thread. The few
+lights of a scene are searched linearly. The cache of a thread gets cleared
+on the first call after SLLight::newShadowFrame, so no pointers to deleted
+nodes or meshes survive a frame.
+*/
+static SLOccluder& lastOccluder(const SLLight* light)
+{
+    thread_local vector<SLOccluder> cache;
+    thread_local SLuint             cacheFrame = 0;
+
+    SLuint frame = SLLight::shadowFrame();
+    if (cacheFrame != frame)
+    {
+        cache.clear();
+        cacheFrame = frame;
+    }
+
+    for (auto& occ : cache)
+        if (occ.light == light)
+            return occ;
+
+    cache.push_back({light, nullptr, nullptr, 0});
+    return cache.back();
+}
+//-----------------------------------------------------------------------------
+//! Returns true if the node is hidden or the shadow ray started in its subtree
+static SLbool isSkippedOccluder(SLNode* node, SLRay* shadowRay)
+{
+    for (SLNode* n = node; n; n = n->parent())
+        if (n->drawBit(SL_DB_HIDDEN) || n == shadowRay->srcNode)
+            return true;
+    return false;
+}
 
 //-----------------------------------------------------------------------------
 SLLight::SLLight(SLfloat ambiPower,
@@ -70,3 +126,77 @@ void SLLight::spotCutOffDEG(const SLfloat cutOffAngleDEG)
     _spotCosCutOffRAD = cos(SL_DEG2RAD * _spotCutOffDEG);
 }
 //-----------------------------------------------------------------------------
+/*!
+SLLight::isOccluded shoots the shadow ray towards the light and returns true if
+anything blocks it before shadowRay->length. The shadow ray is an any-hit query
+that stops at the first occluder in the scene BVH, the node hierarchy and the
+acceleration structures of the meshes (see SLRay::isShaded).
+Before that the last opaque occluder of this light in the calling thread is
+tested with one triangle intersection. The hit parameters of the shadow ray are
+set like with SLScene::hit, so transparent occluders can be shaded afterwards.
+*/
+SLbool SLLight::isOccluded(SLRay* shadowRay)
+{
+    assert(shadowRay->type == SHADOW);
+
+    SLOccluder& occ = lastOccluder(this);
+
+    if (occ.mesh && !isSkippedOccluder(occ.node, shadowRay))
+    {
+        const SLMat4f& wmI = occ.node->updateAndGetWMI();
+        shadowRay->originOS.set(wmI.multVec(shadowRay->origin));
+        shadowRay->setDirOS(wmI.mat3() * shadowRay->dir);
+
+        if (occ.mesh->hitTriangleOS(shadowRay, occ.node, occ.triangle) &&
+            shadowRay->isShaded())
+        {
+            ++SLRayStats::local().occluderHits;
+            return true;
+        }
+    }
+
+    SLApplication::scene->hit(shadowRay);
+
+    if (!shadowRay->isShaded())
+        return false;
+
+    // remember only opaque triangles, transparent ones need the full query
+    SLMesh* mesh = shadowRay->hitMesh;
+    if (mesh->primitive() == PT_triangles && !mesh->mat()->hasAlpha())
+        occ = {this, shadowRay->hitNode, mesh, (SLuint)shadowRay->hitTriangle};
+
+    return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Invalidates the shadow caches of all threads. It must be called before a
+new frame gets ray traced because nodes and meshes may have changed.
+*/
+void SLLight::newShadowFrame()
+{
+    ++shadowFrameCounter;
+}
+//-----------------------------------------------------------------------------
+//! Returns the current frame of the per-thread shadow caches
+SLuint SLLight::shadowFrame()
+{
+    return shadowFrameCounter.load(std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------------
+/*!
+Starts a new tile of the calling render thread. The shadow data that a light
+keeps about the neighbour pixels (see SLLightRect::shadowTest) is only used
+within one tile. The pixels of a tile are always traced in the same order by
+one thread, so the rendered image does not depend on the scheduling.
+*/
+void SLLight::newShadowTile()
+{
+    ++shadowTileCounter;
+}
+//-----------------------------------------------------------------------------
+//! Returns the current tile of the calling render thread
+SLuint SLLight::shadowTile()
+{
+    return shadowTileCounter;
+}
+//-----------------------------------------------------------------------------
@@ -161,7 +161,7 @@ SLfloat SLLightDirect::shadowTest(SLRay*         ray, // ray of hit point
 {
     // define shadow ray and shoot
     SLRay shadowRay(lightDist, L, ray);
-    SLApplication::scene->root3D()->hitRec(&shadowRay);
+    isOccluded(&shadowRay);
 
     if (shadowRay.length < lightDist)
     {
@@ -189,7 +189,7 @@ SLfloat SLLightDirect::shadowTestMC(SLRay*         ray, // ray of hit point
 {
     // define shadow ray and shoot
     SLRay shadowRay(lightDist, L, ray);
-    SLApplication::scene->root3D()->hitRec(&shadowRay);
+    isOccluded(&shadowRay);
 
     if (shadowRay.length < lightDist)
     {
@@ -18,10 +18,10 @@
 #include <SLLightRect.h>
 #include <SLPolygon.h>
 #include <SLRay.h>
+#include <SLSampler.h>
 #include <SLScene.h>
 #include <SLSceneView.h>
 
-extern SLfloat rnd01();
 
 //-----------------------------------------------------------------------------
 SLLightRect::SLLightRect(SLfloat w,
@@ -147,10 +147,65 @@ void SLLightRect::drawMeshes(SLSceneView* sv)
     }
 }
 //-----------------------------------------------------------------------------
+//! Shadow values of the last shaded pixels of one rect light in one thread
+struct SLPenumbraRow
+{
+    const SLLightRect* light;   //!< light of the shadow values
+    SLVfloat           lighted; //!< shadow value of the last shaded pixel per column
+    SLVint             row;     //!< pixel row of that value per column
+    SLVuint            tile;    //!< tile of that value per column (see SLLight::shadowTile)
+};
+//-----------------------------------------------------------------------------
+/*!
+Returns the penumbra row of the light for the calling thread. The row grows
+with the pixel column x. Its values are only valid for the tile they were
+written in, so no reset is needed for a new tile or frame.
+*/
+static SLPenumbraRow& penumbraRow(const SLLightRect* light, SLint x)
+{
+    thread_local vector<SLPenumbraRow> rows;
+    thread_local SLuint                rowsFrame = 0;
+
+    // forget the rows of deleted lights
+    if (rowsFrame != SLLight::shadowFrame())
+    {
+        rowsFrame = SLLight::shadowFrame();
+        rows.clear();
+    }
+
+    SLPenumbraRow* pr = nullptr;
+    for (auto& r : rows)
+        if (r.light == light) pr = &r;
+
+    if (!pr)
+    {
+        rows.push_back({light, SLVfloat(), SLVint(), SLVuint()});
+        pr = &rows.back();
+    }
+
+    if ((SLint)pr->row.size() < x + 2)
+    {
+        pr->lighted.resize((size_t)x + 2, 0.0f);
+        pr->row.resize((size_t)x + 2, -2);
+        pr->tile.resize((size_t)x + 2, 0);
+    }
+    return *pr;
+}
+//-----------------------------------------------------------------------------
 /*!
 SLLightRect::shadowTest returns 0.0 if the hit point is completely shaded and 
 1.0 if it is 100% lighted. A return value inbetween is calculate by the ratio 
 of the shadow rays not blocked to the total number of casted shadow rays.
+The soft shadow is sampled adaptively: First only the important sample points
+at the corners, the edge centers and the center are tested. Only if all of
+them are lighting the other sample cells are skipped, because a light gap
+between blocked important points can't be excluded. For hit points of primary
+rays the shadow values of the already shaded neighbour pixels of the same
+tile are also checked, so that a penumbra that falls between the important
+points is detected at its border. Every sample is jittered within its cell
+with a random point that only depends on the pixel and the cell, so the
+images don't depend on the thread scheduling. The sample states and the
+neighbour values are kept in per-thread scratch memory.
 */
 SLfloat SLLightRect::shadowTest(SLRay*         ray,      // ray of hit point
                                 const SLVec3f& L,        // vector from hit point to light
@@ -161,37 +216,36 @@ SLfloat SLLightRect::shadowTest(SLRay*         ray,      // ray of hit point
         // define shadow ray
         SLRay shadowRay(lightDist, L, ray);
 
-        SLApplication::scene->root3D()->hitRec(&shadowRay);
+        isOccluded(&shadowRay);
 
         return (shadowRay.length < lightDist) ? 0.0f : 1.0f;
     }
-    else // do light sampling for soft shadows
+    else // do adaptive light sampling for soft shadows
     {
         SLfloat dw = (SLfloat)_width / (SLfloat)_samples.x;  // width of a sample cell
         SLfloat dl = (SLfloat)_height / (SLfloat)_samples.y; // length of a sample cell
         SLint   x, y, hx = _samples.x / 2, hy = _samples.y / 2;
-        SLint   samples = _samples.x * _samples.y;
-        SLVbool isSampled;
-        SLbool  importantPointsAreLighting = true;
-        SLfloat lighted                    = 0.0f; // return value
-        SLfloat invSamples                 = 1.0f / (SLfloat)(samples);
-        SLVec3f SP; // vector hit point to sample point in world coords
-
-        isSampled.resize((SLuint)samples);
-
-        for (y = 0; y < _samples.y; ++y)
-        {
-            for (x = 0; x < _samples.x; ++x)
-            {
-                SLint iSP              = y * _samples.x + x;
-                isSampled[(SLuint)iSP] = false;
-            }
-        }
+        SLint   samples    = _samples.x * _samples.y;
+        SLint   numSampled = 0; // NO. of tested sample points
+        SLint   numLighted = 0; // NO. of not blocked sample points
+
+        thread_local SLVuchar isSampled; // per-thread scratch of the cell states
+        isSampled.assign((size_t)samples, 0);
+
+        // Tests the cell (x, y) at a jittered position within the cell
+        auto testCell = [&](SLint cx, SLint cy) {
+            SLint   cell = (cy + hy) * _samples.x + cx + hx;
+            SLVec2f jit  = SLSampler::hashed2D(ray->x, ray->y, (SLuint)cell);
+            isSampled[(size_t)cell] = 1;
+            return isLighting(ray,
+                              ((SLfloat)cx + jit.x - 0.5f) * dw,
+                              ((SLfloat)cy + jit.y - 0.5f) * dl);
+        };
 
         /*
         Important sample points (X) on a 7 by 5 rectangular light.
-        If all of them are lighting the hit point the sample points
-        in between (O) are not tested anymore.
+        If all of them are lighting and the neighbour pixels agree, the 
+        sample points in between (.) are not tested.
 
              0   1   2   3   4   5   6         
            +---+---+---+---+---+---+---+
@@ -207,58 +261,89 @@ SLfloat SLLightRect::shadowTest(SLRay*         ray,      // ray of hit point
            +---+---+---+---+---+---+---+
         */
 
-        // Double loop for the important sample points
-        for (y = -hy; y <= hy; y += hy)
+        // Double loop for the important sample points (hx or hy may be 0)
+        for (y = -hy; y <= hy; y += SL_max(hy, 1))
         {
-            for (x = -hx; x <= hx; x += hx)
+            for (x = -hx; x <= hx; x += SL_max(hx, 1))
             {
-                SLint iSP              = (y + hy) * _samples.x + x + hx;
-                isSampled[(SLuint)iSP] = true;
+                numSampled++;
+                if (testCell(x, y)) numLighted++;
+            }
+        }
 
-                SP.set(updateAndGetWM().multVec(SLVec3f(x * dw, y * dl, 0)) - ray->hitPoint);
-                SLfloat SPDist = SP.length();
-                SP.normalize();
-                SLRay shadowRay(SPDist, SP, ray);
+        SLbool  doAllCells = numLighted < numSampled;
+        SLfloat lighted    = (SLfloat)numLighted / (SLfloat)numSampled;
 
-                SLApplication::scene->root3D()->hitRec(&shadowRay);
+        // Check the already shaded neighbour pixels of a primary hit point
+        SLPenumbraRow* pr   = nullptr;
+        SLint          px   = (SLint)ray->x;
+        SLint          py   = (SLint)ray->y;
+        SLuint         tile = SLLight::shadowTile();
+        if (ray->type == PRIMARY && px >= 0)
+        {
+            pr = &penumbraRow(this, px);
 
-                if (shadowRay.length >= SPDist - FLT_EPSILON)
-                    lighted += invSamples; // sum up the light
-                else
-                    importantPointsAreLighting = false;
+            if (!doAllCells)
+            {
+                // left, top-left, top and top-right neighbour of the tile
+                SLfloat maxDiff = 0.5f / (SLfloat)samples;
+                for (SLint nx = SL_max(px - 1, 0); nx <= px + 1; ++nx)
+                {
+                    SLint nRow = pr->row[(size_t)nx];
+                    if (pr->tile[(size_t)nx] == tile &&
+                        (nRow == py || nRow == py - 1))
+                    {
+                        if (SL_abs(pr->lighted[(size_t)nx] - lighted) > maxDiff)
+                        {
+                            doAllCells = true;
+                            break;
+                        }
+                    }
+                }
             }
         }
 
-        if (importantPointsAreLighting)
-            lighted = 1.0f;
-        else
+        if (doAllCells)
         { // Double loop for the sample points in between
             for (y = -hy; y <= hy; ++y)
             {
                 for (x = -hx; x <= hx; ++x)
                 {
-                    SLint iSP = (y + hy) * _samples.x + x + hx;
-                    if (!isSampled[(SLuint)iSP])
-                    {
-                        SP.set(updateAndGetWM().multVec(SLVec3f(x * dw, y * dl, 0)) - ray->hitPoint);
-                        SLfloat SPDist = SP.length();
-                        SP.normalize();
-                        SLRay shadowRay(SPDist, SP, ray);
-
-                        SLApplication::scene->root3D()->hitRec(&shadowRay);
-
-                        // sum up the light
-                        if (shadowRay.length >= SPDist - FLT_EPSILON)
-                            lighted += invSamples;
-                    }
+                    if (!isSampled[(size_t)((y + hy) * _samples.x + x + hx)])
+                        if (testCell(x, y)) numLighted++;
                 }
             }
+            lighted = (SLfloat)numLighted / (SLfloat)samples;
         }
+
+        if (pr)
+        {
+            pr->lighted[(size_t)px] = lighted;
+            pr->row[(size_t)px]     = py;
+            pr->tile[(size_t)px]    = tile;
+        }
+
         return lighted;
     }
 }
 //-----------------------------------------------------------------------------
 /*!
+Returns true if the sample point at (x, y) in the lights object space is not
+blocked for the hit point of the ray.
+*/
+SLbool SLLightRect::isLighting(SLRay* ray, SLfloat x, SLfloat y)
+{
+    SLVec3f SP(updateAndGetWM().multVec(SLVec3f(x, y, 0)) - ray->hitPoint);
+    SLfloat SPDist = SP.length();
+    SP.normalize();
+    SLRay shadowRay(SPDist, SP, ray);
+
+    isOccluded(&shadowRay);
+
+    return shadowRay.length >= SPDist - FLT_EPSILON;
+}
+//-----------------------------------------------------------------------------
+/*!
 SLLightRect::shadowTestMC returns 0.0 if the hit point is shaded and 1.0 if it
 lighted. Only one shadow sample is tested for path tracing.
 */
@@ -266,8 +351,9 @@ SLfloat SLLightRect::shadowTestMC(SLRay*         ray,      // ray of hit point
                                   const SLVec3f& L,        // vector from hit point to light
                                   const SLfloat  lightDist) // distance to light
 {
-    SLfloat rndX = rnd01();
-    SLfloat rndY = rnd01();
+    SLVec2f rnd  = SLSampler::local().get2D();
+    SLfloat rndX = rnd.x;
+    SLfloat rndY = rnd.y;
 
     // Sample point in object space
     SLVec3f spOS(SLVec3f(rndX * _width - _width * 0.5f,
@@ -281,7 +367,7 @@ SLfloat SLLightRect::shadowTestMC(SLRay*         ray,      // ray of hit point
     spWS.normalize();
     SLRay shadowRay(spDistWS, spWS, ray);
 
-    SLApplication::scene->root3D()->hitRec(&shadowRay);
+    isOccluded(&shadowRay);
 
     return (shadowRay.length < spDistWS) ? 0.0f : 1.0f;
 }
@@ -192,7 +192,7 @@ SLfloat SLLightSpot::shadowTest(SLRay*         ray, // ray of hit point
     {
         // define shadow ray and shoot
         SLRay shadowRay(lightDist, L, ray);
-        SLApplication::scene->root3D()->hitRec(&shadowRay);
+        isOccluded(&shadowRay);
 
         if (shadowRay.length < lightDist)
         {
@@ -247,7 +247,7 @@ SLfloat SLLightSpot::shadowTest(SLRay*         ray, // ray of hit point
 
                 SLRay shadowRay(lightDist, LDisc, ray);
 
-                SLApplication::scene->root3D()->hitRec(&shadowRay);
+                isOccluded(&shadowRay);
 
                 if (shadowRay.length < lightDist)
                     outerCircleIsLighting = false;
@@ -284,7 +284,7 @@ SLfloat SLLightSpot::shadowTestMC(SLRay*         ray, // ray of hit point
     {
         // define shadow ray and shoot
         SLRay shadowRay(lightDist, L, ray);
-        SLApplication::scene->root3D()->hitRec(&shadowRay);
+        isOccluded(&shadowRay);
 
         if (shadowRay.length < lightDist)
         {
@@ -339,7 +339,7 @@ SLfloat SLLightSpot::shadowTestMC(SLRay*         ray, // ray of hit point
 
                 SLRay shadowRay(lightDist, LDisc, ray);
 
-                SLApplication::scene->root3D()->hitRec(&shadowRay);
+                isOccluded(&shadowRay);
 
                 if (shadowRay.length < lightDist)
                     outerCircleIsLighting = false;
@@ -15,15 +15,27 @@
 #endif
 
 #include <SLApplication.h>
+#include <SLBVH.h>
 #include <SLCompactGrid.h>
 #include <SLLightRect.h>
 #include <SLLightSpot.h>
 #include <SLNode.h>
 #include <SLRay.h>
+#include <SLRayPacket.h>
+#include <SLRayStats.h>
 #include <SLRaytracer.h>
+#include <SLRenderPool.h>
 #include <SLSceneView.h>
 #include <SLSkybox.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define SL_SKIN_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define SL_SKIN_NEON
+#    include <arm_neon.h>
+#endif
+
 //-----------------------------------------------------------------------------
 /*! 
 The constructor initializes everything to 0 and adds the instance to the vector
@@ -46,6 +58,11 @@ SLMesh::SLMesh(SLstring name) : SLObject(name)
     _isVolume             = true;    // is used for RT to decide inside/outside
     _accelStruct          = nullptr; // no initial acceleration structure
     _accelStructOutOfDate = true;
+    _accelStructType      = AST_auto;
+    _accelStructKeepSize  = false;
+    _doTriangleCache      = true;
+    _cpuSkinIsOutdated    = false;
+    _vaoIsGPUSkinned      = false;
 
     // Add this mesh to the global resource vector for deallocation
     SLApplication::scene->meshes().push_back(this);
@@ -57,6 +74,11 @@ deallocated when the scene is disposed in SLScene::unInit().
 */
 SLMesh::~SLMesh()
 {
+    // Remove this mesh from the nodes that still hold it
+    unordered_set<SLNode*> nodes = _nodes;
+    for (auto node : nodes)
+        node->removeMesh(this);
+
     deleteData();
 }
 //-----------------------------------------------------------------------------
@@ -74,6 +96,9 @@ void SLMesh::deleteData()
     for (auto i : Jw)
         i.clear();
     Jw.clear();
+    Ji4.clear();
+    Jw4.clear();
+    _jointIdsGL.clear();
     I16.clear();
     I32.clear();
     IS32.clear();
@@ -81,6 +106,7 @@ void SLMesh::deleteData()
     _jointMatrices.clear();
     skinnedP.clear();
     skinnedN.clear();
+    _hitTriangles.clear();
 
     if (_accelStruct)
     {
@@ -114,6 +140,8 @@ void SLMesh::deleteSelected(SLNode* node)
         if (ixDel < Tc.size()) Tc.erase(Tc.begin() + ixDel);
         if (ixDel < Ji.size()) Ji.erase(Ji.begin() + ixDel);
         if (ixDel < Jw.size()) Jw.erase(Jw.begin() + ixDel);
+        if (ixDel < Ji4.size()) Ji4.erase(Ji4.begin() + ixDel);
+        if (ixDel < Jw4.size()) Jw4.erase(Jw4.begin() + ixDel);
 
         // Loop over all 16 bit triangles indexes
         if (I16.size())
@@ -225,6 +253,8 @@ void SLMesh::deleteUnused()
             if (ixDel < Tc.size()) Tc.erase(Tc.begin() + ixDel);
             if (ixDel < Ji.size()) Ji.erase(Ji.begin() + ixDel);
             if (ixDel < Jw.size()) Jw.erase(Jw.begin() + ixDel);
+            if (ixDel < Ji4.size()) Ji4.erase(Ji4.begin() + ixDel);
+            if (ixDel < Jw4.size()) Jw4.erase(Jw4.begin() + ixDel);
 
             // decrease the indexes smaller than the deleted on
             for (SLuint i = 0; i < I16.size(); ++i)
@@ -290,7 +320,7 @@ Optionally you can draw the normals and/or the uniform grid voxels.
 2a) Activate a shader program if it is not yet in use and apply all its material parameters.<br>
 2b) Pass the modelview and modelview-projection matrix to the shader.<br>
 2c) If needed build and pass the inverse modelview and the normal matrix.<br>
-2d) If the mesh has a skeleton and HW skinning is applied pass the joint matrices.<br>
+2d) If the mesh has a skeleton and GPU skinning is applied bind the joint matrices.<br>
 3) Generate Vertex Array Object once<br>
 4) Finally do the draw call<br>
 5) Draw optional normals & tangents<br>
@@ -357,6 +387,17 @@ void SLMesh::draw(SLSceneView* sv, SLNode* node)
 
     // 2.b) Pass the matrices to the shader program
     SLGLProgram* sp = SLMaterial::current->program();
+
+    // With GPU skinning the skinned variant of the program is used instead
+    SLGLProgram* skinSP          = skinnedProgram();
+    SLbool       programSwitched = skinSP && skinSP != sp;
+    if (programSwitched)
+    {
+        sp->endShader();
+        skinSP->beginUse(SLMaterial::current);
+        sp = skinSP;
+    }
+
     sp->uniformMatrix4fv("u_mvMatrix", 1, (SLfloat*)&_stateGL->modelViewMatrix);
     sp->uniformMatrix4fv("u_mvpMatrix", 1, (const SLfloat*)_stateGL->mvpMatrix());
 
@@ -390,21 +431,51 @@ void SLMesh::draw(SLSceneView* sv, SLNode* node)
         sp->uniformMatrix4fv(locTM, 1, (SLfloat*)&_stateGL->textureMatrix);
     }
 
+    // 2.d) With GPU skinning bind the joint matrices of the skeleton. The
+    // uniform block of the program is bound once at link time.
+    if (skinSP)
+        _skeleton->bindJointBuffer(SL_JOINT_BLOCK_BINDING);
+
     ///////////////////////////////////////
     // 3) Generate Vertex Array Object once
     ///////////////////////////////////////
 
+    // The VAO gets rebuilt if the skinning switches between CPU and GPU
+    if (_vao.id() && _vaoIsGPUSkinned != (skinSP != nullptr))
+        _vao.clearAttribs();
+
     if (!_vao.id())
     {
-        _vao.setAttrib(AT_position, sp->getAttribLocation("a_position"), _finalP);
-        if (N.size()) _vao.setAttrib(AT_normal, sp->getAttribLocation("a_normal"), _finalN);
+        // With GPU skinning the VBO holds the unskinned vertices & the joints
+        _vaoIsGPUSkinned = skinSP != nullptr;
+        SLVVec3f* vboP   = _vaoIsGPUSkinned ? &P : _finalP;
+        SLVVec3f* vboN   = _vaoIsGPUSkinned ? &N : _finalN;
+        SLbool    isCPU  = Ji.size() && !_vaoIsGPUSkinned;
+
+        _vao.setAttrib(AT_position, sp->getAttribLocation("a_position"), vboP);
+        if (N.size()) _vao.setAttrib(AT_normal, sp->getAttribLocation("a_normal"), vboN);
         if (Tc.size()) _vao.setAttrib(AT_texCoord, sp->getAttribLocation("a_texCoord"), &Tc);
         if (C.size()) _vao.setAttrib(AT_color, sp->getAttribLocation("a_color"), &C);
         if (T.size()) _vao.setAttrib(AT_tangent, sp->getAttribLocation("a_tangent"), &T);
+        if (_vaoIsGPUSkinned)
+        {
+            if (Ji4.size() != P.size()) packJointInfluences();
+
+            // The float VBO gets the joint ids as floats
+            _jointIdsGL.resize(P.size());
+            for (SLuint i = 0; i < P.size(); ++i)
+                _jointIdsGL[i].set((SLfloat)(Ji4[i] & 0xff),
+                                   (SLfloat)((Ji4[i] >> 8) & 0xff),
+                                   (SLfloat)((Ji4[i] >> 16) & 0xff),
+                                   (SLfloat)(Ji4[i] >> 24));
+
+            _vao.setAttrib(AT_jointIndex, sp->getAttribLocation("a_jointIds"), &_jointIdsGL);
+            _vao.setAttrib(AT_jointWeight, sp->getAttribLocation("a_jointWeights"), &Jw4);
+        }
         if (I16.size()) _vao.setIndices(&I16);
         if (I32.size()) _vao.setIndices(&I32);
 
-        _vao.generate((SLuint)P.size(), Ji.size() ? BU_stream : BU_static, !Ji.size());
+        _vao.generate((SLuint)P.size(), isCPU ? BU_stream : BU_static, !isCPU);
     }
 
     ///////////////////////////////
@@ -416,6 +487,10 @@ void SLMesh::draw(SLSceneView* sv, SLNode* node)
     else
         _vao.drawElementsAs(primitiveType);
 
+    // The next mesh with the same material has to activate its program again
+    if (programSwitched)
+        SLMaterial::current = nullptr;
+
     //////////////////////////////////////
     // 5) Draw optional normals & tangents
     //////////////////////////////////////
@@ -578,13 +653,51 @@ SLbool SLMesh::hit(SLRay* ray, SLNode* node)
         SLbool wasHit = false;
 
         for (SLuint t = 0; t < numI(); t += 3)
+        {
             if (hitTriangleOS(ray, node, t) && !wasHit)
                 wasHit = true;
+            if (ray->isShaded())
+                return true;
+        }
 
         return wasHit;
     }
 }
 //-----------------------------------------------------------------------------
+/*!
+SLMesh::hitPacket intersects a packet of rays that is already transformed into
+the object space of the node. Acceleration structures without packet support
+and non triangle meshes fall back to the scalar hit for each ray.
+*/
+void SLMesh::hitPacket(SLRayPacket& packet, SLNode* node)
+{
+    if (_primitive == PT_triangles)
+    {
+        if (!_accelStruct)
+        {
+            for (SLuint t = 0; t < numI(); t += 3)
+                hitTrianglePacketOS(packet, node, t);
+            return;
+        }
+
+        if (_accelStruct->hasPacketSupport())
+        {
+            _accelStruct->intersectPacket(packet, node);
+            return;
+        }
+    }
+
+    // Scalar fallback for each active ray
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        SLRay* ray = packet.rays[i];
+        if (!ray) continue;
+        packet.toRayOS(i);
+        hit(ray, node);
+        packet.length[i] = ray->length;
+    }
+}
+//-----------------------------------------------------------------------------
 /*! 
 SLMesh::updateStats updates the parent node statistics.
 */
@@ -598,12 +711,17 @@ void SLMesh::addStats(SLNodeStats& stats)
     if (T.size()) stats.numBytes += SL_sizeOfVector(T);
     if (Ji.size()) stats.numBytes += SL_sizeOfVector(Ji);
     if (Jw.size()) stats.numBytes += SL_sizeOfVector(Jw);
+    if (Ji4.size()) stats.numBytes += SL_sizeOfVector(Ji4);
+    if (Jw4.size()) stats.numBytes += SL_sizeOfVector(Jw4);
 
     if (I16.size())
         stats.numBytes += (SLuint)(I16.size() * sizeof(SLushort));
     else
         stats.numBytes += (SLuint)(I32.size() * sizeof(SLuint));
 
+    if (_hitTriangles.size())
+        stats.numBytesAccel += SL_sizeOfVector(_hitTriangles);
+
     stats.numMeshes++;
     if (_primitive == PT_triangles) stats.numTriangles += numI() / 3;
     if (_primitive == PT_lines) stats.numLines += numI() / 2;
@@ -766,7 +884,10 @@ void SLMesh::buildAABB(SLAABBox& aabb, SLMat4f wmNode)
 }
 //-----------------------------------------------------------------------------
 /*! SLMesh::updateAccelStruct rebuilds the acceleration structure if the dirty
-flag is set. This can happen for mesh animations.
+flag is set. This can happen for mesh animations. With accelStructKeepSize a
+compact grid keeps its voxel resolution and only adapts the voxel size to the
+moved vertices. It is still rebuilt completely at the same cost (see
+SLCompactGrid::build).
 */
 void SLMesh::updateAccelStruct()
 {
@@ -785,13 +906,133 @@ void SLMesh::updateAccelStruct()
         return;
 
     if (_accelStruct == nullptr)
-        _accelStruct = new SLCompactGrid(this);
+    {
+        SLAccelStructType type = _accelStructType;
+        if (type == AST_auto)
+            type = autoAccelStructType();
+
+        if (type == AST_BVH)
+            _accelStruct = new SLBVH(this);
+        else
+            _accelStruct = new SLCompactGrid(this);
+    }
 
+    // Meshes with only a few triangles are intersected without structure
     if (_accelStruct && numI() > 15)
     {
+        SLCompactGrid* grid = dynamic_cast<SLCompactGrid*>(_accelStruct);
+        if (grid) grid->keepSize(_accelStructKeepSize);
+
         _accelStruct->build(minP, maxP);
-        _accelStructOutOfDate = false;
     }
+    _accelStructOutOfDate = false;
+
+    updateTriangleCache();
+}
+//-----------------------------------------------------------------------------
+/*! SLMesh::updateTriangleCache precomputes the corner A and the edges e1 & e2
+of all triangles for hitTriangleOS and hitTrianglePacketOS. They then don't
+have to fetch the three corners indirectly over the index and vertex arrays
+and recalculate the edges for every test. The cache is only built for meshes
+without a skeleton because skinned meshes change their vertices every frame.
+It is valid as long as the acceleration structure is up to date.
+*/
+void SLMesh::updateTriangleCache()
+{
+    if (!_doTriangleCache || _skeleton || _primitive != PT_triangles)
+    {
+        _hitTriangles.clear();
+        return;
+    }
+
+    SLuint numT = numI() / 3;
+    _hitTriangles.resize(numT);
+
+    for (SLuint t = 0; t < numT; ++t)
+    {
+        SLuint  iT = t * 3;
+        SLVec3f A  = finalP(I16.size() ? I16[iT] : I32[iT]);
+        SLVec3f B  = finalP(I16.size() ? I16[iT + 1] : I32[iT + 1]);
+        SLVec3f C  = finalP(I16.size() ? I16[iT + 2] : I32[iT + 2]);
+
+        SLHitTriangle& tri = _hitTriangles[t];
+        tri.v0[0]          = A.x;
+        tri.v0[1]          = A.y;
+        tri.v0[2]          = A.z;
+        tri.v0[3]          = 0.0f;
+        tri.e1[0]          = B.x - A.x;
+        tri.e1[1]          = B.y - A.y;
+        tri.e1[2]          = B.z - A.z;
+        tri.e1[3]          = 0.0f;
+        tri.e2[0]          = C.x - A.x;
+        tri.e2[1]          = C.y - A.y;
+        tri.e2[2]          = C.z - A.z;
+        tri.e2[3]          = 0.0f;
+    }
+}
+//-----------------------------------------------------------------------------
+//! Turns the triangle cache on or off. It gets (re)built with the accel. struct
+void SLMesh::doTriangleCache(SLbool doCache)
+{
+    if (doCache == _doTriangleCache)
+        return;
+
+    _doTriangleCache = doCache;
+    _hitTriangles.clear();
+    _accelStructOutOfDate = true;
+}
+//-----------------------------------------------------------------------------
+/*! SLMesh::autoAccelStructType chooses the acceleration structure by the
+variation of the triangle sizes. A uniform grid is fast if all triangles have
+about the same size. If their area varies a lot (e.g. small details on a large
+terrain) most voxels get empty and a few overfull. For such meshes with a
+coefficient of variation (standard deviation / mean) of the triangle areas
+above 1 a BVH is used.
+*/
+SLAccelStructType SLMesh::autoAccelStructType()
+{
+    SLuint numT = numI() / 3;
+    if (numT == 0)
+        return AST_compactGrid;
+
+    // Calculate mean and variance of the triangle areas in one pass
+    SLdouble sum = 0.0, sumSq = 0.0;
+    for (SLuint i = 0; i < numT * 3; i += 3)
+    {
+        SLVec3f v0 = finalP(I16.size() ? I16[i] : I32[i]);
+        SLVec3f v1 = finalP(I16.size() ? I16[i + 1] : I32[i + 1]);
+        SLVec3f v2 = finalP(I16.size() ? I16[i + 2] : I32[i + 2]);
+        SLdouble a = 0.5 * ((v1 - v0) ^ (v2 - v0)).length();
+        sum += a;
+        sumSq += a * a;
+    }
+
+    SLdouble mean = sum / numT;
+    if (mean <= 0.0)
+        return AST_compactGrid;
+
+    SLdouble variance = SL_max(sumSq / numT - mean * mean, 0.0);
+    SLdouble cv       = sqrt(variance) / mean;
+
+    return cv > 1.0 ? AST_BVH : AST_compactGrid;
+}
+//-----------------------------------------------------------------------------
+/*! Sets the type of the acceleration structure. An existing one gets deleted
+and is rebuilt with the new type at the next updateAccelStruct.
+*/
+void SLMesh::accelStructType(SLAccelStructType type)
+{
+    if (type == _accelStructType)
+        return;
+
+    _accelStructType = type;
+
+    if (_accelStruct)
+    {
+        delete _accelStruct;
+        _accelStruct = nullptr;
+    }
+    _accelStructOutOfDate = true;
 }
 //-----------------------------------------------------------------------------
 //! SLMesh::calcNormals recalculates vertex normals for triangle meshes.
@@ -987,7 +1228,7 @@ SLbool SLMesh::hitTriangleOS(SLRay* ray, SLNode* node, SLuint iT)
     assert(node && "node pointer is null");
     assert(_mat && "material pointer is null");
 
-    ++SLRay::tests;
+    ++SLRayStats::local().tests;
 
     if (_primitive != PT_triangles)
         return false;
@@ -996,27 +1237,11 @@ SLbool SLMesh::hitTriangleOS(SLRay* ray, SLNode* node, SLuint iT)
     if (ray->srcMesh == this && ray->srcTriangle == (SLint)iT)
         return false;
 
-    SLVec3f A, B, C; // corners
-    SLVec3f e1, e2;  // edge 1 and 2
+    SLVec3f A;      // corner
+    SLVec3f e1, e2; // edge 1 and 2
     SLVec3f AO, K, Q;
 
-    // get the corner vertices
-    if (I16.size())
-    {
-        A = finalP(I16[iT]);
-        B = finalP(I16[iT + 1]);
-        C = finalP(I16[iT + 2]);
-    }
-    else
-    {
-        A = finalP(I32[iT]);
-        B = finalP(I32[iT + 1]);
-        C = finalP(I32[iT + 2]);
-    }
-
-    // find vectors for two edges sharing the triangle vertex A
-    e1.sub(B, A);
-    e2.sub(C, A);
+    getTriangleOS(iT, A, e1, e2);
 
     // begin calculating determinant - also used to calculate U parameter
     K.cross(ray->dirOS, e2);
@@ -1096,12 +1321,92 @@ SLbool SLMesh::hitTriangleOS(SLRay* ray, SLNode* node, SLuint iT)
     ray->hitNode     = node;
     ray->hitMesh     = this;
 
-    ++SLRay::intersections;
+    ++SLRayStats::local().intersections;
 
     return true;
 }
 //-----------------------------------------------------------------------------
 /*!
+SLMesh::hitTrianglePacketOS is the packet version of hitTriangleOS. The
+Moeller-Trumbore test runs for all rays of the packet in one loop over the
+SoA arrays without early exits so that the compiler can vectorize it. Only
+for the rays that hit the triangle closer than before the hit information is
+written back to their SLRay. Packets contain only primary rays that start
+outside, so face culling applies to all of them for volume meshes.
+*/
+void SLMesh::hitTrianglePacketOS(SLRayPacket& packet, SLNode* node, SLuint iT)
+{
+    assert(node && "node pointer is null");
+
+    SLVec3f A;      // corner
+    SLVec3f e1, e2; // edge 1 and 2
+    getTriangleOS(iT, A, e1, e2);
+
+    const SLbool doCulling = _isVolume;
+
+    SLfloat t[SL_PACKET_SIZE], u[SL_PACKET_SIZE], v[SL_PACKET_SIZE];
+    SLint   isHit[SL_PACKET_SIZE];
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        // K = dir x e2
+        SLfloat Kx = packet.dyOS[i] * e2.z - packet.dzOS[i] * e2.y;
+        SLfloat Ky = packet.dzOS[i] * e2.x - packet.dxOS[i] * e2.z;
+        SLfloat Kz = packet.dxOS[i] * e2.y - packet.dyOS[i] * e2.x;
+
+        SLfloat det    = e1.x * Kx + e1.y * Ky + e1.z * Kz;
+        SLfloat invDet = 1.0f / det;
+
+        // distance from A to ray origin
+        SLfloat AOx = packet.oxOS[i] - A.x;
+        SLfloat AOy = packet.oyOS[i] - A.y;
+        SLfloat AOz = packet.ozOS[i] - A.z;
+
+        // Q = AO x e1
+        SLfloat Qx = AOy * e1.z - AOz * e1.y;
+        SLfloat Qy = AOz * e1.x - AOx * e1.z;
+        SLfloat Qz = AOx * e1.y - AOy * e1.x;
+
+        u[i] = (AOx * Kx + AOy * Ky + AOz * Kz) * invDet;
+        v[i] = (Qx * packet.dxOS[i] + Qy * packet.dyOS[i] + Qz * packet.dzOS[i]) * invDet;
+        t[i] = (e2.x * Qx + e2.y * Qy + e2.z * Qz) * invDet;
+
+        SLint detOK = doCulling ? det >= FLT_EPSILON
+                                : (det >= FLT_EPSILON || det <= -FLT_EPSILON);
+
+        isHit[i] = detOK &&
+                   u[i] >= 0.0f && v[i] >= 0.0f && u[i] + v[i] <= 1.0f &&
+                   t[i] >= 0.0f && t[i] <= packet.length[i];
+    }
+
+    // Write back the hits to the rays
+    SLRayStats& stats = SLRayStats::local();
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        SLRay* ray = packet.rays[i];
+        if (!ray) continue;
+
+        ++stats.tests;
+
+        if (!isHit[i]) continue;
+
+        // prevent self-intersection of triangle
+        if (ray->srcMesh == this && ray->srcTriangle == (SLint)iT)
+            continue;
+
+        packet.length[i] = t[i];
+        ray->length      = t[i];
+        ray->hitU        = u[i];
+        ray->hitV        = v[i];
+        ray->hitTriangle = (SLint)iT;
+        ray->hitNode     = node;
+        ray->hitMesh     = this;
+
+        ++stats.intersections;
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
 SLMesh::preShade calculates the rest of the intersection information 
 after the final hit point is determined. Should be called just before the 
 shading when the final intersection point of the closest triangle was found.
@@ -1135,7 +1440,7 @@ void SLMesh::preShade(SLRay* ray)
                        finalN(iC) * ray->hitV);
 
     // transform normal back to world space
-    ray->hitNormal.set(ray->hitNode->updateAndGetWMN() * ray->hitNormal);
+    ray->hitNormal.set(ray->hitNode->nodeWMN() * ray->hitNormal);
 
     // for shading the normal is expected to be unit length
     ray->hitNormal.normalize();
@@ -1147,7 +1452,25 @@ void SLMesh::preShade(SLRay* ray)
         SLVec2f Tu(Tc[iB] - Tc[iA]);
         SLVec2f Tv(Tc[iC] - Tc[iA]);
         SLVec2f tc(Tc[iA] + ray->hitU * Tu + ray->hitV * Tv);
-        ray->hitColor.set(textures[0]->getTexelf(tc.x, tc.y));
+
+        // width of the ray cone at the hit point in texture coords for the
+        // mip level selection: sqrt of texture area per world area of the
+        // triangle divided by the cosine of the incident angle
+        SLfloat footprint = 0.0f;
+        SLfloat coneWidth = ray->coneWidth + ray->coneAngle * ray->length;
+        if (coneWidth > 0.0f)
+        {
+            SLMat3f wm3(ray->hitNode->nodeWM().mat3());
+            SLVec3f eB(wm3 * (finalP(iB) - finalP(iA)));
+            SLVec3f eC(wm3 * (finalP(iC) - finalP(iA)));
+            SLfloat areaWS = (eB ^ eC).length();
+            SLfloat areaTC = SL_abs(Tu.x * Tv.y - Tu.y * Tv.x);
+            SLfloat cosN   = SL_max(SL_abs(ray->dir.dot(ray->hitNormal)), 0.05f);
+            if (areaWS > FLT_EPSILON)
+                footprint = coneWidth * sqrt(areaTC / areaWS) / cosN;
+        }
+
+        ray->hitColor.set(textures[0]->getTexelf(tc.x, tc.y, 0, footprint));
 
         // bump mapping
         if (textures.size() > 1)
@@ -1160,7 +1483,7 @@ void SLMesh::preShade(SLRay* ray)
                              T[iC] * ray->hitV);
 
                 SLVec3f T3(hitT.x, hitT.y, hitT.z);           // tangent with 3 components
-                T3.set(ray->hitNode->updateAndGetWMN() * T3); // transform tangent back to world space
+                T3.set(ray->hitNode->nodeWMN() * T3);         // transform tangent back to world space
                 SLVec2f d = textures[1]->dsdt(tc.x, tc.y);    // slope of bumpmap at tc
                 SLVec3f N = ray->hitNormal;                   // unperturbated normal
                 SLVec3f B(N ^ T3);                            // binormal tangent B
@@ -1188,9 +1511,12 @@ void SLMesh::preShade(SLRay* ray)
 //! Transforms the vertex positions and normals with by joint weights
 /*! If the mesh is used for skinned skeleton animation this method transforms
 each vertex and normal by max. four joints of the skeleton. Each joint has
-a weight and an index. After the transform the VBO have to be updated.
-This skinning process can also be done (a lot faster) on the GPU.
-This software skinning is also needed for ray or path tracing.  
+a weight and an index. This skinning process can also be done (a lot faster)
+on the GPU. This software skinning is also needed for ray or path tracing.
+\n The vertices are skinned in batches of SL_SKIN_BATCH vertices on the
+threads of the update pool (see SLRenderPool::update and skinRange). If the mesh has a VBO it gets
+mapped, so that the workers write the skinned vertices directly into it
+instead of copying the whole buffers with glBufferSubData afterwards.
 */
 void SLMesh::transformSkin()
 {
@@ -1208,6 +1534,10 @@ void SLMesh::transformSkin()
             skinnedN[i] = N[i];
     }
 
+    // pack the joint influences into 4 per vertex once
+    if (Ji4.size() != P.size())
+        packJointInfluences();
+
     // Create array for joint matrices once
     if (!_jointMatrices.size())
     {
@@ -1226,46 +1556,294 @@ void SLMesh::transformSkin()
 
     // flag acceleration structure to be rebuilt
     _accelStructOutOfDate = true;
+    _cpuSkinIsOutdated    = false;
+
+    // A VBO for the GPU skinning keeps the unskinned vertices
+    SLbool updateVBO = _vao.id() && !_vaoIsGPUSkinned;
+
+    // map the VBO parts of the positions and normals for direct writing
+    vector<SLfloat*> vbo;
+    SLbool           isMapped = false;
+    if (updateVBO)
+    {
+        vector<SLGLAttributeType> types = {AT_position};
+        if (N.size()) types.push_back(AT_normal);
+        isMapped = _vao.mapAttribs(types, vbo);
+    }
+    SLfloat* vboP = isMapped ? vbo[0] : nullptr;
+    SLfloat* vboN = isMapped && N.size() ? vbo[1] : nullptr;
+
+    // skin small meshes directly and large ones in batches on all threads
+    SLuint numV = (SLuint)P.size();
+    if (numV < 2 * SL_SKIN_BATCH)
+        skinRange(0, numV, vboP, vboN);
+    else
+    {
+        SLuint numBatches = (numV + SL_SKIN_BATCH - 1) / SL_SKIN_BATCH;
+        SLRenderPool::update().run(numBatches,
+                                   [&](SLuint task, SLuint worker) {
+                                       SLuint first = task * SL_SKIN_BATCH;
+                                       SLuint last  = SL_min(first + SL_SKIN_BATCH, numV);
+                                       skinRange(first, last, vboP, vboN);
+                                   });
+    }
+
+    // update or create buffers
+    if (isMapped)
+        _vao.unmapAttribs();
+    else if (updateVBO)
+    {
+        _vao.updateAttrib(AT_position, _finalP);
+        if (N.size()) _vao.updateAttrib(AT_normal, _finalN);
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Updates the skin of the mesh after its skeleton has changed and returns
+true if it has changed. With GPU skinning (see skinnedProgram) the vertices
+are transformed in the vertex shader and only the AABBs of the parent nodes
+get updated. So the upload per frame is only the joint matrices of the
+skeleton instead of all vertex positions and normals. The CPU skinning with
+transformSkin is then only done if the ray tracer needs the skinned vertices
+(needsCPUSkin) or if the GPU skinning is not possible.
+*/
+SLbool SLMesh::updateSkin(SLbool needsCPUSkin)
+{
+    if (!_skeleton)
+        return false;
+
+    SLbool changed = _skeleton->changed();
+    if (changed)
+        _cpuSkinIsOutdated = true;
+
+    if (!_cpuSkinIsOutdated)
+        return false;
+
+    if (needsCPUSkin || !skinnedProgram())
+    {
+        transformSkin();
+        return true;
+    }
+
+    if (changed)
+        notifyParentNodesAABBUpdate();
+
+    return changed;
+}
+//-----------------------------------------------------------------------------
+/*! Returns the shader program that is used for the GPU skinning of the mesh
+or nullptr if the mesh gets skinned on the CPU. The GPU skinning needs a
+skeleton, the global flag SLScene::doGPUSkinning and uniform buffers of
+OpenGL 3.1 or OpenGL ES 3.0. Only the Blinn-Phong programs have a skinned
+variant. Meshes with other materials are skinned on the CPU.
+*/
+SLGLProgram* SLMesh::skinnedProgram()
+{
+    SLScene* s = SLApplication::scene;
+    if (!_skeleton || !Ji.size() || !_mat || !s->doGPUSkinning())
+        return nullptr;
+
+    if (!_stateGL->glIsES3() && _stateGL->glVersionNOf() < 3.1f)
+        return nullptr;
+
+    // Materials without a program get a default program in SLMaterial::activate
+    SLGLProgram* sp = _mat->program();
+    if (!sp)
+        sp = s->programs(_mat->textures().size() ? SP_perVrtBlinnTex : SP_perVrtBlinn);
+
+    if (sp == s->programs(SP_perVrtBlinn)) return s->programs(SP_perVrtBlinnSkinned);
+    if (sp == s->programs(SP_perVrtBlinnTex)) return s->programs(SP_perVrtBlinnTexSkinned);
+    if (sp == s->programs(SP_perPixBlinn)) return s->programs(SP_perPixBlinnSkinned);
+    if (sp == s->programs(SP_perPixBlinnTex)) return s->programs(SP_perPixBlinnTexSkinned);
+
+    if (sp == s->programs(SP_perVrtBlinnSkinned) ||
+        sp == s->programs(SP_perVrtBlinnTexSkinned) ||
+        sp == s->programs(SP_perPixBlinnSkinned) ||
+        sp == s->programs(SP_perPixBlinnTexSkinned))
+        return sp;
+
+    return nullptr;
+}
+//-----------------------------------------------------------------------------
+/*! Packs the joint ids and weights of Ji and Jw into the fixed format Ji4 and
+Jw4 with four joints per vertex. Unused joints get the weight zero. If a vertex
+has more than four joints only the four with the largest weights are kept and
+their weights are normalized again.
+*/
+void SLMesh::packJointInfluences()
+{
+    Ji4.resize(P.size());
+    Jw4.resize(P.size());
 
-    // iterate over all vertices and write to new buffers
     for (SLuint i = 0; i < P.size(); ++i)
     {
-        skinnedP[i] = SLVec3f::ZERO;
-        if (N.size()) skinnedN[i] = SLVec3f::ZERO;
+        SLuchar ids[4] = {0, 0, 0, 0};
+        SLfloat w[4]   = {0, 0, 0, 0};
+        SLuint  numJ   = i < Ji.size() ? (SLuint)Ji[i].size() : 0;
 
-        // accumulate final normal and positions
-        for (SLuint j = 0; j < Ji[i].size(); ++j)
+        // insert the weights sorted in descending order
+        for (SLuint j = 0; j < numJ; ++j)
         {
-            const SLMat4f& jm      = _jointMatrices[Ji[i][j]];
-            SLVec4f        tempPos = jm * P[i];
-            skinnedP[i].x += tempPos.x * Jw[i][j];
-            skinnedP[i].y += tempPos.y * Jw[i][j];
-            skinnedP[i].z += tempPos.z * Jw[i][j];
+            SLfloat wj = Jw[i][j];
+            if (wj <= w[3]) continue;
 
-            if (N.size())
+            SLint k = 3;
+            for (; k > 0 && w[k - 1] < wj; --k)
             {
-                // Build the 3x3 submatrix in GLSL 110 (= mat3 jt3 = mat3(jt))
-                // for the normal transform that is the normally the inverse transpose.
-                // The inverse transpose can be ignored as long as we only have
-                // rotation and uniform scaling in the 3x3 submatrix.
-                SLMat3f jnm = jm.mat3();
-                skinnedN[i] += jnm * N[i] * Jw[i][j];
+                w[k]   = w[k - 1];
+                ids[k] = ids[k - 1];
             }
+            w[k]   = wj;
+            ids[k] = Ji[i][j];
         }
+
+        if (numJ > 4)
+        {
+            SLfloat sum = w[0] + w[1] + w[2] + w[3];
+            if (sum > 0.0f)
+                for (SLint k = 0; k < 4; ++k)
+                    w[k] /= sum;
+        }
+
+        Ji4[i] = (SLuint)ids[0] |
+                 (SLuint)ids[1] << 8 |
+                 (SLuint)ids[2] << 16 |
+                 (SLuint)ids[3] << 24;
+        Jw4[i].set(w[0], w[1], w[2], w[3]);
     }
+}
+//-----------------------------------------------------------------------------
+/*! Skins the vertices in the index range [first, last) into skinnedP and
+skinnedN and into the mapped VBO parts vboP and vboN if they are not null.
+The four joint matrices of a vertex are blended with its weights once into
+one matrix that transforms the position and the normal. The blending is done
+column by column with SSE2 or NEON if available. The 3x3 submatrix of the
+blended matrix transforms the normal. The inverse transpose can be ignored as
+long as we only have rotation and uniform scaling in the joint matrices.
+*/
+void SLMesh::skinRange(SLuint first, SLuint last, SLfloat* vboP, SLfloat* vboN)
+{
+    const SLMat4f* jm   = _jointMatrices.data();
+    const SLbool   hasN = N.size() > 0;
 
-    // update or create buffers
-    if (_vao.id())
+    for (SLuint i = first; i < last; ++i)
     {
-        _vao.updateAttrib(AT_position, _finalP);
-        if (N.size()) _vao.updateAttrib(AT_normal, _finalN);
+        const SLuint   ids = Ji4[i];
+        const SLfloat* w   = &Jw4[i].x;
+        const SLfloat* m0  = jm[ids & 0xff].m();
+        const SLfloat* m1  = jm[(ids >> 8) & 0xff].m();
+        const SLfloat* m2  = jm[(ids >> 16) & 0xff].m();
+        const SLfloat* m3  = jm[ids >> 24].m();
+        SLfloat        p[4], n[4];
+
+#if defined(SL_SKIN_SSE2)
+        __m128 w0 = _mm_set1_ps(w[0]);
+        __m128 w1 = _mm_set1_ps(w[1]);
+        __m128 w2 = _mm_set1_ps(w[2]);
+        __m128 w3 = _mm_set1_ps(w[3]);
+        __m128 c[4];
+        for (SLint k = 0; k < 4; ++k)
+        {
+            __m128 col = _mm_mul_ps(w0, _mm_loadu_ps(m0 + 4 * k));
+            col        = _mm_add_ps(col, _mm_mul_ps(w1, _mm_loadu_ps(m1 + 4 * k)));
+            col        = _mm_add_ps(col, _mm_mul_ps(w2, _mm_loadu_ps(m2 + 4 * k)));
+            c[k]       = _mm_add_ps(col, _mm_mul_ps(w3, _mm_loadu_ps(m3 + 4 * k)));
+        }
+
+        __m128 vp = _mm_add_ps(c[3], _mm_mul_ps(c[0], _mm_set1_ps(P[i].x)));
+        vp        = _mm_add_ps(vp, _mm_mul_ps(c[1], _mm_set1_ps(P[i].y)));
+        vp        = _mm_add_ps(vp, _mm_mul_ps(c[2], _mm_set1_ps(P[i].z)));
+        _mm_storeu_ps(p, vp);
+
+        if (hasN)
+        {
+            __m128 vn = _mm_mul_ps(c[0], _mm_set1_ps(N[i].x));
+            vn        = _mm_add_ps(vn, _mm_mul_ps(c[1], _mm_set1_ps(N[i].y)));
+            vn        = _mm_add_ps(vn, _mm_mul_ps(c[2], _mm_set1_ps(N[i].z)));
+            _mm_storeu_ps(n, vn);
+        }
+#elif defined(SL_SKIN_NEON)
+        float32x4_t c[4];
+        for (SLint k = 0; k < 4; ++k)
+        {
+            float32x4_t col = vmulq_n_f32(vld1q_f32(m0 + 4 * k), w[0]);
+            col             = vmlaq_n_f32(col, vld1q_f32(m1 + 4 * k), w[1]);
+            col             = vmlaq_n_f32(col, vld1q_f32(m2 + 4 * k), w[2]);
+            c[k]            = vmlaq_n_f32(col, vld1q_f32(m3 + 4 * k), w[3]);
+        }
+
+        float32x4_t vp = vmlaq_n_f32(c[3], c[0], P[i].x);
+        vp             = vmlaq_n_f32(vp, c[1], P[i].y);
+        vp             = vmlaq_n_f32(vp, c[2], P[i].z);
+        vst1q_f32(p, vp);
+
+        if (hasN)
+        {
+            float32x4_t vn = vmulq_n_f32(c[0], N[i].x);
+            vn             = vmlaq_n_f32(vn, c[1], N[i].y);
+            vn             = vmlaq_n_f32(vn, c[2], N[i].z);
+            vst1q_f32(n, vn);
+        }
+#else
+        SLfloat c[16];
+        for (SLint k = 0; k < 16; ++k)
+            c[k] = w[0] * m0[k] + w[1] * m1[k] + w[2] * m2[k] + w[3] * m3[k];
+
+        for (SLint k = 0; k < 3; ++k)
+        {
+            p[k] = c[k] * P[i].x + c[4 + k] * P[i].y + c[8 + k] * P[i].z + c[12 + k];
+            if (hasN)
+                n[k] = c[k] * N[i].x + c[4 + k] * N[i].y + c[8 + k] * N[i].z;
+        }
+#endif
+
+        skinnedP[i].set(p[0], p[1], p[2]);
+        if (vboP)
+        {
+            vboP[3 * i]     = p[0];
+            vboP[3 * i + 1] = p[1];
+            vboP[3 * i + 2] = p[2];
+        }
+
+        if (hasN)
+        {
+            skinnedN[i].set(n[0], n[1], n[2]);
+            if (vboN)
+            {
+                vboN[3 * i]     = n[0];
+                vboN[3 * i + 1] = n[1];
+                vboN[3 * i + 2] = n[2];
+            }
+        }
     }
 }
 //-----------------------------------------------------------------------------
+/*!
+Adds a node to the nodes that hold this mesh. It is called by SLNode::addMesh
+and SLNode::insertMesh. The nodes are kept in a hash set, so that adding and
+removing stays constant in time even for thousands of instances of a mesh.
+*/
+void SLMesh::addNode(SLNode* node)
+{
+    assert(node);
+    _nodes.insert(node);
+}
+//-----------------------------------------------------------------------------
+/*!
+Removes a node from the nodes that hold this mesh. It is called when the node
+removes the mesh or gets deleted.
+*/
+void SLMesh::removeNode(SLNode* node)
+{
+    _nodes.erase(node);
+}
+//-----------------------------------------------------------------------------
+/*!
+Flags the AABBs of all nodes that hold this mesh for an update. The nodes are
+known by their back references, so no search in the scene graph is needed.
+*/
 void SLMesh::notifyParentNodesAABBUpdate() const
 {
-    SLVNode nodes = SLApplication::scene->root3D()->findChildren(this);
-    for (auto node : nodes)
+    for (auto node : _nodes)
         node->needAABBUpdate();
 }
 //-----------------------------------------------------------------------------
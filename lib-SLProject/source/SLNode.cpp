@@ -15,12 +15,14 @@
 #endif
 
 #include <SLAnimation.h>
+#include <SLApplication.h>
 #include <SLCVTracked.h>
 #include <SLLightDirect.h>
 #include <SLLightRect.h>
 #include <SLLightSpot.h>
 #include <SLNode.h>
 #include <SLSceneView.h>
+#include <SLTransformStore.h>
 
 //-----------------------------------------------------------------------------
 // Static update counter
@@ -43,6 +45,8 @@ SLNode::SLNode(SLstring name) : SLObject(name)
     _isWMUpToDate   = false;
     _isAABBUpToDate = false;
     _tracker        = nullptr;
+    _store          = nullptr;
+    _storeIndex     = -1;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -62,6 +66,8 @@ SLNode::SLNode(SLMesh* mesh, SLstring name) : SLObject(name)
     _isWMUpToDate   = false;
     _isAABBUpToDate = false;
     _tracker        = nullptr;
+    _store          = nullptr;
+    _storeIndex     = -1;
 
     addMesh(mesh);
 }
@@ -76,6 +82,12 @@ SLNode::~SLNode()
 {
     //SL_LOG("~SLNode: %s\n", name().c_str());
 
+    if (_store)
+        _store->removeNode(_storeIndex);
+
+    for (auto mesh : _meshes)
+        mesh->removeNode(this);
+
     for (auto child : _children)
         delete child;
     _children.clear();
@@ -100,7 +112,9 @@ void SLNode::addMesh(SLMesh* mesh)
         _name = mesh->name() + "-Node";
 
     _meshes.push_back(mesh);
+    mesh->addNode(this);
     mesh->init(this);
+    needBVHRebuild();
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -116,7 +130,9 @@ bool SLNode::insertMesh(SLMesh* insertM, SLMesh* afterM)
     if (found != _meshes.end())
     {
         _meshes.insert(found, insertM);
+        insertM->addNode(this);
         insertM->init(this);
+        needBVHRebuild();
 
         // Take over mesh name if node name is default name
         if (_name == "Node" && insertM->name() != "Mesh")
@@ -128,13 +144,26 @@ bool SLNode::insertMesh(SLMesh* insertM, SLMesh* afterM)
 }
 //-----------------------------------------------------------------------------
 /*! 
+Removes all meshes.
+*/
+void SLNode::removeMeshes()
+{
+    for (auto mesh : _meshes)
+        mesh->removeNode(this);
+    _meshes.clear();
+    needBVHRebuild();
+}
+//-----------------------------------------------------------------------------
+/*! 
 Removes the last mesh.
 */
 bool SLNode::removeMesh()
 {
     if (_meshes.size() > 0)
     {
+        _meshes.back()->removeNode(this);
         _meshes.pop_back();
+        needBVHRebuild();
         return true;
     }
     return false;
@@ -150,7 +179,9 @@ bool SLNode::removeMesh(SLMesh* mesh)
     {
         if (_meshes[i] == mesh)
         {
+            mesh->removeNode(this);
             _meshes.erase(_meshes.begin() + i);
+            needBVHRebuild();
             return true;
         }
     }
@@ -282,6 +313,7 @@ void SLNode::addChild(SLNode* child)
     _children.push_back(child);
     _isAABBUpToDate = false;
     child->parent(this);
+    needBVHRebuild();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -299,6 +331,7 @@ bool SLNode::insertChild(SLNode* insertC, SLNode* afterC)
         _children.insert(found, insertC);
         insertC->parent(this);
         _isAABBUpToDate = false;
+        needBVHRebuild();
         return true;
     }
     return false;
@@ -312,6 +345,7 @@ void SLNode::deleteChildren()
     for (SLuint i = 0; i < _children.size(); ++i)
         delete _children[i];
     _children.clear();
+    needBVHRebuild();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -324,6 +358,7 @@ bool SLNode::deleteChild()
         delete _children.back();
         _children.pop_back();
         _isAABBUpToDate = false;
+        needBVHRebuild();
         return true;
     }
     return false;
@@ -342,6 +377,7 @@ bool SLNode::deleteChild(SLNode* child)
             _children.erase(_children.begin() + i);
             delete child;
             _isAABBUpToDate = false;
+            needBVHRebuild();
             return true;
         }
     }
@@ -544,8 +580,13 @@ void SLNode::statsRec(SLNodeStats& stats)
     if (typeid(*this) == typeid(SLLightRect)) stats.numLights++;
     if (typeid(*this) == typeid(SLLightDirect)) stats.numLights++;
 
+    // Shared meshes are counted only at their first reference
     for (auto mesh : _meshes)
-        mesh->addStats(stats);
+    {
+        stats.numInstances++;
+        if (stats.countedMeshes.insert(mesh).second)
+            mesh->addStats(stats);
+    }
     for (auto child : _children)
         child->statsRec(stats);
 }
@@ -572,31 +613,44 @@ bool SLNode::hitRec(SLRay* ray)
     if (!_aabb.isHitInWS(ray))
         return false;
 
-    SLbool meshWasHit = false;
+    SLbool meshWasHit = hitMeshes(ray);
+    if (ray->isShaded())
+        return true;
 
-    // Transform ray to object space for non-groups
-    if (_meshes.size() > 0)
+    // Test children nodes
+    for (auto child : _children)
     {
-        // transform origin position to object space
-        ray->originOS.set(updateAndGetWMI().multVec(ray->origin));
+        if (child->hitRec(ray) && !meshWasHit)
+            meshWasHit = true;
+        if (ray->isShaded())
+            return true;
+    }
 
-        // transform the direction only with the linear sub matrix
-        ray->setDirOS(_wmI.mat3() * ray->dir);
+    return meshWasHit;
+}
+//-----------------------------------------------------------------------------
+/*!
+Intersects only the nodes own meshes with the given ray without testing the
+AABB and the children. The ray is transformed into the object space of the
+node. This is used by SLSceneBVH for its leaf nodes and by hitRec.
+*/
+bool SLNode::hitMeshes(SLRay* ray)
+{
+    if (_meshes.size() == 0)
+        return false;
 
-        // test all meshes
-        for (auto mesh : _meshes)
-        {
-            if (mesh->hit(ray, this) && !meshWasHit)
-                meshWasHit = true;
-            if (ray->isShaded())
-                return true;
-        }
-    }
+    SLbool meshWasHit = false;
 
-    // Test children nodes
-    for (auto child : _children)
+    // transform origin position to object space
+    ray->originOS.set(updateAndGetWMI().multVec(ray->origin));
+
+    // transform the direction only with the linear sub matrix
+    ray->setDirOS(updateAndGetWMI().mat3() * ray->dir);
+
+    // test all meshes
+    for (auto mesh : _meshes)
     {
-        if (child->hitRec(ray) && !meshWasHit)
+        if (mesh->hit(ray, this) && !meshWasHit)
             meshWasHit = true;
         if (ray->isShaded())
             return true;
@@ -657,6 +711,8 @@ void SLNode::needUpdate()
         return;
 
     _isWMUpToDate = false;
+    if (_store)
+        _store->markDirty(_storeIndex);
 
     // mark the WM of the children dirty since their parent just changed
     for (auto child : _children)
@@ -681,6 +737,8 @@ void SLNode::needWMUpdate()
         return;
 
     _isWMUpToDate = false;
+    if (_store)
+        _store->markDirty(_storeIndex);
 
     // mark the WM of the children dirty since their parent just changed
     for (auto child : _children)
@@ -705,11 +763,29 @@ void SLNode::needAABBUpdate()
     // merge the child AABBs
     if (_parent)
         _parent->needAABBUpdate();
+    else if (SLApplication::scene && this == SLApplication::scene->root3D())
+        SLApplication::scene->sceneBVH().needRefit();
+}
+//-----------------------------------------------------------------------------
+/*!
+Flags the scene BVH and the transform store for a rebuild after the structure
+of the scene graph changed. Nodes that are not yet in the scene graph can't be
+distinguished cheaply, so any structural change triggers a rebuild at the next
+ray tracing or scene update.
+*/
+void SLNode::needBVHRebuild()
+{
+    if (SLApplication::scene)
+    {
+        SLApplication::scene->sceneBVH().needRebuild();
+        SLApplication::scene->transformStore().needRebuild();
+    }
 }
 //-----------------------------------------------------------------------------
 /*!
 A helper function that updates the current _wm to reflect the local matrix. 
-recursively calls the updateAndGetWM of the node's parent.
+recursively calls the updateAndGetWM of the node's parent. A node in the
+transform store gets updated in the store.
 
 @note
 This function is const because it has to be called from inside the updateAndGetWM
@@ -718,17 +794,23 @@ class it is ok.
 */
 void SLNode::updateWM() const
 {
+    numWMUpdates++;
+
+    if (_store)
+    {
+        _store->updateNode(_storeIndex);
+        return;
+    }
+
     if (_parent)
         _wm.setMatrix(_parent->updateAndGetWM() * _om);
     else
         _wm.setMatrix(_om);
 
-    _wmI.setMatrix(_wm);
-    _wmI.invert();
+    _wmI.setMatrix(_wm.invertedAffine());
     _wmN.setMatrix(_wm.mat3());
 
     _isWMUpToDate = true;
-    numWMUpdates++;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -741,7 +823,7 @@ SLNode::updateAndGetWM() const
     if (!_isWMUpToDate)
         updateWM();
 
-    return _wm;
+    return _store ? _store->wm(_storeIndex) : _wm;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -754,7 +836,7 @@ SLNode::updateAndGetWMI() const
     if (!_isWMUpToDate)
         updateWM();
 
-    return _wmI;
+    return _store ? _store->wmI(_storeIndex) : _wmI;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -767,7 +849,29 @@ SLNode::updateAndGetWMN() const
     if (!_isWMUpToDate)
         updateWM();
 
-    return _wmN;
+    return _store ? _store->wmN(_storeIndex) : _wmN;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the world matrix without updating it. It is used by the render threads
+of the ray tracers that must not write to the node or to the transform store.
+The matrices are updated before by SLScene::updateTransforms.
+*/
+const SLMat4f&
+SLNode::nodeWM() const
+{
+    assert(_isWMUpToDate && "SLNode::nodeWM: World matrix is out of date");
+    return _store ? _store->wm(_storeIndex) : _wm;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the world normal matrix without updating it (see SLNode::nodeWM).
+*/
+const SLMat3f&
+SLNode::nodeWMN() const
+{
+    assert(_isWMUpToDate && "SLNode::nodeWMN: World matrix is out of date");
+    return _store ? _store->wmN(_storeIndex) : _wmN;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -1016,7 +1120,7 @@ void SLNode::rotate(const SLQuat4f& rot, SLTransformSpace relativeTo)
         rot.multiply(rotation);
         rot.translate(-updateAndGetWM().translation());
 
-        _om = _parent->_wm.inverted() * rot * updateAndGetWM();
+        _om = _parent->updateAndGetWMI() * rot * updateAndGetWM();
     }
     else // relativeTo == TS_Parent || relativeTo == TS_World && !_parent
     {
@@ -15,7 +15,6 @@
 
 #include <algorithm>
 
-using namespace std::placeholders;
 using namespace std::chrono;
 
 #include <SLApplication.h>
@@ -23,18 +22,21 @@ using namespace std::chrono;
 #include <SLLightRect.h>
 #include <SLLightSpot.h>
 #include <SLPathtracer.h>
+#include <SLSampler.h>
 #include <SLSceneView.h>
 #include <SLText.h>
 #include <SLVolume.h>
 
-extern SLfloat rnd01();
-
 //-----------------------------------------------------------------------------
 SLPathtracer::SLPathtracer()
 {
     name("PathTracer");
-    _calcDirect   = true;
-    _calcIndirect = true;
+    _calcDirect        = true;
+    _calcIndirect      = true;
+    _exposure          = 1.0f;
+    _doToneMapping     = false;
+    _doRussianRoulette = true;
+    _doDenoise         = false;
     gamma(2.2f);
 }
 
@@ -51,40 +53,36 @@ SLPathtracer::render(SLSceneView* sv)
     _renderSec  = 0.0f;                     // reset time
     _pcRendered = 0;                        // % rendered
 
+    initStats(_maxDepth); // init statistics
     prepareImage();
 
-    // Set second image for render update to the same size
-    while (_images.size() > 1)
-    {
-        delete _images[_images.size() - 1];
-        _images.pop_back();
-    }
-    _images.push_back(new SLCVImage(_sv->scrW(), _sv->scrH(), PF_rgb, "Pathtracer"));
+    // Reset the HDR accumulation buffer
+    SLuint numPixels = _images[0]->width() * _images[0]->height();
+    _accumSum.assign(numPixels, SLCol4f(0, 0, 0, 0));
+    _accumNum.assign(numPixels, 0);
+    _denoiser.resize((SLint)_images[0]->width(), (SLint)_images[0]->height());
 
     // Measure time
     double t1 = SLApplication::scene->timeSec();
+    _tUpdate  = t1;
 
-    // Bind the renderSlices method to a function object
-    auto renderSlicesFunction = bind(&SLPathtracer::renderSlices, this, _1, _2);
+    SLRenderPool::hilbertTiles((SLint)_images[0]->width(),
+                               (SLint)_images[0]->height(),
+                               SL_RENDER_TILE_SIZE,
+                               _tiles);
 
-    // Do multi-threading only in release config
     SL_LOG("\n\nRendering with %d samples", _aaSamples);
     SL_LOG("\nCurrent Sample:       ");
     for (int currentSample = 1; currentSample <= _aaSamples; currentSample++)
     {
         SL_LOG("\b\b\b\b\b\b%6d", currentSample);
-        vector<thread> threads; // vector for additional threads
-        _next = 0;              // init _next=0. _next should be atomic
 
-        // Start additional threads on the renderSlices function
-        for (SLuint t = 0; t < SL::maxThreads() - 1; t++)
-            threads.push_back(thread(renderSlicesFunction, false, currentSample));
-
-        // Do the same work in the main thread
-        renderSlicesFunction(true, currentSample);
-
-        for (auto& thread : threads)
-            thread.join();
+        // Render all tiles with the persistent threads of the render pool
+        _pool.run((SLuint)_tiles.size(),
+                  [this, currentSample](SLuint task, SLuint worker) {
+                      renderTile(_tiles[task], worker, currentSample);
+                  },
+                  _numThreads);
 
         _pcRendered = (SLint)((SLfloat)currentSample / (SLfloat)_aaSamples * 100.0f);
     }
@@ -93,87 +91,92 @@ SLPathtracer::render(SLSceneView* sv)
 
     SL_LOG("\nTime to render image: %6.3fsec", _renderSec);
 
+    if (_doDenoise)
+    {
+        denoise();
+        SL_LOG("\nTime to denoise:      %6.3fsec", _denoiser.denoiseSec());
+    }
+
+    _stats = SLRayStats::merged(); // all render tasks are finished here
     _state = rtFinished;
     return true;
 }
 //-----------------------------------------------------------------------------
 /*!
-Renders a slice of 4px width.
+Renders one sample for all pixels of a tile. This method is called by the
+workers of the render pool. Only the main thread (worker 0) updates the window.
 */
-void SLPathtracer::renderSlices(const bool isMainThread, SLint currentSample)
+void SLPathtracer::renderTile(const SLRenderTile& tile,
+                              SLuint              worker,
+                              SLint               currentSample)
 {
-    // Time points
-    double        t1           = 0;
+    SLSampler& sampler = SLSampler::local();
 
-    while (_next < (SLint)_images[0]->width())
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
     {
-        const SLint minX = _next;
-
-        // The next line should be theoretically atomic
-        _next += 4;
-
-        for (SLint x = minX; x < minX + 4; ++x)
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
         {
-            for (SLuint y = 0; y < _images[0]->height(); ++y)
-            {
-                SLCol4f color(SLCol4f::BLACK);
-
-                // calculate direction for primary ray - scatter with random variables for anti aliasing
-                SLRay primaryRay;
-                setPrimaryRay((SLfloat)(x - rnd01() + 0.5f),
-                              (SLfloat)(y - rnd01() + 0.5f),
-                              &primaryRay);
-
-                ///////////////////////////////
-                color += trace(&primaryRay, 0);
-                ///////////////////////////////
-
-                // weight old and new color for continuous rendering
-                SLCol4f oldColor;
-                if (currentSample > 1)
-                {
-                    oldColor = _images[1]->getPixeli(x, (SLint)y);
-
-                    // weight old color ( examp. 3/4, 4/5, 5/6 )
-                    oldColor /= (SLfloat)currentSample;
-                    oldColor *= (SLfloat)(currentSample - 1);
-
-                    // weight new color ( examp. 1/4, 1/5, 1/6 )
-                    color /= (SLfloat)currentSample;
-
-                    // bring them together ( examp. 4/4, 5/5, 6/6)
-                    color += oldColor;
-                }
-
-                color.clampMinMax(0.0f, 1.0f);
-
-                // save image without gamma
-                _images[1]->setPixeliRGB(x, (SLint)y, color);
-
-                color.gammaCorrect(_oneOverGamma);
+            SLCol4f color(SLCol4f::BLACK);
+
+            // all sample values of the path depend only on pixel & sample
+            sampler.startPixel(x, y, (SLuint)currentSample - 1);
+
+            // calculate direction for primary ray - scatter with random variables for anti aliasing
+            SLVec2f aa = sampler.get2D();
+            SLRay   primaryRay;
+            setPrimaryRay((SLfloat)(x - aa.x + 0.5f),
+                          (SLfloat)(y - aa.y + 0.5f),
+                          &primaryRay);
+
+            ///////////////////////////////
+            color += trace(&primaryRay, 0.0f);
+            ///////////////////////////////
+
+            // accumulate the unclamped color in the HDR buffer
+            SLuint i = (SLuint)(y * (SLint)_images[0]->width() + x);
+            _accumSum[i] += color;
+            _accumNum[i]++;
+
+            // features of the first hit that guide the denoiser
+            if (primaryRay.length < FLT_MAX)
+                _denoiser.addSample(i,
+                                    color,
+                                    hitAlbedo(&primaryRay),
+                                    primaryRay.hitNormal,
+                                    primaryRay.length);
+            else
+                _denoiser.addSample(i, color, SLCol4f::WHITE, SLVec3f::ZERO, 0.0f);
 
-                // image to render
-                _images[0]->setPixeliRGB(x, (SLint)y, color);
-            }
+            // image to render with the tone mapped mean
+            _images[0]->setPixeliRGB(x, y, toneMap(_accumSum[i] / (SLfloat)_accumNum[i]));
+        }
+    }
 
-            // update image after 500 ms
-            if (isMainThread)
-            {
-                if (SLApplication::scene->timeSec() - t1 > 0.5f)
-                {
-                    finishBeforeUpdate();
-                    _sv->onWndUpdate(); // update window
-                    t1 = SLApplication::scene->timeSec();
-                }
-            }
+    // update image after 500 ms (not if rendered headless)
+    if (worker == 0 && _sv->onWndUpdate)
+    {
+        if (SLApplication::scene->timeSec() - _tUpdate > 0.5f)
+        {
+            finishBeforeUpdate();
+            _sv->onWndUpdate(); // update window
+            _tUpdate = SLApplication::scene->timeSec();
         }
     }
 }
 //-----------------------------------------------------------------------------
 /*!
-Recursively traces Ray in Scene.
+Recursively traces Ray in Scene. The bsdfPdf is the solid angle pdf with which
+the ray direction was sampled on a diffuse surface. It is 0 for primary rays
+and for rays of specular, glossy or transparent surfaces. An emitter that is
+hit with bsdfPdf > 0 could also have been sampled with the next event
+estimation in shade. Its emission is therefore weighted with the power
+heuristic (see emission).
+With Russian roulette a path is continued after maxDepth bounces only with a
+probability that is proportional to the surface color. The surviving paths
+get divided by this probability, so the result is unbiased. SL_PT_MAX_DEPTH
+is only an upper limit for the recursion.
 */
-SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
+SLCol4f SLPathtracer::trace(SLRay* ray, SLfloat bsdfPdf)
 {
     SLScene* s = SLApplication::scene;
     SLCol4f  finalColor(ray->backgroundColor);
@@ -182,10 +185,11 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
     SLfloat absorbtion = 1.0f; // used to calculate absorbtion along the ray
     SLfloat scaleBy    = 1.0f; // used to scale surface reflectance at the end of random walk
 
-    s->root3D()->hitRec(ray);
+    s->hit(ray);
 
     // end of recursion - no object hit OR max depth reached
-    if (ray->length >= FLT_MAX || ray->depth > maxDepth())
+    SLint maxDepth = _doRussianRoulette ? SL_PT_MAX_DEPTH : _maxDepth;
+    if (ray->length >= FLT_MAX || ray->depth > maxDepth)
         return SLCol4f::BLACK;
 
     // hit material
@@ -201,41 +205,46 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
     else if (ray->hitMatIsTransparent())
         objectColor = mat->transmissiv();
 
-    // set object emission
-    SLCol4f objectEmission = mat->emissive();
-    SLfloat maxEmission    = objectEmission.maxXYZ();
-
     // stop recursion if light source is hit
-    if (maxEmission > 0)
-    {
-        if (ray->depth == 1)
-            return mat->emissive() * absorbtion;
-        else
-            return mat->emissive() * absorbtion * em;
-    }
+    if (mat->emissive().maxXYZ() > 0)
+        return emission(ray, bsdfPdf) * absorbtion;
 
     // add absorbtion to base color from Participating Media
     objectColor = objectColor * absorbtion;
 
+    // Add component wise the texture color
+    if (ray->hitMatIsDiffuse() && mat->textures().size())
+        objectColor &= ray->hitColor;
+
+    // direct illumination with next event estimation
+    if (ray->hitMatIsDiffuse() && _calcDirect)
+        finalColor += shade(ray, &objectColor) * scaleBy;
+
+    // Russian roulette: continue the path with the probability of the color
+    if (_doRussianRoulette && ray->depth >= _maxDepth)
+    {
+        SLfloat survive = SL_min(SL_max(objectColor.r,
+                                        objectColor.g,
+                                        objectColor.b),
+                                 0.95f);
+        if (SLSampler::local().get1D() >= survive)
+            return finalColor;
+        scaleBy /= survive;
+    }
+
     // diffuse reflection
     if (ray->hitMatIsDiffuse())
     {
-        // Add component wise the texture color
-        if (mat->textures().size())
-        {
-            objectColor &= ray->hitColor;
-        }
-
-        if (_calcDirect)
-            finalColor += shade(ray, &objectColor) * scaleBy;
-
         if (_calcIndirect)
         {
             SLRay scatter;
             ray->diffuseMC(&scatter);
 
+            // pdf of the cosine distributed direction
+            SLfloat pdf = SL_max(scatter.dir.dot(ray->hitNormal), 0.0f) / SL_PI;
+
             // material emission, material diffuse and recursive indirect illumination
-            finalColor += (trace(&scatter, 0) & objectColor) * scaleBy;
+            finalColor += (trace(&scatter, pdf) & objectColor) * scaleBy;
         }
     }
     else if (ray->hitMatIsReflective())
@@ -256,7 +265,7 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
         }
 
         // shininess contribution * recursive indirect illumination and matrial base color
-        finalColor += ((mat->shininess() + 2.0f) / (mat->shininess() + 1.0f) * (trace(&reflected, 1) & objectColor)) * scaleBy;
+        finalColor += ((mat->shininess() + 2.0f) / (mat->shininess() + 1.0f) * (trace(&reflected, 0.0f) & objectColor)) * scaleBy;
     }
     else if (ray->hitMatIsTransparent())
     {
@@ -311,11 +320,11 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
         }
 
         // probability of reflection
-        if (rnd01() > (0.25f + 0.5f * schlick))
+        if (SLSampler::local().get1D() > (0.25f + 0.5f * schlick))
             // scatter toward transmissive direction
             finalColor += ((mat->translucency() + 2.0f) /
                            (mat->translucency() + 1.0f) *
-                           (trace(&refracted, 1) & objectColor) *
+                           (trace(&refracted, 0.0f) & objectColor) *
                            refractionProbability) *
                           scaleBy;
         else
@@ -327,7 +336,7 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
             // shininess contribution * recursive indirect illumination and matrial basecolor
             finalColor += ((mat->shininess() + 2.0f) /
                            (mat->shininess() + 1.0f) *
-                           (trace(&scattered, 1) & objectColor) *
+                           (trace(&scattered, 0.0f) & objectColor) *
                            reflectionProbability) *
                           scaleBy;
         }
@@ -337,66 +346,292 @@ SLCol4f SLPathtracer::trace(SLRay* ray, SLbool em)
 }
 //-----------------------------------------------------------------------------
 /*!
-Calculates direct illumination for intersection point of ray
+Returns the emission of the hit emitter. Primary rays and rays of specular
+surfaces (bsdfPdf = 0) get the full emissive color of the material. For rays
+that were sampled on a diffuse surface the emitter could also have been
+sampled in shade if it is a light. The radiance of the light is then converted
+so that both strategies estimate the same integral. It is weighted with the
+power heuristic if the direct illumination is on.
+*/
+SLCol4f SLPathtracer::emission(SLRay* ray, SLfloat bsdfPdf)
+{
+    SLCol4f emissive = ray->hitMesh->mat()->emissive();
+
+    if (bsdfPdf <= 0.0f)
+        return emissive;
+
+    // Emitters that are no lights are not sampled by the NEE
+    SLLight* light = dynamic_cast<SLLight*>(ray->hitNode);
+    if (!light || !light->isOn())
+        return emissive;
+
+    SLfloat lightPdf = lightPdfOfHit(light, ray);
+    if (lightPdf <= 0.0f)
+        return emissive;
+
+    // Radiance that corresponds to the intensity used in shade. The ray
+    // direction points from the surface to the light like L in shade.
+    SLCol4f radiance = lightIntensity(light, ray->dir, ray->length) * lightPdf;
+
+    if (!_calcDirect)
+        return radiance;
+
+    return radiance * powerHeuristic(bsdfPdf, lightPdf);
+}
+//-----------------------------------------------------------------------------
+/*!
+Calculates direct illumination for intersection point of ray with next event
+estimation: For every light one point is sampled and connected with a shadow
+ray. The contributions of lights that can also be hit by the rays of the
+diffuse bounces (SLLightRect) are weighted with the power heuristic.
 */
 SLCol4f SLPathtracer::shade(SLRay* ray, SLCol4f* objectColor)
 {
-    SLScene* s            = SLApplication::scene;
-    SLCol4f  color        = SLCol4f::BLACK;
-    SLCol4f  diffuseColor = SLCol4f::BLACK;
-    SLVec3f  L, N;
-    SLfloat  lightDist, LdN, df, spotEffect, lighted = 0.0f;
+    SLScene* s     = SLApplication::scene;
+    SLCol4f  color = SLCol4f::BLACK;
+    SLVec3f  L, N(ray->hitNormal);
+    SLfloat  lightDist, lightPdf;
 
     // loop over light sources in scene
-    for (SLuint i = 0; i < s->lights().size(); ++i)
+    for (auto light : s->lights())
     {
-        SLLight* light = s->lights()[i];
+        if (!light || !light->isOn())
+            continue;
 
-        if (light && light->isOn())
-        {
-            N.set(ray->hitNormal);
-            L.sub(light->positionWS().vec3(), ray->hitPoint);
-            lightDist = L.length();
-            L /= lightDist;
-            LdN = L.dot(N);
+        if (!sampleLight(light, ray, L, lightDist, lightPdf))
+            continue;
+
+        SLfloat LdN = L.dot(N);
+        if (LdN <= 0.0f)
+            continue;
 
-            // check shadow ray if hit point is towards the light
-            lighted = (SLfloat)((LdN > 0) ? light->shadowTestMC(ray, L, lightDist) : 0);
+        SLCol4f intensity = lightIntensity(light, L, lightDist);
+        if (intensity.maxXYZ() <= 0.0f)
+            continue;
 
-            // calculate spot effect if light is a spotlight
-            if (lighted > 0.0f && light->spotCutOffDEG() < 180.0f)
+        // check shadow ray to the sample point on the light
+        SLfloat lighted = 1.0f;
+        SLRay   shadowRay(lightDist, L, ray);
+        light->isOccluded(&shadowRay);
+        if (shadowRay.length < lightDist)
+        {
+            // Handle shadow value of transparent materials
+            if (shadowRay.hitMesh->mat()->hasAlpha())
             {
-                SLfloat LdS = SL_max(-L.dot(light->spotDirWS()), 0.0f);
-
-                // check if point is in spot cone
-                if (LdS > light->spotCosCut())
-                {
-                    spotEffect = pow(LdS, (SLfloat)light->spotExponent());
-                }
-                else
-                {
-                    lighted    = 0.0f;
-                    spotEffect = 0.0f;
-                }
+                shadowRay.hitMesh->preShade(&shadowRay);
+                lighted = SL_abs(shadowRay.dir.dot(shadowRay.hitNormal)) *
+                          shadowRay.hitMesh->mat()->kt();
             }
             else
-                spotEffect = 1.0f;
-
-            if (lighted > 0.0f)
-            {
-                df = SL_max(LdN, 0.0f); // diffuse factor
+                continue;
+        }
 
-                // material color * light emission * LdN * brdf(1/pi) * lighted(for soft shadows)
-                diffuseColor = (*objectColor & (light->diffuse() * df) * (1 / SL_PI) * lighted);
-            }
+        // MIS weight if the light could also be hit by a diffuse bounce
+        SLfloat weight = 1.0f;
+        if (lightPdf > 0.0f && _calcIndirect && lightIsHitByBounces(light))
+            weight = powerHeuristic(lightPdf, LdN / SL_PI);
 
-            color += light->attenuation(lightDist) * spotEffect * diffuseColor;
-        }
+        // material color * light emission * LdN * brdf(1/pi) * lighted(for soft shadows)
+        color += (*objectColor & intensity) * (LdN / SL_PI * lighted * weight);
     }
 
     return color;
 }
 //-----------------------------------------------------------------------------
+/*!
+Samples a point on the light for the hit point of the ray and returns the
+normalized direction L to it, its distance and the solid angle pdf of the
+sample. Point and directional lights return a pdf of 0 (delta lights).
+\n SLLightRect: Uniform point on the rectangle.
+\n SLLightSpot with radius: Uniform direction within the cone of the sphere.
+*/
+SLbool SLPathtracer::sampleLight(SLLight* light,
+                                 SLRay*   ray,
+                                 SLVec3f& L,
+                                 SLfloat& lightDist,
+                                 SLfloat& lightPdf)
+{
+    SLVec4f lightPos = light->positionWS();
+    lightPdf         = 0.0f;
+
+    // directional light shines along its spot direction
+    if (lightPos.w == 0.0f)
+    {
+        L         = -light->spotDirWS();
+        lightDist = FLT_MAX;
+        L.normalize();
+        return true;
+    }
+
+    SLLightRect* rect = dynamic_cast<SLLightRect*>(light);
+    if (rect)
+    {
+        SLVec3f ex, ey, nL;
+        SLfloat area = rectLightGeometry(rect, ex, ey, nL);
+        if (area <= 0.0f) return false;
+
+        SLVec2f u = SLSampler::local().get2D();
+        SLVec3f P = lightPos.vec3() + (u.x - 0.5f) * ex + (u.y - 0.5f) * ey;
+        L.sub(P, ray->hitPoint);
+        lightDist = L.length();
+        if (lightDist <= FLT_EPSILON) return false;
+        L /= lightDist;
+
+        SLfloat cosL = SL_abs(L.dot(nL));
+        if (cosL <= FLT_EPSILON) return false;
+
+        lightPdf = lightDist * lightDist / (area * cosL);
+        return true;
+    }
+
+    SLLightSpot* spot = dynamic_cast<SLLightSpot*>(light);
+    SLVec3f      toC  = lightPos.vec3() - ray->hitPoint;
+    SLfloat      dC   = toC.length();
+    if (dC <= FLT_EPSILON) return false;
+
+    if (spot && spot->radius() > 0.0f && dC > spot->radius())
+    {
+        SLfloat r      = spot->radius();
+        SLfloat cosMax = sqrt(1.0f - r * r / (dC * dC));
+
+        // uniform direction within the cone towards the sphere
+        SLVec2f u      = SLSampler::local().get2D();
+        SLfloat cosT   = 1.0f - u.x * (1.0f - cosMax);
+        SLfloat sinT   = sqrt(SL_max(0.0f, 1.0f - cosT * cosT));
+        SLfloat phi    = SL_2PI * u.y;
+        SLVec3f W      = toC / dC;
+        SLVec3f U      = (fabs(W.x) > 0.1f ? SLVec3f(0, 1, 0) : SLVec3f(1, 0, 0)) ^ W;
+        U.normalize();
+        SLVec3f V      = W ^ U;
+        L              = U * (cos(phi) * sinT) + V * (sin(phi) * sinT) + W * cosT;
+
+        // distance to the sphere surface along L
+        SLfloat b    = L.dot(toC);
+        SLfloat disc = b * b - (dC * dC - r * r);
+        lightDist    = b - sqrt(SL_max(disc, 0.0f));
+        lightPdf     = 1.0f / (SL_2PI * (1.0f - cosMax));
+        return true;
+    }
+
+    // point light
+    L         = toC / dC;
+    lightDist = dC;
+    return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the solid angle pdf with which sampleLight would have sampled the
+direction of a ray that hit the light. Only lights that are hit by the rays
+of the diffuse bounces (see lightIsHitByBounces) return a pdf > 0.
+*/
+SLfloat SLPathtracer::lightPdfOfHit(SLLight* light, SLRay* ray)
+{
+    if (!lightIsHitByBounces(light))
+        return 0.0f;
+
+    SLVec3f ex, ey, nL;
+    SLfloat area = rectLightGeometry((SLLightRect*)light, ex, ey, nL);
+    SLfloat cosL = SL_abs(ray->dir.dot(nL));
+    if (area <= 0.0f || cosL <= FLT_EPSILON)
+        return 0.0f;
+
+    return ray->length * ray->length / (area * cosL);
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns true if the light can be hit by the rays of diffuse bounces. This is
+only the case for rectangular lights with a mesh. SLLightSpot only intersects
+primary rays (see SLLightSpot::hitRec).
+*/
+SLbool SLPathtracer::lightIsHitByBounces(SLLight* light)
+{
+    SLLightRect* rect = dynamic_cast<SLLightRect*>(light);
+    return rect && rect->meshes().size() > 0;
+}
+//-----------------------------------------------------------------------------
+//! Returns the edges, the normal and the area of a rectangular light in WS
+SLfloat SLPathtracer::rectLightGeometry(SLLightRect* rect,
+                                        SLVec3f&     ex,
+                                        SLVec3f&     ey,
+                                        SLVec3f&     nL)
+{
+    const SLMat4f& wm = rect->updateAndGetWM();
+    SLVec3f        c  = wm.multVec(SLVec3f::ZERO);
+    ex                = wm.multVec(SLVec3f(rect->width(), 0, 0)) - c;
+    ey                = wm.multVec(SLVec3f(0, rect->height(), 0)) - c;
+    nL                = ex ^ ey;
+    SLfloat area      = nL.length();
+    if (area > 0.0f) nL /= area;
+    return area;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the intensity of the light towards the direction -L at the distance
+lightDist including the attenuation and the spot cone. This is the quantity
+the old direct lighting used and it is kept so that the scenes don't change
+their brightness.
+*/
+SLCol4f SLPathtracer::lightIntensity(SLLight*       light,
+                                     const SLVec3f& L,
+                                     SLfloat        lightDist)
+{
+    SLCol4f intensity = light->diffuse();
+
+    if (lightDist < FLT_MAX)
+        intensity *= light->attenuation(lightDist);
+
+    // calculate spot effect if light is a spotlight
+    if (light->spotCutOffDEG() < 180.0f)
+    {
+        SLfloat LdS = SL_max(-L.dot(light->spotDirWS()), 0.0f);
+
+        // check if point is in spot cone
+        if (LdS > light->spotCosCut())
+            intensity *= pow(LdS, (SLfloat)light->spotExponent());
+        else
+            return SLCol4f::BLACK;
+    }
+
+    return intensity;
+}
+//-----------------------------------------------------------------------------
+//! Power heuristic (beta = 2) of Veach for multiple importance sampling
+SLfloat SLPathtracer::powerHeuristic(SLfloat pdfA, SLfloat pdfB)
+{
+    SLfloat a2 = pdfA * pdfA;
+    SLfloat b2 = pdfB * pdfB;
+    return a2 + b2 > 0.0f ? a2 / (a2 + b2) : 0.0f;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the albedo of the first hit of a primary ray after trace. It is the
+color that trace multiplies with the incoming light. Emitters have a white
+albedo, so their emission is kept as lighting by the denoiser.
+*/
+SLCol4f SLPathtracer::hitAlbedo(SLRay* ray)
+{
+    SLMaterial* mat = ray->hitMesh->mat();
+
+    if (mat->emissive().maxXYZ() > 0)
+        return SLCol4f::WHITE;
+
+    if (ray->hitMatIsDiffuse())
+    {
+        SLCol4f albedo = mat->diffuse();
+        if (mat->textures().size())
+            albedo &= ray->hitColor;
+        return albedo;
+    }
+
+    if (ray->hitMatIsReflective())
+        return mat->specular();
+
+    if (ray->hitMatIsTransparent())
+        return mat->transmissiv();
+
+    return SLCol4f::WHITE;
+}
+//-----------------------------------------------------------------------------
 //! Saves the current PT image as PNG image
 void SLPathtracer::saveImage()
 {
@@ -406,3 +641,110 @@ void SLPathtracer::saveImage()
     _images[0]->savePNG(filename);
 }
 //-----------------------------------------------------------------------------
+/*!
+Saves the mean of the HDR accumulation buffer without exposure, tone mapping
+and gamma as PFM (portable float map) image. The PFM stores the rows as 32 bit
+little endian RGB floats from bottom to top like the RT images.
+*/
+void SLPathtracer::saveHDRImage()
+{
+    if (_images.empty() || _accumSum.empty()) return;
+
+    static SLint no = 0;
+    SLchar       filename[255];
+    sprintf(filename, "Pathtraced_%d_%d.pfm", _aaSamples, no++);
+
+    SLint w = (SLint)_images[0]->width();
+    SLint h = (SLint)_images[0]->height();
+
+    ofstream file(filename, ios::binary);
+    if (!file.is_open())
+    {
+        SL_LOG("\nSLPathtracer::saveHDRImage: Could not open %s", filename);
+        return;
+    }
+
+    // A negative scale means little endian
+    file << "PF\n"
+         << w << " " << h << "\n"
+         << "-1.0\n";
+
+    SLVfloat row((SLuint)w * 3);
+    for (SLint y = 0; y < h; ++y)
+    {
+        for (SLint x = 0; x < w; ++x)
+        {
+            SLuint  i     = (SLuint)(y * w + x);
+            SLCol4f color = _accumNum[i] ? _accumSum[i] / (SLfloat)_accumNum[i]
+                                         : SLCol4f::BLACK;
+            row[(SLuint)x * 3]     = color.r;
+            row[(SLuint)x * 3 + 1] = color.g;
+            row[(SLuint)x * 3 + 2] = color.b;
+        }
+        file.write((const char*)row.data(), (std::streamsize)(row.size() * sizeof(SLfloat)));
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Converts the HDR mean color of a pixel to the display color. The exposure is
+applied first. Then the color is either clamped or compressed with the
+Reinhard operator on the luminance. At the end the gamma correction is done.
+*/
+SLCol4f SLPathtracer::toneMap(const SLCol4f& hdr)
+{
+    SLCol4f color = hdr * _exposure;
+
+    if (_doToneMapping)
+    {
+        SLfloat lum = 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+        if (lum > 0.0f) color *= 1.0f / (1.0f + lum);
+    }
+
+    color.clampMinMax(0.0f, 1.0f);
+    color.gammaCorrect(_oneOverGamma);
+    return color;
+}
+//-----------------------------------------------------------------------------
+/*!
+Rewrites the whole display image from the HDR accumulation buffer. This is
+used after the exposure, the tone mapping or the gamma got changed, so that
+the image doesn't have to be rendered again.
+*/
+void SLPathtracer::updateDisplayImage()
+{
+    if (_images.empty() || _accumSum.size() != _images[0]->width() * _images[0]->height())
+        return;
+
+    SLint w = (SLint)_images[0]->width();
+    SLint h = (SLint)_images[0]->height();
+
+    SLbool showDenoised = _doDenoise && _denoiser.isValid();
+
+    for (SLint y = 0; y < h; ++y)
+        for (SLint x = 0; x < w; ++x)
+        {
+            SLuint i = (SLuint)(y * w + x);
+            if (!_accumNum[i]) continue;
+
+            if (showDenoised)
+                _images[0]->setPixeliRGB(x, y, toneMap(_denoiser.result(i)));
+            else
+                _images[0]->setPixeliRGB(x, y, toneMap(_accumSum[i] / (SLfloat)_accumNum[i]));
+        }
+}
+//-----------------------------------------------------------------------------
+/*!
+Denoises the current mean of the accumulation buffer with the threads of the
+render pool and rewrites the display image. It is called at the end of render
+if doDenoise is on and by the GUI if the denoising gets switched on after the
+rendering.
+*/
+void SLPathtracer::denoise()
+{
+    if (_images.empty() || _accumSum.size() != _images[0]->width() * _images[0]->height())
+        return;
+
+    _denoiser.denoise(_accumSum, _accumNum, _pool, _tiles, _numThreads);
+    updateDisplayImage();
+}
+//-----------------------------------------------------------------------------
@@ -2,301 +2,442 @@
 //  File:      SLPhotonMapper.cpp
 //  Author:    Michael Strub, Stefan Traud, Marcus Hudritsch
 //  Date:      September 2011 (HS11)
-//  Copyright (c): 2002-2013 Marcus Hudritsch
+//  Copyright: Marcus Hudritsch
 //             This software is provide under the GNU General Public License
 //             Please visit: http://opensource.org/licenses/GPL-3.0
 //#############################################################################
 
-#include <stdafx.h>           // precompiled headers
-#ifdef SL_MEMLEAKDETECT
-#include <nvwa/debug_new.h>   // memory leak detector
-#endif
-#ifdef SL_OMP
-#include <omp.h>              // OpenMP
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
 #endif
 
-#include "SLPhotonMap.h"
-#include "SLPhotonMapper.h"
-#include "SLCamera.h"
-#include "SLSceneView.h"
-#include "SLLightSphere.h"
-#include "SLLightRect.h"
-#include "SLLight.h"
-#include "SLGroup.h"
-#include "SLMesh.h"
-#include "SLGLTexture.h"
-#include "SLSamples2D.h"
-#include "SLGLShaderProg.h"
+#include <SLApplication.h>
+#include <SLCamera.h>
+#include <SLLightRect.h>
+#include <SLLightSpot.h>
+#include <SLPhotonMapper.h>
+#include <SLRay.h>
+#include <SLSampler.h>
+#include <SLSceneView.h>
 
 //-----------------------------------------------------------------------------
-SLPhotonMapper::SLPhotonMapper()
-{  
-   name("myCoolPhotonMapper");
-   
-   // random vars are initialized with current time
-   _random = new TRanrotBGenerator((unsigned)time(NULL));
-   _russianRandom = new TRanrotBGenerator((unsigned)time(NULL)+1);
-
-   // photonmapping
-   _photonsToEmit=0;
-   _mapCaustic = new SLPhotonMap();
-   _mapGlobal = new SLPhotonMap();
-   _mapCausticGotFull = false;
-   _mapGlobalGotFull = false;
-   _gamma = 2.2f;
+//! Adds n bytes of data to the 64 bit FNV-1a hash
+static inline void hashBytes(SLuint64& hash, const void* data, size_t n)
+{
+    const SLuchar* bytes = (const SLuchar*)data;
+    for (size_t i = 0; i < n; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
 }
 //-----------------------------------------------------------------------------
-SLPhotonMapper::~SLPhotonMapper()
-{  
-   delete _mapCaustic;
-   delete _mapGlobal;
-   delete _random;
-   delete _russianRandom;
-   delete SLRay::random;
+SLPhotonMapper::SLPhotonMapper()
+{
+    name("PhotonMapper");
+    _numPhotons      = 200000;
+    _doGlobalIllum   = true;
+    _doPhotonCaching = true;
+    _mapsAreValid    = false;
+    _mapsSignature   = 0;
+    _causticRadius   = 0.02f;
+    _globalRadius    = 0.05f;
+    _emitSec         = 0.0f;
+    _mapCaustic.estimateParams(80, 0.1f);
+    _mapGlobal.estimateParams(200, 0.1f);
 }
 //-----------------------------------------------------------------------------
 /*!
+Main render function of the photon mapper. The photons get emitted if the
+maps are not valid for the current scene. Then the image is ray traced by the
+render pool with SLRaytracer::renderDistrib.
 */
-SLbool SLPhotonMapper::render()
-{  
-   return true;
+SLbool SLPhotonMapper::render(SLSceneView* sv)
+{
+    SLScene* s = SLApplication::scene;
+    _sv        = sv;
+
+    // the emitting threads only read the world matrices
+    s->updateTransforms();
+
+    // Emit only if anything else than the camera changed
+    SLuint64 signature = sceneSignature();
+    if (!_doPhotonCaching || !_mapsAreValid || signature != _mapsSignature)
+    {
+        emitPhotons();
+        _mapsSignature = signature;
+        _mapsAreValid  = true;
+    }
+    else
+        SL_LOG("\nPhotons reused : %d caustic, %d global",
+               _mapCaustic.numPhotons(),
+               _mapGlobal.numPhotons());
+
+    // The search radii are relative to the scene size
+    SLfloat sceneRadius = s->root3D() ? s->root3D()->aabb()->radiusWS() : 1.0f;
+    _mapCaustic.estimateParams(_mapCaustic.maxEstimatePhotons(),
+                               _causticRadius * sceneRadius);
+    _mapGlobal.estimateParams(_mapGlobal.maxEstimatePhotons(),
+                              _globalRadius * sceneRadius);
+
+    return renderDistrib(sv);
 }
 //-----------------------------------------------------------------------------
 /*!
+Emits the photons of all lights in chunks of SL_PHOTON_CHUNK photons with the
+render pool. The photons are distributed onto the lights according to their
+power. Every worker stores its photons in its own buffers. The buffers are
+merged afterwards in the worker order and both kd-trees get balanced in
+parallel. Directional lights are not supported because they have no position
+to emit from.
 */
-SLCol4f SLPhotonMapper::trace(SLRay* ray)
-{  
-   SLScene* s = SLScene::current;
-   SLCol4f color(s->backColor());
-   
-   return color;
+void SLPhotonMapper::emitPhotons()
+{
+    SLScene* s  = SLApplication::scene;
+    double   t1 = s->timeSec();
+
+    _emitLights.clear();
+    _emitPower.clear();
+    _emitTasks.clear();
+
+    // Flux of the lights (intensity times the solid angle of the emission)
+    vector<SLVec3f> flux;
+    SLfloat         fluxSum = 0.0f;
+    for (auto light : s->lights())
+    {
+        if (!light || !light->isOn() || light->positionWS().w == 0.0f)
+            continue;
+
+        SLfloat solidAngle;
+        if (dynamic_cast<SLLightRect*>(light))
+            solidAngle = SL_PI; // cosine distribution over the hemisphere
+        else if (light->spotCutOffDEG() < 180.0f)
+            solidAngle = SL_2PI * (1.0f - light->spotCosCut());
+        else
+            solidAngle = 4.0f * SL_PI;
+
+        SLCol4f I = light->diffuse();
+        SLVec3f F(I.r * solidAngle, I.g * solidAngle, I.b * solidAngle);
+        if (F.x + F.y + F.z <= 0.0f) continue;
+
+        _emitLights.push_back(light);
+        flux.push_back(F);
+        fluxSum += F.x + F.y + F.z;
+    }
+
+    // NO. of photons per light and its chunks
+    for (SLuint l = 0; l < _emitLights.size(); ++l)
+    {
+        SLfloat share = (flux[l].x + flux[l].y + flux[l].z) / fluxSum;
+        SLuint  n     = SL_max((SLuint)((SLfloat)_numPhotons * share), (SLuint)1);
+
+        _emitPower.push_back(flux[l] / (SLfloat)n);
+
+        for (SLuint first = 0; first < n; first += SL_PHOTON_CHUNK)
+            _emitTasks.push_back({l, first, SL_min((SLuint)SL_PHOTON_CHUNK, n - first)});
+    }
+
+    // Reuse the per-worker buffers of the last emission
+    SLuint numBuffers = SL::maxThreads();
+    _causticBuffers.resize(numBuffers);
+    _globalBuffers.resize(numBuffers);
+    for (SLuint w = 0; w < numBuffers; ++w)
+    {
+        _causticBuffers[w].clear();
+        _globalBuffers[w].clear();
+    }
+
+    _pool.run((SLuint)_emitTasks.size(),
+              [this](SLuint task, SLuint worker) {
+                  const EmitTask& t = _emitTasks[task];
+                  emitChunk(t.light, t.first, t.count, worker);
+              },
+              _numThreads);
+
+    // Merge the buffers and build both kd-trees at the same time
+    _mapCaustic.clear();
+    _mapGlobal.clear();
+    for (SLuint w = 0; w < numBuffers; ++w)
+    {
+        _mapCaustic.add(_causticBuffers[w]);
+        _mapGlobal.add(_globalBuffers[w]);
+    }
+
+    _pool.run(2,
+              [this](SLuint task, SLuint worker) {
+                  if (task == 0)
+                      _mapCaustic.balance();
+                  else
+                      _mapGlobal.balance();
+              },
+              _numThreads);
+
+    _emitSec = (SLfloat)(s->timeSec() - t1);
+
+    SL_LOG("\nPhotons emitted: %u from %u lights in %5.3f sec",
+           _numPhotons,
+           (SLuint)_emitLights.size(),
+           _emitSec);
+    SL_LOG("\nPhotons stored : %d caustic, %d global",
+           _mapCaustic.numPhotons(),
+           _mapGlobal.numPhotons());
 }
 //-----------------------------------------------------------------------------
 /*!
+Emits count photons of the light with the index light starting with the
+photon index first. This is called by the workers of the render pool.
+\n SLLightRect: uniform point on the rectangle & cosine distributed direction.
+\n Spot light: uniform direction in the cone weighted by the spot exponent.
+\n Point light: uniform direction on the sphere.
 */
-SLCol4f SLPhotonMapper::shade(SLRay* ray)
-{  
-   //SLScene*    s = SLScene::current;
-   SLCol4f     localColor = SLCol4f::BLACK;
-   
-   return localColor;  
+void SLPhotonMapper::emitChunk(SLuint light,
+                               SLuint first,
+                               SLuint count,
+                               SLuint worker)
+{
+    SLLight*     l       = _emitLights[light];
+    SLLightRect* rect    = dynamic_cast<SLLightRect*>(l);
+    SLSampler&   sampler = SLSampler::local();
+    SLVec3f      pos     = l->positionWS().vec3();
+
+    // orthonormal frame around the spot direction
+    SLVec3f W = l->spotDirWS();
+    W.normalize();
+    SLVec3f U = (fabs(W.x) > 0.1f ? SLVec3f(0, 1, 0) : SLVec3f(1, 0, 0)) ^ W;
+    U.normalize();
+    SLVec3f V = W ^ U;
+
+    // edges of the rectangle in world space
+    SLVec3f ex, ey;
+    if (rect)
+    {
+        const SLMat4f& wm = rect->updateAndGetWM();
+        SLVec3f        c  = wm.multVec(SLVec3f::ZERO);
+        ex                = wm.multVec(SLVec3f(rect->width(), 0, 0)) - c;
+        ey                = wm.multVec(SLVec3f(0, rect->height(), 0)) - c;
+    }
+
+    for (SLuint i = 0; i < count; ++i)
+    {
+        sampler.startPixel((SLint)light, 0, first + i);
+
+        SLVec3f power  = _emitPower[light];
+        SLVec3f origin = pos;
+        SLVec3f dir;
+
+        if (rect)
+        {
+            SLVec2f u = sampler.get2D();
+            origin += (u.x - 0.5f) * ex + (u.y - 0.5f) * ey;
+            SLVec2f v   = sampler.get2D();
+            SLfloat r   = sqrt(v.x);
+            SLfloat phi = SL_2PI * v.y;
+            dir         = U * (r * cos(phi)) + V * (r * sin(phi)) + W * sqrt(1.0f - v.x);
+        }
+        else if (l->spotCutOffDEG() < 180.0f)
+        {
+            SLVec2f v    = sampler.get2D();
+            SLfloat cosT = 1.0f - v.x * (1.0f - l->spotCosCut());
+            SLfloat sinT = sqrt(SL_max(0.0f, 1.0f - cosT * cosT));
+            SLfloat phi  = SL_2PI * v.y;
+            dir          = U * (sinT * cos(phi)) + V * (sinT * sin(phi)) + W * cosT;
+            power *= pow(cosT, l->spotExponent());
+        }
+        else
+        {
+            SLVec2f v   = sampler.get2D();
+            SLfloat z   = 1.0f - 2.0f * v.x;
+            SLfloat r   = sqrt(SL_max(0.0f, 1.0f - z * z));
+            SLfloat phi = SL_2PI * v.y;
+            dir.set(r * cos(phi), r * sin(phi), z);
+        }
+
+        // Photons are no primary rays, so they pass the light spheres
+        SLRay photon;
+        photon.origin = origin + dir * 0.0001f;
+        photon.setDir(dir);
+        photon.type = REFLECTED;
+
+        scatterPhoton(&photon, power, worker);
+    }
 }
 //-----------------------------------------------------------------------------
 /*!
-Inits the photonmap members with the photonmap settings
+Traces a photon through the scene. On every diffuse hit the photon gets stored
+into the caustic buffer if its path was light - specular - diffuse or into the
+global buffer if it had a diffuse bounce before. Direct hits from the light are
+not stored because the direct light is ray traced. The photon is reflected,
+refracted, diffusely scattered or absorbed by Russian roulette.
 */
-void SLPhotonMapper::setPhotonmaps(SLlong photonsToEmit,
-                                   SLlong maxCausticStoredPhotons, 
-                                   SLuint maxCausticEstimationPhotons, 
-                                   SLfloat maxCausticEstimationRadius,
-                                   SLlong maxGlobalStoredPhotons, 
-                                   SLuint maxGlobalEstimationPhotons, 
-                                   SLfloat maxGlobalEstimationRadius)
+void SLPhotonMapper::scatterPhoton(SLRay* photon, SLVec3f power, SLuint worker)
 {
-   _mapCaustic->setPhotonMapParams(maxCausticStoredPhotons, 
-                                   maxCausticEstimationPhotons, 
-                                   maxCausticEstimationRadius);
-   _mapGlobal->setPhotonMapParams(maxGlobalStoredPhotons, 
-                                  maxGlobalEstimationPhotons, 
-                                  maxGlobalEstimationRadius);
-   _photonsToEmit = photonsToEmit;
+    SLScene*   s           = SLApplication::scene;
+    SLSampler& sampler     = SLSampler::local();
+    SLbool     wasDiffuse  = false;
+    SLbool     wasSpecular = false;
+    SLRay      ray         = *photon;
+
+    for (SLint depth = 1; depth <= SL_PHOTON_MAX_DEPTH; ++depth)
+    {
+        s->hit(&ray);
+        if (ray.length >= FLT_MAX) return;
+
+        // photons get absorbed by the meshes of the lights
+        SLMaterial* mat = ray.hitMesh->mat();
+        if (mat->emissive().maxXYZ() > 0.0f) return;
+
+        ray.hitMesh->preShade(&ray);
+
+        SLCol4f diffuse = mat->diffuse();
+        if (mat->textures().size() || ray.hitMesh->C.size())
+            diffuse &= ray.hitColor;
+
+        SLfloat kr    = mat->kr();
+        SLfloat kt    = mat->kt();
+        SLfloat avgKd = (diffuse.r + diffuse.g + diffuse.b) / 3.0f;
+        SLfloat pd    = avgKd * SL_max(1.0f - kr - kt, 0.0f);
+
+        // store the photon on diffuse surfaces
+        if (pd > 0.0f && (wasDiffuse || wasSpecular))
+        {
+            SLPhoton p;
+            p.pos   = ray.hitPoint;
+            p.dir   = ray.dir;
+            p.power = SLRGBE(power);
+            p.plane = 0;
+
+            if (wasDiffuse)
+                _globalBuffers[worker].push_back(p);
+            else
+                _causticBuffers[worker].push_back(p);
+        }
+
+        // Russian roulette over diffuse, reflected, refracted & absorbed
+        SLRay   scattered;
+        SLfloat eta = sampler.get1D();
+        if (eta < pd)
+        {
+            ray.diffuseMC(&scattered);
+            power.x *= diffuse.r / avgKd;
+            power.y *= diffuse.g / avgKd;
+            power.z *= diffuse.b / avgKd;
+            wasDiffuse = true;
+        }
+        else if (eta < pd + kr)
+        {
+            ray.reflect(&scattered);
+            wasSpecular = true;
+        }
+        else if (eta < pd + kr + kt)
+        {
+            ray.refract(&scattered);
+            wasSpecular = true;
+        }
+        else
+            return; // absorbed
+
+        ray = scattered;
+    }
 }
 //-----------------------------------------------------------------------------
 /*!
-Photons are scattered (or absorbed) according to surface properties. 
-This is done by russian roulette.
-Photons are stored on diffuse surfaces only.
+Adds to the Whitted style shading of SLRaytracer::shade the radiance
+estimates of the caustic and the global photon map on diffuse surfaces. The
+estimates are done by the render threads in parallel.
 */
-void SLPhotonMapper::photonScatter(SLRay* photon, 
-                                   SLVec3f power, 
-                                   SLPhotonType photonType)//, SLint RGB)
+SLCol4f SLPhotonMapper::shade(SLRay* ray)
 {
-   SLScene* s = SLScene::current;      // scene shortcut
-   s->root3D()->hit(photon);
-   
-   if (photon->length < SL_FLOAT_MAX)
-   {  
-      //photons "absorbed" by luminaire
-      if (typeid(*photon->hitShape)==typeid(SLLightSphere) ||
-          typeid(*photon->hitShape)==typeid(SLLightRect)) 
-         return;
-
-      //abort if maps are full or depth>100
-      if((_mapCaustic->isFull() && _mapGlobal->isFull()) || 
-         photon->depth>100) //physically plausible ;-)
-         return;
-      
-      photon->normalizeNormal();
-      SLMaterial* mat = photon->hitMat;
-
-      //store photon if diffuse surface and not from light
-      if (photon->nodeDiffuse() && photonType!=LIGHT)//photon->type()!=PRIMARY)
-      {
-         if(photonType!=CAUSTIC)
-            _mapGlobal->store(photon->hitPoint,photon->dir,power);
-         else
-         {
-            _mapCaustic->store(photon->hitPoint,photon->dir,power);
-            return; // caustic photons "die" on diffuse surfaces
-         }
-      }
-
-      //calculate average of materials
-      SLfloat avgDiffuse     = (mat->diffuse().x+mat->diffuse().y+mat->diffuse().z)/3.0f;
-      SLfloat avgSpecular    = (mat->specular().x+mat->specular().y+mat->specular().z)/3.0f;
-      SLfloat avgTransmission= (mat->transmission().x+mat->transmission().y+mat->transmission().z)/3.0f;
-      SLfloat eta            = _russianRandom->Random();
-
-      //Decide type of photon (Global or Caustic) if from light
-      if (photonType == LIGHT)
-      {
-         if ((eta*(avgDiffuse+avgSpecular+avgTransmission))<=avgDiffuse)
-            photonType=GLOBAL;
-         else
-            photonType=CAUSTIC;
-      }
-
-      //Russian Roulette
-      if (eta <= avgDiffuse) 
-      {
-         //scattered diffuse (cosine distribution around normal)
-         SLRay scattered;
-         photon->diffuseMC(&scattered);
-         //adjust power
-         power.x*=(mat->diffuse().x/avgDiffuse);
-         power.y*=(mat->diffuse().y/avgDiffuse);
-         power.z*=(mat->diffuse().z/avgDiffuse);
-
-         ++SLRay::diffusePhotons;
-         photonScatter(&scattered, power, photonType);
-
-         
-      }
-      else if (eta <= avgDiffuse+avgSpecular)
-      {
-         //scatter toward perfect specular direction
-         SLRay scattered;
-         photon->reflect(&scattered);
-         
-         //scatter around perfect reflected direction only if material not perfect
-         if(photon->hitMat->shininess() < SLMaterial::PERFECT)
-         {
-            //rotation matrix
-            SLMat3f rotMat;
-            SLVec3f rotAxis((SLVec3f(0.0,0.0,1.0) ^ scattered.dir).normalize());
-            SLfloat rotAngle=acos(scattered.dir.z);//z*scattered.dir()
-            rotMat.rotation(rotAngle*180.0/SL_PI,rotAxis);
-            photon->reflectMC(&scattered,rotMat);
-         }
-         
-         //avoid scattering into surface
-         if (scattered.dir*photon->hitNormal >= 0.0f)
-         {
-            //adjust power
-            power.x*=(mat->specular().x/avgSpecular);
-            power.y*=(mat->specular().y/avgSpecular);
-            power.z*=(mat->specular().z/avgSpecular);
-
-            ++SLRay::reflectedPhotons;
-            photonScatter(&scattered,power,photonType);
-         }
-      }
-      else if (eta <= avgDiffuse+avgSpecular+avgTransmission) //scattered refracted
-      {
-         //scatter toward perfect transmissive direction
-         SLRay scattered;
-         photon->refract(&scattered);
-         
-         //scatter around perfect transmissive direction only if material not perfect
-         if(photon->hitMat->translucency() < SLMaterial::PERFECT)
-         {
-            //rotation matrix
-            SLMat3f rotMat;
-            SLVec3f rotAxis((SLVec3f(0.0,0.0,1.0) ^ scattered.dir).normalize());
-            SLfloat rotAngle=acos(scattered.dir.z);//z*scattered.dir()
-            rotMat.rotation(rotAngle*180.0/SL_PI,rotAxis);
-            photon->refractMC(&scattered,rotMat);
-         }
-         SLVec3f N = -photon->hitNormal;
-         if(scattered.type==REFLECTED) N*=-1.0;  //In case of total reflection invert the Normal
-         
-         if (scattered.dir*N >= 0.0f)
-         {
-            //adjust power
-            power.x*=(mat->transmission().x/avgTransmission);
-            power.y*=(mat->transmission().y/avgTransmission);
-            power.z*=(mat->transmission().z/avgTransmission);
-            if(scattered.type==TRANSMITTED) ++SLRay::refractedPhotons; else ++SLRay::tirPhotons;
-            photonScatter(&scattered,power,photonType);
-         }
-      }
-      else //absorbed [rest in peace]
-      {
-      }
-   }
+    SLCol4f     color = SLRaytracer::shade(ray); // calls preShade
+    SLMaterial* mat   = ray->hitMesh->mat();
+
+    SLCol4f diffuse = mat->diffuse();
+    if (mat->textures().size() || ray->hitMesh->C.size())
+        diffuse &= ray->hitColor;
+
+    // same diffuse reflectance as in the photon scattering
+    SLfloat kdScale = SL_max(1.0f - mat->kr() - mat->kt(), 0.0f);
+    if (diffuse.maxXYZ() <= 0.0f || kdScale <= 0.0f)
+        return color;
+
+    SLVec3f E = _mapCaustic.irradianceEstimate(ray->hitPoint,
+                                               ray->hitNormal,
+                                               PF_cone);
+    if (_doGlobalIllum)
+        E += _mapGlobal.irradianceEstimate(ray->hitPoint,
+                                           ray->hitNormal,
+                                           PF_none);
+
+    color += SLCol4f(E.x * diffuse.r, E.y * diffuse.g, E.z * diffuse.b, 0.0f) * kdScale;
+    color.clampMinMax(0, 1);
+    return color;
 }
 //-----------------------------------------------------------------------------
-/*!Creates photons (ray with power) from a point light source and sends 
-it into the scene. 
-Note that a point light has no cosine distribution and no surface area
+/*!
+Returns a hash over everything that changes the photon maps: the lights, the
+world matrices and AABBs of all nodes, the meshes & their materials, the
+sampler and the NO. of photons. The camera nodes are skipped, so the maps can
+be reused while only the camera moves.
 */
-void SLPhotonMapper::photonEmission(SLLight* light)
+SLuint64 SLPhotonMapper::sceneSignature()
 {
-   SLfloat eta1,eta2,f1,f2;
-   SLVec3f C,N;
-   SLVec3f power;
-      
-   C = light->positionWS();
-
-   //because point lights have no surface use only radiance for power of emitted photons
-   power.set(light->diffuse().r,light->diffuse().g,light->diffuse().b);
-
-   //progress
-   SLlong maxPhotons=_mapCaustic->maxStoredPhotons()+_mapGlobal->maxStoredPhotons();
-   SLlong curPhotons=_mapCaustic->storedPhotons()+_mapGlobal->storedPhotons();;
-   
-   SLlong emitted=0;
-
-   //shoot the photons as long as maps are not full
-   while(emitted<light->photons() && !(_mapCaustic->isFull()&&(_mapGlobal->isFull())))
-   {
-      //progress
-      if(emitted%1000==0)
-      {  curPhotons=_mapCaustic->storedPhotons()+_mapGlobal->storedPhotons();
-         printf("\b\b\b\b%3.0f%%",(SLfloat)curPhotons/(SLfloat)maxPhotons*100.0f);
-      }
-
-      //create spherical random direction
-      eta1=_random->Random();eta2=_random->Random();
-      f1 = SL_2PI*eta2;
-      f2 = 2.0f * sqrt(eta1 * (1-eta1));
-
-      //direction in cartesian coordinates
-      N.set(cos(f1)*f2, sin(f1)*f2, (1.0-2.0*eta1));
-      
-      //create and emit photon
-      SLRay scattered(C,N,PRIMARY, (SLShape*)light, SL_FLOAT_MAX, 1);
-      photonScatter(&scattered,power,LIGHT);
-
-      emitted++;
-      //scaling of stored photons is necessary if one of the maps was filled by this photon
-      //(because emission of photons continues in order to fill the other map)
-      if(_mapCaustic->isFull() && !_mapCausticGotFull)
-      {  _mapCausticGotFull = true;
-         _mapCaustic->scalePhotonPower(1.0f/SLfloat(emitted));
-      }
-      if(_mapGlobal->isFull() && !_mapGlobalGotFull)
-      {  _mapGlobalGotFull = true;
-         _mapGlobal->scalePhotonPower(1.0f/SLfloat(emitted));
-      }
-
-   }
-
-   //scale all stored photons of this light source
-   if(emitted)
-   {  SLRay::emittedPhotons+=emitted;
-      _mapCaustic->scalePhotonPower(1.0f/SLfloat(emitted));
-      _mapGlobal->scalePhotonPower(1.0f/SLfloat(emitted));
-   }
+    SLScene* s    = SLApplication::scene;
+    SLuint64 hash = 14695981039346656037ULL;
+
+    SLuint        seed = SLSampler::seed();
+    SLSamplerType type = SLSampler::type();
+    hashBytes(hash, &seed, sizeof(seed));
+    hashBytes(hash, &type, sizeof(type));
+    hashBytes(hash, &_numPhotons, sizeof(_numPhotons));
+
+    for (auto light : s->lights())
+    {
+        if (!light) continue;
+        SLbool  isOn   = light->isOn();
+        SLVec4f pos    = light->positionWS();
+        SLVec3f dir    = light->spotDirWS();
+        SLCol4f diff   = light->diffuse();
+        SLfloat cutOff = light->spotCutOffDEG();
+        SLfloat exp    = light->spotExponent();
+        hashBytes(hash, &isOn, sizeof(isOn));
+        hashBytes(hash, &pos, sizeof(pos));
+        hashBytes(hash, &dir, sizeof(dir));
+        hashBytes(hash, &diff, sizeof(diff));
+        hashBytes(hash, &cutOff, sizeof(cutOff));
+        hashBytes(hash, &exp, sizeof(exp));
+    }
+
+    if (s->root3D())
+        hashNodeRec(s->root3D(), hash);
+
+    return hash;
+}
+//-----------------------------------------------------------------------------
+//! Adds a node and its children without the cameras to the scene signature
+void SLPhotonMapper::hashNodeRec(SLNode* node, SLuint64& hash)
+{
+    if (dynamic_cast<SLCamera*>(node)) return;
+
+    const SLMat4f& wm    = node->updateAndGetWM();
+    SLVec3f        minWS = node->aabb()->minWS();
+    SLVec3f        maxWS = node->aabb()->maxWS();
+    hashBytes(hash, wm.m(), 16 * sizeof(SLfloat));
+    hashBytes(hash, &minWS, sizeof(minWS));
+    hashBytes(hash, &maxWS, sizeof(maxWS));
+
+    for (auto mesh : node->meshes())
+    {
+        SLMaterial* mat  = mesh->mat();
+        SLCol4f     diff = mat->diffuse();
+        SLfloat     k[3] = {mat->kr(), mat->kt(), mat->kn()};
+        hashBytes(hash, &mesh, sizeof(mesh));
+        hashBytes(hash, &mat, sizeof(mat));
+        hashBytes(hash, &diff, sizeof(diff));
+        hashBytes(hash, k, sizeof(k));
+    }
+
+    for (auto child : node->children())
+        hashNodeRec(child, hash);
 }
 //-----------------------------------------------------------------------------
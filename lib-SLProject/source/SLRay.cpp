@@ -14,35 +14,24 @@
 #endif
 
 #include <SLRay.h>
+#include <SLRayStats.h>
+#include <SLSampler.h>
 #include <SLSceneView.h>
 
 // init static variables
-SLint   SLRay::maxDepth         = 0;
-SLfloat SLRay::minContrib       = 1.0 / 256.0;
-SLuint  SLRay::reflectedRays    = 0;
-SLuint  SLRay::refractedRays    = 0;
-SLuint  SLRay::ignoredRays      = 0;
-SLuint  SLRay::shadowRays       = 0;
-SLuint  SLRay::subsampledRays   = 0;
-SLuint  SLRay::subsampledPixels = 0;
-SLuint  SLRay::tirRays          = 0;
-SLuint  SLRay::tests            = 0;
-SLuint  SLRay::intersections    = 0;
-SLint   SLRay::depthReached     = 1;
-SLint   SLRay::maxDepthReached  = 0;
-SLfloat SLRay::avgDepth         = 0;
+SLint   SLRay::maxDepth   = 0;
+SLfloat SLRay::minContrib = 1.0 / 256.0;
 
 //-----------------------------------------------------------------------------
-/*! Global uniform random number generator for numbers between 0 and 1 that are
-used in SLRay, SLLightRect and SLPathtracer. So far they work perfectly with 
-CPP11 multithreading.
+/*! Uniform random number between 0 and 1 that is used in SLRay, SLLightRect and
+SLPathtracer. It returns the next dimension of the thread local SLSampler so
+that the render threads never share a generator. For reproducible renderings
+the seed is set with SLSampler::seed.
 */
-auto    random01 = bind(uniform_real_distribution<SLfloat>(0.0, 1.0),
-                     mt19937((SLuint)time(nullptr)));
 SLfloat rnd01();
 SLfloat rnd01()
 {
-    return random01();
+    return SLSampler::local().get1D();
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -70,6 +59,8 @@ SLRay::SLRay(SLSceneView* sceneView)
     isOutside      = true;
     isInsideVolume = false;
     sv             = sceneView;
+    coneWidth      = 0.0f;
+    coneAngle      = 0.0f;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -103,6 +94,8 @@ SLRay::SLRay(SLVec3f      Origin,
     isInsideVolume  = false;
     backgroundColor = backColor;
     sv              = sceneView;
+    coneWidth       = 0.0f;
+    coneAngle       = 0.0f;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -133,7 +126,9 @@ SLRay::SLRay(SLfloat distToLight,
     sv              = rayFromHitPoint->sv;
     contrib         = 0.0f;
     isOutside       = rayFromHitPoint->isOutside;
-    shadowRays++;
+    coneWidth       = 0.0f;
+    coneAngle       = 0.0f;
+    SLRayStats::local().shadowRays++;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -180,13 +175,16 @@ void SLRay::reflect(SLRay* reflected)
     reflected->x           = x;
     reflected->y           = y;
     reflected->sv          = sv;
+    reflected->coneWidth   = coneWidth + coneAngle * length;
+    reflected->coneAngle   = coneAngle;
     if (sv->skybox())
         reflected->backgroundColor = sv->skybox()->colorAtDir(reflected->dir);
     else
         reflected->backgroundColor = backgroundColor;
 
-    depthReached = reflected->depth;
-    ++reflectedRays;
+    SLRayStats& stats  = SLRayStats::local();
+    stats.depthReached = SL_max(stats.depthReached, reflected->depth);
+    ++stats.reflectedRays;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -291,7 +289,7 @@ void SLRay::refract(SLRay* refracted)
             }
         }
 
-        ++refractedRays;
+        ++SLRayStats::local().refractedRays;
     }
     else // total internal refraction results in a internal reflected ray
     {
@@ -299,7 +297,7 @@ void SLRay::refract(SLRay* refracted)
         refracted->contrib   = 1.0f;
         refracted->type      = REFLECTED;
         refracted->isOutside = isOutside; // remain inside
-        ++tirRays;
+        ++SLRayStats::local().tirRays;
     }
 
     refracted->setDir(T);
@@ -312,11 +310,14 @@ void SLRay::refract(SLRay* refracted)
     refracted->x           = x;
     refracted->y           = y;
     refracted->sv          = sv;
+    refracted->coneWidth   = coneWidth + coneAngle * length;
+    refracted->coneAngle   = coneAngle;
     if (sv->skybox())
         refracted->backgroundColor = sv->skybox()->colorAtDir(refracted->dir);
     else
         refracted->backgroundColor = backgroundColor;
-    depthReached = refracted->depth;
+    SLRayStats& stats  = SLRayStats::local();
+    stats.depthReached = SL_max(stats.depthReached, refracted->depth);
 
 #ifdef DEBUG_RAY
     cout << hitMesh->name();
@@ -350,8 +351,9 @@ bool SLRay::reflectMC(SLRay* reflected, SLMat3f rotMat)
     SLfloat shininess = hitMesh->mat()->shininess();
 
     //scatter within specular lobe
-    eta1       = rnd01();
-    eta2       = SL_2PI * rnd01();
+    SLVec2f eta = SLSampler::local().get2D();
+    eta1        = eta.x;
+    eta2        = SL_2PI * eta.y;
     SLfloat f1 = sqrt(1.0f - pow(eta1, 2.0f / (shininess + 1.0f)));
 
     //tranform to cartesian
@@ -402,8 +404,9 @@ void SLRay::refractMC(SLRay* refracted, SLMat3f rotMat)
     SLfloat translucency = hitMesh->mat()->translucency();
 
     //scatter within transmissive lobe
-    eta1       = rnd01();
-    eta2       = SL_2PI * rnd01();
+    SLVec2f eta = SLSampler::local().get2D();
+    eta1        = eta.x;
+    eta2        = SL_2PI * eta.y;
     SLfloat f1 = sqrt(1.0f - pow(eta1, 2.0f / (translucency + 1.0f)));
 
     //transform to cartesian
@@ -448,7 +451,9 @@ void SLRay::diffuseMC(SLRay* scattered)
     scattered->setDir(hitNormal);
     scattered->origin = hitPoint;
     scattered->depth  = depth + 1;
-    depthReached      = scattered->depth;
+
+    SLRayStats& stats  = SLRayStats::local();
+    stats.depthReached = SL_max(stats.depthReached, scattered->depth);
 
     // for reflectance the start material stays the same
     scattered->srcNode = hitNode;
@@ -462,8 +467,9 @@ void SLRay::diffuseMC(SLRay* scattered)
     rotMat.rotation(rotAngle * 180.0f / SL_PI, rotAxis);
 
     //cosine distribution
-    eta1     = rnd01();
-    eta2     = SL_2PI * rnd01();
+    SLVec2f eta = SLSampler::local().get2D();
+    eta1        = eta.x;
+    eta2        = SL_2PI * eta.y;
     eta1sqrt = sqrt(1 - eta1);
 
     //transform to cartesian
@@ -0,0 +1,177 @@
+//#############################################################################
+//  File:      SLRayPacket.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#include <SLRay.h>
+#include <SLRayPacket.h>
+
+//-----------------------------------------------------------------------------
+SLRayPacket::SLRayPacket()
+{
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        rays[i]   = nullptr;
+        length[i] = -FLT_MAX;
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Copies the world space origins and directions of up to SL_PACKET_SIZE
+rays into the SoA arrays. Unused slots become inactive rays with a negative
+length that never hit anything.
+*/
+void SLRayPacket::set(SLRay** r, SLint numRays)
+{
+    assert(numRays <= SL_PACKET_SIZE);
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        SLRay* ray = i < numRays ? r[i] : nullptr;
+        rays[i]    = ray;
+
+        if (ray)
+        {
+            ox[i]     = ray->origin.x;
+            oy[i]     = ray->origin.y;
+            oz[i]     = ray->origin.z;
+            dx[i]     = ray->dir.x;
+            dy[i]     = ray->dir.y;
+            dz[i]     = ray->dir.z;
+            ix[i]     = ray->invDir.x;
+            iy[i]     = ray->invDir.y;
+            iz[i]     = ray->invDir.z;
+            length[i] = ray->length;
+        }
+        else
+        {
+            ox[i] = oy[i] = oz[i] = 0.0f;
+            dx[i] = dy[i] = dz[i] = 1.0f;
+            ix[i] = iy[i] = iz[i] = 1.0f;
+            length[i]             = -FLT_MAX;
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Transforms all rays into the object space with the inverse world matrix
+of a node. The origin is transformed as point, the direction only with the
+linear 3x3 sub matrix (see also SLNode::hitMeshes).
+*/
+void SLRayPacket::toOS(const SLMat4f& wmI)
+{
+    const SLfloat m0 = wmI.m(0), m4 = wmI.m(4), m8 = wmI.m(8), m12 = wmI.m(12);
+    const SLfloat m1 = wmI.m(1), m5 = wmI.m(5), m9 = wmI.m(9), m13 = wmI.m(13);
+    const SLfloat m2 = wmI.m(2), m6 = wmI.m(6), m10 = wmI.m(10), m14 = wmI.m(14);
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        oxOS[i] = m0 * ox[i] + m4 * oy[i] + m8 * oz[i] + m12;
+        oyOS[i] = m1 * ox[i] + m5 * oy[i] + m9 * oz[i] + m13;
+        ozOS[i] = m2 * ox[i] + m6 * oy[i] + m10 * oz[i] + m14;
+        dxOS[i] = m0 * dx[i] + m4 * dy[i] + m8 * dz[i];
+        dyOS[i] = m1 * dx[i] + m5 * dy[i] + m9 * dz[i];
+        dzOS[i] = m2 * dx[i] + m6 * dy[i] + m10 * dz[i];
+        ixOS[i] = 1.0f / dxOS[i];
+        iyOS[i] = 1.0f / dyOS[i];
+        izOS[i] = 1.0f / dzOS[i];
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Copies the object space origin and direction of ray i back into its SLRay
+for the scalar fallback of meshes or nodes without packet support.
+*/
+void SLRayPacket::toRayOS(SLint i)
+{
+    SLRay* ray = rays[i];
+    assert(ray);
+    ray->originOS.set(oxOS[i], oyOS[i], ozOS[i]);
+    ray->setDirOS(SLVec3f(dxOS[i], dyOS[i], dzOS[i]));
+}
+//-----------------------------------------------------------------------------
+//! Returns the NO. of active rays in the packet
+SLint SLRayPacket::numActive() const
+{
+    SLint num = 0;
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+        if (rays[i]) num++;
+    return num;
+}
+//-----------------------------------------------------------------------------
+/*! Slab test of all rays against an AABB in world space. Returns true if at
+least one ray hits the box in front of its closest hit. tNear returns the
+smallest entry distance of all hitting rays.
+*/
+SLbool SLRayPacket::hitAABBInWS(const SLVec3f& min,
+                                const SLVec3f& max,
+                                SLfloat&       tNear) const
+{
+    SLfloat tEnter[SL_PACKET_SIZE];
+    SLint   hit[SL_PACKET_SIZE];
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        SLfloat tx1  = (min.x - ox[i]) * ix[i];
+        SLfloat tx2  = (max.x - ox[i]) * ix[i];
+        SLfloat ty1  = (min.y - oy[i]) * iy[i];
+        SLfloat ty2  = (max.y - oy[i]) * iy[i];
+        SLfloat tz1  = (min.z - oz[i]) * iz[i];
+        SLfloat tz2  = (max.z - oz[i]) * iz[i];
+        SLfloat tmin = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2));
+        SLfloat tmax = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+        tEnter[i]    = tmin;
+        hit[i]       = tmin <= tmax && tmax > 0.0f && tmin < length[i];
+    }
+
+    SLbool anyHit = false;
+    tNear         = FLT_MAX;
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        if (hit[i])
+        {
+            anyHit = true;
+            tNear  = std::min(tNear, tEnter[i]);
+        }
+    }
+    return anyHit;
+}
+//-----------------------------------------------------------------------------
+//! Slab test of all rays in object space (see hitAABBInWS)
+SLbool SLRayPacket::hitAABBInOS(const SLVec3f& min,
+                                const SLVec3f& max,
+                                SLfloat&       tNear) const
+{
+    SLfloat tEnter[SL_PACKET_SIZE];
+    SLint   hit[SL_PACKET_SIZE];
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        SLfloat tx1  = (min.x - oxOS[i]) * ixOS[i];
+        SLfloat tx2  = (max.x - oxOS[i]) * ixOS[i];
+        SLfloat ty1  = (min.y - oyOS[i]) * iyOS[i];
+        SLfloat ty2  = (max.y - oyOS[i]) * iyOS[i];
+        SLfloat tz1  = (min.z - ozOS[i]) * izOS[i];
+        SLfloat tz2  = (max.z - ozOS[i]) * izOS[i];
+        SLfloat tmin = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2));
+        SLfloat tmax = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+        tEnter[i]    = tmin;
+        hit[i]       = tmin <= tmax && tmax > 0.0f && tmin < length[i];
+    }
+
+    SLbool anyHit = false;
+    tNear         = FLT_MAX;
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+    {
+        if (hit[i])
+        {
+            anyHit = true;
+            tNear  = std::min(tNear, tEnter[i]);
+        }
+    }
+    return anyHit;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+//#############################################################################
+//  File:      SLRayStats.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLRayStats.h>
+#include <mutex>
+
+//-----------------------------------------------------------------------------
+//! Registry of the stats blocks of all living threads
+struct SLRayStatsRegistry
+{
+    std::mutex          mutex;   //!< Protects the registration only
+    vector<SLRayStats*> blocks;  //!< Blocks of the living threads
+    SLRayStats          retired; //!< Sum of the blocks of finished threads
+};
+//-----------------------------------------------------------------------------
+static SLRayStatsRegistry& registry()
+{
+    static SLRayStatsRegistry reg;
+    return reg;
+}
+//-----------------------------------------------------------------------------
+//! Thread local holder that registers its block for the lifetime of a thread
+struct alignas(64) SLRayStatsSlot
+{
+    SLRayStatsSlot()
+    {
+        SLRayStatsRegistry&         reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.blocks.push_back(&stats);
+    }
+    ~SLRayStatsSlot()
+    {
+        SLRayStatsRegistry&         reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.retired.add(stats);
+        reg.blocks.erase(std::remove(reg.blocks.begin(),
+                                     reg.blocks.end(),
+                                     &stats),
+                         reg.blocks.end());
+    }
+
+    SLRayStats stats;
+};
+//-----------------------------------------------------------------------------
+void SLRayStats::reset()
+{
+    primaryRays      = 0;
+    reflectedRays    = 0;
+    refractedRays    = 0;
+    ignoredRays      = 0;
+    shadowRays       = 0;
+    occluderHits     = 0;
+    tirRays          = 0;
+    subsampledRays   = 0;
+    subsampledPixels = 0;
+    tests            = 0;
+    intersections    = 0;
+    depthReached     = 1;
+    maxDepthReached  = 0;
+    depthSum         = 0;
+
+    for (SLint i = 0; i < SL_RAYSTATS_DEPTH_BINS; ++i)
+        depthHistogram[i] = 0;
+}
+//-----------------------------------------------------------------------------
+//! Adds the counters of another block
+void SLRayStats::add(const SLRayStats& other)
+{
+    primaryRays += other.primaryRays;
+    reflectedRays += other.reflectedRays;
+    refractedRays += other.refractedRays;
+    ignoredRays += other.ignoredRays;
+    shadowRays += other.shadowRays;
+    occluderHits += other.occluderHits;
+    tirRays += other.tirRays;
+    subsampledRays += other.subsampledRays;
+    subsampledPixels += other.subsampledPixels;
+    tests += other.tests;
+    intersections += other.intersections;
+    depthSum += other.depthSum;
+    maxDepthReached = SL_max(maxDepthReached, other.maxDepthReached);
+
+    for (SLint i = 0; i < SL_RAYSTATS_DEPTH_BINS; ++i)
+        depthHistogram[i] += other.depthHistogram[i];
+}
+//-----------------------------------------------------------------------------
+/*! Must be called after a primary ray with all its secondary rays got traced.
+It records the depth reached into the histogram and resets it for the next
+primary ray.
+*/
+void SLRayStats::primaryDone()
+{
+    primaryRays++;
+    depthSum += (SLuint64)depthReached;
+    maxDepthReached = SL_max(maxDepthReached, depthReached);
+
+    SLint bin = SL_min(SL_max(depthReached, 1), SL_RAYSTATS_DEPTH_BINS) - 1;
+    depthHistogram[bin]++;
+
+    depthReached = 1;
+}
+//-----------------------------------------------------------------------------
+//! Returns the total NO. of rays
+SLuint SLRayStats::totalRays() const
+{
+    return primaryRays +
+           reflectedRays +
+           refractedRays +
+           subsampledRays +
+           shadowRays;
+}
+//-----------------------------------------------------------------------------
+//! Returns the average NO. of intersection tests per ray
+SLfloat SLRayStats::testsPerRay() const
+{
+    SLuint total = totalRays();
+    return total ? (SLfloat)tests / (SLfloat)total : 0.0f;
+}
+//-----------------------------------------------------------------------------
+//! Returns the average depth reached per primary ray
+SLfloat SLRayStats::avgDepth() const
+{
+    return primaryRays ? (SLfloat)depthSum / (SLfloat)primaryRays : 0.0f;
+}
+//-----------------------------------------------------------------------------
+/*! Returns the stats block of the calling thread. The block gets created and
+registered on the first call of a thread. Afterwards this is only a thread
+local access without any locking.
+*/
+SLRayStats& SLRayStats::local()
+{
+    thread_local SLRayStatsSlot slot;
+    return slot.stats;
+}
+//-----------------------------------------------------------------------------
+/*! Returns the sum of the blocks of all threads. This must only be called if
+no render thread is running (e.g. after the threads of a frame got joined).
+*/
+SLRayStats SLRayStats::merged()
+{
+    SLRayStatsRegistry&         reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    SLRayStats sum(reg.retired);
+    for (auto block : reg.blocks)
+        sum.add(*block);
+    return sum;
+}
+//-----------------------------------------------------------------------------
+//! Resets the blocks of all threads before a new frame gets rendered
+void SLRayStats::resetAll()
+{
+    SLRayStatsRegistry&         reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    reg.retired.reset();
+    for (auto block : reg.blocks)
+        block->reset();
+}
+//-----------------------------------------------------------------------------
@@ -13,7 +13,6 @@
 #    include <debug_new.h> // memory leak detector
 #endif
 
-using namespace std::placeholders;
 using namespace std::chrono;
 
 #include <SLApplication.h>
@@ -21,12 +20,15 @@ using namespace std::chrono;
 #include <SLLightRect.h>
 #include <SLLightSpot.h>
 #include <SLRay.h>
+#include <SLRayPacket.h>
+#include <SLRayStats.h>
 #include <SLRaytracer.h>
+#include <SLSampler.h>
 #include <SLSceneView.h>
 #include <SLText.h>
 
 //-----------------------------------------------------------------------------
-SLRaytracer::SLRaytracer()
+SLRaytracer::SLRaytracer() : _pool(SLRenderPool::render())
 {
     name("myCoolRaytracer");
 
@@ -34,9 +36,16 @@ SLRaytracer::SLRaytracer()
     _doDistributed = true;
     _doContinuous  = false;
     _doFresnel     = false;
+    _doPackets     = false;
+    _doProgressive = false;
     _maxDepth      = 5;
     _aaThreshold   = 0.3f; // = 10% color difference
     _aaSamples     = 3;
+    _numThreads    = 0;
+    _progPass      = -1;
+    _progTile      = 0;
+    _frameBudgetMS = 40.0f;
+    _varThreshold  = 0.01f; // = 2.5 of 255 luminance levels
     gamma(1.0f);
 
     // set texture properties
@@ -54,12 +63,13 @@ SLRaytracer::~SLRaytracer()
 //-----------------------------------------------------------------------------
 /*!
 This is the main rendering method for the classic ray tracing. It loops over all 
-lines and pixels and determines for each pixel a color with a partly global 
-illumination calculation.
+tiles and pixels and determines for each pixel a color with a partly global 
+illumination calculation. The tiles are rendered only by the calling thread.
 */
 SLbool SLRaytracer::renderClassic(SLSceneView* sv)
 {
     _sv         = sv;
+    _progPass   = -1;                       // No progressive pass is running
     _state      = rtBusy;                   // From here we state the RT as busy
     _stateGL    = SLGLState::getInstance(); // OpenGL state shortcut
     _pcRendered = 0;                        // % rendered
@@ -69,46 +79,25 @@ SLbool SLRaytracer::renderClassic(SLSceneView* sv)
     prepareImage();       // Setup image & precalculations
 
     // Measure time
-    double  t1           = SLApplication::scene->timeSec();
-    double  tStart       = t1;
-
-    for (SLuint y = 0; y < _images[0]->height(); ++y)
-    {
-        for (SLuint x = 0; x < _images[0]->width(); ++x)
-        {
-            SLRay primaryRay(_sv);
-            setPrimaryRay((SLfloat)x, (SLfloat)y, &primaryRay);
-
-#ifdef DEBUG_RAY
-            cout << "\nRay(" << x << "," << y << "):" << endl;
-#endif
-
-            ///////////////////////////////////
-            SLCol4f color = trace(&primaryRay);
-            ///////////////////////////////////
-
-            color.gammaCorrect(_oneOverGamma);
-
-            _images[0]->setPixeliRGB((SLint)x, (SLint)y, color);
-
-            SLRay::avgDepth += SLRay::depthReached;
-            SLRay::maxDepthReached = SL_max(SLRay::depthReached,
-                                            SLRay::maxDepthReached);
-        }
-
-        // Update image after 500 ms
-        double t2 = SLApplication::scene->timeSec();
-        if (t2 - t1 > 0.5)
-        {
-            _pcRendered = (SLint)((SLfloat)y / (SLfloat)_images[0]->height() * 100);
-            finishBeforeUpdate();
-            _sv->onWndUpdate();
-            t1 = SLApplication::scene->timeSec();
-        }
-    }
+    double tStart = SLApplication::scene->timeSec();
+    _tUpdate      = tStart;
+
+    SLRenderPool::hilbertTiles((SLint)_images[0]->width(),
+                               (SLint)_images[0]->height(),
+                               SL_RENDER_TILE_SIZE,
+                               _tiles);
+
+    // Render all tiles in the calling thread only
+    _pool.run((SLuint)_tiles.size(),
+              [this](SLuint task, SLuint worker) {
+                  renderTile(_tiles[task], worker);
+                  updateWindow(worker, 0, 100);
+              },
+              1);
 
     _renderSec  = (SLfloat)(SLApplication::scene->timeSec() - tStart);
     _pcRendered = 100;
+    _stats      = SLRayStats::merged();
 
     if (_doContinuous)
         _state = rtReady;
@@ -122,10 +111,13 @@ SLbool SLRaytracer::renderClassic(SLSceneView* sv)
 //-----------------------------------------------------------------------------
 /*!
 This is the main rendering method for parallel and distributed ray tracing.
+The image is divided into tiles that are rendered by the persistent threads
+of the render pool (see SLRenderPool).
 */
 SLbool SLRaytracer::renderDistrib(SLSceneView* sv)
 {
     _sv         = sv;
+    _progPass   = -1;                       // No progressive pass is running
     _state      = rtBusy;                   // From here we state the RT as busy
     _stateGL    = SLGLState::getInstance(); // OpenGL state shortcut
     _pcRendered = 0;                        // % rendered
@@ -136,50 +128,49 @@ SLbool SLRaytracer::renderDistrib(SLSceneView* sv)
 
     // Measure time
     double t1 = SLApplication::scene->timeSec();
-
-    // Bind render functions to be called multithreaded
-    auto sampleAAPixelsFunction = bind(&SLRaytracer::sampleAAPixels, this, _1);
-    auto renderSlicesFunction   = _cam->lensSamples()->samples() == 1
-                                  ? bind(&SLRaytracer::renderSlices, this, _1)
-                                  : bind(&SLRaytracer::renderSlicesMS, this, _1);
-
-    // Do multithreading only in release config
-    // Render image without antialiasing
-    vector<thread> threads; // vector for additional threads
-    _next = 0;              // init _next=0. _next should be atomic
-
-    // Start additional threads on the renderSlices function
-    for (SLuint t = 0; t < SL::maxThreads() - 1; t++)
-        threads.push_back(thread(renderSlicesFunction, false));
-
-    // Do the same work in the main thread
-    renderSlicesFunction(true);
-
-    // Wait for the other threads to finish
-    for (auto& thread : threads)
-        thread.join();
+    _tUpdate  = t1;
+
+    SLRenderPool::hilbertTiles((SLint)_images[0]->width(),
+                               (SLint)_images[0]->height(),
+                               SL_RENDER_TILE_SIZE,
+                               _tiles);
+
+    // Render image without antialiasing (renderTileMS does its own AA)
+    SLbool doLensDOF = _cam->lensSamples()->samples() > 1;
+    SLbool doAA      = !_doContinuous && _aaSamples > 1 && !doLensDOF;
+    SLint  pcRange   = doAA ? 50 : 100;
+
+    _pool.run((SLuint)_tiles.size(),
+              [this, doLensDOF, pcRange](SLuint task, SLuint worker) {
+                  if (doLensDOF)
+                      renderTileMS(_tiles[task], worker);
+                  else
+                      renderTile(_tiles[task], worker);
+                  updateWindow(worker, 0, pcRange);
+              },
+              _numThreads);
 
     // Do anti-aliasing w. contrast compare in a 2nd. pass
-    if (!_doContinuous && _aaSamples > 1)
+    if (doAA)
     {
-        getAAPixels();          // Fills in the AA pixels by contrast
-        vector<thread> threads; // vector for additional threads
-        _next = 0;              // init _next=0. _next should be atomic
-
-        // Start additional threads on the sampleAAPixelFunction function
-        for (SLuint t = 0; t < SL::maxThreads() - 1; t++)
-            threads.push_back(thread(sampleAAPixelsFunction, false));
-
-        // Do the same work in the main thread
-        sampleAAPixelsFunction(true);
-
-        // Wait for the other threads to finish
-        for (auto& thread : threads)
-            thread.join();
+        getAAPixels(); // Fills in the AA pixels by contrast
+
+        const SLuint chunk    = 64; // NO. of AA pixels per task
+        SLuint       numTasks = ((SLuint)_aaPixels.size() + chunk - 1) / chunk;
+
+        _pool.run(numTasks,
+                  [this, chunk](SLuint task, SLuint worker) {
+                      SLuint first = task * chunk;
+                      SLuint last  = SL_min(first + chunk, (SLuint)_aaPixels.size());
+                      sampleAAPixels(first, last);
+                      updateWindow(worker, 50, 50);
+                  },
+                  _numThreads);
     }
 
     _renderSec  = (SLfloat)(SLApplication::scene->timeSec() - t1);
     _pcRendered = 100;
+    _stats      = SLRayStats::merged(); // all render tasks are finished here
 
     if (_doContinuous)
         _state = rtReady;
@@ -192,149 +183,466 @@ SLbool SLRaytracer::renderDistrib(SLSceneView* sv)
 }
 //-----------------------------------------------------------------------------
 /*!
-Renders slices of 4 rows until the full width of the image is rendered. This
-method can be called as a function by multiple threads.
-The _next index is used and incremented by every thread. So it should be locked
-or an atomic index. I prefer not protecting it because it's faster. If the
-increment is not done properly some pixels may get ray traced twice. Only the
-main thread is allowed to call a repaint of the image.
+Does one step of the progressive ray tracing and returns true if further steps
+are needed. Other than renderClassic and renderDistrib this method returns
+after the frame budget (_frameBudgetMS) so that the window system can process
+its events between the steps. A camera move stops the progressive RT between
+two steps (see SLSceneView::onMouseMove). The image is refined in passes:
+- Pass 0 renders a coarse preview with one ray per block of 4x4 pixels.
+- Pass 1 traces one ray through the center of all other pixels.
+- Pass 2 adds a sample to all pixels with a contrast to their neighbors above
+  _aaThreshold (or to all pixels if depth of field is on).
+- Pass 3 and higher add a sample to all pixels whose standard error of the
+  mean luminance is above _varThreshold.
+The RT is finished if no pixel needs to be refined anymore or all pixels got
+the max. NO. of samples (_aaSamples^2 or the NO. of lens samples).
 */
-void SLRaytracer::renderSlices(const bool isMainThread)
+SLbool SLRaytracer::renderProgressive(SLSceneView* sv)
 {
-    // Time points
-    double  t1           = 0;
+    SLScene* s = SLApplication::scene;
 
-    while (_next < (SLint)_images[0]->height())
+    // Start a new progressive RT
+    if (_state != rtBusy || _progPass < 0)
     {
-        const SLint minY = _next;
+        _sv         = sv;
+        _state      = rtBusy;
+        _stateGL    = SLGLState::getInstance();
+        _pcRendered = 0;
+        _renderSec  = 0.0f;
+
+        initStats(_maxDepth);
+        prepareImage();
+
+        SLint w = (SLint)_images[0]->width();
+        SLint h = (SLint)_images[0]->height();
+        SLRenderPool::hilbertTiles(w, h, SL_RENDER_TILE_SIZE, _tiles);
+
+        size_t numPixels = (size_t)w * (size_t)h;
+        _progSum.assign(numPixels, SLCol3f::BLACK);
+        _progSumSq.assign(numPixels, 0.0f);
+        _progNum.assign(numPixels, 0);
+        _progRefine.assign(numPixels, 0);
+
+        _progMaxSamples = SL_max(_aaSamples * _aaSamples,
+                                 (SLint)_cam->lensSamples()->samples());
+        _progPass       = 0;
+        _progTile       = 0;
+        _progMSPerTile  = 0.0f;
+        _progStart      = s->timeSec();
+    }
+
+    double tStep    = s->timeSec();
+    SLuint numTiles = (SLuint)_tiles.size();
+
+    while (_progPass >= 0)
+    {
+        SLfloat elapsedMS = (SLfloat)(s->timeSec() - tStep) * 1000.0f;
 
-        // The next line should be atomic
-        _next += 4;
+        // The coarse preview is always finished within the first step
+        if (_progPass > 0 && elapsedMS >= _frameBudgetMS) break;
 
-        for (SLint y = minY; y < minY + 4; ++y)
+        // Flag the pixels to refine before a refinement pass
+        if (_progPass >= 2 && _progTile == 0)
         {
-            for (SLuint x = 0; x < _images[0]->width(); ++x)
+            SLuint numRefine = markRefinePixels(_progPass);
+            if (numRefine == 0 || _progPass > _progMaxSamples)
             {
-                SLRay primaryRay(_sv);
-                setPrimaryRay((SLfloat)x, (SLfloat)y, &primaryRay);
+                _progPass = -1;
+                break;
+            }
+            SLRayStats::local().subsampledPixels += numRefine;
+        }
 
-                ///////////////////////////////////
-                SLCol4f color = trace(&primaryRay);
-                ///////////////////////////////////
+        // Estimate the NO. of tiles that fit into the rest of the budget. The
+        // first batch of a pass renders one tile per worker to measure it.
+        SLuint numWorkers = numThreads();
+        SLuint numLeft    = numTiles - _progTile;
+        SLuint batch      = numLeft;
+        if (_progPass > 0)
+        {
+            if (_progTile == 0 || _progMSPerTile <= 0.0f)
+                batch = numWorkers;
+            else
+                batch = (SLuint)((_frameBudgetMS - elapsedMS) /
+                                 _progMSPerTile * (SLfloat)numWorkers);
+            batch = SL_min(SL_max(batch, numWorkers), numLeft);
+        }
 
-                color.gammaCorrect(_oneOverGamma);
+        double tBatch = s->timeSec();
+        SLuint first  = _progTile;
+        SLint  pass   = _progPass;
+
+        _pool.run(batch,
+                  [this, first, pass](SLuint task, SLuint worker) {
+                      renderTileProgressive(_tiles[first + task], pass);
+                  },
+                  _numThreads);
+
+        SLfloat batchMS = (SLfloat)(s->timeSec() - tBatch) * 1000.0f;
+        _progMSPerTile  = batchMS * (SLfloat)numWorkers / (SLfloat)batch;
+        _progTile += batch;
+
+        // Percentage of the passes 0 & 1 and estimated part of the refinement
+        if (_progPass <= 1)
+            _pcRendered = (SLint)(50.0f * ((SLfloat)_progPass +
+                                           (SLfloat)_progTile / numTiles) /
+                                  2.0f);
+        else
+            _pcRendered = SL_min(50 + 50 * (_progPass - 1) / _progMaxSamples, 99);
+
+        if (_progTile >= numTiles)
+        {
+            _progTile = 0;
+            _progPass++;
+        }
+    }
 
-                _images[0]->setPixeliRGB((SLint)x, (SLint)y, color);
+    // Finished: No pixel needs more samples
+    if (_progPass < 0)
+    {
+        _renderSec  = (SLfloat)(s->timeSec() - _progStart);
+        _pcRendered = 100;
+        _stats      = SLRayStats::merged();
+        _state      = rtFinished;
+        printStats(_renderSec);
+        return false;
+    }
 
-                SLRay::avgDepth += SLRay::depthReached;
-                SLRay::maxDepthReached = SL_max(SLRay::depthReached,
-                                                SLRay::maxDepthReached);
-            }
+    return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Renders one progressive pass (see renderProgressive) of a tile. This method is
+called by the workers of the render pool. The tiles are aligned to a multiple
+of 4 pixels so that the 4x4 blocks of the preview pass never cross a tile.
+*/
+void SLRaytracer::renderTileProgressive(const SLRenderTile& tile, SLint pass)
+{
+    SLint w    = (SLint)_images[0]->width();
+    SLint maxX = tile.x + tile.w;
+    SLint maxY = tile.y + tile.h;
+
+    SLLight::newShadowTile();
 
-            // Update image after 500 ms
-            if (isMainThread && !_doContinuous)
+    if (pass == 0)
+    {
+        for (SLint y = tile.y; y < maxY; y += 4)
+        {
+            for (SLint x = tile.x; x < maxX; x += 4)
             {
-                if (SLApplication::scene->timeSec() - t1 > 0.5)
-                {
-                    _pcRendered = (SLint)((SLfloat)y /
-                                          (SLfloat)_images[0]->height() * 100);
-                    if (_aaSamples > 0) _pcRendered /= 2;
-                    finishBeforeUpdate();
-                    _sv->onWndUpdate();
-                    t1 = SLApplication::scene->timeSec();
-                }
+                SLCol4f color = traceSample(x, y, 0);
+                addSample(x, y, color);
+
+                color.gammaCorrect(_oneOverGamma);
+                for (SLint by = y; by < y + 4 && by < maxY; ++by)
+                    for (SLint bx = x; bx < x + 4 && bx < maxX; ++bx)
+                        _images[0]->setPixeliRGB(bx, by, color);
             }
         }
+        return;
+    }
+
+    for (SLint y = tile.y; y < maxY; ++y)
+    {
+        for (SLint x = tile.x; x < maxX; ++x)
+        {
+            size_t i = (size_t)y * (size_t)w + (size_t)x;
+
+            if (pass == 1 ? _progNum[i] > 0 : !_progRefine[i])
+                continue;
+
+            SLCol4f color = traceSample(x, y, _progNum[i]);
+            addSample(x, y, color);
+            if (pass > 1) SLRayStats::local().subsampledRays++;
+        }
     }
 }
 //-----------------------------------------------------------------------------
 /*!
-Renders slices of 4 rows multisampled until the full width of the image is
-rendered. Every pixel is multisampled for depth of field lens sampling. This
-method can be called as a function by multiple threads.
-The _next index is used and incremented by every thread. So it should be locked
-or an atomic index. I prefer not protecting it because it's faster. If the
-increment is not done properly some pixels may get ray traced twice. Only the
-main thread is allowed to call a repaint of the image.
+Traces the sample with the index sample through the pixel x, y and returns
+its linear color. Sample 0 goes through the pixel center like in renderTile.
+The other samples are jittered with the low discrepancy R2 sequence over the
+pixel area. With depth of field the samples also loop over the lens samples.
 */
-void SLRaytracer::renderSlicesMS(const bool isMainThread)
+SLCol4f SLRaytracer::traceSample(SLint x, SLint y, SLint sample)
 {
-    // Time points
-    double t1 = 0;
+    SLfloat px = (SLfloat)x;
+    SLfloat py = (SLfloat)y;
 
-    // lens sampling constants
-    SLVec3f lensRadiusX = _LR * (_cam->lensDiameter() * 0.5f);
-    SLVec3f lensRadiusY = _LU * (_cam->lensDiameter() * 0.5f);
+    if (sample > 0)
+    {
+        px += fmod(0.5f + (SLfloat)sample * 0.7548777f, 1.0f) - 0.5f;
+        py += fmod(0.5f + (SLfloat)sample * 0.5698403f, 1.0f) - 0.5f;
+    }
+
+    SLRay primaryRay(_sv);
 
-    while (_next < (SLint)_images[0]->width())
+    if (_cam->lensSamples()->samples() > 1)
     {
-        const SLint minY = _next;
+        SLuint  numY = _cam->lensSamples()->samplesY();
+        SLuint  iLen = (SLuint)sample % _cam->lensSamples()->samples();
+        SLVec2f disc(_cam->lensSamples()->point(iLen / numY, iLen % numY));
+        setLensRay(px, py, disc, &primaryRay);
+    }
+    else
+        setPrimaryRay(px, py, &primaryRay);
 
-        // The next line should be atomic
-        _next += 4;
+    SLCol4f color = trace(&primaryRay);
+    SLRayStats::local().primaryDone();
+    return color;
+}
+//-----------------------------------------------------------------------------
+/*!
+Adds the linear color of a sample to the accumulation buffers of the pixel
+x, y and writes the gamma corrected mean into the image.
+*/
+void SLRaytracer::addSample(SLint x, SLint y, const SLCol4f& color)
+{
+    size_t  i   = (size_t)y * _images[0]->width() + (size_t)x;
+    SLfloat lum = 0.299f * color.r + 0.587f * color.g + 0.114f * color.b;
 
-        for (SLint y = minY; y < minY + 4; ++y)
-        {
-            for (SLuint x = 0; x < _images[0]->width(); ++x)
-            {
-                // focal point is single shot primary dir
-                SLVec3f primaryDir(_BL + _pxSize * ((SLfloat)x * _LR + (SLfloat)y * _LU));
-                SLVec3f FP = _EYE + primaryDir;
-                SLCol4f color(SLCol4f::BLACK);
+    _progSum[i] += color.vec3();
+    _progSumSq[i] += lum * lum;
+    _progNum[i]++;
 
-                // Loop over radius r and angle phi of lens
-                for (SLint iR = (SLint)_cam->lensSamples()->samplesX() - 1; iR >= 0; --iR)
-                {
-                    for (SLint iPhi = (SLint)_cam->lensSamples()->samplesY() - 1; iPhi >= 0; --iPhi)
-                    {
-                        SLVec2f discPos(_cam->lensSamples()->point((SLuint)iR, (SLuint)iPhi));
+    SLCol3f mean(_progSum[i] / (SLfloat)_progNum[i]);
+    SLCol4f pixel(mean.r, mean.g, mean.b, 1.0f);
+    pixel.gammaCorrect(_oneOverGamma);
+    _images[0]->setPixeliRGB(x, y, pixel);
+}
+//-----------------------------------------------------------------------------
+/*!
+Flags the pixels that get another sample in the refinement pass and returns
+their NO.. In pass 2 every pixel has one sample and the contrast to the 4
+neighbors is used as in getAAPixels. From pass 3 on the standard error of the
+mean luminance is used, which can be estimated from 2 and more samples.
+*/
+SLuint SLRaytracer::markRefinePixels(SLint pass)
+{
+    SLint               w         = (SLint)_images[0]->width();
+    SLint               h         = (SLint)_images[0]->height();
+    SLbool              doLensDOF = _cam->lensSamples()->samples() > 1;
+    std::atomic<SLuint> numRefine(0);
+
+    _pool.run((SLuint)h,
+              [&](SLuint row, SLuint worker) {
+                  SLint  y     = (SLint)row;
+                  SLuint count = 0;
+
+                  for (SLint x = 0; x < w; ++x)
+                  {
+                      size_t i      = (size_t)y * (size_t)w + (size_t)x;
+                      SLint  n      = _progNum[i];
+                      SLbool refine = false;
+
+                      if (n > 0 && n < _progMaxSamples)
+                      {
+                          if (pass == 2)
+                          {
+                              SLCol4f color = _images[0]->getPixeli(x, y);
+                              auto    diff  = [&](SLint nx, SLint ny) {
+                                  return color.diffRGB(_images[0]->getPixeli(nx, ny)) > _aaThreshold;
+                              };
+                              refine = doLensDOF ||
+                                       (x > 0 && diff(x - 1, y)) ||
+                                       (x < w - 1 && diff(x + 1, y)) ||
+                                       (y > 0 && diff(x, y - 1)) ||
+                                       (y < h - 1 && diff(x, y + 1));
+                          }
+                          else if (n > 1)
+                          {
+                              SLCol3f& sum  = _progSum[i];
+                              SLfloat  mean = (0.299f * sum.r + 0.587f * sum.g + 0.114f * sum.b) / n;
+                              SLfloat  var  = SL_max(_progSumSq[i] / n - mean * mean, 0.0f);
+                              refine        = sqrt(var / n) > _varThreshold;
+                          }
+                      }
+
+                      _progRefine[i] = refine ? 1 : 0;
+                      if (refine) count++;
+                  }
+                  numRefine += count;
+              },
+              _numThreads);
+
+    return numRefine;
+}
+//-----------------------------------------------------------------------------
+/*!
+Renders all pixels of a tile. This method is called by the workers of the
+render pool. With packet tracing the tile is traced in blocks of 2x2 pixels
+(see renderPacket).
+*/
+void SLRaytracer::renderTile(const SLRenderTile& tile, SLuint worker)
+{
+    SLLight::newShadowTile();
 
-                        // calculate lens position out of disc position
-                        SLVec3f lensPos(_EYE + discPos.x * lensRadiusX + discPos.y * lensRadiusY);
-                        SLVec3f lensToFP(FP - lensPos);
-                        lensToFP.normalize();
+    // Packets are only traced with the scene BVH
+    if (_doPackets && SLApplication::scene->sceneBVH().isEnabled())
+    {
+        for (SLint y = tile.y; y < tile.y + tile.h; y += 2)
+            for (SLint x = tile.x; x < tile.x + tile.w; x += 2)
+                renderPacket(x, y, tile);
+        return;
+    }
+
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            SLRay primaryRay(_sv);
+            setPrimaryRay((SLfloat)x, (SLfloat)y, &primaryRay);
 
-                        SLCol4f backColor;
-                        if (_sv->skybox())
-                            backColor = _sv->skybox()->colorAtDir(lensToFP);
-                        else
-                            backColor = _sv->camera()->background().colorAtPos((SLfloat)x, (SLfloat)y);
+#ifdef DEBUG_RAY
+            cout << "\nRay(" << x << "," << y << "):" << endl;
+#endif
 
-                        SLRay primaryRay(lensPos, lensToFP, (SLfloat)x, (SLfloat)y, backColor, _sv);
+            ///////////////////////////////////
+            SLCol4f color = trace(&primaryRay);
+            ///////////////////////////////////
 
-                        ////////////////////////////
-                        color += trace(&primaryRay);
-                        ////////////////////////////
+            color.gammaCorrect(_oneOverGamma);
 
-                        SLRay::avgDepth += SLRay::depthReached;
-                        SLRay::maxDepthReached = SL_max(SLRay::depthReached,
-                                                        SLRay::maxDepthReached);
-                    }
-                }
-                color /= (SLfloat)_cam->lensSamples()->samples();
+            _images[0]->setPixeliRGB(x, y, color);
 
-                color.gammaCorrect(_oneOverGamma);
+            SLRayStats::local().primaryDone();
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Returns a stride close to n divided by the golden ratio that is coprime to n
+static SLuint coprimeStride(SLuint n)
+{
+    auto gcd = [](SLuint a, SLuint b) {
+        while (b)
+        {
+            SLuint t = a % b;
+            a        = b;
+            b        = t;
+        }
+        return a;
+    };
 
-                _images[0]->setPixeliRGB((SLint)x, y, color);
+    SLuint stride = SL_max((SLuint)((SLfloat)n * 0.618034f), (SLuint)1);
+    while (gcd(stride, n) != 1) stride++;
+    return stride;
+}
+//-----------------------------------------------------------------------------
+/*!
+Renders all pixels of a tile multisampled for depth of field. The lens samples
+and the anti-aliasing are done in one stratified sample loop per pixel with
+max(lens samples, aaSamples^2) samples:
+\n The subpixel positions follow the R2 low discrepancy sequence with a
+random rotation per pixel.
+\n The lens positions visit the ring and sector strata of the cameras lens
+samples (see SLSamples2D::stratumPoint) with a coprime stride from a random
+start per pixel and get jittered within their stratum.
+\n So the lens and subpixel samples are decorrelated and the noise of a given
+sample count is lower than with the fixed lens points at the pixel center.
+After SL_RT_MIN_MS_SAMPLES samples the loop stops early as soon as the
+standard error of the mean luminance is below _varThreshold. This method is
+called by the workers of the render pool.
+*/
+void SLRaytracer::renderTileMS(const SLRenderTile& tile, SLuint worker)
+{
+    SLSamples2D* lens       = _cam->lensSamples();
+    SLuint       numLens    = lens->samples();
+    SLuint       numY       = lens->samplesY();
+    SLuint       lensStride = coprimeStride(numLens);
+    SLint        numAA      = _doContinuous ? 1 : _aaSamples * _aaSamples;
+    SLint        maxSamples = SL_max((SLint)numLens, numAA);
+    SLint        minSamples = SL_min(maxSamples, SL_RT_MIN_MS_SAMPLES);
+    SLSampler&   sampler    = SLSampler::local();
+
+    SLLight::newShadowTile();
+
+    for (SLint y = tile.y; y < tile.y + tile.h; ++y)
+    {
+        for (SLint x = tile.x; x < tile.x + tile.w; ++x)
+        {
+            // random rotation of the sample sequences of this pixel
+            sampler.startPixel(x, y, 0);
+            SLVec2f rot       = sampler.get2D();
+            SLuint  lensStart = (SLuint)(sampler.get1D() * (SLfloat)numLens) % numLens;
 
-                SLRay::avgDepth += SLRay::depthReached;
-                SLRay::maxDepthReached = SL_max(SLRay::depthReached, SLRay::maxDepthReached);
-            }
+            SLCol3f sum(SLCol3f::BLACK);
+            SLfloat sumLum   = 0.0f;
+            SLfloat sumLumSq = 0.0f;
+            SLint   n        = 0;
 
-            if (isMainThread && !_doContinuous)
+            while (n < maxSamples)
             {
-                if (SLApplication::scene->timeSec() - t1 > 0.5)
+                // subpixel position of the R2 sequence
+                SLfloat px = (SLfloat)x + fmod(rot.x + (SLfloat)n * 0.7548777f, 1.0f) - 0.5f;
+                SLfloat py = (SLfloat)y + fmod(rot.y + (SLfloat)n * 0.5698403f, 1.0f) - 0.5f;
+
+                // jittered lens position in the next lens stratum
+                SLuint iLens = (lensStart + (SLuint)n * lensStride) % numLens;
+                sampler.startPixel(x, y, (SLuint)n + 1);
+                SLVec2f jitter = sampler.get2D();
+                SLVec2f disc   = lens->stratumPoint(iLens / numY,
+                                                  iLens % numY,
+                                                  jitter.x,
+                                                  jitter.y);
+
+                SLRay primaryRay(_sv);
+                setLensRay(px, py, disc, &primaryRay);
+
+                ////////////////////////////////////
+                SLCol4f color = trace(&primaryRay);
+                ////////////////////////////////////
+
+                SLRayStats::local().primaryDone();
+
+                SLfloat lum = 0.299f * color.r + 0.587f * color.g + 0.114f * color.b;
+                sum += color.vec3();
+                sumLum += lum;
+                sumLumSq += lum * lum;
+                n++;
+
+                // adaptive stop if the std. error of the mean luminance is low
+                if (n >= minSamples && n % 4 == 0)
                 {
-                    finishBeforeUpdate();
-                    _sv->onWndUpdate();
-                    t1 = SLApplication::scene->timeSec();
+                    SLfloat mean = sumLum / (SLfloat)n;
+                    SLfloat var  = SL_max(sumLumSq / (SLfloat)n - mean * mean, 0.0f);
+                    if (sqrt(var / (SLfloat)n) <= _varThreshold)
+                        break;
                 }
             }
+
+            if (n > 1)
+                SLRayStats::local().subsampledRays += (SLuint)n - 1;
+
+            SLCol3f mean(sum / (SLfloat)n);
+            SLCol4f color(mean.r, mean.g, mean.b, 1.0f);
+            color.gammaCorrect(_oneOverGamma);
+
+            _images[0]->setPixeliRGB(x, y, color);
         }
     }
 }
 //-----------------------------------------------------------------------------
 /*!
+Updates the window with the partially rendered image every 500 ms. Only the
+main thread (worker 0 of the render pool) is allowed to do this. The percentage
+rendered is pcStart plus the finished part of the current pass times pcRange.
+A sceneview without window update callback renders headless (no GL context).
+*/
+void SLRaytracer::updateWindow(SLuint worker, SLint pcStart, SLint pcRange)
+{
+    if (worker != 0 || _doContinuous || !_sv->onWndUpdate) return;
+
+    if (SLApplication::scene->timeSec() - _tUpdate > 0.5)
+    {
+        _pcRendered = pcStart + (SLint)((SLfloat)_pool.numTasksDone() /
+                                        (SLfloat)_pool.numTasks() * pcRange);
+        finishBeforeUpdate();
+        _sv->onWndUpdate();
+        _tUpdate = SLApplication::scene->timeSec();
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
 This method is the classic recursive ray tracing method that checks the scene
 for intersection. If the ray hits an object the local color is calculated and
 if the material is reflective and/or transparent new rays are created and
@@ -343,10 +651,18 @@ background color is return.
 */
 SLCol4f SLRaytracer::trace(SLRay* ray)
 {
-    SLScene* s = SLApplication::scene;
-    SLCol4f  color(ray->backgroundColor);
-
-    s->root3D()->hitRec(ray);
+    SLApplication::scene->hit(ray);
+    return traceHit(ray);
+}
+//-----------------------------------------------------------------------------
+/*!
+Calculates the color of a ray that was already intersected with the scene.
+This is the second half of trace that is also used for the rays of a packet
+after they got intersected all at once with SLScene::hitPacket.
+*/
+SLCol4f SLRaytracer::traceHit(SLRay* ray)
+{
+    SLCol4f color(ray->backgroundColor);
 
     if (ray->length < FLT_MAX)
     {
@@ -408,6 +724,51 @@ SLCol4f SLRaytracer::trace(SLRay* ray)
     return color;
 }
 //-----------------------------------------------------------------------------
+/*!
+Traces the block of 2x2 pixels with the lower left pixel x, y as one packet of
+primary rays. The packet is intersected at once with the scene and the color
+of each ray is calculated afterwards with traceHit. Pixels outside the tile
+become inactive rays of the packet.
+*/
+void SLRaytracer::renderPacket(SLint x, SLint y, const SLRenderTile& tile)
+{
+    static_assert(SL_PACKET_SIZE >= 4, "A packet must hold 2x2 rays");
+
+    SLRay       rays[4] = {SLRay(_sv), SLRay(_sv), SLRay(_sv), SLRay(_sv)};
+    SLRay*      active[4];
+    SLint       numRays = 0;
+    SLint       maxX    = tile.x + tile.w;
+    SLint       maxY    = tile.y + tile.h;
+    SLRayPacket packet;
+
+    for (SLint py = y; py < y + 2 && py < maxY; ++py)
+    {
+        for (SLint px = x; px < x + 2 && px < maxX; ++px)
+        {
+            setPrimaryRay((SLfloat)px, (SLfloat)py, &rays[numRays]);
+            active[numRays] = &rays[numRays];
+            numRays++;
+        }
+    }
+
+    packet.set(active, numRays);
+
+    ////////////////////////////////////////////
+    SLApplication::scene->hitPacket(packet);
+    ////////////////////////////////////////////
+
+    for (SLint i = 0; i < numRays; ++i)
+    {
+        SLRay*  ray   = active[i];
+        SLCol4f color = traceHit(ray);
+        color.gammaCorrect(_oneOverGamma);
+
+        _images[0]->setPixeliRGB((SLint)ray->x, (SLint)ray->y, color);
+
+        SLRayStats::local().primaryDone();
+    }
+}
+//-----------------------------------------------------------------------------
 //! Set the parameters of a primary ray for a pixel position at x, y.
 void SLRaytracer::setPrimaryRay(SLfloat x, SLfloat y, SLRay* primaryRay)
 {
@@ -429,6 +790,18 @@ void SLRaytracer::setPrimaryRay(SLfloat x, SLfloat y, SLRay* primaryRay)
         primaryRay->origin = _EYE;
     }
 
+    // the ray cone covers one pixel for the texture LOD (see SLTexCache)
+    if (_cam->projection() == P_monoOrthographic)
+    {
+        primaryRay->coneWidth = _pxSize;
+        primaryRay->coneAngle = 0.0f;
+    }
+    else
+    {
+        primaryRay->coneWidth = 0.0f;
+        primaryRay->coneAngle = _pxSize / _cam->focalDist();
+    }
+
     if (_sv->skybox())
         primaryRay->backgroundColor = _sv->skybox()->colorAtDir(primaryRay->dir);
     else
@@ -436,6 +809,32 @@ void SLRaytracer::setPrimaryRay(SLfloat x, SLfloat y, SLRay* primaryRay)
 }
 //-----------------------------------------------------------------------------
 /*!
+Set the parameters of a primary ray for depth of field. The ray starts at the
+position disc on the lens (unit disc scaled by the lens radius) and goes
+through the pixel position x, y on the focal plane (see prepareImage()).
+*/
+void SLRaytracer::setLensRay(SLfloat        x,
+                             SLfloat        y,
+                             const SLVec2f& disc,
+                             SLRay*         primaryRay)
+{
+    SLfloat lensRadius = _cam->lensDiameter() * 0.5f;
+    SLVec3f FP(_EYE + _BL + _pxSize * (x * _LR + y * _LU));
+    SLVec3f lensPos(_EYE + disc.x * lensRadius * _LR + disc.y * lensRadius * _LU);
+    SLVec3f lensToFP(FP - lensPos);
+    lensToFP.normalize();
+
+    SLCol4f backColor;
+    if (_sv->skybox())
+        backColor = _sv->skybox()->colorAtDir(lensToFP);
+    else
+        backColor = _sv->camera()->background().colorAtPos(x, y);
+
+    *primaryRay           = SLRay(lensPos, lensToFP, x, y, backColor, _sv);
+    primaryRay->coneAngle = _pxSize / _cam->focalDist();
+}
+//-----------------------------------------------------------------------------
+/*!
 This method calculates the local illumination at the rays intersection point. 
 It uses the OpenGL local light model where the color is calculated as 
 follows:
@@ -596,75 +995,55 @@ void SLRaytracer::getAAPixels()
             gotSampled[x] = isSubsampled;
         }
     }
-    SLRay::subsampledPixels = (SLuint)_aaPixels.size();
+    SLRayStats::local().subsampledPixels = (SLuint)_aaPixels.size();
 }
 //-----------------------------------------------------------------------------
 /*!
-SLRaytracer::sampleAAPixels does the subsampling of the pixels that need to be
-antialiased. See also getAAPixels. This routine can be called by multiple
-threads.
-The _next index is used and incremented by every thread. So it should be locked
-or an atomic index. I prefer not protecting it because it's faster. If the
-increment is not done properly some pixels may get ray traced twice. Only the
-main thread is allowed to call a repaint of the image.
+SLRaytracer::sampleAAPixels does the subsampling of the AA pixels with the
+indexes [first, last) that need to be antialiased. See also getAAPixels. This
+routine is called by the workers of the render pool.
 */
-void SLRaytracer::sampleAAPixels(const bool isMainThread)
+void SLRaytracer::sampleAAPixels(SLuint first, SLuint last)
 {
     assert(_aaSamples % 2 == 1 && "subSample: maskSize must be uneven");
-    double  t1 = 0, t2 = 0;
 
-    while (_next < (SLint)_aaPixels.size())
-    {
-        SLuint mini = (SLuint)_next;
-        _next += 4;
+    // The AA pixels of one task are a tile for the shadow data of the lights
+    SLLight::newShadowTile();
 
-        for (SLuint i = mini; i < mini + 4 && i < _aaPixels.size(); ++i)
+    for (SLuint i = first; i < last; ++i)
+    {
+        SLuint  x           = _aaPixels[i].x;
+        SLuint  y           = _aaPixels[i].y;
+        SLCol4f centerColor = _images[0]->getPixeli((SLint)x, (SLint)y);
+        SLint   centerIndex = _aaSamples >> 1;
+        SLfloat f           = 1.0f / (SLfloat)_aaSamples;
+        SLfloat xpos        = x - centerIndex * f;
+        SLfloat ypos        = y - centerIndex * f;
+        SLfloat samples     = (SLfloat)_aaSamples * _aaSamples;
+        SLCol4f color(0, 0, 0);
+
+        // Loop regularly over the float pixel
+        for (SLint sy = 0; sy < _aaSamples; ++sy)
         {
-            SLuint  x           = _aaPixels[i].x;
-            SLuint  y           = _aaPixels[i].y;
-            SLCol4f centerColor = _images[0]->getPixeli((SLint)x, (SLint)y);
-            SLint   centerIndex = _aaSamples >> 1;
-            SLfloat f           = 1.0f / (SLfloat)_aaSamples;
-            SLfloat xpos        = x - centerIndex * f;
-            SLfloat ypos        = y - centerIndex * f;
-            SLfloat samples     = (SLfloat)_aaSamples * _aaSamples;
-            SLCol4f color(0, 0, 0);
-
-            // Loop regularly over the float pixel
-            for (SLint j = 0; j < _aaSamples; ++j)
+            for (SLint sx = 0; sx < _aaSamples; ++sx)
             {
-                for (SLint i = 0; i < _aaSamples; ++i)
+                if (sx == centerIndex && sy == centerIndex)
+                    color += centerColor; // don't shoot for center position
+                else
                 {
-                    if (i == centerIndex && j == centerIndex)
-                        color += centerColor; // don't shoot for center position
-                    else
-                    {
-                        SLRay primaryRay(_sv);
-                        setPrimaryRay(xpos + i * f, ypos + i * f, &primaryRay);
-                        color += trace(&primaryRay);
-                    }
+                    SLRay primaryRay(_sv);
+                    setPrimaryRay(xpos + sx * f, ypos, &primaryRay);
+                    color += trace(&primaryRay);
                 }
-                ypos += f;
             }
-            SLRay::subsampledRays += (SLuint)samples;
-            color /= samples;
-
-            color.gammaCorrect(_oneOverGamma);
-
-            _images[0]->setPixeliRGB((SLint)x, (SLint)y, color);
+            ypos += f;
         }
+        SLRayStats::local().subsampledRays += (SLuint)samples;
+        color /= samples;
 
-        if (isMainThread && !_doContinuous)
-        {
-            t2 = SLApplication::scene->timeSec();
-            if (t2 - t1 > 0.5)
-            {
-                _pcRendered = 50 + (SLint)((SLfloat)_next / (SLfloat)_aaPixels.size() * 50);
-                finishBeforeUpdate();
-                _sv->onWndUpdate();
-                t1 = SLApplication::scene->timeSec();
-            }
-        }
+        color.gammaCorrect(_oneOverGamma);
+
+        _images[0]->setPixeliRGB((SLint)x, (SLint)y, color);
     }
 }
 //-----------------------------------------------------------------------------
@@ -691,57 +1070,60 @@ SLCol4f SLRaytracer::fogBlend(SLfloat z, SLCol4f color)
 }
 //-----------------------------------------------------------------------------
 /*!
-Initialises the statistic variables in SLRay to zero
+Initialises the max. depth and resets the statistic blocks of all threads
 */
 void SLRaytracer::initStats(SLint depth)
 {
-    SLRay::maxDepth         = (depth) ? depth : SL_MAXTRACE;
-    SLRay::reflectedRays    = 0;
-    SLRay::refractedRays    = 0;
-    SLRay::tirRays          = 0;
-    SLRay::shadowRays       = 0;
-    SLRay::subsampledRays   = 0;
-    SLRay::subsampledPixels = 0;
-    SLRay::tests            = 0;
-    SLRay::intersections    = 0;
-    SLRay::maxDepthReached  = 0;
-    SLRay::avgDepth         = 0.0f;
+    SLRay::maxDepth = (depth) ? depth : SL_MAXTRACE;
+    SLRayStats::resetAll();
+    _stats.reset();
 }
 //-----------------------------------------------------------------------------
 /*! 
-Prints some statistics after the rendering
+Prints the statistics of the last frame. They are merged from the stats blocks
+of all render threads (see SLRayStats) after the threads have finished.
 */
 void SLRaytracer::printStats(SLfloat sec)
 {
     SL_LOG("\nRender time  : %10.2f sec.", sec);
     SL_LOG("\nImage size   : %10d x %d", _images[0]->width(), _images[0]->height());
-    SL_LOG("\nNum. Threads : %10d", SL::maxThreads());
+    SL_LOG("\nNum. Threads : %10d", numThreads());
     SL_LOG("\nAllowed depth: %10d", SLRay::maxDepth);
 
-    SLuint primarys = (SLuint)(_sv->scrW() * _sv->scrH());
-    SLuint total    = primarys +
-                   SLRay::reflectedRays +
-                   SLRay::subsampledRays +
-                   SLRay::refractedRays +
-                   SLRay::shadowRays;
+    const SLRayStats& st       = _stats;
+    SLuint            primarys = SL_max(st.primaryRays, (SLuint)1);
+    SLuint            total    = SL_max(st.totalRays(), (SLuint)1);
 
-    SL_LOG("\nMaximum depth     : %10d", SLRay::maxDepthReached);
-    SL_LOG("\nAverage depth     : %10.6f", SLRay::avgDepth / primarys);
+    SL_LOG("\nMaximum depth     : %10d", st.maxDepthReached);
+    SL_LOG("\nAverage depth     : %10.6f", st.avgDepth());
     SL_LOG("\nAA threshold      : %10.1f", _aaThreshold);
     SL_LOG("\nAA subsampling    : %8dx%d\n", _aaSamples, _aaSamples);
-    SL_LOG("\nSubsampled pixels : %10u, %4.1f%% of total", SLRay::subsampledPixels, (SLfloat)SLRay::subsampledPixels / primarys * 100.0f);
-    SL_LOG("\nPrimary rays      : %10u, %4.1f%% of total", primarys, (SLfloat)primarys / total * 100.0f);
-    SL_LOG("\nReflected rays    : %10u, %4.1f%% of total", SLRay::reflectedRays, (SLfloat)SLRay::reflectedRays / total * 100.0f);
-    SL_LOG("\nRefracted rays    : %10u, %4.1f%% of total", SLRay::refractedRays, (SLfloat)SLRay::refractedRays / total * 100.0f);
-    SL_LOG("\nIgnored rays      : %10u, %4.1f%% of total", SLRay::ignoredRays, (SLfloat)SLRay::ignoredRays / total * 100.0f);
-    SL_LOG("\nTIR rays          : %10u, %4.1f%% of total", SLRay::tirRays, (SLfloat)SLRay::tirRays / total * 100.0f);
-    SL_LOG("\nShadow rays       : %10u, %4.1f%% of total", SLRay::shadowRays, (SLfloat)SLRay::shadowRays / total * 100.0f);
-    SL_LOG("\nAA subsampled rays: %10u, %4.1f%% of total", SLRay::subsampledRays, (SLfloat)SLRay::subsampledRays / total * 100.0f);
-    SL_LOG("\nTotal rays        : %10u,100.0%%\n", total);
-
-    SL_LOG("\nRays per second   : %10u", (SLuint)(total / sec));
-    SL_LOG("\nIntersection tests: %10u", SLRay::tests);
-    SL_LOG("\nIntersections     : %10u, %4.1f%%", SLRay::intersections, SLRay::intersections / (SLfloat)SLRay::tests * 100.0f);
+    SL_LOG("\nSubsampled pixels : %10u, %4.1f%% of total", st.subsampledPixels, (SLfloat)st.subsampledPixels / primarys * 100.0f);
+    SL_LOG("\nPrimary rays      : %10u, %4.1f%% of total", st.primaryRays, (SLfloat)st.primaryRays / total * 100.0f);
+    SL_LOG("\nReflected rays    : %10u, %4.1f%% of total", st.reflectedRays, (SLfloat)st.reflectedRays / total * 100.0f);
+    SL_LOG("\nRefracted rays    : %10u, %4.1f%% of total", st.refractedRays, (SLfloat)st.refractedRays / total * 100.0f);
+    SL_LOG("\nIgnored rays      : %10u, %4.1f%% of total", st.ignoredRays, (SLfloat)st.ignoredRays / total * 100.0f);
+    SL_LOG("\nTIR rays          : %10u, %4.1f%% of total", st.tirRays, (SLfloat)st.tirRays / total * 100.0f);
+    SL_LOG("\nShadow rays       : %10u, %4.1f%% of total", st.shadowRays, (SLfloat)st.shadowRays / total * 100.0f);
+    SL_LOG("\nOccluder hits     : %10u, %4.1f%% of shadow rays", st.occluderHits, st.shadowRays ? (SLfloat)st.occluderHits / st.shadowRays * 100.0f : 0.0f);
+    SL_LOG("\nAA subsampled rays: %10u, %4.1f%% of total", st.subsampledRays, (SLfloat)st.subsampledRays / total * 100.0f);
+    SL_LOG("\nTotal rays        : %10u,100.0%%\n", st.totalRays());
+
+    SL_LOG("\nRays per second   : %10u", sec > 0.0f ? (SLuint)(st.totalRays() / sec) : 0);
+    SL_LOG("\nIntersection tests: %10llu", (unsigned long long)st.tests);
+    SL_LOG("\nTests per ray     : %10.2f", st.testsPerRay());
+    SL_LOG("\nIntersections     : %10llu, %4.1f%%", (unsigned long long)st.intersections, st.tests ? st.intersections / (SLfloat)st.tests * 100.0f : 0.0f);
+
+    SL_LOG("\n\nDepth histogram (primary rays per depth reached):");
+    for (SLint d = 0; d < SL_RAYSTATS_DEPTH_BINS; ++d)
+    {
+        if (st.depthHistogram[d] == 0) continue;
+        SL_LOG("\nDepth %2d%s       : %10u, %4.1f%%",
+               d + 1,
+               d == SL_RAYSTATS_DEPTH_BINS - 1 ? "+" : " ",
+               st.depthHistogram[d],
+               (SLfloat)st.depthHistogram[d] / primarys * 100.0f);
+    }
     SL_LOG("\n\n");
 }
 //-----------------------------------------------------------------------------
@@ -758,6 +1140,12 @@ void SLRaytracer::prepareImage()
 
     _cam = _sv->_camera; // camera shortcut
 
+    // forget the shadow caches of the last frame
+    SLLight::newShadowFrame();
+
+    // the render threads only read the world matrices
+    SLApplication::scene->updateTransforms();
+
     // get camera vectors eye, lookAt, lookUp
     _cam->updateAndGetVM().lookAt(&_EYE, &_LA, &_LU, &_LR);
 
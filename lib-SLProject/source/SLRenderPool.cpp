@@ -0,0 +1,308 @@
+//#############################################################################
+//  File:      SLRenderPool.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLRenderPool.h>
+
+//-----------------------------------------------------------------------------
+//! Packs the begin & end index of a deque into one 64 bit value
+static inline SLuint64 packRange(SLuint begin, SLuint end)
+{
+    return ((SLuint64)end << 32) | (SLuint64)begin;
+}
+//-----------------------------------------------------------------------------
+//! Converts the distance d along a Hilbert curve of n x n cells to x & y
+static void hilbertD2XY(SLint n, SLint d, SLint& x, SLint& y)
+{
+    SLint t = d;
+    x = y = 0;
+    for (SLint s = 1; s < n; s *= 2)
+    {
+        SLint rx = 1 & (t / 2);
+        SLint ry = 1 & (t ^ rx);
+
+        // rotate the quadrant
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+
+        x += s * rx;
+        y += s * ry;
+        t /= 4;
+    }
+}
+//-----------------------------------------------------------------------------
+SLRenderPool::SLRenderPool()
+{
+    _numDeques    = 0;
+    _numActive    = 0;
+    _func         = nullptr;
+    _numTasks     = 0;
+    _numTasksDone = 0;
+    _numBusy      = 0;
+    _isRunning    = false;
+    _generation   = 0;
+    _quit         = false;
+}
+//-----------------------------------------------------------------------------
+//! The destructor wakes up all workers to terminate and joins them
+SLRenderPool::~SLRenderPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wakeUp.notify_all();
+
+    for (auto& worker : _workers)
+        if (worker.joinable())
+            worker.join();
+}
+//-----------------------------------------------------------------------------
+/*!
+Starts additional worker threads until numThreads threads are running. The
+threads remember the current generation so that they only start working at
+the next call of run.
+*/
+void SLRenderPool::startWorkers(SLuint numThreads)
+{
+    if (_numDeques < numThreads + 1)
+    {
+        _numDeques = numThreads + 1;
+        _deques.reset(new Deque[_numDeques]);
+        for (SLuint i = 0; i < _numDeques; ++i)
+            _deques[i].range = 0;
+    }
+
+    while (_workers.size() < numThreads)
+    {
+        SLuint worker = (SLuint)_workers.size() + 1;
+        _workers.push_back(std::thread(&SLRenderPool::workerLoop,
+                                       this,
+                                       worker,
+                                       _generation));
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Executes the task function for all tasks [0, numTasks) on all workers and
+returns when all tasks are finished. The calling thread works as worker 0.
+With maxWorkers the NO. of workers can be limited (0 = SL::maxThreads()).
+If the pool is already running (e.g. a nested call from a task) all tasks
+are executed in the calling thread as worker 0.
+*/
+void SLRenderPool::run(SLuint                  numTasks,
+                       const SLRenderTaskFunc& func,
+                       SLuint                  maxWorkers)
+{
+    if (numTasks == 0) return;
+
+    if (_isRunning.exchange(true))
+    {
+        for (SLuint task = 0; task < numTasks; ++task)
+            func(task, 0);
+        return;
+    }
+
+    SLuint numWorkers = SL::maxThreads();
+    if (maxWorkers > 0) numWorkers = SL_min(maxWorkers, numWorkers);
+    numWorkers = SL_max(SL_min(numWorkers, numTasks), (SLuint)1);
+
+    startWorkers(SL_max((SLuint)_workers.size(), numWorkers - 1));
+
+    // Distribute the tasks in contiguous blocks onto the deques
+    for (SLuint w = 0; w < _numDeques; ++w)
+    {
+        if (w < numWorkers)
+        {
+            SLuint begin = (SLuint)((SLuint64)numTasks * w / numWorkers);
+            SLuint end   = (SLuint)((SLuint64)numTasks * (w + 1) / numWorkers);
+            _deques[w].range.store(packRange(begin, end));
+        }
+        else
+            _deques[w].range.store(packRange(0, 0));
+    }
+
+    _func         = &func;
+    _numTasks     = numTasks;
+    _numTasksDone = 0;
+    _numActive    = numWorkers;
+    _numBusy      = numWorkers - 1;
+
+    if (numWorkers > 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _generation++;
+        }
+        _wakeUp.notify_all();
+    }
+
+    // Do the same work in the calling thread
+    work(0);
+
+    // Wait for the other workers to finish
+    if (numWorkers > 1)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _finished.wait(lock, [this] { return _numBusy == 0; });
+    }
+
+    _func      = nullptr;
+    _isRunning = false;
+}
+//-----------------------------------------------------------------------------
+/*!
+Thread function of the workers 1..n that sleep between the runs. The
+generation at the start of the thread is passed by startWorkers because the
+thread may only get running after run has already started the next one.
+*/
+void SLRenderPool::workerLoop(SLuint worker, SLuint64 seenGeneration)
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wakeUp.wait(lock, [&] { return _quit || _generation != seenGeneration; });
+            if (_quit) return;
+            seenGeneration = _generation;
+            if (worker >= _numActive) continue;
+        }
+
+        work(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_numBusy == 0)
+                _finished.notify_one();
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Executes own and stolen tasks until all deques are empty
+void SLRenderPool::work(SLuint worker)
+{
+    SLuint task;
+    while (popTask(worker, task) || stealTask(worker, task))
+    {
+        (*_func)(task, worker);
+        _numTasksDone++;
+    }
+}
+//-----------------------------------------------------------------------------
+//! Pops the next task from the front of the own deque
+SLbool SLRenderPool::popTask(SLuint worker, SLuint& task)
+{
+    std::atomic<SLuint64>& range = _deques[worker].range;
+    SLuint64               r     = range.load();
+
+    while (true)
+    {
+        SLuint begin = (SLuint)(r & 0xFFFFFFFF);
+        SLuint end   = (SLuint)(r >> 32);
+        if (begin >= end) return false;
+
+        if (range.compare_exchange_weak(r, packRange(begin + 1, end)))
+        {
+            task = begin;
+            return true;
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Steals a task from the back of the deque of another worker. The victims are
+visited starting with the next worker so that not all thieves start with the
+same one.
+*/
+SLbool SLRenderPool::stealTask(SLuint worker, SLuint& task)
+{
+    for (SLuint i = 1; i < _numActive; ++i)
+    {
+        std::atomic<SLuint64>& range = _deques[(worker + i) % _numActive].range;
+        SLuint64               r     = range.load();
+
+        while (true)
+        {
+            SLuint begin = (SLuint)(r & 0xFFFFFFFF);
+            SLuint end   = (SLuint)(r >> 32);
+            if (begin >= end) break;
+
+            if (range.compare_exchange_weak(r, packRange(begin, end - 1)))
+            {
+                task = end - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+//-----------------------------------------------------------------------------
+/*!
+Divides an image of width x height pixels into tiles of tileSize x tileSize
+pixels that are ordered along a Hilbert curve. The tiles at the right and top
+border are smaller if the image size is not a multiple of the tile size.
+*/
+void SLRenderPool::hilbertTiles(SLint          width,
+                                SLint          height,
+                                SLint          tileSize,
+                                SLVRenderTile& tiles)
+{
+    tiles.clear();
+    if (width <= 0 || height <= 0 || tileSize <= 0) return;
+
+    SLint numX = (width + tileSize - 1) / tileSize;
+    SLint numY = (height + tileSize - 1) / tileSize;
+
+    // The Hilbert curve needs a square grid with a power of 2 side length
+    SLint n = 1;
+    while (n < numX || n < numY) n *= 2;
+
+    tiles.reserve((size_t)(numX * numY));
+    for (SLint d = 0; d < n * n; ++d)
+    {
+        SLint tx, ty;
+        hilbertD2XY(n, d, tx, ty);
+        if (tx >= numX || ty >= numY) continue;
+
+        SLRenderTile tile;
+        tile.x = tx * tileSize;
+        tile.y = ty * tileSize;
+        tile.w = SL_min(tileSize, width - tile.x);
+        tile.h = SL_min(tileSize, height - tile.y);
+        tiles.push_back(tile);
+    }
+}
+//-----------------------------------------------------------------------------
+//! Returns the pool that is shared by the passes of all renderers
+SLRenderPool& SLRenderPool::render()
+{
+    static SLRenderPool pool;
+    return pool;
+}
+//-----------------------------------------------------------------------------
+//! Returns the pool that is shared by the parallel parts of the scene update
+SLRenderPool& SLRenderPool::update()
+{
+    static SLRenderPool pool;
+    return pool;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,211 @@
+//#############################################################################
+//  File:      SLSampler.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLSampler.h>
+
+// init static variables
+SLuint              SLSampler::_seed           = 0;
+SLSamplerType       SLSampler::_type           = ST_sobol;
+std::atomic<SLuint> SLSampler::_seedGeneration(0);
+
+//-----------------------------------------------------------------------------
+//! First 32 primes as bases of the Halton sequence dimensions
+static const SLuint haltonPrimes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                      37, 41, 43, 47, 53, 59, 61, 67, 71, 73,
+                                      79, 83, 89, 97, 101, 103, 107, 109, 113,
+                                      127, 131};
+static const SLuint numHaltonPrimes = sizeof(haltonPrimes) / sizeof(SLuint);
+//-----------------------------------------------------------------------------
+//! Integer hash with good avalanche behaviour (lowbias32 by C. Wellons)
+static inline SLuint hashUint(SLuint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+//-----------------------------------------------------------------------------
+//! Combines a hash value h with the value v
+static inline SLuint hashCombine(SLuint h, SLuint v)
+{
+    return hashUint(h ^ (v + 0x9e3779b9U + (h << 6) + (h >> 2)));
+}
+//-----------------------------------------------------------------------------
+//! Converts the upper 24 bits to a float in [0,1)
+static inline SLfloat toFloat01(SLuint bits)
+{
+    return (SLfloat)(bits >> 8) * (1.0f / 16777216.0f);
+}
+//-----------------------------------------------------------------------------
+//! Reverses the bits (1st dimension of the Sobol sequence = van der Corput)
+static inline SLuint reverseBits(SLuint v)
+{
+    v = ((v >> 1) & 0x55555555U) | ((v & 0x55555555U) << 1);
+    v = ((v >> 2) & 0x33333333U) | ((v & 0x33333333U) << 2);
+    v = ((v >> 4) & 0x0F0F0F0FU) | ((v & 0x0F0F0F0FU) << 4);
+    v = ((v >> 8) & 0x00FF00FFU) | ((v & 0x00FF00FFU) << 8);
+    return (v >> 16) | (v << 16);
+}
+//-----------------------------------------------------------------------------
+//! 2nd dimension of the Sobol sequence with the XOR scrambling r
+static inline SLuint sobol2(SLuint i, SLuint r)
+{
+    for (SLuint v = 1U << 31; i; i >>= 1, v ^= v >> 1)
+        if (i & 1) r ^= v;
+    return r;
+}
+//-----------------------------------------------------------------------------
+//! Radical inverse of the index i in the prime base
+static inline SLfloat radicalInverse(SLuint base, SLuint i)
+{
+    const SLdouble invBase = 1.0 / base;
+    SLdouble       f       = invBase;
+    SLdouble       r       = 0.0;
+    while (i)
+    {
+        r += (i % base) * f;
+        i /= base;
+        f *= invBase;
+    }
+    return (SLfloat)r;
+}
+//-----------------------------------------------------------------------------
+SLSampler::SLSampler()
+{
+    _pixelHash  = 0;
+    _sample     = 0;
+    _dimension  = 0;
+    _hasPixel   = false;
+    _generation = (SLuint)-1;
+    seedPCG(0, 0);
+}
+//-----------------------------------------------------------------------------
+//! Sets the global seed of all samplers
+void SLSampler::seed(SLuint seed)
+{
+    _seed = seed;
+    _seedGeneration++;
+}
+//-----------------------------------------------------------------------------
+/*! Returns the sampler of the calling thread. If the global seed was changed
+since the last call, the sampler gets reseeded as plain PCG32 stream. The
+stream index comes from a global counter so that the threads don't produce
+the same numbers.
+*/
+SLSampler& SLSampler::local()
+{
+    static std::atomic<SLuint> streamCounter(0);
+    thread_local SLSampler     sampler;
+
+    SLuint generation = _seedGeneration.load(std::memory_order_relaxed);
+    if (sampler._generation != generation)
+    {
+        sampler._generation = generation;
+        sampler._hasPixel   = false;
+        sampler.seedPCG(hashUint(_seed), streamCounter++);
+    }
+    return sampler;
+}
+//-----------------------------------------------------------------------------
+/*! Returns a random point in [0,1)^2 for the index at the float position
+(x,y) (e.g. the pixel position of a ray). It depends only on the global seed
+and the arguments, so it is reproducible no matter which thread calls it.
+*/
+SLVec2f SLSampler::hashed2D(SLfloat x, SLfloat y, SLuint index)
+{
+    SLuint bitsX, bitsY;
+    memcpy(&bitsX, &x, sizeof(SLuint));
+    memcpy(&bitsY, &y, sizeof(SLuint));
+
+    SLuint h = hashCombine(hashCombine(hashUint(_seed), bitsX), bitsY);
+    h        = hashCombine(h, index);
+    return SLVec2f(toFloat01(h), toFloat01(hashUint(h)));
+}
+//-----------------------------------------------------------------------------
+//! Seeds the PCG32 generator with the initial state and the stream index
+void SLSampler::seedPCG(SLuint64 state, SLuint64 stream)
+{
+    _pcgState = 0;
+    _pcgInc   = (stream << 1) | 1;
+    nextPCG();
+    _pcgState += state;
+    nextPCG();
+}
+//-----------------------------------------------------------------------------
+//! Returns the next 32 bit number of the PCG32 generator (PCG-XSH-RR)
+SLuint SLSampler::nextPCG()
+{
+    SLuint64 old   = _pcgState;
+    _pcgState      = old * 6364136223846793005ULL + _pcgInc;
+    SLuint xorShft = (SLuint)(((old >> 18) ^ old) >> 27);
+    SLuint rot     = (SLuint)(old >> 59);
+    return (xorShft >> rot) | (xorShft << ((32 - rot) & 31));
+}
+//-----------------------------------------------------------------------------
+/*! Starts the sample with the index sample of the pixel (x,y). The dimension
+gets reset to 0 and the PCG32 stream is derived from (seed, pixel, sample).
+*/
+void SLSampler::startPixel(SLint x, SLint y, SLuint sample)
+{
+    _pixelHash = hashCombine(hashCombine(hashUint(_seed), (SLuint)x), (SLuint)y);
+    _sample    = sample;
+    _dimension = 0;
+    _hasPixel  = true;
+    seedPCG(hashCombine(_pixelHash, sample), _pixelHash);
+}
+//-----------------------------------------------------------------------------
+//! Returns the sample value in [0,1) of the next dimension
+SLfloat SLSampler::get1D()
+{
+    SLuint dim = _dimension++;
+
+    if (!_hasPixel || _type == ST_random)
+        return toFloat01(nextPCG());
+
+    if (_type == ST_halton)
+    {
+        if (dim >= numHaltonPrimes)
+            return toFloat01(nextPCG());
+
+        // Cranley-Patterson rotation per pixel & dimension
+        SLfloat v = radicalInverse(haltonPrimes[dim], _sample) +
+                    toFloat01(hashCombine(_pixelHash, dim));
+        if (v >= 1.0f) v -= 1.0f;
+        return SL_min(v, 0.99999994f);
+    }
+
+    // Sobol: Every pair of dimensions is a 2D (0,2)-sequence. The index
+    // shuffling with XOR keeps the stratification of power of 2 sample counts.
+    SLuint pairHash = hashCombine(_pixelHash, dim >> 1);
+    SLuint index    = _sample ^ (pairHash & 0xFFFF0000U);
+    SLuint scramble = hashCombine(pairHash, dim & 1);
+    SLuint bits     = (dim & 1) ? sobol2(index, scramble)
+                                : reverseBits(index) ^ scramble;
+    return toFloat01(bits);
+}
+//-----------------------------------------------------------------------------
+//! Returns the sample values of the next two dimensions
+SLVec2f SLSampler::get2D()
+{
+    // Align to a dimension pair for the 2D Sobol sequence
+    if (_dimension & 1) _dimension++;
+    SLfloat u = get1D();
+    SLfloat v = get1D();
+    return SLVec2f(u, v);
+}
+//-----------------------------------------------------------------------------
@@ -23,6 +23,7 @@ void SLSamples2D::samples(SLuint x, SLuint y, SLbool evenlyDistributed)
     _samplesX = x;
     _samplesY = y;
     _samples  = x * y;
+    _evenly   = evenlyDistributed;
     _points.resize(_samples);
     if (_samples > 1) distribConcentric(evenlyDistributed);
 }
@@ -58,6 +59,19 @@ void SLSamples2D::distribConcentric(SLbool evenlyDistributed)
     }
 }
 //-----------------------------------------------------------------------------
+/*!
+Returns a jittered point within the stratum (iR, iPhi) of the disc. The strata
+are the same rings and sectors as the ones of distribConcentric. The jitter
+values jR and jPhi in [0,1) move the point within the ring and the sector.
+*/
+SLVec2f SLSamples2D::stratumPoint(SLuint iR, SLuint iPhi, SLfloat jR, SLfloat jPhi)
+{
+    SLfloat r = ((SLfloat)iR + jR) / _samplesX;
+    if (_evenly) r = sqrt(r);
+    SLfloat phi = SL_2PI * ((SLfloat)iPhi + jPhi) / _samplesY;
+    return SLVec2f(r * cos(phi), r * sin(phi));
+}
+//-----------------------------------------------------------------------------
 /*! Concentric mapping of a x,y-position
 Code taken from Peter Shirley out of "Realistic Ray Tracing"
 */
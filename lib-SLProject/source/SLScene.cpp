@@ -22,8 +22,10 @@
 #include <SLDeviceLocation.h>
 #include <SLInputManager.h>
 #include <SLLightDirect.h>
+#include <SLRayPacket.h>
 #include <SLScene.h>
 #include <SLSceneView.h>
+#include <SLSkeleton.h>
 #include <SLText.h>
 
 //-----------------------------------------------------------------------------
@@ -86,6 +88,7 @@ SLScene::SLScene(SLstring      name,
     _selectedMesh     = nullptr;
     _selectedNode     = nullptr;
     _stopAnimations   = false;
+    _doGPUSkinning    = true;
     _fps              = 0;
     _elapsedTimeMS    = 0;
     _lastUpdateTimeMS = 0;
@@ -109,6 +112,14 @@ SLScene::SLScene(SLstring      name,
     p = new SLGLGenericProgram("FontTex.vert", "FontTex.frag");
     p = new SLGLGenericProgram("StereoOculus.vert", "StereoOculus.frag");
     p = new SLGLGenericProgram("StereoOculusDistortionMesh.vert", "StereoOculusDistortionMesh.frag");
+    p = new SLGLGenericProgram("PerVrtBlinnSkinned.vert", "PerVrtBlinn.frag");
+    p->addUniformBlock("u_jointBlock", SL_JOINT_BLOCK_BINDING);
+    p = new SLGLGenericProgram("PerVrtBlinnTexSkinned.vert", "PerVrtBlinnTex.frag");
+    p->addUniformBlock("u_jointBlock", SL_JOINT_BLOCK_BINDING);
+    p = new SLGLGenericProgram("PerPixBlinnSkinned.vert", "PerPixBlinn.frag");
+    p->addUniformBlock("u_jointBlock", SL_JOINT_BLOCK_BINDING);
+    p = new SLGLGenericProgram("PerPixBlinnTexSkinned.vert", "PerPixBlinnTex.frag");
+    p->addUniformBlock("u_jointBlock", SL_JOINT_BLOCK_BINDING);
 
     _numProgsPreload = (SLint)_programs.size();
 
@@ -237,11 +248,15 @@ void SLScene::unInit()
         }
     }
 
-    // delete entire scene graph
+    // delete entire scene graph without removing every node from its meshes
+    for (auto m : _meshes)
+        m->removeAllNodes();
     delete _root3D;
     _root3D = nullptr;
     delete _root2D;
     _root2D = nullptr;
+    _sceneBVH.clear();
+    _transformStore.clear();
 
     // clear light pointers
     _lights.clear();
@@ -376,14 +391,10 @@ bool SLScene::onUpdate()
 
     sceneHasChanged |= !_stopAnimations && _animManager.update(elapsedTimeSec());
 
-    // Do software skinning on all changed skeletons
+    // Do the skinning on all changed skeletons on the GPU or for RT on the CPU
     for (auto mesh : _meshes)
     {
-        if (mesh->skeleton() && mesh->skeleton()->changed())
-        {
-            mesh->transformSkin();
-            sceneHasChanged = true;
-        }
+        sceneHasChanged |= mesh->updateSkin(renderTypeIsRT);
 
         // update any out of date acceleration structure for RT or if they're being rendered.
         if (renderTypeIsRT || voxelsAreShown)
@@ -514,10 +525,10 @@ bool SLScene::onUpdate()
     /////////////////////
 
     // The updateAABBRec call won't generate any overhead if nothing changed
+    // The world matrices of the 3D nodes are updated before level by level
     SLNode::numWMUpdates = 0;
     SLGLState::getInstance()->modelViewMatrix.identity();
-    if (_root3D)
-        _root3D->updateAABBRec();
+    updateTransforms();
     if (_root2D)
         _root2D->updateAABBRec();
 
@@ -643,6 +654,72 @@ void SLScene::selectNodeMesh(SLNode* nodeToSelect,
     }
 }
 //-----------------------------------------------------------------------------
+/*!
+SLScene::updateMeshesForRays skins all meshes with an outdated CPU skin and
+updates the acceleration structures of all meshes. It must be called before
+rays get cast into the scene (ray tracing, picking) because the GPU skinning
+of the OpenGL rendering leaves the CPU vertices in an older pose.
+*/
+void SLScene::updateMeshesForRays()
+{
+    for (auto mesh : _meshes)
+    {
+        mesh->updateSkin(true);
+        mesh->updateAccelStruct();
+    }
+}
+//-----------------------------------------------------------------------------
+/*!
+SLScene::updateTransforms updates the world matrices of all 3D nodes level by
+level in the transform store and then the AABBs that are out of date. The ray
+tracers call it before their threads start, so that the threads only read the
+world matrices (see SLNode::nodeWM) and never update a node concurrently.
+*/
+void SLScene::updateTransforms()
+{
+    if (_root3D)
+    {
+        _transformStore.update(_root3D);
+        _root3D->updateAABBRec();
+    }
+}
+//-----------------------------------------------------------------------------
+//! Intersects the ray with the 3D scene for ray and path tracing
+/*! If the scene BVH is enabled the ray traverses the flat hierarchy over the
+scene nodes instead of the recursive scene graph with SLNode::hitRec.
+SLSceneBVH::update must have been called before the rendering starts.
+*/
+SLbool SLScene::hit(SLRay* ray)
+{
+    if (!_root3D)
+        return false;
+
+    if (_sceneBVH.isEnabled())
+        return _sceneBVH.intersect(ray);
+
+    return _root3D->hitRec(ray);
+}
+//-----------------------------------------------------------------------------
+/*!
+SLScene::hitPacket intersects a packet of primary rays with the scene. Without
+the scene BVH each ray of the packet is intersected on its own with hitRec.
+*/
+void SLScene::hitPacket(SLRayPacket& packet)
+{
+    if (!_root3D)
+        return;
+
+    if (_sceneBVH.isEnabled())
+    {
+        _sceneBVH.intersectPacket(packet);
+        return;
+    }
+
+    for (SLint i = 0; i < SL_PACKET_SIZE; ++i)
+        if (packet.rays[i])
+            _root3D->hitRec(packet.rays[i]);
+}
+//-----------------------------------------------------------------------------
 void SLScene::onLoadAsset(SLstring assetFile,
                           SLuint   processFlags)
 {
@@ -0,0 +1,586 @@
+//#############################################################################
+//  File:      SLSceneBVH.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLAccelStruct.h>
+#include <SLLight.h>
+#include <SLNode.h>
+#include <SLRay.h>
+#include <SLRayPacket.h>
+#include <SLSceneBVH.h>
+#include <SLText.h>
+
+//-----------------------------------------------------------------------------
+//! NO. of bins for the binned SAH split search
+static const SLint  SL_BVH_NUM_BINS = 12;
+//! Max. NO. of scene nodes in a BVH leaf
+static const SLuint SL_BVH_MAX_LEAF = 2;
+//-----------------------------------------------------------------------------
+//! Returns the half surface area of the box defined by min & max
+static inline SLfloat halfArea(const SLVec3f& min, const SLVec3f& max)
+{
+    SLVec3f d = max - min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+//-----------------------------------------------------------------------------
+SLSceneBVH::SLSceneBVH()
+{
+    _root         = nullptr;
+    _needsRebuild = true;
+    _needsRefit   = false;
+    _isEnabled    = true;
+}
+//-----------------------------------------------------------------------------
+/*! Clears the hierarchy. It gets rebuilt at the next call of update.
+*/
+void SLSceneBVH::clear()
+{
+    _leaves.clear();
+    _nodes.clear();
+    _root         = nullptr;
+    _needsRebuild = true;
+    _needsRefit   = false;
+}
+//-----------------------------------------------------------------------------
+/*! SLSceneBVH::update must be called before ray tracing starts. It rebuilds
+the hierarchy if the scene graph structure changed or refits it if only AABBs
+changed. It must not be called while rays are traversing the hierarchy.
+*/
+void SLSceneBVH::update(SLNode* root)
+{
+    if (!_isEnabled)
+        return;
+
+    if (!root)
+    {
+        clear();
+        return;
+    }
+
+    // Update the scene graph AABBs in world space (only if needed)
+    root->updateAABBRec();
+
+    if (_needsRebuild || root != _root)
+        build(root);
+    else if (_needsRefit)
+        refit();
+    else
+    {
+        // The hidden flags can change without a refit
+        for (auto& leaf : _leaves)
+            updateLeafFlags(leaf);
+    }
+}
+//-----------------------------------------------------------------------------
+/*! SLSceneBVH::build collects all scene nodes with meshes as leaves and
+builds the hierarchy top-down with the binned surface area heuristic.
+*/
+void SLSceneBVH::build(SLNode* root)
+{
+    _leaves.clear();
+    _nodes.clear();
+    _root = root;
+
+    collectLeavesRec(root);
+
+    if (!_leaves.empty())
+    {
+        _nodes.reserve(2 * _leaves.size());
+        buildRec(0, (SLuint)_leaves.size(), 0);
+    }
+
+    _needsRebuild = false;
+    _needsRefit   = false;
+}
+//-----------------------------------------------------------------------------
+/*! Adds the node as leaf if it has meshes. Nodes that implement their own ray
+intersection are added with their entire subtree. Hidden nodes are not skipped
+here because the hidden flag can change without a rebuild (see update).
+*/
+void SLSceneBVH::collectLeavesRec(SLNode* node)
+{
+    // Text nodes are never hit by rays (see SLText::hitRec)
+    if (dynamic_cast<SLText*>(node))
+        return;
+
+    // Lights override hitRec and are intersected with their subtree
+    if (dynamic_cast<SLLight*>(node))
+    {
+        Leaf leaf;
+        leaf.node      = node;
+        leaf.isSubtree = true;
+        updateLeafAABB(leaf);
+        updateLeafFlags(leaf);
+        _leaves.push_back(leaf);
+        return;
+    }
+
+    if (node->numMeshes() > 0)
+    {
+        Leaf leaf;
+        leaf.node      = node;
+        leaf.isSubtree = false;
+        updateLeafAABB(leaf);
+        updateLeafFlags(leaf);
+        _leaves.push_back(leaf);
+    }
+
+    for (auto child : node->children())
+        collectLeavesRec(child);
+}
+//-----------------------------------------------------------------------------
+/*! Updates the world space AABB of a leaf. Subtree leaves take the AABB of
+the node that includes its children. Mesh leaves only merge the AABBs of the
+nodes own meshes.
+*/
+void SLSceneBVH::updateLeafAABB(Leaf& leaf)
+{
+    SLNode* node = leaf.node;
+
+    if (leaf.isSubtree)
+    {
+        leaf.min = node->aabb()->minWS();
+        leaf.max = node->aabb()->maxWS();
+    }
+    else
+    {
+        leaf.min.set(FLT_MAX, FLT_MAX, FLT_MAX);
+        leaf.max.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+        for (auto mesh : node->meshes())
+        {
+            SLAABBox aabbMesh;
+            mesh->buildAABB(aabbMesh, node->updateAndGetWM());
+            leaf.min.setMin(aabbMesh.minWS());
+            leaf.max.setMax(aabbMesh.maxWS());
+        }
+    }
+
+    leaf.center = (leaf.min + leaf.max) * 0.5f;
+}
+//-----------------------------------------------------------------------------
+/*! Updates the flags of a leaf that depend on its parents: If the node or one
+of its parents is hidden the leaf is never hit. If a parent has meshes it can
+be the source node of a shadow ray that excludes its subtree (see isExcluded).
+*/
+void SLSceneBVH::updateLeafFlags(Leaf& leaf)
+{
+    leaf.isHidden      = false;
+    leaf.hasMeshParent = false;
+
+    for (SLNode* n = leaf.node; n; n = n->parent())
+    {
+        if (n->drawBit(SL_DB_HIDDEN))
+            leaf.isHidden = true;
+        if (n != leaf.node && n->numMeshes() > 0)
+            leaf.hasMeshParent = true;
+        if (n == _root)
+            break;
+    }
+}
+//-----------------------------------------------------------------------------
+/*! Builds recursively the BVH node for the leaves [first, first+count) and
+returns its index. The nodes are stored in depth-first order so that the left
+child of an inner node always follows directly and only the index of the right
+child has to be stored. At the max. depth all remaining leaves go into one
+BVH leaf so that the traversal stack can't overflow.
+*/
+SLuint SLSceneBVH::buildRec(SLuint first, SLuint count, SLint depth)
+{
+    SLuint index = (SLuint)_nodes.size();
+    _nodes.push_back(Node());
+
+    // Calculate the bounds of the leaves and of their centers
+    SLVec3f min(FLT_MAX, FLT_MAX, FLT_MAX);
+    SLVec3f max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    SLVec3f cMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    SLVec3f cMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (SLuint i = first; i < first + count; ++i)
+    {
+        min.setMin(_leaves[i].min);
+        max.setMax(_leaves[i].max);
+        cMin.setMin(_leaves[i].center);
+        cMax.setMax(_leaves[i].center);
+    }
+    _nodes[index].min = min;
+    _nodes[index].max = max;
+
+    if (count <= SL_BVH_MAX_LEAF || depth >= SL_BVH_MAX_DEPTH - 1)
+    {
+        _nodes[index].first = first;
+        _nodes[index].count = count;
+        return index;
+    }
+
+    // Find the best split with binned SAH over all three axes
+    SLint   bestAxis = -1;
+    SLint   bestBin  = 0;
+    SLfloat bestCost = halfArea(min, max) * (SLfloat)count;
+    SLVec3f extent   = cMax - cMin;
+
+    for (SLint axis = 0; axis < 3; ++axis)
+    {
+        if (extent.comp[axis] <= FLT_EPSILON) continue;
+
+        SLVec3f binMin[SL_BVH_NUM_BINS];
+        SLVec3f binMax[SL_BVH_NUM_BINS];
+        SLuint  binCnt[SL_BVH_NUM_BINS] = {0};
+        for (SLint b = 0; b < SL_BVH_NUM_BINS; ++b)
+        {
+            binMin[b].set(FLT_MAX, FLT_MAX, FLT_MAX);
+            binMax[b].set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        }
+
+        SLfloat scale = (SLfloat)SL_BVH_NUM_BINS / extent.comp[axis];
+        for (SLuint i = first; i < first + count; ++i)
+        {
+            SLint b = (SLint)((_leaves[i].center.comp[axis] - cMin.comp[axis]) * scale);
+            b       = SL_min(b, SL_BVH_NUM_BINS - 1);
+            binCnt[b]++;
+            binMin[b].setMin(_leaves[i].min);
+            binMax[b].setMax(_leaves[i].max);
+        }
+
+        // Sweep from the right to get the cost of the right partitions
+        SLfloat rightCost[SL_BVH_NUM_BINS];
+        SLVec3f rMin(FLT_MAX, FLT_MAX, FLT_MAX);
+        SLVec3f rMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        SLuint  rCnt = 0;
+        for (SLint b = SL_BVH_NUM_BINS - 1; b > 0; --b)
+        {
+            rMin.setMin(binMin[b]);
+            rMax.setMax(binMax[b]);
+            rCnt += binCnt[b];
+            rightCost[b] = rCnt ? halfArea(rMin, rMax) * (SLfloat)rCnt : 0.0f;
+        }
+
+        // Sweep from the left and evaluate each split plane
+        SLVec3f lMin(FLT_MAX, FLT_MAX, FLT_MAX);
+        SLVec3f lMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        SLuint  lCnt = 0;
+        for (SLint b = 0; b < SL_BVH_NUM_BINS - 1; ++b)
+        {
+            lMin.setMin(binMin[b]);
+            lMax.setMax(binMax[b]);
+            lCnt += binCnt[b];
+            if (lCnt == 0 || lCnt == count) continue;
+
+            SLfloat cost = halfArea(lMin, lMax) * (SLfloat)lCnt + rightCost[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin  = b;
+            }
+        }
+    }
+
+    // Partition the leaves or fall back to a median split
+    SLuint mid = first + count / 2;
+    if (bestAxis >= 0)
+    {
+        SLfloat scale  = (SLfloat)SL_BVH_NUM_BINS / extent.comp[bestAxis];
+        auto    isLeft = [&](const Leaf& l) {
+            SLint b = (SLint)((l.center.comp[bestAxis] - cMin.comp[bestAxis]) * scale);
+            return SL_min(b, SL_BVH_NUM_BINS - 1) <= bestBin;
+        };
+        auto it = std::partition(_leaves.begin() + first,
+                                 _leaves.begin() + first + count,
+                                 isLeft);
+        mid     = (SLuint)(it - _leaves.begin());
+    }
+    else
+    {
+        SLint axis = extent.maxComp();
+        std::nth_element(_leaves.begin() + first,
+                         _leaves.begin() + mid,
+                         _leaves.begin() + first + count,
+                         [axis](const Leaf& a, const Leaf& b) {
+                             return a.center.comp[axis] < b.center.comp[axis];
+                         });
+    }
+
+    buildRec(first, mid - first, depth + 1);
+    SLuint right = buildRec(mid, first + count - mid, depth + 1);
+
+    _nodes[index].first = right;
+    _nodes[index].count = 0;
+    return index;
+}
+//-----------------------------------------------------------------------------
+/*! SLSceneBVH::refit updates the leaf AABBs and the node AABBs bottom-up
+without changing the topology. Because every child has a higher index than its
+parent a reverse loop over the nodes is enough.
+*/
+void SLSceneBVH::refit()
+{
+    for (auto& leaf : _leaves)
+    {
+        updateLeafAABB(leaf);
+        updateLeafFlags(leaf);
+    }
+
+    for (SLint i = (SLint)_nodes.size() - 1; i >= 0; --i)
+    {
+        Node& n = _nodes[(SLuint)i];
+        n.min.set(FLT_MAX, FLT_MAX, FLT_MAX);
+        n.max.set(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+        if (n.count)
+        {
+            for (SLuint l = n.first; l < n.first + n.count; ++l)
+            {
+                n.min.setMin(_leaves[l].min);
+                n.max.setMax(_leaves[l].max);
+            }
+        }
+        else
+        {
+            const Node& left  = _nodes[(SLuint)i + 1];
+            const Node& right = _nodes[n.first];
+            n.min             = left.min;
+            n.max             = left.max;
+            n.min.setMin(right.min);
+            n.max.setMax(right.max);
+        }
+    }
+
+    _needsRefit = false;
+}
+//-----------------------------------------------------------------------------
+/*! Slab test of a BVH node in world space. Other than SLAABBox::isHitInWS it
+does not overwrite the tmin & tmax of the ray that are used by the
+acceleration structures of the meshes.
+*/
+SLbool SLSceneBVH::isHitAABB(const Node& n, SLRay* ray, SLfloat& tNear) const
+{
+    SLVec3f params[2] = {n.min, n.max};
+    SLfloat tmin, tmax, tymin, tymax, tzmin, tzmax;
+
+    tmin  = (params[ray->sign[0]].x - ray->origin.x) * ray->invDir.x;
+    tmax  = (params[1 - ray->sign[0]].x - ray->origin.x) * ray->invDir.x;
+    tymin = (params[ray->sign[1]].y - ray->origin.y) * ray->invDir.y;
+    tymax = (params[1 - ray->sign[1]].y - ray->origin.y) * ray->invDir.y;
+
+    if ((tmin > tymax) || (tymin > tmax)) return false;
+    if (tymin > tmin) tmin = tymin;
+    if (tymax < tmax) tmax = tymax;
+
+    tzmin = (params[ray->sign[2]].z - ray->origin.z) * ray->invDir.z;
+    tzmax = (params[1 - ray->sign[2]].z - ray->origin.z) * ray->invDir.z;
+
+    if ((tmin > tzmax) || (tzmin > tmax)) return false;
+    if (tzmin > tmin) tmin = tzmin;
+    if (tzmax < tmax) tmax = tzmax;
+
+    tNear = tmin;
+    return ((tmin < ray->length) && (tmax > 0));
+}
+//-----------------------------------------------------------------------------
+/*! Returns true if the node of the leaf or one of its parents is hidden or if
+it is in the subtree of the source node of a shadow ray. This corresponds to
+the early returns in SLNode::hitRec. The parents only have to be searched for
+the rare leaves below another node with meshes.
+*/
+SLbool SLSceneBVH::isExcluded(const Leaf& leaf, SLRay* ray) const
+{
+    if (leaf.isHidden)
+        return true;
+    if (ray->type != SHADOW || !ray->srcNode)
+        return false;
+    if (leaf.node == ray->srcNode)
+        return true;
+    if (!leaf.hasMeshParent)
+        return false;
+
+    for (SLNode* n = leaf.node->parent(); n; n = n->parent())
+    {
+        if (n == ray->srcNode)
+            return true;
+        if (n == _root)
+            break;
+    }
+    return false;
+}
+//-----------------------------------------------------------------------------
+/*! SLSceneBVH::intersect traverses the hierarchy with a stack by visiting
+the nearer child first. Subtrees that start behind the closest hit so far
+(ray->length) are skipped. For shadow rays the traversal stops at the first
+occluder.
+*/
+SLbool SLSceneBVH::intersect(SLRay* ray)
+{
+    if (_nodes.empty())
+        return false;
+
+    SLfloat tNear;
+    if (!isHitAABB(_nodes[0], ray, tNear))
+        return false;
+
+    SLuint  stackNode[SL_BVH_MAX_DEPTH];
+    SLfloat stackNear[SL_BVH_MAX_DEPTH];
+    SLint   top    = 0;
+    SLbool  wasHit = false;
+    stackNode[top] = 0;
+    stackNear[top] = tNear;
+    top++;
+
+    while (top > 0)
+    {
+        --top;
+
+        // Skip the node if a closer hit was found after it got pushed
+        if (stackNear[top] >= ray->length)
+            continue;
+
+        SLuint      i = stackNode[top];
+        const Node& n = _nodes[i];
+
+        if (n.count)
+        {
+            for (SLuint l = n.first; l < n.first + n.count; ++l)
+            {
+                const Leaf& leaf = _leaves[l];
+                if (isExcluded(leaf, ray))
+                    continue;
+
+                SLbool hit = leaf.isSubtree ? leaf.node->hitRec(ray)
+                                            : leaf.node->hitMeshes(ray);
+                if (hit)
+                    wasHit = true;
+                if (ray->isShaded())
+                    return true;
+            }
+            continue;
+        }
+
+        SLuint  l = i + 1;
+        SLuint  r = n.first;
+        SLfloat tL, tR;
+        SLbool  hitL = isHitAABB(_nodes[l], ray, tL);
+        SLbool  hitR = isHitAABB(_nodes[r], ray, tR);
+
+        // Push the farther child first so that the nearer gets popped first
+        if (hitL && hitR)
+        {
+            if (tL < tR)
+            {
+                std::swap(l, r);
+                std::swap(tL, tR);
+            }
+            assert(top + 2 <= SL_BVH_MAX_DEPTH);
+            stackNode[top]   = l;
+            stackNear[top++] = tL;
+            stackNode[top]   = r;
+            stackNear[top++] = tR;
+        }
+        else if (hitL)
+        {
+            stackNode[top]   = l;
+            stackNear[top++] = tL;
+        }
+        else if (hitR)
+        {
+            stackNode[top]   = r;
+            stackNear[top++] = tR;
+        }
+    }
+
+    return wasHit;
+}
+//-----------------------------------------------------------------------------
+/*! SLSceneBVH::intersectPacket is the packet version of intersect for primary
+rays. The packet descends into a node if one of its rays hits the nodes AABB.
+At mesh leaves the whole packet gets transformed into the object space of the
+node and is passed to SLMesh::hitPacket. Subtree leaves (lights) are
+intersected ray by ray with hitRec.
+*/
+void SLSceneBVH::intersectPacket(SLRayPacket& packet)
+{
+    if (_nodes.empty())
+        return;
+
+    SLfloat tNear;
+    if (!packet.hitAABBInWS(_nodes[0].min, _nodes[0].max, tNear))
+        return;
+
+    SLuint stackNode[SL_BVH_MAX_DEPTH];
+    SLint  top       = 0;
+    stackNode[top++] = 0;
+
+    while (top > 0)
+    {
+        SLuint      i = stackNode[--top];
+        const Node& n = _nodes[i];
+
+        if (n.count)
+        {
+            for (SLuint l = n.first; l < n.first + n.count; ++l)
+            {
+                const Leaf& leaf = _leaves[l];
+
+                if (leaf.isSubtree)
+                {
+                    for (SLint r = 0; r < SL_PACKET_SIZE; ++r)
+                    {
+                        SLRay* ray = packet.rays[r];
+                        if (!ray || isExcluded(leaf, ray)) continue;
+                        leaf.node->hitRec(ray);
+                        packet.length[r] = ray->length;
+                    }
+                    continue;
+                }
+
+                // All primary rays share the same exclusion state
+                SLRay* first = nullptr;
+                for (SLint r = 0; r < SL_PACKET_SIZE && !first; ++r)
+                    first = packet.rays[r];
+                if (!first || isExcluded(leaf, first))
+                    continue;
+
+                packet.toOS(leaf.node->updateAndGetWMI());
+                for (auto mesh : leaf.node->meshes())
+                    mesh->hitPacket(packet, leaf.node);
+            }
+            continue;
+        }
+
+        SLuint  l = i + 1;
+        SLuint  r = n.first;
+        SLfloat tL, tR;
+        SLbool  hitL = packet.hitAABBInWS(_nodes[l].min, _nodes[l].max, tL);
+        SLbool  hitR = packet.hitAABBInWS(_nodes[r].min, _nodes[r].max, tR);
+
+        // Push the farther child first so that the nearer gets popped first
+        if (hitL && hitR)
+        {
+            if (tL < tR) std::swap(l, r);
+            assert(top + 2 <= SL_BVH_MAX_DEPTH);
+            stackNode[top++] = l;
+            stackNode[top++] = r;
+        }
+        else if (hitL)
+            stackNode[top++] = l;
+        else if (hitR)
+            stackNode[top++] = r;
+    }
+}
+//-----------------------------------------------------------------------------
+//! Returns the NO. of bytes used by the hierarchy
+SLuint SLSceneBVH::numBytes() const
+{
+    return (SLuint)(SL_sizeOfVector(_nodes) + SL_sizeOfVector(_leaves));
+}
+//-----------------------------------------------------------------------------
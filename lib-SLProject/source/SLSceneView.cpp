@@ -388,7 +388,8 @@ void SLSceneView::onResize(SLint width, SLint height)
 /*!
 SLSceneView::onPaint is called by window system whenever the window and therefore 
 the scene needs to be painted. Depending on the renderer it calls first
-SLSceneView::draw3DGL, SLSceneView::draw3DRT or SLSceneView::draw3DPT and
+SLSceneView::draw3DGL, SLSceneView::draw3DRT, SLSceneView::draw3DPT or
+SLSceneView::draw3DPM and
 then SLSceneView::draw2DGL for all UI in 2D. The method returns true if either
 the 2D or 3D graph was updated or waitEvents is false.
 */
@@ -411,6 +412,7 @@ SLbool SLSceneView::onPaint()
             case RT_gl: camUpdated = draw3DGL(s->elapsedTimeMS()); break;
             case RT_rt: camUpdated = draw3DRT(); break;
             case RT_pt: camUpdated = draw3DPT(); break;
+            case RT_pm: camUpdated = draw3DPM(); break;
         }
     };
 
@@ -1009,6 +1011,13 @@ SLbool SLSceneView::onMouseUp(SLMouseButton button,
         _pathtracer.state(rtReady);
     }
 
+    // Continue with photon mapping (the photon maps are reused)
+    if (_photonMapper.state() == rtMoveGL)
+    {
+        _renderType = RT_pm;
+        _photonMapper.state(rtReady);
+    }
+
     // Pass the event to imgui
     ImGui::GetIO().MousePos = ImVec2((SLfloat)x, (SLfloat)y);
     _gui.onMouseUp(button, x, y);
@@ -1058,7 +1067,8 @@ SLbool SLSceneView::onMouseMove(SLint x, SLint y)
         // Handle move in ray tracing
         if (_renderType == RT_rt && !_raytracer.doContinuous())
         {
-            if (_raytracer.state() == rtFinished)
+            // A progressive RT gets stopped and restarts on mouse up
+            if (_raytracer.state() == rtFinished || _raytracer.isProgressing())
                 _raytracer.state(rtMoveGL);
             else
             {
@@ -1075,6 +1085,14 @@ SLbool SLSceneView::onMouseMove(SLint x, SLint y)
             _renderType = RT_gl;
         }
 
+        // Handle move in photon mapping
+        if (_renderType == RT_pm)
+        {
+            if (_photonMapper.state() == rtFinished)
+                _photonMapper.state(rtMoveGL);
+            _renderType = RT_gl;
+        }
+
         result = _camera->onMouseMove(btn, x, y, _mouseMod);
 
         for (auto eh : s->eventHandlers())
@@ -1119,7 +1137,7 @@ SLbool SLSceneView::onMouseWheel(SLint delta, SLKey mod)
 
     // Handle mouse wheel in RT mode
     if (_renderType == RT_rt && !_raytracer.doContinuous() &&
-        _raytracer.state() == rtFinished)
+        (_raytracer.state() == rtFinished || _raytracer.isProgressing()))
         _raytracer.state(rtReady);
     SLbool result = false;
 
@@ -1156,6 +1174,7 @@ SLbool SLSceneView::onDoubleClick(SLMouseButton button,
         SLRay pickRay(this);
         if (_camera)
         {
+            s->updateMeshesForRays();
             _camera->eyeToPixelRay((SLfloat)x, (SLfloat)y, &pickRay);
             s->root3D()->hitRec(&pickRay);
             if (pickRay.hitNode)
@@ -1304,7 +1323,7 @@ SLbool SLSceneView::onKeyPress(SLKey key, SLKey mod)
              _camera->projection(P_monoOrthographic);
         else _camera->projection(P_monoPerspective);
         if (_renderType == RT_rt && !_raytracer.doContinuous() &&
-            _raytracer.state() == rtFinished)
+            (_raytracer.state() == rtFinished || _raytracer.isProgressing()))
             _raytracer.state(rtReady);
     }
 
@@ -1319,6 +1338,10 @@ SLbool SLSceneView::onKeyPress(SLKey key, SLKey mod)
         {  _stopPT = true;
             return false;
         }
+        else if(_renderType == RT_pm)
+        {  _stopPM = true;
+            return false;
+        }
         else return true; // end the program
     }
     // clang-format on
@@ -1422,6 +1445,16 @@ SLstring SLSceneView::windowTitle()
                 _pathtracer.pcRendered(),
                 _pathtracer.numThreads());
     }
+    else if (_renderType == RT_pm)
+    {
+        sprintf(title,
+                "%s (%d%%, Photons: %d, Threads: %d)",
+                s->name().c_str(),
+                _photonMapper.pcRendered(),
+                _photonMapper.mapCaustic().numPhotons() +
+                  _photonMapper.mapGlobal().numPhotons(),
+                _photonMapper.numThreads());
+    }
     else
     {
         SLuint nr = (uint)_visibleNodes.size();
@@ -1457,7 +1490,7 @@ void SLSceneView::startRaytracing(SLint maxDepth)
 /*!
 SLSceneView::updateAndRT3D starts the raytracing or refreshes the current RT
 image during rendering. The function returns true if an animation was done 
-prior to the rendering start.
+prior to the rendering start or if a progressive RT needs further steps.
 */
 SLbool SLSceneView::draw3DRT()
 {
@@ -1473,15 +1506,25 @@ SLbool SLSceneView::draw3DRT()
         //s->root3D()->needUpdate();
 
         // Do software skinning on all changed skeletons
-        for (auto mesh : s->meshes())
-            mesh->updateAccelStruct();
+        s->updateMeshesForRays();
+
+        // Rebuild or refit the top level BVH over the scene nodes
+        s->sceneBVH().update(s->root3D());
 
         // Start raytracing
-        if (_raytracer.doDistributed())
+        if (_raytracer.doProgressive() && !_raytracer.doContinuous())
+            updated = _raytracer.renderProgressive(this);
+        else if (_raytracer.doDistributed())
             _raytracer.renderDistrib(this);
         else
             _raytracer.renderClassic(this);
     }
+    else if (_raytracer.isProgressing())
+    {
+        // Refine the progressive RT within the frame budget. Returning true
+        // requests the next paint without waiting for events.
+        updated = _raytracer.renderProgressive(this);
+    }
 
     // Refresh the render image during RT
     _raytracer.renderImage();
@@ -1526,8 +1569,10 @@ SLbool SLSceneView::draw3DPT()
         //s->root3D()->needUpdate();
 
         // Do software skinning on all changed skeletons
-        for (auto mesh : s->meshes())
-            mesh->updateAccelStruct();
+        s->updateMeshesForRays();
+
+        // Rebuild or refit the top level BVH over the scene nodes
+        s->sceneBVH().update(s->root3D());
 
         // Start raytracing
         _pathtracer.render(this);
@@ -1546,3 +1591,51 @@ SLbool SLSceneView::draw3DPT()
     return updated;
 }
 //-----------------------------------------------------------------------------
+/*!
+Starts the photon mapping
+*/
+void SLSceneView::startPhotonMapping(SLint maxDepth)
+{
+    _renderType = RT_pm;
+    _stopPM     = false;
+    _photonMapper.maxDepth(maxDepth);
+    _photonMapper.aaSamples(_doMultiSampling && SLApplication::dpi < 200 ? 3 : 1);
+}
+//-----------------------------------------------------------------------------
+/*!
+SLSceneView::draw3DPM emits the photons, starts the ray tracing with the photon
+maps or refreshes the current image during rendering. The photon maps are
+reused if only the camera moved since the last rendering.
+*/
+SLbool SLSceneView::draw3DPM()
+{
+    SLbool updated = false;
+
+    // if the photon mapper not yet got started
+    if (_photonMapper.state() == rtReady)
+    {
+        SLScene* s = SLApplication::scene;
+
+        // Do software skinning on all changed skeletons
+        s->updateMeshesForRays();
+
+        // Rebuild or refit the top level BVH over the scene nodes
+        s->sceneBVH().update(s->root3D());
+
+        // Start photon mapping
+        _photonMapper.render(this);
+    }
+
+    // Refresh the render image during PM
+    _photonMapper.renderImage();
+
+    // React on the stop flag (e.g. ESC)
+    if (_stopPM)
+    {
+        _renderType = RT_gl;
+        updated     = true;
+    }
+
+    return updated;
+}
+//-----------------------------------------------------------------------------
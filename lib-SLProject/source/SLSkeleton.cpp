@@ -24,7 +24,8 @@
 SLSkeleton::SLSkeleton() : _rootJoint(nullptr),
                            _minOS(-1, -1, -1),
                            _maxOS(1, 1, 1),
-                           _minMaxOutOfDate(true)
+                           _minMaxOutOfDate(true),
+                           _jointBufferOutOfDate(true)
 {
     SLApplication::scene->animManager().addSkeleton(this);
 }
@@ -102,6 +103,27 @@ void SLSkeleton::getJointMatrices(SLVMat4f& jointWM)
     }
 }
 //-----------------------------------------------------------------------------
+/*! Binds the uniform buffer with the joint matrices to the passed binding
+point for the GPU skinning. The joint matrices are only calculated and
+uploaded if the skeleton has changed since the last upload. So all meshes of
+the skeleton share one upload per frame.
+*/
+void SLSkeleton::bindJointBuffer(SLuint binding)
+{
+    if (_jointBufferOutOfDate || !_jointBuffer.id())
+    {
+        SLuint numJ = (SLuint)SL_min(_joints.size(), (size_t)SL_MAX_JOINTS);
+        _jointMatrices.resize(_joints.size());
+        getJointMatrices(_jointMatrices);
+        _jointBuffer.update(_jointMatrices.data(),
+                            numJ * (SLuint)sizeof(SLMat4f),
+                            SL_MAX_JOINTS * (SLuint)sizeof(SLMat4f));
+        _jointBufferOutOfDate = false;
+    }
+
+    _jointBuffer.bindBase(binding);
+}
+//-----------------------------------------------------------------------------
 /*! Create a nw animation owned by this skeleton.
 */
 SLAnimation* SLSkeleton::createAnimation(const SLstring& name, SLfloat duration)
@@ -0,0 +1,292 @@
+//#############################################################################
+//  File:      SLTexCache.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLCVImage.h>
+#include <SLTexCache.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define SL_TEXCACHE_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define SL_TEXCACHE_NEON
+#    include <arm_neon.h>
+#endif
+
+//-----------------------------------------------------------------------------
+//! Packs a color with components in [0,255] into a RGBA8 texel
+static inline SLuint packRGBA(SLuint r, SLuint g, SLuint b, SLuint a)
+{
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the texel coordinate within [0, n-1] of the integral float coordinate
+x. The wrapping is done in float so that huge coordinates never get converted
+to int. Mirrored repeat repeats with the period 2n and mirrors the 2nd half.
+*/
+static inline SLint wrapCoord(SLfloat x, SLint n, SLTexWrap wrap)
+{
+    if (wrap == TW_clampToEdge)
+        return (SLint)SL_max(0.0f, SL_min(x, (SLfloat)(n - 1)));
+
+    SLint   period = wrap == TW_mirroredRepeat ? 2 * n : n;
+    SLfloat p      = (SLfloat)period;
+    SLint   i      = (SLint)SL_max(0.0f, SL_min(x - floor(x / p) * p, p - 1.0f));
+
+    return i < n ? i : period - 1 - i;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the sum of the four RGBA8 texels c weighted with w as color in [0,1].
+The texels get unpacked into 4 floats each and are summed up in one register.
+*/
+static inline SLCol4f blendTexels(const SLuint* c, const SLfloat* w)
+{
+#if defined(SL_TEXCACHE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i px   = _mm_loadu_si128((const __m128i*)c);
+    __m128i lo   = _mm_unpacklo_epi8(px, zero); // texel 0 & 1 as 16 bit
+    __m128i hi   = _mm_unpackhi_epi8(px, zero); // texel 2 & 3 as 16 bit
+    __m128  c0   = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+    __m128  c1   = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+    __m128  c2   = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+    __m128  c3   = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+    __m128  sum  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(w[0])),
+                                       _mm_mul_ps(c1, _mm_set1_ps(w[1]))),
+                            _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(w[2])),
+                                       _mm_mul_ps(c3, _mm_set1_ps(w[3]))));
+    alignas(16) SLfloat rgba[4];
+    _mm_store_ps(rgba, _mm_mul_ps(sum, _mm_set1_ps(1.0f / 255.0f)));
+    return SLCol4f(rgba[0], rgba[1], rgba[2], rgba[3]);
+#elif defined(SL_TEXCACHE_NEON)
+    uint8x16_t  px  = vreinterpretq_u8_u32(vld1q_u32(c));
+    uint16x8_t  lo  = vmovl_u8(vget_low_u8(px));  // texel 0 & 1 as 16 bit
+    uint16x8_t  hi  = vmovl_u8(vget_high_u8(px)); // texel 2 & 3 as 16 bit
+    float32x4_t sum = vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), w[0]);
+    sum             = vmlaq_n_f32(sum, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), w[1]);
+    sum             = vmlaq_n_f32(sum, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), w[2]);
+    sum             = vmlaq_n_f32(sum, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), w[3]);
+    SLfloat rgba[4];
+    vst1q_f32(rgba, vmulq_n_f32(sum, 1.0f / 255.0f));
+    return SLCol4f(rgba[0], rgba[1], rgba[2], rgba[3]);
+#else
+    SLfloat rgba[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (SLint i = 0; i < 4; ++i)
+        for (SLint ch = 0; ch < 4; ++ch)
+            rgba[ch] += w[i] * (SLfloat)((c[i] >> (8 * ch)) & 0xFF);
+    return SLCol4f(rgba[0], rgba[1], rgba[2], rgba[3]) / 255.0f;
+#endif
+}
+//-----------------------------------------------------------------------------
+/*!
+Copies the image into the tiled full resolution level and builds the mip
+levels down to 1x1 texels if buildMipmaps is true.
+*/
+SLTexCache::SLTexCache(SLCVImage* image, SLbool buildMipmaps)
+{
+    assert(image && image->width() > 0 && image->height() > 0);
+
+    _levels.resize(1);
+    loadLevel0(image);
+
+    if (buildMipmaps)
+    {
+        while (_levels.back().width > 1 || _levels.back().height > 1)
+        {
+            _levels.emplace_back();
+            buildLevel(_levels[_levels.size() - 2], _levels.back());
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Sets the size of a level and allocates its tiles
+void SLTexCache::initLevel(SLTexLevel& level, SLint width, SLint height)
+{
+    const SLint T = SL_TEXCACHE_TILE;
+    level.width   = width;
+    level.height  = height;
+    level.tilesX  = (width + T - 1) / T;
+    SLint tilesY  = (height + T - 1) / T;
+    level.texels.assign((size_t)(level.tilesX * tilesY * T * T), 0);
+}
+//-----------------------------------------------------------------------------
+/*!
+Copies the image pixels into level 0. The common 8 bit formats are read
+directly from the image data. All others go through SLCVImage::getPixeli.
+*/
+void SLTexCache::loadLevel0(SLCVImage* image)
+{
+    SLTexLevel& level = _levels[0];
+    SLint       w     = (SLint)image->width();
+    SLint       h     = (SLint)image->height();
+    initLevel(level, w, h);
+
+    SLPixelFormat format = image->format();
+    SLbool        isRGB  = format == PF_rgb;
+    SLbool        isRGBA = format == PF_rgba;
+    SLbool        isBGRA = format == PF_bgra;
+
+    for (SLint y = 0; y < h; ++y)
+    {
+        const SLubyte* row = image->data() + (size_t)y * image->bytesPerLine();
+
+        for (SLint x = 0; x < w; ++x)
+        {
+            SLuint texel;
+            if (isRGB)
+                texel = packRGBA(row[3 * x], row[3 * x + 1], row[3 * x + 2], 255);
+            else if (isRGBA)
+                texel = packRGBA(row[4 * x], row[4 * x + 1], row[4 * x + 2], row[4 * x + 3]);
+            else if (isBGRA)
+                texel = packRGBA(row[4 * x + 2], row[4 * x + 1], row[4 * x], row[4 * x + 3]);
+            else
+            {
+                SLCol4f c = image->getPixeli(x, y) * 255.0f;
+                texel     = packRGBA((SLuint)(c.r + 0.5f),
+                                 (SLuint)(c.g + 0.5f),
+                                 (SLuint)(c.b + 0.5f),
+                                 (SLuint)(c.a + 0.5f));
+            }
+            level.texels[texelIndex(level, x, y)] = texel;
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Builds the next smaller mip level with a 2x2 box filter
+void SLTexCache::buildLevel(const SLTexLevel& src, SLTexLevel& dst)
+{
+    initLevel(dst, SL_max(src.width / 2, 1), SL_max(src.height / 2, 1));
+
+    for (SLint y = 0; y < dst.height; ++y)
+    {
+        SLint y0 = SL_min(2 * y, src.height - 1);
+        SLint y1 = SL_min(2 * y + 1, src.height - 1);
+
+        for (SLint x = 0; x < dst.width; ++x)
+        {
+            SLint  x0   = SL_min(2 * x, src.width - 1);
+            SLint  x1   = SL_min(2 * x + 1, src.width - 1);
+            SLuint c[4] = {src.texels[texelIndex(src, x0, y0)],
+                           src.texels[texelIndex(src, x1, y0)],
+                           src.texels[texelIndex(src, x0, y1)],
+                           src.texels[texelIndex(src, x1, y1)]};
+
+            SLuint avg = 0;
+            for (SLint ch = 0; ch < 4; ++ch)
+            {
+                SLuint sum = 2; // for rounding
+                for (SLint i = 0; i < 4; ++i)
+                    sum += (c[i] >> (8 * ch)) & 0xFF;
+                avg |= (sum >> 2) << (8 * ch);
+            }
+            dst.texels[texelIndex(dst, x, y)] = avg;
+        }
+    }
+}
+//-----------------------------------------------------------------------------
+//! Returns the bilinear interpolated color at s, t of a level
+SLCol4f SLTexCache::bilinear(const SLTexLevel& level,
+                             SLfloat           s,
+                             SLfloat           t,
+                             SLTexWrap         wrapS,
+                             SLTexWrap         wrapT) const
+{
+    // texel coords relative to the texel centers
+    SLfloat x  = s * (SLfloat)level.width - 0.5f;
+    SLfloat y  = t * (SLfloat)level.height - 0.5f;
+    SLfloat xf = floor(x);
+    SLfloat yf = floor(y);
+    SLfloat fx = x - xf;
+    SLfloat fy = y - yf;
+
+    SLint x0 = wrapCoord(xf, level.width, wrapS);
+    SLint x1 = wrapCoord(xf + 1.0f, level.width, wrapS);
+    SLint y0 = wrapCoord(yf, level.height, wrapT);
+    SLint y1 = wrapCoord(yf + 1.0f, level.height, wrapT);
+
+    alignas(16) SLuint c[4] = {level.texels[texelIndex(level, x0, y0)],
+                               level.texels[texelIndex(level, x1, y0)],
+                               level.texels[texelIndex(level, x0, y1)],
+                               level.texels[texelIndex(level, x1, y1)]};
+
+    SLfloat w[4] = {(1.0f - fx) * (1.0f - fy),
+                    fx * (1.0f - fy),
+                    (1.0f - fx) * fy,
+                    fx * fy};
+
+    return blendTexels(c, w);
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the trilinear interpolated color at the texture coords s, t. The level
+of detail lod is the mip level as float (0 = full resolution). The texture
+coords are repeated, mirrored or clamped to the edge.
+*/
+SLCol4f SLTexCache::sample(SLfloat   s,
+                           SLfloat   t,
+                           SLfloat   lod,
+                           SLTexWrap wrapS,
+                           SLTexWrap wrapT) const
+{
+    // avoid undefined float to int conversions for broken tex. coords
+    if (!std::isfinite(s) || !std::isfinite(t))
+        return SLCol4f::BLACK;
+
+    SLint maxLevel = (SLint)_levels.size() - 1;
+
+    if (lod <= 0.0f || maxLevel == 0)
+        return bilinear(_levels[0], s, t, wrapS, wrapT);
+    if (lod >= (SLfloat)maxLevel)
+        return bilinear(_levels[(size_t)maxLevel], s, t, wrapS, wrapT);
+
+    SLint   l0 = (SLint)lod;
+    SLfloat f  = lod - (SLfloat)l0;
+    SLCol4f c0 = bilinear(_levels[(size_t)l0], s, t, wrapS, wrapT);
+    SLCol4f c1 = bilinear(_levels[(size_t)l0 + 1], s, t, wrapS, wrapT);
+    return c0 * (1.0f - f) + c1 * f;
+}
+//-----------------------------------------------------------------------------
+//! Returns the nearest texel of the full resolution level at s, t
+SLCol4f SLTexCache::sampleNearest(SLfloat   s,
+                                  SLfloat   t,
+                                  SLTexWrap wrapS,
+                                  SLTexWrap wrapT) const
+{
+    if (!std::isfinite(s) || !std::isfinite(t))
+        return SLCol4f::BLACK;
+
+    const SLTexLevel& level = _levels[0];
+
+    SLint  x     = wrapCoord(floor(s * (SLfloat)level.width), level.width, wrapS);
+    SLint  y     = wrapCoord(floor(t * (SLfloat)level.height), level.height, wrapT);
+    SLuint texel = level.texels[texelIndex(level, x, y)];
+
+    return SLCol4f((SLfloat)(texel & 0xFF),
+                   (SLfloat)((texel >> 8) & 0xFF),
+                   (SLfloat)((texel >> 16) & 0xFF),
+                   (SLfloat)(texel >> 24)) /
+           255.0f;
+}
+//-----------------------------------------------------------------------------
+//! Returns the NO. of bytes of all mip levels
+SLuint SLTexCache::numBytes() const
+{
+    size_t bytes = 0;
+    for (auto& level : _levels)
+        bytes += level.texels.size() * sizeof(SLuint);
+    return (SLuint)bytes;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,265 @@
+//#############################################################################
+//  File:      SLTransformStore.cpp
+//  Author:    Marcus Hudritsch
+//  Date:      October 2026
+//  Codestyle: https://github.com/cpvrlab/SLProject/wiki/Coding-Style-Guidelines
+//  Copyright: Marcus Hudritsch
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h> // Must be the 1st include followed by  an empty line
+
+#ifdef SL_MEMLEAKDETECT    // set in SL.h for debug config only
+#    include <debug_new.h> // memory leak detector
+#endif
+
+#include <SLNode.h>
+#include <SLRenderPool.h>
+#include <SLTransformStore.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define SL_TRANSFORM_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define SL_TRANSFORM_NEON
+#    include <arm_neon.h>
+#endif
+
+//-----------------------------------------------------------------------------
+//! Calculates the column major matrix product c = a * b
+static inline void multiply(const SLMat4f& a, const SLMat4f& b, SLMat4f& c)
+{
+    const SLfloat* A = a.m();
+    const SLfloat* B = b.m();
+    SLfloat        C[16];
+
+#if defined(SL_TRANSFORM_SSE2)
+    __m128 a0 = _mm_loadu_ps(A);
+    __m128 a1 = _mm_loadu_ps(A + 4);
+    __m128 a2 = _mm_loadu_ps(A + 8);
+    __m128 a3 = _mm_loadu_ps(A + 12);
+    for (SLint j = 0; j < 4; ++j)
+    {
+        // column j of c is the sum of the columns of a weighted by column j of b
+        __m128 col = _mm_mul_ps(a0, _mm_set1_ps(B[4 * j]));
+        col        = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(B[4 * j + 1])));
+        col        = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(B[4 * j + 2])));
+        col        = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(B[4 * j + 3])));
+        _mm_storeu_ps(C + 4 * j, col);
+    }
+#elif defined(SL_TRANSFORM_NEON)
+    float32x4_t a0 = vld1q_f32(A);
+    float32x4_t a1 = vld1q_f32(A + 4);
+    float32x4_t a2 = vld1q_f32(A + 8);
+    float32x4_t a3 = vld1q_f32(A + 12);
+    for (SLint j = 0; j < 4; ++j)
+    {
+        float32x4_t col = vmulq_n_f32(a0, B[4 * j]);
+        col             = vmlaq_n_f32(col, a1, B[4 * j + 1]);
+        col             = vmlaq_n_f32(col, a2, B[4 * j + 2]);
+        col             = vmlaq_n_f32(col, a3, B[4 * j + 3]);
+        vst1q_f32(C + 4 * j, col);
+    }
+#else
+    for (SLint j = 0; j < 4; ++j)
+        for (SLint i = 0; i < 4; ++i)
+            C[4 * j + i] = A[i] * B[4 * j] +
+                           A[4 + i] * B[4 * j + 1] +
+                           A[8 + i] * B[4 * j + 2] +
+                           A[12 + i] * B[4 * j + 3];
+#endif
+
+    c.setMatrix(C);
+}
+//-----------------------------------------------------------------------------
+SLTransformStore::SLTransformStore()
+{
+    _isEnabled    = true;
+    _needsRebuild = true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Switches the store on or off. Without the store the nodes calculate their
+matrices again in their own members, so all of them get flagged.
+*/
+void SLTransformStore::isEnabled(SLbool enabled)
+{
+    if (!enabled) clear();
+    _isEnabled    = enabled;
+    _needsRebuild = true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Updates the world matrices of all flagged nodes under the root level by
+level. The arrays are rebuilt first if the scene graph structure changed.
+Small levels are updated by the calling thread.
+*/
+void SLTransformStore::update(SLNode* root)
+{
+    if (!_isEnabled || !root)
+        return;
+
+    if (_needsRebuild || _nodes.empty() || _nodes[0] != root)
+        build(root);
+
+    atomic<SLuint> numUpdates(0);
+
+    for (SLuint l = 0; l + 1 < _levels.size(); ++l)
+    {
+        SLuint first = _levels[l];
+        SLuint last  = _levels[l + 1];
+
+        if (last - first < 2 * SL_TRANSFORM_BATCH)
+        {
+            numUpdates += updateRange(first, last);
+            continue;
+        }
+
+        SLuint numBatches = (last - first + SL_TRANSFORM_BATCH - 1) / SL_TRANSFORM_BATCH;
+        SLRenderPool::update().run(numBatches,
+                                   [&](SLuint task, SLuint worker) {
+                                       SLuint begin = first + task * SL_TRANSFORM_BATCH;
+                                       SLuint end   = SL_min(begin + SL_TRANSFORM_BATCH, last);
+                                       numUpdates += updateRange(begin, end);
+                                   });
+    }
+
+    SLNode::numWMUpdates += numUpdates;
+}
+//-----------------------------------------------------------------------------
+/*!
+Collects all nodes under the root breadth first, so that the nodes are sorted
+by their depth. All nodes get flagged, because their matrices are not yet in
+the store.
+*/
+void SLTransformStore::build(SLNode* root)
+{
+    clear();
+
+    _nodes.push_back(root);
+    _parents.push_back(-1);
+    _levels.push_back(0);
+
+    SLuint begin = 0;
+    while (begin < _nodes.size())
+    {
+        SLuint end = (SLuint)_nodes.size();
+        for (SLuint i = begin; i < end; ++i)
+        {
+            for (auto child : _nodes[i]->_children)
+            {
+                _nodes.push_back(child);
+                _parents.push_back((SLint)i);
+            }
+        }
+        _levels.push_back(end);
+        begin = end;
+    }
+
+    SLuint numNodes = (SLuint)_nodes.size();
+    _dirty.assign(numNodes, 1);
+    _wm.resize(numNodes);
+    _wmI.resize(numNodes);
+    _wmN.resize(numNodes);
+
+    for (SLuint i = 0; i < numNodes; ++i)
+    {
+        _nodes[i]->_store        = this;
+        _nodes[i]->_storeIndex   = (SLint)i;
+        _nodes[i]->_isWMUpToDate = false;
+    }
+
+    _needsRebuild = false;
+}
+//-----------------------------------------------------------------------------
+/*!
+Releases all nodes. Their matrices are calculated again in their own members
+at the next access.
+*/
+void SLTransformStore::clear()
+{
+    for (auto node : _nodes)
+    {
+        if (node)
+        {
+            node->_store        = nullptr;
+            node->_storeIndex   = -1;
+            node->_isWMUpToDate = false;
+        }
+    }
+
+    _nodes.clear();
+    _parents.clear();
+    _levels.clear();
+    _dirty.clear();
+    _wm.clear();
+    _wmI.clear();
+    _wmN.clear();
+    _needsRebuild = true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Updates the flagged nodes in the index range [first, last) of one level and
+returns the NO. of updated nodes. The parents are in the level above and are
+already up to date.
+*/
+SLuint SLTransformStore::updateRange(SLuint first, SLuint last)
+{
+    SLuint numUpdates = 0;
+
+    for (SLuint i = first; i < last; ++i)
+    {
+        if (!_dirty[i] || !_nodes[i])
+            continue;
+
+        SLint parent = _parents[i];
+        if (parent >= 0)
+            multiply(_wm[(SLuint)parent], _nodes[i]->_om, _wm[i]);
+        else
+            _wm[i] = _nodes[i]->_om;
+
+        finishNode(i);
+        numUpdates++;
+    }
+
+    return numUpdates;
+}
+//-----------------------------------------------------------------------------
+/*!
+Updates a single node between two calls of update. It is called by
+SLNode::updateWM and uses the parent pointer of the node, because the parent
+index is outdated if the node was moved since the last build.
+*/
+void SLTransformStore::updateNode(SLint index)
+{
+    SLuint  i    = (SLuint)index;
+    SLNode* node = _nodes[i];
+
+    if (node->_parent)
+        multiply(node->_parent->updateAndGetWM(), node->_om, _wm[i]);
+    else
+        _wm[i] = node->_om;
+
+    finishNode(i);
+}
+//-----------------------------------------------------------------------------
+//! Derives the inverse and the normal matrix and clears the flags of a node
+void SLTransformStore::finishNode(SLuint i)
+{
+    _wmI[i] = _wm[i].invertedAffine();
+    _wmN[i].setMatrix(_wm[i].mat3());
+    _dirty[i]                = 0;
+    _nodes[i]->_isWMUpToDate = true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Removes a node that gets deleted. Its slot stays empty until the next
+update rebuilds the arrays.
+*/
+void SLTransformStore::removeNode(SLint index)
+{
+    _nodes[(SLuint)index] = nullptr;
+    _needsRebuild         = true;
+}
+//-----------------------------------------------------------------------------